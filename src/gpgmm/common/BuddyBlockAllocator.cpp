@@ -21,241 +21,289 @@
 #include "gpgmm/utils/Math.h"
 #include "gpgmm/utils/Utils.h"
 
+#include <algorithm>
+
 namespace gpgmm {
 
     BuddyBlockAllocator::BuddyBlockAllocator(uint64_t maxBlockSize) : mMaxBlockSize(maxBlockSize) {
         ASSERT(IsPowerOfTwo(maxBlockSize));
 
-        mFreeLists.resize(Log2(mMaxBlockSize) + 1);
+        mLevels.resize(Log2(mMaxBlockSize) + 1);
 
         // Insert the level0 free block.
-        mRoot = new BuddyBlock{};
-        mRoot->Size = maxBlockSize;
-        mRoot->Offset = 0;
-
-        mFreeLists[0] = {mRoot};
+        SetBlockState(/*level*/ 0, /*nodeIndex*/ 0, BlockState::Free);
     }
 
-    BuddyBlockAllocator::~BuddyBlockAllocator() {
-        if (mRoot != nullptr) {
-            DeleteBlock(mRoot);
-            mRoot = nullptr;
-        }
-    }
+    BuddyBlockAllocator::~BuddyBlockAllocator() = default;
 
     uint64_t BuddyBlockAllocator::ComputeTotalNumOfFreeBlocksForTesting() const {
-        return ComputeNumOfFreeBlocks(mRoot);
+        uint64_t numOfFreeBlocks = 0;
+        for (const BuddyLevel& level : mLevels) {
+            for (uint64_t freeNodes : level.FreeNodes) {
+                for (; freeNodes != 0; freeNodes &= freeNodes - 1) {
+                    numOfFreeBlocks++;
+                }
+            }
+        }
+        return numOfFreeBlocks;
     }
 
-    uint64_t BuddyBlockAllocator::ComputeNumOfFreeBlocks(BuddyBlock* block) const {
-        if (block->mState == BlockState::Free) {
-            return 1;
-        } else if (block->mState == BlockState::Split) {
-            return ComputeNumOfFreeBlocks(block->split.pLeft) +
-                   ComputeNumOfFreeBlocks(block->split.pLeft->pBuddy);
+    uint64_t BuddyBlockAllocator::GetLargestFreeBlockSize(uint64_t maxBlockSize) const {
+        if (maxBlockSize == 0) {
+            return 0;
         }
+
+        ASSERT(IsPowerOfTwo(maxBlockSize));
+        ASSERT(maxBlockSize <= mMaxBlockSize);
+
+        for (size_t level = ComputeLevelFromBlockSize(maxBlockSize); level < mLevels.size();
+             level++) {
+            if (mLevels[level].FreeNodeCount > 0) {
+                return mMaxBlockSize >> level;
+            }
+        }
+
         return 0;
     }
 
     uint32_t BuddyBlockAllocator::ComputeLevelFromBlockSize(uint64_t blockSize) const {
         // Every level in the buddy system can be indexed by order-n where n = log2(blockSize).
-        // However, mFreeList zero-indexed by level.
+        // However, mLevels zero-indexed by level.
         // For example, blockSize=4 is Level1 if MAX_BLOCK is 8.
         return Log2(mMaxBlockSize) - Log2(blockSize);
     }
 
-    uint64_t BuddyBlockAllocator::GetNextFreeAlignedBlock(size_t allocationBlockLevel,
-                                                          uint64_t alignment) const {
-        ASSERT(IsPowerOfTwo(alignment));
-        // The current level is the level that corresponds to the allocation size. The free list may
-        // not contain a block at that level until a larger one gets allocated (and splits).
-        // Continue to go up the tree until such a larger block exists.
-        //
-        // Even if the block exists at the level, it cannot be used if it's offset is unaligned.
-        // When the alignment is also a power-of-two, we simply use the next free block whose size
-        // is greater than or equal to the alignment value.
-        //
-        //  After one 8-byte allocation:
-        //
-        //  Level          --------------------------------
-        //      0       32 |               S              |
-        //                 --------------------------------
-        //      1       16 |       S       |       F2     |       S - split
-        //                 --------------------------------       F - free
-        //      2       8  |   Aa  |   F1  |              |       A - allocated
-        //                 --------------------------------
-        //
-        //  Allocate(size=8, alignment=8) will be satisfied by using F1.
-        //  Allocate(size=8, alignment=4) will be satified by using F1.
-        //  Allocate(size=8, alignment=16) will be satisified by using F2.
-        //
-        for (size_t ii = 0; ii <= allocationBlockLevel; ++ii) {
-            size_t currLevel = allocationBlockLevel - ii;
-            BuddyBlock* freeBlock = mFreeLists[currLevel].head;
-            if (freeBlock && IsAligned(freeBlock->Offset, alignment)) {
-                return currLevel;
-            }
+    BuddyBlockAllocator::BlockState BuddyBlockAllocator::GetBlockState(size_t level,
+                                                                       uint64_t nodeIndex) const {
+        const BuddyLevel& buddyLevel = mLevels[level];
+        const uint64_t wordIndex = nodeIndex / kStatesPerWord;
+
+        // Storage only covers nodes that were used.
+        if (wordIndex >= buddyLevel.NodeStates.size()) {
+            return BlockState::Unused;
         }
-        return kInvalidOffset;  // No free block exists at any level.
+
+        const uint64_t shift = (nodeIndex % kStatesPerWord) * kBitsPerState;
+        return static_cast<BlockState>((buddyLevel.NodeStates[wordIndex] >> shift) & 0x3);
     }
 
-    // Inserts existing free block into the free-list.
-    // Called by allocate upon splitting to insert a child block into a free-list.
-    // Note: Always insert into the head of the free-list. As when a larger free block at a lower
-    // level was split, there were no smaller free blocks at a higher level to allocate.
-    void BuddyBlockAllocator::InsertFreeBlock(BuddyBlock* block, size_t level) {
-        ASSERT(block->mState == BlockState::Free);
+    void BuddyBlockAllocator::SetBlockState(size_t level, uint64_t nodeIndex, BlockState state) {
+        BuddyLevel& buddyLevel = mLevels[level];
+
+        // Grow the level to cover the node. The level can never exceed 2^level nodes.
+        const uint64_t freeWordIndex = nodeIndex / kBitsPerWord;
+        if (freeWordIndex >= buddyLevel.FreeNodes.size()) {
+            const uint64_t maxNumOfWords = ((uint64_t{1} << level) + kBitsPerWord - 1) / kBitsPerWord;
+            const uint64_t numOfWords = std::min(
+                std::max<uint64_t>(freeWordIndex + 1, buddyLevel.FreeNodes.size() * 2),
+                maxNumOfWords);
+            buddyLevel.FreeNodes.resize(numOfWords);
+            buddyLevel.NodeStates.resize(numOfWords * (kBitsPerWord / kStatesPerWord));
+        }
 
-        // Inserted block is now the front (no prev).
-        block->free.pPrev = nullptr;
+        const uint64_t stateWordIndex = nodeIndex / kStatesPerWord;
+        const uint64_t shift = (nodeIndex % kStatesPerWord) * kBitsPerState;
+        uint64_t& nodeStates = buddyLevel.NodeStates[stateWordIndex];
+        nodeStates = (nodeStates & ~(uint64_t{0x3} << shift)) |
+                     (static_cast<uint64_t>(state) << shift);
+
+        const uint64_t freeBit = uint64_t{1} << (nodeIndex % kBitsPerWord);
+        const bool wasFree = (buddyLevel.FreeNodes[freeWordIndex] & freeBit) != 0;
+        if (state == BlockState::Free) {
+            buddyLevel.FreeNodes[freeWordIndex] |= freeBit;
+            buddyLevel.FreeNodeCount += (wasFree) ? 0 : 1;
+        } else {
+            buddyLevel.FreeNodes[freeWordIndex] &= ~freeBit;
+            buddyLevel.FreeNodeCount -= (wasFree) ? 1 : 0;
+        }
+    }
+
+    uint64_t BuddyBlockAllocator::FindFreeAlignedNode(size_t level,
+                                                      uint64_t alignment,
+                                                      uint64_t beginNode,
+                                                      uint64_t endNode) const {
+        ASSERT(IsPowerOfTwo(alignment));
 
-        // Old head is now the inserted block's next.
-        block->free.pNext = mFreeLists[level].head;
+        // Even if the block exists at the level, it cannot be used if it's offset is unaligned.
+        // Since both the block size and alignment are a power-of-two, only every n-th node is
+        // aligned where n = alignment / blockSize.
+        const uint64_t blockSize = mMaxBlockSize >> level;
+        const uint64_t nodeStride = (alignment > blockSize) ? alignment / blockSize : 1;
+
+        const std::vector<uint64_t>& freeNodes = mLevels[level].FreeNodes;
+        endNode = std::min(endNode, freeNodes.size() * kBitsPerWord);
+        if (nodeStride < kBitsPerWord) {
+            // Mask-off the unaligned nodes of each word.
+            uint64_t alignedNodesMask = 0;
+            for (uint64_t bit = 0; bit < kBitsPerWord; bit += nodeStride) {
+                alignedNodesMask |= uint64_t{1} << bit;
+            }
 
-        // MemoryBlock already in HEAD position (ex. right child was inserted first).
-        if (mFreeLists[level].head != nullptr) {
-            // Old head's previous is the inserted block.
-            mFreeLists[level].head->free.pPrev = block;
+            for (uint64_t wordIndex = beginNode / kBitsPerWord; wordIndex * kBitsPerWord < endNode;
+                 wordIndex++) {
+                uint64_t alignedFreeNodes = freeNodes[wordIndex] & alignedNodesMask;
+
+                // Mask-off the nodes outside the range.
+                if (wordIndex == beginNode / kBitsPerWord) {
+                    alignedFreeNodes &= ~uint64_t{0} << (beginNode % kBitsPerWord);
+                }
+                if ((wordIndex + 1) * kBitsPerWord > endNode) {
+                    alignedFreeNodes &= (uint64_t{1} << (endNode % kBitsPerWord)) - 1;
+                }
+
+                if (alignedFreeNodes != 0) {
+                    return wordIndex * kBitsPerWord + ScanForward(alignedFreeNodes);
+                }
+            }
+        } else {
+            // Only the first node of every n-th word is aligned.
+            const uint64_t wordStride = nodeStride / kBitsPerWord;
+            for (uint64_t wordIndex = AlignTo(beginNode, nodeStride) / kBitsPerWord;
+                 wordIndex * kBitsPerWord < endNode; wordIndex += wordStride) {
+                if (freeNodes[wordIndex] & 0x1) {
+                    return wordIndex * kBitsPerWord;
+                }
+            }
         }
 
-        mFreeLists[level].head = block;
+        return kInvalidIndex;  // No free aligned block exists at the level.
     }
 
-    void BuddyBlockAllocator::RemoveFreeBlock(BuddyBlock* block, size_t level) {
-        ASSERT(block->mState == BlockState::Free);
-
-        if (mFreeLists[level].head == block) {
-            // MemoryBlock is in HEAD position.
-            mFreeLists[level].head = mFreeLists[level].head->free.pNext;
+    MemoryBlock* BuddyBlockAllocator::AcquireBlock(uint64_t offset, uint64_t size) {
+        MemoryBlock* block = nullptr;
+        if (!mUnusedBlocks.empty()) {
+            block = mUnusedBlocks.back();
+            mUnusedBlocks.pop_back();
         } else {
-            // MemoryBlock is after HEAD position.
-            BuddyBlock* pPrev = block->free.pPrev;
-            BuddyBlock* pNext = block->free.pNext;
-
-            ASSERT(pPrev != nullptr);
-            ASSERT(pPrev->mState == BlockState::Free);
+            mBlocks.push_back(std::make_unique<MemoryBlock>());
+            block = mBlocks.back().get();
+        }
 
-            pPrev->free.pNext = pNext;
+        block->Offset = offset;
+        block->Size = size;
+        return block;
+    }
 
-            if (pNext != nullptr) {
-                ASSERT(pNext->mState == BlockState::Free);
-                pNext->free.pPrev = pPrev;
-            }
-        }
+    void BuddyBlockAllocator::ReturnBlock(MemoryBlock* block) {
+        block->Offset = kInvalidOffset;
+        block->Size = kInvalidSize;
+        mUnusedBlocks.push_back(block);
     }
 
     MemoryBlock* BuddyBlockAllocator::TryAllocateBlock(uint64_t requestSize, uint64_t alignment) {
         // Request cannot exceed max block size.
         GPGMM_INVALID_IF(requestSize > mMaxBlockSize);
 
+        return TryAllocateBlockInRange(requestSize, alignment, /*rangeOffset*/ 0, mMaxBlockSize);
+    }
+
+    MemoryBlock* BuddyBlockAllocator::TryAllocateBlockInRange(uint64_t requestSize,
+                                                              uint64_t alignment,
+                                                              uint64_t rangeOffset,
+                                                              uint64_t rangeSize) {
+        ASSERT(IsPowerOfTwo(rangeSize) && rangeSize <= mMaxBlockSize);
+        ASSERT(IsAligned(rangeOffset, rangeSize));
+
+        // Request cannot exceed the range.
+        GPGMM_INVALID_IF(requestSize > rangeSize);
+
         // Compute the level
         const uint32_t sizeToLevel = ComputeLevelFromBlockSize(requestSize);
 
-        ASSERT(sizeToLevel < mFreeLists.size());
+        ASSERT(sizeToLevel < mLevels.size());
+
+        auto findFreeAlignedNodeInRange = [&](size_t level) {
+            const uint64_t blockSize = mMaxBlockSize >> level;
+            if (blockSize > rangeSize) {
+                // Only the block containing the range can be split down to it.
+                const uint64_t nodeIndex = rangeOffset / blockSize;
+                return (GetBlockState(level, nodeIndex) == BlockState::Free &&
+                        IsAligned(rangeOffset, alignment))
+                           ? nodeIndex
+                           : kInvalidIndex;
+            }
+            return FindFreeAlignedNode(level, alignment, rangeOffset / blockSize,
+                                       (rangeOffset + rangeSize) / blockSize);
+        };
 
-        uint64_t currBlockLevel = GetNextFreeAlignedBlock(sizeToLevel, alignment);
+        // The current level is the level that corresponds to the allocation size. The level may
+        // not contain a free block until a larger one gets allocated (and splits).
+        // Continue to go up the tree until such a larger block exists.
+        //
+        //  After one 8-byte allocation:
+        //
+        //  Level          --------------------------------
+        //      0       32 |               S              |
+        //                 --------------------------------
+        //      1       16 |       S       |       F2     |       S - split
+        //                 --------------------------------       F - free
+        //      2       8  |   Aa  |   F1  |              |       A - allocated
+        //                 --------------------------------
+        //
+        //  Allocate(size=8, alignment=8) will be satisfied by using F1.
+        //  Allocate(size=8, alignment=4) will be satified by using F1.
+        //  Allocate(size=8, alignment=16) will be satisified by using F2.
+        //
+        //  Blocks larger than the range are only used when they contain the range.
+        //
+        size_t currBlockLevel = sizeToLevel;
+        uint64_t currNodeIndex = findFreeAlignedNodeInRange(currBlockLevel);
+        while (currNodeIndex == kInvalidIndex && currBlockLevel > 0) {
+            currBlockLevel--;
+            currNodeIndex = findFreeAlignedNodeInRange(currBlockLevel);
+        }
 
         // Error when no free blocks exist (allocator is full)
-        GPGMM_INVALID_IF(currBlockLevel == kInvalidOffset);
+        GPGMM_INVALID_IF(currNodeIndex == kInvalidIndex);
 
         // Split free blocks level-by-level.
         // Terminate when the current block level is equal to the computed level of the requested
         // allocation.
-        BuddyBlock* currBlock = mFreeLists[currBlockLevel].head;
-
         for (; currBlockLevel < sizeToLevel; currBlockLevel++) {
-            ASSERT(currBlock->mState == BlockState::Free);
-
-            // Remove curr block (about to be split).
-            RemoveFreeBlock(currBlock, currBlockLevel);
-
-            // Create two free child blocks (the buddies).
-            const uint64_t nextLevelSize = currBlock->Size / 2;
-            BuddyBlock* leftChildBlock = new BuddyBlock{};
-            leftChildBlock->Size = nextLevelSize;
-            leftChildBlock->Offset = currBlock->Offset;
-
-            BuddyBlock* rightChildBlock = new BuddyBlock{};
-            rightChildBlock->Size = nextLevelSize;
-            rightChildBlock->Offset = currBlock->Offset + nextLevelSize;
-
-            // Remember the parent to merge these back upon de-allocation.
-            rightChildBlock->pParent = currBlock;
-            leftChildBlock->pParent = currBlock;
-
-            // Make them buddies.
-            leftChildBlock->pBuddy = rightChildBlock;
-            rightChildBlock->pBuddy = leftChildBlock;
-
-            // Insert the children back into the free list into the next level.
-            // The free list does not require a specific order. However, an order is specified as
-            // it's ideal to allocate lower addresses first by having the leftmost child in HEAD.
-            InsertFreeBlock(rightChildBlock, currBlockLevel + 1);
-            InsertFreeBlock(leftChildBlock, currBlockLevel + 1);
-
-            // Curr block is now split.
-            currBlock->mState = BlockState::Split;
-            currBlock->split.pLeft = leftChildBlock;
-
-            // Decend down into the next level.
-            currBlock = leftChildBlock;
+            ASSERT(GetBlockState(currBlockLevel, currNodeIndex) == BlockState::Free);
+
+            // Curr block is now split into two free child blocks (the buddies).
+            SetBlockState(currBlockLevel, currNodeIndex, BlockState::Split);
+            SetBlockState(currBlockLevel + 1, currNodeIndex * 2, BlockState::Free);
+            SetBlockState(currBlockLevel + 1, currNodeIndex * 2 + 1, BlockState::Free);
+
+            // Decend down into the next level, using the child containing the range or else the
+            // leftmost child so lower addresses are allocated first.
+            const uint64_t childBlockSize = mMaxBlockSize >> (currBlockLevel + 1);
+            currNodeIndex = (childBlockSize >= rangeSize) ? rangeOffset / childBlockSize
+                                                          : currNodeIndex * 2;
         }
 
-        // Remove curr block from free-list (now allocated).
-        RemoveFreeBlock(currBlock, currBlockLevel);
-        currBlock->mState = BlockState::Allocated;
+        ASSERT(GetBlockState(currBlockLevel, currNodeIndex) == BlockState::Free);
+        SetBlockState(currBlockLevel, currNodeIndex, BlockState::Allocated);
 
-        return currBlock;
+        const uint64_t blockSize = mMaxBlockSize >> currBlockLevel;
+        return AcquireBlock(currNodeIndex * blockSize, blockSize);
     }
 
     void BuddyBlockAllocator::DeallocateBlock(MemoryBlock* block) {
         ASSERT(block != nullptr);
 
-        BuddyBlock* curr = static_cast<BuddyBlock*>(block);
-
-        ASSERT(curr->mState == BlockState::Allocated);
-
-        size_t currBlockLevel = ComputeLevelFromBlockSize(curr->Size);
+        size_t currBlockLevel = ComputeLevelFromBlockSize(block->Size);
+        uint64_t currNodeIndex = block->Offset / block->Size;
 
-        // Mark curr free so we can merge.
-        curr->mState = BlockState::Free;
+        ASSERT(GetBlockState(currBlockLevel, currNodeIndex) == BlockState::Allocated);
 
         // Merge the buddies (LevelN-to-Level0).
-        while (currBlockLevel > 0 && curr->pBuddy->mState == BlockState::Free) {
-            // Remove the buddy.
-            RemoveFreeBlock(curr->pBuddy, currBlockLevel);
-
-            BuddyBlock* parent = curr->pParent;
-
-            // The buddies were inserted in a specific order but
-            // could be deleted in any order.
-            DeleteBlock(curr->pBuddy);
-            DeleteBlock(curr);
-
-            // Parent is now free.
-            parent->mState = BlockState::Free;
+        while (currBlockLevel > 0 &&
+               GetBlockState(currBlockLevel, currNodeIndex ^ 1) == BlockState::Free) {
+            SetBlockState(currBlockLevel, currNodeIndex, BlockState::Unused);
+            SetBlockState(currBlockLevel, currNodeIndex ^ 1, BlockState::Unused);
 
             // Ascend up to the next level (parent block).
-            curr = parent;
+            currNodeIndex /= 2;
             currBlockLevel--;
         }
 
-        InsertFreeBlock(curr, currBlockLevel);
+        SetBlockState(currBlockLevel, currNodeIndex, BlockState::Free);
 
         // Invalidate to ensure it cannot be deallocated again.
-        block = {};
-    }
-
-    // Helper which deletes a block in the tree recursively (post-order).
-    void BuddyBlockAllocator::DeleteBlock(BuddyBlock* block) {
-        ASSERT(block != nullptr);
-
-        if (block->mState == BlockState::Split) {
-            // Delete the pair in same order we inserted.
-            DeleteBlock(block->split.pLeft->pBuddy);
-            DeleteBlock(block->split.pLeft);
-        }
-        SafeDelete(block);
+        ReturnBlock(block);
     }
 
     const char* BuddyBlockAllocator::GetTypename() const {
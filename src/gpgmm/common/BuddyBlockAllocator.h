@@ -21,6 +21,7 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <memory>
 #include <vector>
 
 namespace gpgmm {
@@ -31,10 +32,13 @@ namespace gpgmm {
     // returning the starting offset whose size is guaranteed to be greater than or equal to the
     // allocation size. To deallocate, the same offset is used to find the corresponding block.
     //
-    // Internally, it manages a free list to track free blocks in a full binary tree.
-    // Every index in the free list corresponds to a level in the tree. That level also determines
-    // the size of the block to be used to satisfy the request. The first level (index=0) represents
-    // the root whose size is also called the max block size.
+    // Internally, blocks are nodes of an implicit full binary tree: the node at index i of a level
+    // has offset i * blockSize, its buddy is at index i ^ 1, its parent is at index i / 2 of the
+    // level above and its children are at index 2i and 2i + 1 of the level below. The first
+    // level (level=0) represents the root whose size is also called the max block size. Every
+    // level stores the state of each node, packed as bits, and a bitmap of free nodes so a free
+    // aligned block is found by scanning the bitmap. Since nodes are never created, splitting or
+    // merging blocks does not allocate. Level storage only grows to cover the highest node used.
     //
     class BuddyBlockAllocator : public BlockAllocator {
       public:
@@ -45,6 +49,18 @@ namespace gpgmm {
         MemoryBlock* TryAllocateBlock(uint64_t requestSize, uint64_t alignment) override;
         void DeallocateBlock(MemoryBlock* block) override;
 
+        // Allocates a block only from within the block at |rangeOffset| of |rangeSize| bytes,
+        // which must be a power-of-two and aligned to its size. Returns nullptr, without
+        // splitting any block outside of the range or containing it, if none fits.
+        MemoryBlock* TryAllocateBlockInRange(uint64_t requestSize,
+                                             uint64_t alignment,
+                                             uint64_t rangeOffset,
+                                             uint64_t rangeSize);
+
+        // Returns the size of the largest free block no larger than |maxBlockSize|, or zero if
+        // none exists.
+        uint64_t GetLargestFreeBlockSize(uint64_t maxBlockSize) const;
+
         // For testing purposes only.
         uint64_t ComputeTotalNumOfFreeBlocksForTesting() const;
 
@@ -52,62 +68,42 @@ namespace gpgmm {
 
       private:
         uint32_t ComputeLevelFromBlockSize(uint64_t blockSize) const;
-        uint64_t GetNextFreeAlignedBlock(size_t allocationBlockLevel, uint64_t alignment) const;
-
-        enum class BlockState { Free, Split, Allocated };
-
-        struct BuddyBlock : public MemoryBlock {
-            BuddyBlock() {
-                free = {};
-            }
-
-            // Pointer to this block's buddy, iff parent is split.
-            // Used to quickly merge buddy blocks upon de-allocate.
-            BuddyBlock* pBuddy = nullptr;
-            BuddyBlock* pParent = nullptr;
 
-            // Track whether this block has been split or not.
-            BlockState mState = BlockState::Free;
+        enum class BlockState : uint64_t { Unused = 0, Free = 1, Split = 2, Allocated = 3 };
 
-            struct FreeLinks {
-                BuddyBlock* pPrev = nullptr;
-                BuddyBlock* pNext = nullptr;
-            };
+        static constexpr uint64_t kBitsPerWord = 64;
+        static constexpr uint64_t kBitsPerState = 2;
+        static constexpr uint64_t kStatesPerWord = kBitsPerWord / kBitsPerState;
 
-            struct SplitLink {
-                BuddyBlock* pLeft = nullptr;
-            };
-
-            union {
-                // Used upon allocation.
-                // Avoids searching for the next free block.
-                FreeLinks free;
-
-                // Used upon de-allocation.
-                // Had this block split upon allocation, it and it's buddy is to be deleted.
-                SplitLink split;
-            };
+        // Nodes of the same size.
+        struct BuddyLevel {
+            std::vector<uint64_t> NodeStates;  // |kBitsPerState| bits per node.
+            std::vector<uint64_t> FreeNodes;   // Bit is set if the node is free.
+            uint64_t FreeNodeCount = 0;
         };
 
-        void InsertFreeBlock(BuddyBlock* block, size_t level);
-        void RemoveFreeBlock(BuddyBlock* block, size_t level);
-        void DeleteBlock(BuddyBlock* block);
+        BlockState GetBlockState(size_t level, uint64_t nodeIndex) const;
+        void SetBlockState(size_t level, uint64_t nodeIndex, BlockState state);
 
-        uint64_t ComputeNumOfFreeBlocks(BuddyBlock* block) const;
+        // Returns the index of the lowest free node in the level, between |beginNode| and
+        // |endNode|, whose offset is aligned, or kInvalidIndex if none exists.
+        uint64_t FindFreeAlignedNode(size_t level,
+                                     uint64_t alignment,
+                                     uint64_t beginNode = 0,
+                                     uint64_t endNode = kInvalidIndex) const;
 
-        // Keep track the head and tail (for faster insertion/removal).
-        struct BlockList {
-            BuddyBlock* head = nullptr;  // First free block in level.
-            // TODO: Track the tail.
-        };
-
-        BuddyBlock* mRoot = nullptr;  // Used to deallocate non-free blocks.
+        // Returns a block descriptor, re-using one if possible.
+        MemoryBlock* AcquireBlock(uint64_t offset, uint64_t size);
+        void ReturnBlock(MemoryBlock* block);
 
         uint64_t mMaxBlockSize = 0;
 
-        // List of linked-lists of free blocks where the index is a level that
-        // corresponds to a power-of-two sized block.
-        std::vector<BlockList> mFreeLists;
+        // Levels of the tree where the index corresponds to a power-of-two sized block.
+        std::vector<BuddyLevel> mLevels;
+
+        // Descriptors for allocated blocks. Unused descriptors are kept for re-use.
+        std::vector<std::unique_ptr<MemoryBlock>> mBlocks;
+        std::vector<MemoryBlock*> mUnusedBlocks;
     };
 
 }  // namespace gpgmm
@@ -47,6 +47,26 @@ namespace gpgmm {
 
         std::lock_guard<std::mutex> lock(mMutex);
 
+        return TryAllocateMemoryInternal(request);
+    }
+
+    std::vector<std::unique_ptr<MemoryAllocation>> BuddyMemoryAllocator::TryAllocateMemoryBatch(
+        const MemoryAllocationRequest* requests,
+        uint64_t count) {
+        TRACE_EVENT0(TraceEventCategory::kDefault, "BuddyMemoryAllocator.TryAllocateMemoryBatch");
+
+        std::vector<std::unique_ptr<MemoryAllocation>> allocations(count);
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        for (uint64_t i = 0; i < count; i++) {
+            allocations[i] = TryAllocateMemoryInternal(requests[i]);
+        }
+
+        return allocations;
+    }
+
+    std::unique_ptr<MemoryAllocation> BuddyMemoryAllocator::TryAllocateMemoryInternal(
+        const MemoryAllocationRequest& request) {
         GPGMM_INVALID_IF(!ValidateRequest(request));
 
         // Round allocation size to nearest power-of-two.
@@ -56,12 +76,21 @@ namespace gpgmm {
         GPGMM_INVALID_IF(allocationSize > mMemorySize);
 
         // Attempt to sub-allocate a block of the requested size.
+        MemoryBlock* block = nullptr;
+        if (request.GroupKey != kNoGroupKey) {
+            GPGMM_TRY_ASSIGN(
+                TryAllocateBlockInGroup(allocationSize, request.Alignment, request.GroupKey),
+                block);
+        } else {
+            GPGMM_TRY_ASSIGN(
+                mBuddyBlockAllocator.TryAllocateBlock(allocationSize, request.Alignment), block);
+        }
+
         std::unique_ptr<MemoryAllocation> subAllocation;
         GPGMM_TRY_ASSIGN(TrySubAllocateMemory(
-                             &mBuddyBlockAllocator, allocationSize, request.Alignment,
-                             request.NeverAllocate,
-                             [&](const auto& block) -> IMemoryObject* {
-                                 const uint64_t memoryIndex = GetMemoryIndex(block->Offset);
+                             &mBuddyBlockAllocator, block, request.NeverAllocate,
+                             [&](const auto& newBlock) -> IMemoryObject* {
+                                 const uint64_t memoryIndex = GetMemoryIndex(newBlock->Offset);
                                  MemoryAllocation memoryAllocation =
                                      mUsedPool.AcquireFromPool(memoryIndex);
 
@@ -76,6 +105,9 @@ namespace gpgmm {
                                          GetNextInChain()->TryAllocateMemory(newRequest),
                                          memoryAllocationPtr);
                                      memoryAllocation = *memoryAllocationPtr;
+
+                                     // New memory is free until sub-allocated.
+                                     mStats.ExternalFragmentationUsage += mMemorySize;
                                  }
 
                                  IMemoryObject* memory = memoryAllocation.GetMemory();
@@ -85,27 +117,86 @@ namespace gpgmm {
                              }),
                          subAllocation);
 
-        MemoryBlock* block = subAllocation->GetBlock();
+        ASSERT(subAllocation->GetBlock() == block);
+        block->RequestSize = request.SizeInBytes;
+        block->GroupKey = request.GroupKey;
+
+        if (request.GroupKey != kNoGroupKey) {
+            // Claim the memory for the group unless another group already did.
+            const uint64_t memoryIndex = GetMemoryIndex(block->Offset);
+            auto it = mMemoryGroupKeys.emplace(memoryIndex, request.GroupKey).first;
+            if (it->second == request.GroupKey) {
+                mGroupMemoryIndices[request.GroupKey] = memoryIndex;
+            }
+            mGroupTracker.AddAllocation(request.GroupKey, subAllocation->GetMemory());
+        }
+
         mStats.UsedBlockCount++;
         mStats.UsedBlockUsage += block->Size;
+        mStats.InternalFragmentationUsage += block->Size - block->RequestSize;
+        mStats.ExternalFragmentationUsage -= block->Size;
 
         // Memory allocation offset is always memory-relative.
         const uint64_t memoryOffset = block->Offset % mMemorySize;
 
-        return std::make_unique<MemoryAllocation>(/*allocator*/ this, subAllocation->GetMemory(),
-                                                  memoryOffset, AllocationMethod::kSubAllocated,
-                                                  block, request.SizeInBytes);
+        // Re-use the sub-allocation instead of creating another MemoryAllocation.
+        *subAllocation =
+            MemoryAllocation(/*allocator*/ this, subAllocation->GetMemory(), memoryOffset,
+                             AllocationMethod::kSubAllocated, block, request.SizeInBytes);
+        return subAllocation;
+    }
+
+    MemoryBlock* BuddyMemoryAllocator::TryAllocateBlockInGroup(uint64_t allocationSize,
+                                                               uint64_t alignment,
+                                                               uint64_t groupKey) {
+        // Prefer the memory last used by the group, if it has room.
+        auto it = mGroupMemoryIndices.find(groupKey);
+        if (it != mGroupMemoryIndices.end()) {
+            MemoryBlock* block = mBuddyBlockAllocator.TryAllocateBlockInRange(
+                allocationSize, alignment, it->second * mMemorySize, mMemorySize);
+            if (block != nullptr) {
+                return block;
+            }
+        }
+
+        // Otherwise, use the lowest free block, even in the memory of another group, rather than
+        // create memory only to keep groups apart.
+        return mBuddyBlockAllocator.TryAllocateBlock(allocationSize, alignment);
     }
 
     void BuddyMemoryAllocator::DeallocateMemory(std::unique_ptr<MemoryAllocation> subAllocation) {
+        TRACE_EVENT0(TraceEventCategory::kDefault, "BuddyMemoryAllocator.DeallocateMemory");
+
         std::lock_guard<std::mutex> lock(mMutex);
 
-        TRACE_EVENT0(TraceEventCategory::kDefault, "BuddyMemoryAllocator.DeallocateMemory");
+        DeallocateMemoryInternal(std::move(subAllocation));
+    }
 
+    void BuddyMemoryAllocator::DeallocateMemoryBatch(
+        std::vector<std::unique_ptr<MemoryAllocation>> allocations) {
+        TRACE_EVENT0(TraceEventCategory::kDefault, "BuddyMemoryAllocator.DeallocateMemoryBatch");
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        for (auto& allocation : allocations) {
+            if (allocation != nullptr) {
+                DeallocateMemoryInternal(std::move(allocation));
+            }
+        }
+    }
+
+    void BuddyMemoryAllocator::DeallocateMemoryInternal(
+        std::unique_ptr<MemoryAllocation> subAllocation) {
         ASSERT(subAllocation != nullptr);
 
+        const MemoryBlock* block = subAllocation->GetBlock();
+        if (block->GroupKey != kNoGroupKey) {
+            mGroupTracker.RemoveAllocation(block->GroupKey, subAllocation->GetMemory());
+        }
+
         mStats.UsedBlockCount--;
-        mStats.UsedBlockUsage -= subAllocation->GetSize();
+        mStats.UsedBlockUsage -= block->Size;
+        mStats.InternalFragmentationUsage -= block->Size - block->RequestSize;
+        mStats.ExternalFragmentationUsage += block->Size;
 
         const uint64_t memoryIndex = GetMemoryIndex(subAllocation->GetBlock()->Offset);
 
@@ -117,6 +208,18 @@ namespace gpgmm {
         ASSERT(memory != nullptr);
 
         if (memory->RemoveSubAllocationRef()) {
+            mStats.ExternalFragmentationUsage -= mMemorySize;
+
+            // The group can no longer prefer the released memory.
+            auto it = mMemoryGroupKeys.find(memoryIndex);
+            if (it != mMemoryGroupKeys.end()) {
+                auto groupIt = mGroupMemoryIndices.find(it->second);
+                if (groupIt != mGroupMemoryIndices.end() && groupIt->second == memoryIndex) {
+                    mGroupMemoryIndices.erase(groupIt);
+                }
+                mMemoryGroupKeys.erase(it);
+            }
+
             GetNextInChain()->DeallocateMemory(
                 std::make_unique<MemoryAllocation>(memoryAllocation));
         } else {
@@ -140,6 +243,12 @@ namespace gpgmm {
         result.UsedMemoryCount = memoryInfo.UsedMemoryCount;
         result.UsedMemoryUsage = memoryInfo.UsedMemoryUsage;
         result.FreeMemoryUsage = memoryInfo.FreeMemoryUsage;
+
+        // A free block as large as the memory would have released it.
+        result.LargestFreeBlockSize = mBuddyBlockAllocator.GetLargestFreeBlockSize(mMemorySize / 2);
+
+        result.GroupCount = mGroupTracker.GetGroupCount();
+        result.GroupMemoryCount = mGroupTracker.GetGroupMemoryCount();
         return result;
     }
 
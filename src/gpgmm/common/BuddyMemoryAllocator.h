@@ -19,8 +19,10 @@
 #include "gpgmm/common/BuddyBlockAllocator.h"
 #include "gpgmm/common/IndexedMemoryPool.h"
 #include "gpgmm/common/MemoryAllocator.h"
+#include "gpgmm/common/MemoryGroup.h"
 
 #include <memory>
+#include <unordered_map>
 
 namespace gpgmm {
 
@@ -33,6 +35,10 @@ namespace gpgmm {
     // same memory index, the memory refcount is incremented to ensure de-allocating one doesn't
     // release the other prematurely.
     //
+    // Allocations of the same group are sub-allocated from the memory last used by the group,
+    // if it has room, so they are spread across fewer memory objects. Otherwise, they are
+    // sub-allocated like any other allocation.
+    //
     // The MemoryAllocator should return ResourceHeaps that are all compatible with each other.
     // It should also outlive all the resources that are in the buddy allocator.
     class BuddyMemoryAllocator final : public MemoryAllocator {
@@ -46,6 +52,11 @@ namespace gpgmm {
         std::unique_ptr<MemoryAllocation> TryAllocateMemory(
             const MemoryAllocationRequest& request) override;
         void DeallocateMemory(std::unique_ptr<MemoryAllocation> subAllocation) override;
+        std::vector<std::unique_ptr<MemoryAllocation>> TryAllocateMemoryBatch(
+            const MemoryAllocationRequest* requests,
+            uint64_t count) override;
+        void DeallocateMemoryBatch(
+            std::vector<std::unique_ptr<MemoryAllocation>> allocations) override;
 
         uint64_t GetMemorySize() const override;
         uint64_t GetMemoryAlignment() const override;
@@ -53,6 +64,14 @@ namespace gpgmm {
         const char* GetTypename() const override;
 
       private:
+        // Must be called with |mMutex| held.
+        std::unique_ptr<MemoryAllocation> TryAllocateMemoryInternal(
+            const MemoryAllocationRequest& request);
+        void DeallocateMemoryInternal(std::unique_ptr<MemoryAllocation> subAllocation);
+        MemoryBlock* TryAllocateBlockInGroup(uint64_t allocationSize,
+                                             uint64_t alignment,
+                                             uint64_t groupKey);
+
         uint64_t GetMemoryIndex(uint64_t offset) const;
 
         const uint64_t mMemorySize;
@@ -62,6 +81,11 @@ namespace gpgmm {
 
         // Set of fixed memory allocations containing at-least one sub-allocation.
         IndexedMemoryPool mUsedPool;
+
+        // Index of the memory last claimed by each group and the group claiming each memory.
+        std::unordered_map<uint64_t, uint64_t> mGroupMemoryIndices;
+        std::unordered_map<uint64_t, uint64_t> mMemoryGroupKeys;
+        MemoryGroupTracker mGroupTracker;
     };
 
 }  // namespace gpgmm
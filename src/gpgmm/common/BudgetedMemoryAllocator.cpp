@@ -0,0 +1,101 @@
+// Copyright 2022 The GPGMM Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gpgmm/common/BudgetedMemoryAllocator.h"
+
+#include "gpgmm/common/EventMessage.h"
+#include "gpgmm/common/MemoryBudget.h"
+#include "gpgmm/common/TraceEvent.h"
+#include "gpgmm/utils/Math.h"
+
+#include <algorithm>
+
+namespace gpgmm {
+
+    BudgetedMemoryAllocator::BudgetedMemoryAllocator(
+        std::unique_ptr<MemoryAllocator> memoryAllocator,
+        std::shared_ptr<MemoryBudget> budget)
+        : MemoryAllocator(std::move(memoryAllocator)), mBudget(std::move(budget)) {
+        ASSERT(mBudget != nullptr);
+    }
+
+    std::unique_ptr<MemoryAllocation> BudgetedMemoryAllocator::TryAllocateMemory(
+        const MemoryAllocationRequest& request) {
+        TRACE_EVENT0(TraceEventCategory::kDefault, "BudgetedMemoryAllocator.TryAllocateMemory");
+
+        GPGMM_INVALID_IF(!ValidateRequest(request));
+
+        // Reserve before creating memory so concurrent allocators cannot both fit under the
+        // limit. The budget is atomic so |mMutex| is not needed.
+        const uint64_t reservedSize = AlignTo(request.SizeInBytes, request.Alignment);
+        if (!mBudget->TryReserve(reservedSize)) {
+            DebugEvent(GetTypename(), EventMessageId::kBudgetExceeded)
+                << "Requested size exceeds budget (" + std::to_string(reservedSize) +
+                       " bytes with " + std::to_string(mBudget->GetUsage()) + " of " +
+                       std::to_string(mBudget->GetHardLimit()) + " bytes used).";
+            return {};
+        }
+
+        std::unique_ptr<MemoryAllocation> allocation =
+            GetNextInChain()->TryAllocateMemory(request);
+        if (allocation == nullptr) {
+            mBudget->Release(reservedSize);
+            return {};
+        }
+
+        // The created memory could differ in size from the request.
+        const uint64_t memorySize = allocation->GetSize();
+        if (memorySize > reservedSize) {
+            mBudget->Reserve(memorySize - reservedSize);
+        } else if (memorySize < reservedSize) {
+            mBudget->Release(reservedSize - memorySize);
+        }
+
+        // Re-use the allocation instead of creating another MemoryAllocation.
+        *allocation = MemoryAllocation(this, allocation->GetMemory(), allocation->GetOffset(),
+                                       allocation->GetMethod(), allocation->GetBlock(),
+                                       request.SizeInBytes, allocation->GetMappedPointer());
+        return allocation;
+    }
+
+    void BudgetedMemoryAllocator::DeallocateMemory(std::unique_ptr<MemoryAllocation> allocation) {
+        TRACE_EVENT0(TraceEventCategory::kDefault, "BudgetedMemoryAllocator.DeallocateMemory");
+
+        const uint64_t memorySize = allocation->GetSize();
+        GetNextInChain()->DeallocateMemory(std::move(allocation));
+        mBudget->Release(memorySize);
+    }
+
+    MemoryAllocatorStats BudgetedMemoryAllocator::GetStats() const {
+        return GetNextInChain()->GetStats();
+    }
+
+    uint64_t BudgetedMemoryAllocator::GetMemorySize() const {
+        return GetNextInChain()->GetMemorySize();
+    }
+
+    uint64_t BudgetedMemoryAllocator::GetMemoryAlignment() const {
+        return GetNextInChain()->GetMemoryAlignment();
+    }
+
+    uint64_t BudgetedMemoryAllocator::GetAvailableForAllocation() const {
+        return std::min(mBudget->GetAvailableForAllocation(),
+                        GetNextInChain()->GetAvailableForAllocation());
+    }
+
+    const char* BudgetedMemoryAllocator::GetTypename() const {
+        return "BudgetedMemoryAllocator";
+    }
+
+}  // namespace gpgmm
@@ -0,0 +1,51 @@
+// Copyright 2022 The GPGMM Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GPGMM_COMMON_BUDGETEDMEMORYALLOCATOR_H_
+#define GPGMM_COMMON_BUDGETEDMEMORYALLOCATOR_H_
+
+#include "gpgmm/common/MemoryAllocator.h"
+
+namespace gpgmm {
+
+    class MemoryBudget;
+
+    // BudgetedMemoryAllocator reserves memory created by the next allocator from a MemoryBudget.
+    // The same budget can be shared by many allocators, so memory created by one allocator
+    // reduces what the others could create. Allocators above it in the chain can check
+    // GetAvailableForAllocation() to keep their allocations under budget.
+    class BudgetedMemoryAllocator final : public MemoryAllocator {
+      public:
+        BudgetedMemoryAllocator(std::unique_ptr<MemoryAllocator> memoryAllocator,
+                                std::shared_ptr<MemoryBudget> budget);
+
+        // MemoryAllocator interface
+        std::unique_ptr<MemoryAllocation> TryAllocateMemory(
+            const MemoryAllocationRequest& request) override;
+        void DeallocateMemory(std::unique_ptr<MemoryAllocation> allocation) override;
+        uint64_t GetMemorySize() const override;
+        uint64_t GetMemoryAlignment() const override;
+        uint64_t GetAvailableForAllocation() const override;
+
+        MemoryAllocatorStats GetStats() const override;
+
+      private:
+        const char* GetTypename() const override;
+
+        const std::shared_ptr<MemoryBudget> mBudget;
+    };
+
+}  // namespace gpgmm
+
+#endif  // GPGMM_COMMON_BUDGETEDMEMORYALLOCATOR_H_
@@ -17,6 +17,8 @@
 #include "gpgmm/common/TraceEvent.h"
 #include "gpgmm/utils/Assert.h"
 
+#include <algorithm>
+
 namespace gpgmm {
 
     ConditionalMemoryAllocator::ConditionalMemoryAllocator(
@@ -51,6 +53,14 @@ namespace gpgmm {
         return result;
     }
 
+    uint64_t ConditionalMemoryAllocator::GetSizeClassStats(MemorySizeClassStats* pSizeClassStats,
+                                                           uint64_t count) const {
+        const uint64_t firstCount = mFirstAllocator->GetSizeClassStats(pSizeClassStats, count);
+        const uint64_t writtenCount = std::min(firstCount, count);
+        return firstCount + mSecondAllocator->GetSizeClassStats(pSizeClassStats + writtenCount,
+                                                                count - writtenCount);
+    }
+
     const char* ConditionalMemoryAllocator::GetTypename() const {
         return "ConditionalMemoryAllocator";
     }
@@ -35,6 +35,8 @@ namespace gpgmm {
         void DeallocateMemory(std::unique_ptr<MemoryAllocation> allocation) override;
 
         MemoryAllocatorStats GetStats() const override;
+        uint64_t GetSizeClassStats(MemorySizeClassStats* pSizeClassStats,
+                                   uint64_t count) const override;
         const char* GetTypename() const override;
 
         MemoryAllocator* GetFirstAllocatorForTesting() const;
@@ -30,6 +30,27 @@ namespace gpgmm {
 
         std::lock_guard<std::mutex> lock(mMutex);
 
+        return TryAllocateMemoryInternal(request);
+    }
+
+    std::vector<std::unique_ptr<MemoryAllocation>> DedicatedMemoryAllocator::TryAllocateMemoryBatch(
+        const MemoryAllocationRequest* requests,
+        uint64_t count) {
+        TRACE_EVENT0(TraceEventCategory::kDefault,
+                     "DedicatedMemoryAllocator.TryAllocateMemoryBatch");
+
+        std::vector<std::unique_ptr<MemoryAllocation>> allocations(count);
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        for (uint64_t i = 0; i < count; i++) {
+            allocations[i] = TryAllocateMemoryInternal(requests[i]);
+        }
+
+        return allocations;
+    }
+
+    std::unique_ptr<MemoryAllocation> DedicatedMemoryAllocator::TryAllocateMemoryInternal(
+        const MemoryAllocationRequest& request) {
         GPGMM_INVALID_IF(!ValidateRequest(request));
 
         std::unique_ptr<MemoryAllocation> allocation;
@@ -48,6 +69,24 @@ namespace gpgmm {
 
         std::lock_guard<std::mutex> lock(mMutex);
 
+        DeallocateMemoryInternal(std::move(allocation));
+    }
+
+    void DedicatedMemoryAllocator::DeallocateMemoryBatch(
+        std::vector<std::unique_ptr<MemoryAllocation>> allocations) {
+        TRACE_EVENT0(TraceEventCategory::kDefault,
+                     "DedicatedMemoryAllocator.DeallocateMemoryBatch");
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        for (auto& allocation : allocations) {
+            if (allocation != nullptr) {
+                DeallocateMemoryInternal(std::move(allocation));
+            }
+        }
+    }
+
+    void DedicatedMemoryAllocator::DeallocateMemoryInternal(
+        std::unique_ptr<MemoryAllocation> allocation) {
         MemoryBlock* block = allocation->GetBlock();
         mStats.UsedBlockCount--;
         mStats.UsedBlockUsage -= block->Size;
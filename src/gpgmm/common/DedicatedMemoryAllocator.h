@@ -31,11 +31,21 @@ namespace gpgmm {
         std::unique_ptr<MemoryAllocation> TryAllocateMemory(
             const MemoryAllocationRequest& request) override;
         void DeallocateMemory(std::unique_ptr<MemoryAllocation> subAllocation) override;
+        std::vector<std::unique_ptr<MemoryAllocation>> TryAllocateMemoryBatch(
+            const MemoryAllocationRequest* requests,
+            uint64_t count) override;
+        void DeallocateMemoryBatch(
+            std::vector<std::unique_ptr<MemoryAllocation>> allocations) override;
         uint64_t GetMemoryAlignment() const override;
 
         MemoryAllocatorStats GetStats() const override;
 
       private:
+        // Must be called with |mMutex| held.
+        std::unique_ptr<MemoryAllocation> TryAllocateMemoryInternal(
+            const MemoryAllocationRequest& request);
+        void DeallocateMemoryInternal(std::unique_ptr<MemoryAllocation> allocation);
+
         const char* GetTypename() const override;
     };
 
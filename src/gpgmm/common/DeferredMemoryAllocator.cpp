@@ -0,0 +1,198 @@
+// Copyright 2022 The GPGMM Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gpgmm/common/DeferredMemoryAllocator.h"
+
+#include "gpgmm/common/TraceEvent.h"
+#include "gpgmm/utils/Assert.h"
+
+#include <algorithm>
+
+namespace gpgmm {
+
+    DeferredMemoryAllocator::DeferredMemoryAllocator(
+        std::unique_ptr<MemoryAllocator> memoryAllocator)
+        : MemoryAllocator(std::move(memoryAllocator)) {
+    }
+
+    DeferredMemoryAllocator::~DeferredMemoryAllocator() {
+        FlushDeferredFrees();
+    }
+
+    std::unique_ptr<MemoryAllocation> DeferredMemoryAllocator::TryAllocateMemory(
+        const MemoryAllocationRequest& request) {
+        TRACE_EVENT0(TraceEventCategory::kDefault, "DeferredMemoryAllocator.TryAllocateMemory");
+
+        // Reclaim pending frees first so the next allocator can re-use their memory.
+        FlushDeferredFrees();
+
+        std::unique_ptr<MemoryAllocation> allocation;
+        GPGMM_TRY_ASSIGN(GetNextInChain()->TryAllocateMemory(request), allocation);
+
+        // Re-use the allocation instead of creating another MemoryAllocation.
+        *allocation = MemoryAllocation(this, allocation->GetMemory(), allocation->GetOffset(),
+                                       allocation->GetMethod(), allocation->GetBlock(),
+                                       allocation->GetRequestSize(),
+                                       allocation->GetMappedPointer());
+        return allocation;
+    }
+
+    std::vector<std::unique_ptr<MemoryAllocation>> DeferredMemoryAllocator::TryAllocateMemoryBatch(
+        const MemoryAllocationRequest* requests,
+        uint64_t count) {
+        TRACE_EVENT0(TraceEventCategory::kDefault,
+                     "DeferredMemoryAllocator.TryAllocateMemoryBatch");
+
+        FlushDeferredFrees();
+
+        std::vector<std::unique_ptr<MemoryAllocation>> allocations =
+            GetNextInChain()->TryAllocateMemoryBatch(requests, count);
+        for (auto& allocation : allocations) {
+            if (allocation == nullptr) {
+                continue;
+            }
+            *allocation = MemoryAllocation(this, allocation->GetMemory(), allocation->GetOffset(),
+                                           allocation->GetMethod(), allocation->GetBlock(),
+                                           allocation->GetRequestSize(),
+                                           allocation->GetMappedPointer());
+        }
+
+        return allocations;
+    }
+
+    void DeferredMemoryAllocator::DeallocateMemory(std::unique_ptr<MemoryAllocation> allocation) {
+        TRACE_EVENT0(TraceEventCategory::kDefault, "DeferredMemoryAllocator.DeallocateMemory");
+
+        ASSERT(allocation != nullptr);
+
+        const uint64_t allocationSize = allocation->GetSize();
+        MemoryAllocation* deferredFree = CreateDeferredFree(std::move(allocation));
+        PushDeferredFrees(deferredFree, deferredFree, 1, allocationSize);
+    }
+
+    void DeferredMemoryAllocator::DeallocateMemoryBatch(
+        std::vector<std::unique_ptr<MemoryAllocation>> allocations) {
+        TRACE_EVENT0(TraceEventCategory::kDefault,
+                     "DeferredMemoryAllocator.DeallocateMemoryBatch");
+
+        // Link the whole batch first so it is published with a single atomic operation.
+        MemoryAllocation* first = nullptr;
+        MemoryAllocation* last = nullptr;
+        uint64_t count = 0;
+        uint64_t usage = 0;
+        for (auto& allocation : allocations) {
+            if (allocation == nullptr) {
+                continue;
+            }
+
+            usage += allocation->GetSize();
+            count++;
+
+            MemoryAllocation* deferredFree = CreateDeferredFree(std::move(allocation));
+            deferredFree->mNextDeferredFree = first;
+            first = deferredFree;
+            if (last == nullptr) {
+                last = deferredFree;
+            }
+        }
+
+        if (first != nullptr) {
+            PushDeferredFrees(first, last, count, usage);
+        }
+    }
+
+    MemoryAllocation* DeferredMemoryAllocator::CreateDeferredFree(
+        std::unique_ptr<MemoryAllocation> allocation) const {
+        // Pending frees are kept as allocations of the next allocator so they can be returned
+        // as-is.
+        *allocation = MemoryAllocation(GetNextInChain(), allocation->GetMemory(),
+                                       allocation->GetOffset(), allocation->GetMethod(),
+                                       allocation->GetBlock(), allocation->GetRequestSize(),
+                                       allocation->GetMappedPointer());
+        return allocation.release();
+    }
+
+    void DeferredMemoryAllocator::PushDeferredFrees(MemoryAllocation* first,
+                                                    MemoryAllocation* last,
+                                                    uint64_t count,
+                                                    uint64_t usage) {
+        // Counted before publishing so a concurrent flush never observes more frees than pending.
+        mPendingFreeCount.fetch_add(count, std::memory_order_relaxed);
+        mPendingFreeUsage.fetch_add(usage, std::memory_order_relaxed);
+
+        MemoryAllocation* head = mDeferredFrees.load(std::memory_order_relaxed);
+        do {
+            last->mNextDeferredFree = head;
+        } while (!mDeferredFrees.compare_exchange_weak(head, first, std::memory_order_release,
+                                                       std::memory_order_relaxed));
+    }
+
+    uint64_t DeferredMemoryAllocator::FlushDeferredFrees() {
+        // Fast path: nothing is pending.
+        if (mDeferredFrees.load(std::memory_order_relaxed) == nullptr) {
+            return 0;
+        }
+
+        TRACE_EVENT0(TraceEventCategory::kDefault, "DeferredMemoryAllocator.FlushDeferredFrees");
+
+        // Take every pending free at once. Since the list is never popped one at a time,
+        // concurrent flushes take disjoint lists and cannot suffer from ABA.
+        MemoryAllocation* head = mDeferredFrees.exchange(nullptr, std::memory_order_acquire);
+
+        // Reverse the list so memory is de-allocated in the order it was freed.
+        std::vector<std::unique_ptr<MemoryAllocation>> allocations;
+        uint64_t usage = 0;
+        while (head != nullptr) {
+            MemoryAllocation* next = head->mNextDeferredFree;
+            head->mNextDeferredFree = nullptr;
+            usage += head->GetSize();
+            allocations.emplace_back(head);
+            head = next;
+        }
+        std::reverse(allocations.begin(), allocations.end());
+
+        const uint64_t count = allocations.size();
+        GetNextInChain()->DeallocateMemoryBatch(std::move(allocations));
+
+        mPendingFreeCount.fetch_sub(count, std::memory_order_relaxed);
+        mPendingFreeUsage.fetch_sub(usage, std::memory_order_relaxed);
+
+        return count;
+    }
+
+    uint64_t DeferredMemoryAllocator::ReleaseMemory(uint64_t bytesToRelease) {
+        FlushDeferredFrees();
+        return GetNextInChain()->ReleaseMemory(bytesToRelease);
+    }
+
+    uint64_t DeferredMemoryAllocator::GetMemorySize() const {
+        return GetNextInChain()->GetMemorySize();
+    }
+
+    uint64_t DeferredMemoryAllocator::GetMemoryAlignment() const {
+        return GetNextInChain()->GetMemoryAlignment();
+    }
+
+    MemoryAllocatorStats DeferredMemoryAllocator::GetStats() const {
+        MemoryAllocatorStats result = GetNextInChain()->GetStats();
+        result.PendingFreeCount = mPendingFreeCount.load(std::memory_order_relaxed);
+        result.PendingFreeUsage = mPendingFreeUsage.load(std::memory_order_relaxed);
+        return result;
+    }
+
+    const char* DeferredMemoryAllocator::GetTypename() const {
+        return "DeferredMemoryAllocator";
+    }
+
+}  // namespace gpgmm
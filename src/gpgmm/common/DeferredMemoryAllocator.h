@@ -0,0 +1,81 @@
+// Copyright 2022 The GPGMM Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GPGMM_COMMON_DEFERREDMEMORYALLOCATOR_H_
+#define GPGMM_COMMON_DEFERREDMEMORYALLOCATOR_H_
+
+#include "gpgmm/common/MemoryAllocator.h"
+
+#include <atomic>
+
+namespace gpgmm {
+
+    // DeferredMemoryAllocator defers de-allocations so threads that only free memory (eg. upon
+    // fence retirement) never contend with the allocating thread on the next allocator's locks.
+    //
+    // De-allocated allocations are pushed onto a lock-free, multiple-producer single-consumer
+    // queue, linked through the allocations themselves. Pending frees are then de-allocated in
+    // bulk, in the order they were freed, by the next allocation or by an explicit call to
+    // FlushDeferredFrees().
+    //
+    // Pending frees still hold memory, so they remain counted as used and are also reported by
+    // PendingFreeCount and PendingFreeUsage.
+    class DeferredMemoryAllocator final : public MemoryAllocator {
+      public:
+        explicit DeferredMemoryAllocator(std::unique_ptr<MemoryAllocator> memoryAllocator);
+        ~DeferredMemoryAllocator() override;
+
+        // MemoryAllocator interface
+        std::unique_ptr<MemoryAllocation> TryAllocateMemory(
+            const MemoryAllocationRequest& request) override;
+        void DeallocateMemory(std::unique_ptr<MemoryAllocation> allocation) override;
+        std::vector<std::unique_ptr<MemoryAllocation>> TryAllocateMemoryBatch(
+            const MemoryAllocationRequest* requests,
+            uint64_t count) override;
+        void DeallocateMemoryBatch(
+            std::vector<std::unique_ptr<MemoryAllocation>> allocations) override;
+        uint64_t ReleaseMemory(uint64_t bytesToRelease = kInvalidSize) override;
+
+        uint64_t GetMemorySize() const override;
+        uint64_t GetMemoryAlignment() const override;
+
+        MemoryAllocatorStats GetStats() const override;
+
+        const char* GetTypename() const override;
+
+        // De-allocates every pending free. Safe to call from any thread.
+        // Returns the number of allocations de-allocated.
+        uint64_t FlushDeferredFrees();
+
+      private:
+        // Converts an allocation of |this| allocator into a pending free, owned by the pending
+        // frees once pushed.
+        MemoryAllocation* CreateDeferredFree(std::unique_ptr<MemoryAllocation> allocation) const;
+
+        // Atomically prepends the list [first, last] to the pending frees.
+        void PushDeferredFrees(MemoryAllocation* first,
+                               MemoryAllocation* last,
+                               uint64_t count,
+                               uint64_t usage);
+
+        // Head of the pending frees, most recently freed first.
+        std::atomic<MemoryAllocation*> mDeferredFrees{nullptr};
+
+        std::atomic<uint64_t> mPendingFreeCount{0};
+        std::atomic<uint64_t> mPendingFreeUsage{0};
+    };
+
+}  // namespace gpgmm
+
+#endif  // GPGMM_COMMON_DEFERREDMEMORYALLOCATOR_H_
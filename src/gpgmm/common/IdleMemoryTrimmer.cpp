@@ -0,0 +1,145 @@
+// Copyright 2022 The GPGMM Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "gpgmm/common/IdleMemoryTrimmer.h"
+
+#include "gpgmm/common/SizeClass.h"
+#include "gpgmm/common/TraceEvent.h"
+#include "gpgmm/common/WorkerThread.h"
+#include "gpgmm/utils/Assert.h"
+
+namespace gpgmm {
+
+    static constexpr const char* kIdleTrimWorkerThreadName = "GPGMM_ThreadIdleTrimWorker";
+
+    // Checks the allocator for idleness and runs the next step of the pass, if any, before
+    // scheduling itself again.
+    class IdleMemoryTrimmer::TrimMemoryTask : public VoidCallback {
+      public:
+        TrimMemoryTask(std::weak_ptr<ThreadPool> threadPool, std::shared_ptr<TrimState> state)
+            : mThreadPool(threadPool), mState(state) {
+        }
+
+        static void Post(std::weak_ptr<ThreadPool> threadPool,
+                         std::shared_ptr<TrimState> state,
+                         Clock::duration delay) {
+            // The pool is only referenced weakly since it holds on to the task until due.
+            std::shared_ptr<ThreadPool> pool = threadPool.lock();
+            if (pool == nullptr) {
+                return;
+            }
+            ThreadPool::PostDelayedTask(pool, std::make_shared<TrimMemoryTask>(threadPool, state),
+                                        kIdleTrimWorkerThreadName, delay, TaskPriority::kLow);
+        }
+
+        void operator()() override {
+            Clock::duration nextDelay = {};
+            {
+                std::lock_guard<std::mutex> lock(mState->Mutex);
+                if (mState->IsShutdown) {
+                    return;
+                }
+                nextDelay = RunStep();
+            }
+            Post(mThreadPool, mState, nextDelay);
+        }
+
+      private:
+        // Returns the time to wait before the next step.
+        Clock::duration RunStep() {
+            const IdleMemoryTrimPolicy& policy = mState->Policy;
+
+            // Pairs with the release store of RecordActivity().
+            const Clock::rep lastActivity =
+                mState->LastActivityTime.load(std::memory_order_acquire);
+            const Clock::time_point idleTime =
+                Clock::time_point(Clock::duration(lastActivity)) + policy.IdleInterval;
+            const Clock::time_point now = Clock::now();
+            if (now < idleTime) {
+                return idleTime - now;
+            }
+
+            if (!mState->IsPassStarted || mState->PassActivityTime != lastActivity) {
+                mState->IsPassStarted = true;
+                mState->IsPassDone = false;
+                mState->PassActivityTime = lastActivity;
+
+                const uint64_t trimPassCount = ++mState->TrimPassCount;
+                GPGMM_TRACE_EVENT_METRIC("GPU idle trim passes", trimPassCount);
+            } else if (mState->IsPassDone) {
+                // Nothing was allocated since the pass completed, so check again later.
+                return policy.IdleInterval;
+            }
+
+            TRACE_EVENT0(TraceEventCategory::kDefault, "IdleMemoryTrimmer.TrimMemory");
+
+            const uint64_t bytesReleased = mState->Allocator->ReleaseMemory(policy.MaxBytesPerStep);
+            mState->BytesReleased += bytesReleased;
+
+            GPGMM_TRACE_EVENT_METRIC("GPU idle trimmed (KB)", GPGMM_BYTES_TO_KB(bytesReleased));
+
+            // Releasing less than requested means nothing else was left to release.
+            if (bytesReleased < policy.MaxBytesPerStep) {
+                mState->IsPassDone = true;
+                return policy.IdleInterval;
+            }
+
+            return policy.StepInterval;
+        }
+
+        const std::weak_ptr<ThreadPool> mThreadPool;
+        const std::shared_ptr<TrimState> mState;
+    };
+
+    // IdleMemoryTrimmer::TrimState
+
+    IdleMemoryTrimmer::TrimState::TrimState(MemoryAllocator* allocator,
+                                            const IdleMemoryTrimPolicy& policy)
+        : Allocator(allocator),
+          Policy(policy),
+          LastActivityTime(Clock::now().time_since_epoch().count()) {
+    }
+
+    // IdleMemoryTrimmer
+
+    IdleMemoryTrimmer::IdleMemoryTrimmer(MemoryAllocator* allocator,
+                                         const IdleMemoryTrimPolicy& policy)
+        : mThreadPool(ThreadPool::GetOrCreateShared()),
+          mState(std::make_shared<TrimState>(allocator, policy)) {
+        ASSERT(allocator != nullptr);
+        ASSERT(policy.MaxBytesPerStep > 0);
+        TrimMemoryTask::Post(mThreadPool, mState, policy.IdleInterval);
+    }
+
+    IdleMemoryTrimmer::~IdleMemoryTrimmer() {
+        // The task already scheduled, if any, becomes a no-op.
+        std::lock_guard<std::mutex> lock(mState->Mutex);
+        mState->IsShutdown = true;
+    }
+
+    void IdleMemoryTrimmer::RecordActivity() {
+        mState->LastActivityTime.store(Clock::now().time_since_epoch().count(),
+                                       std::memory_order_release);
+    }
+
+    uint64_t IdleMemoryTrimmer::GetTrimPassCount() const {
+        return mState->TrimPassCount.load();
+    }
+
+    uint64_t IdleMemoryTrimmer::GetBytesReleased() const {
+        return mState->BytesReleased.load();
+    }
+
+}  // namespace gpgmm
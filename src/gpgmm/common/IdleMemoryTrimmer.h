@@ -0,0 +1,97 @@
+// Copyright 2022 The GPGMM Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef GPGMM_COMMON_IDLEMEMORYTRIMMER_H_
+#define GPGMM_COMMON_IDLEMEMORYTRIMMER_H_
+
+#include "gpgmm/common/MemoryAllocator.h"
+#include "gpgmm/common/WorkerThread.h"
+#include "gpgmm/utils/NonCopyable.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+namespace gpgmm {
+
+    struct IdleMemoryTrimPolicy {
+        // Time without allocation activity before memory starts getting released.
+        std::chrono::steady_clock::duration IdleInterval = std::chrono::seconds(1);
+
+        // Max. amount of memory released at once, so a step never stalls the allocator for long.
+        uint64_t MaxBytesPerStep = 4ull * 1024 * 1024;
+
+        // Time between steps of the same pass.
+        std::chrono::steady_clock::duration StepInterval = std::chrono::milliseconds(10);
+    };
+
+    // IdleMemoryTrimmer releases the memory an allocator retains once the allocator goes idle.
+    // Allocation activity must be reported through RecordActivity(). After no activity was
+    // reported for the idle interval, a trim pass releases memory in bounded steps, each run as a
+    // delayed task on the shared worker pool, until nothing is left to release or activity
+    // resumes.
+    class IdleMemoryTrimmer : public NonCopyable {
+      public:
+        IdleMemoryTrimmer(MemoryAllocator* allocator, const IdleMemoryTrimPolicy& policy);
+
+        // Stops trimming, after the step in progress, if any, completes.
+        ~IdleMemoryTrimmer();
+
+        // Marks the allocator busy. Cheap enough to be called on every allocation.
+        void RecordActivity();
+
+        // Number of passes started since creation.
+        uint64_t GetTrimPassCount() const;
+
+        // Total amount of memory released since creation.
+        uint64_t GetBytesReleased() const;
+
+      private:
+        class TrimMemoryTask;
+
+        using Clock = std::chrono::steady_clock;
+
+        // Shared with the scheduled task, which could only run after the trimmer was destroyed.
+        struct TrimState {
+            TrimState(MemoryAllocator* allocator, const IdleMemoryTrimPolicy& policy);
+
+            MemoryAllocator* const Allocator;
+            const IdleMemoryTrimPolicy Policy;
+
+            std::atomic<Clock::rep> LastActivityTime;
+
+            std::atomic<uint64_t> TrimPassCount = {0};
+            std::atomic<uint64_t> BytesReleased = {0};
+
+            // Held while trimming so the allocator is never trimmed once shutdown. Guards the
+            // members below.
+            std::mutex Mutex;
+            bool IsShutdown = false;
+
+            // Time of the last activity the current, or last, pass started after.
+            Clock::rep PassActivityTime = 0;
+            bool IsPassStarted = false;
+            bool IsPassDone = false;
+        };
+
+        std::shared_ptr<ThreadPool> mThreadPool;
+        std::shared_ptr<TrimState> mState;
+    };
+
+}  // namespace gpgmm
+
+#endif  // GPGMM_COMMON_IDLEMEMORYTRIMMER_H_
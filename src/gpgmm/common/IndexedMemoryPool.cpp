@@ -17,6 +17,8 @@
 #include "gpgmm/common/MemoryAllocator.h"
 #include "gpgmm/common/TraceEvent.h"
 
+#include <algorithm>
+
 namespace gpgmm {
 
     IndexedMemoryPool::IndexedMemoryPool(uint64_t memorySize) : MemoryPoolBase(memorySize) {
@@ -26,7 +28,7 @@ namespace gpgmm {
         if (indexInPool >= mPool.size()) {
             mPool.resize(indexInPool + 1);
         }
-        MemoryAllocation tmp = mPool[indexInPool];
+        MemoryAllocation tmp = mPool[indexInPool].Allocation;
         mPool[indexInPool] = {};  // invalidate it
         return tmp;
     }
@@ -34,17 +36,60 @@ namespace gpgmm {
     void IndexedMemoryPool::ReturnToPool(MemoryAllocation allocation, uint64_t indexInPool) {
         ASSERT(indexInPool < mPool.size());
         ASSERT(allocation.GetSize() == GetMemorySize());
-        mPool[indexInPool] = std::move(allocation);
+        mPool[indexInPool] = {std::move(allocation), std::chrono::steady_clock::now()};
     }
 
     uint64_t IndexedMemoryPool::ReleasePool(uint64_t bytesToRelease) {
-        return TrimPoolUntil(mPool, bytesToRelease);
+        // Release the least recently used memory first.
+        std::vector<PooledMemory*> pooledMemories;
+        for (PooledMemory& pooledMemory : mPool) {
+            if (pooledMemory.Allocation != GPGMM_ERROR_INVALID_ALLOCATION) {
+                pooledMemories.push_back(&pooledMemory);
+            }
+        }
+
+        std::sort(pooledMemories.begin(), pooledMemories.end(),
+                  [](const PooledMemory* lhs, const PooledMemory* rhs) {
+                      return lhs->LastUsedTime < rhs->LastUsedTime;
+                  });
+
+        uint64_t totalBytesReleased = 0;
+        for (PooledMemory* pooledMemory : pooledMemories) {
+            if (totalBytesReleased >= bytesToRelease) {
+                break;
+            }
+            totalBytesReleased += DeallocatePooledMemory(*pooledMemory);
+        }
+        return totalBytesReleased;
+    }
+
+    uint64_t IndexedMemoryPool::ReleasePoolOlderThan(
+        std::chrono::steady_clock::time_point lastUsedTime) {
+        uint64_t totalBytesReleased = 0;
+        for (PooledMemory& pooledMemory : mPool) {
+            if (pooledMemory.Allocation != GPGMM_ERROR_INVALID_ALLOCATION &&
+                pooledMemory.LastUsedTime < lastUsedTime) {
+                totalBytesReleased += DeallocatePooledMemory(pooledMemory);
+            }
+        }
+        return totalBytesReleased;
+    }
+
+    std::chrono::steady_clock::time_point IndexedMemoryPool::GetLeastRecentlyUsedTime() const {
+        std::chrono::steady_clock::time_point leastRecentlyUsedTime =
+            std::chrono::steady_clock::time_point::max();
+        for (const PooledMemory& pooledMemory : mPool) {
+            if (pooledMemory.Allocation != GPGMM_ERROR_INVALID_ALLOCATION) {
+                leastRecentlyUsedTime = std::min(leastRecentlyUsedTime, pooledMemory.LastUsedTime);
+            }
+        }
+        return leastRecentlyUsedTime;
     }
 
     uint64_t IndexedMemoryPool::GetPoolSize() const {
         uint64_t count = 0;
-        for (auto& allocation : mPool) {
-            if (allocation != GPGMM_ERROR_INVALID_ALLOCATION) {
+        for (const PooledMemory& pooledMemory : mPool) {
+            if (pooledMemory.Allocation != GPGMM_ERROR_INVALID_ALLOCATION) {
                 count++;
             }
         }
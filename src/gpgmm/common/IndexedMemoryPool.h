@@ -30,11 +30,15 @@ namespace gpgmm {
         MemoryAllocation AcquireFromPool(uint64_t indexInPool) override;
         void ReturnToPool(MemoryAllocation allocation, uint64_t indexInPool) override;
         uint64_t ReleasePool(uint64_t bytesToRelease) override;
+        uint64_t ReleasePoolOlderThan(std::chrono::steady_clock::time_point lastUsedTime) override;
+        std::chrono::steady_clock::time_point GetLeastRecentlyUsedTime() const override;
 
         uint64_t GetPoolSize() const override;
 
       private:
-        std::vector<MemoryAllocation> mPool;
+        // Released memory allocations are invalidated, instead of removed, so indexes remain
+        // unchanged.
+        std::vector<PooledMemory> mPool;
     };
 
 }  // namespace gpgmm
@@ -49,6 +49,15 @@ namespace gpgmm {
         dict.AddItem("UsedBlockUsage", info.UsedBlockUsage);
         dict.AddItem("FreeMemoryUsage", info.FreeMemoryUsage);
         dict.AddItem("UsedMemoryUsage", info.UsedMemoryUsage);
+        dict.AddItem("PendingFreeCount", info.PendingFreeCount);
+        dict.AddItem("PendingFreeUsage", info.PendingFreeUsage);
+        dict.AddItem("InternalFragmentationUsage", info.InternalFragmentationUsage);
+        dict.AddItem("ExternalFragmentationUsage", info.ExternalFragmentationUsage);
+        dict.AddItem("LargestFreeBlockSize", info.LargestFreeBlockSize);
+        if (info.GroupCount > 0) {
+            dict.AddItem("GroupCount", info.GroupCount);
+            dict.AddItem("GroupMemoryCount", info.GroupMemoryCount);
+        }
         return dict;
     }
 
@@ -61,6 +70,7 @@ namespace gpgmm {
         dict.AddItem("AlwaysCacheSize", desc.AlwaysCacheSize);
         dict.AddItem("AlwaysPrefetch", desc.AlwaysPrefetch);
         dict.AddItem("AvailableForAllocation", desc.AvailableForAllocation);
+        dict.AddItem("GroupKey", desc.GroupKey);
         return dict;
     }
 
@@ -29,7 +29,7 @@ namespace gpgmm {
 
         MemoryAllocation allocation = {};
         if (!mPool.empty()) {
-            allocation = std::move(mPool.front());
+            allocation = std::move(mPool.front().Allocation);
             mPool.pop_front();
         }
         return allocation;
@@ -39,11 +39,33 @@ namespace gpgmm {
         ASSERT(indexInPool == kInvalidIndex);
         ASSERT(allocation.GetSize() == GetMemorySize());
 
-        mPool.push_front(std::move(allocation));
+        mPool.push_front({std::move(allocation), std::chrono::steady_clock::now()});
     }
 
     uint64_t LIFOMemoryPool::ReleasePool(uint64_t bytesToRelease) {
-        return TrimPoolUntil(mPool, bytesToRelease);
+        uint64_t totalBytesReleased = 0;
+        while (!mPool.empty() && totalBytesReleased < bytesToRelease) {
+            totalBytesReleased += DeallocatePooledMemory(mPool.back());
+            mPool.pop_back();
+        }
+        return totalBytesReleased;
+    }
+
+    uint64_t LIFOMemoryPool::ReleasePoolOlderThan(
+        std::chrono::steady_clock::time_point lastUsedTime) {
+        uint64_t totalBytesReleased = 0;
+        while (!mPool.empty() && mPool.back().LastUsedTime < lastUsedTime) {
+            totalBytesReleased += DeallocatePooledMemory(mPool.back());
+            mPool.pop_back();
+        }
+        return totalBytesReleased;
+    }
+
+    std::chrono::steady_clock::time_point LIFOMemoryPool::GetLeastRecentlyUsedTime() const {
+        if (mPool.empty()) {
+            return std::chrono::steady_clock::time_point::max();
+        }
+        return mPool.back().LastUsedTime;
     }
 
     uint64_t LIFOMemoryPool::GetPoolSize() const {
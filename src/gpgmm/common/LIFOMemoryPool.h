@@ -21,7 +21,7 @@
 
 namespace gpgmm {
 
-    // Pool using LIFO (newest are recycled first).
+    // Pool using LIFO (newest are recycled first, oldest are released first).
     class LIFOMemoryPool : public MemoryPoolBase {
       public:
         explicit LIFOMemoryPool(uint64_t memorySize);
@@ -32,11 +32,14 @@ namespace gpgmm {
         void ReturnToPool(MemoryAllocation allocation,
                           uint64_t indexInPool = kInvalidIndex) override;
         uint64_t ReleasePool(uint64_t bytesToFree = kInvalidSize) override;
+        uint64_t ReleasePoolOlderThan(std::chrono::steady_clock::time_point lastUsedTime) override;
+        std::chrono::steady_clock::time_point GetLeastRecentlyUsedTime() const override;
 
         uint64_t GetPoolSize() const override;
 
       private:
-        std::deque<MemoryAllocation> mPool;
+        // Ordered from most to least recently used.
+        std::deque<PooledMemory> mPool;
     };
 
 }  // namespace gpgmm
@@ -0,0 +1,470 @@
+// Copyright 2022 The GPGMM Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gpgmm/common/MagazineMemoryAllocator.h"
+
+#include "gpgmm/common/TraceEvent.h"
+#include "gpgmm/utils/Math.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+
+namespace gpgmm {
+
+    // Maximum number of full magazines, per size, the depot may hold before draining them back to
+    // the next allocator. Otherwise, a burst of de-allocations could keep blocks cached forever.
+    static constexpr uint64_t kMaxFullMagazinesInDepot = 4u;
+
+    // Number of allocators a thread can find its thread cache of without a hash lookup.
+    static constexpr uint64_t kThreadCacheSlotCount = 16u;
+
+    namespace {
+
+        // Zero is reserved for unused thread cache slots.
+        uint64_t GenerateAllocatorID() {
+            static std::atomic<uint64_t> nextAllocatorID{1};
+            return nextAllocatorID++;
+        }
+
+    }  // namespace
+
+    struct MagazineMemoryAllocator::ThreadCacheSlots {
+        struct Slot {
+            uint64_t AllocatorID = 0;
+            ThreadCache* Cache = nullptr;
+        };
+
+        ~ThreadCacheSlots() {
+            for (auto& entry : ThreadCaches) {
+                std::shared_ptr<ThreadCache> threadCache = entry.second.Owner.lock();
+                if (threadCache == nullptr) {
+                    continue;
+                }
+
+                // The allocator cannot finish being destroyed while the thread cache is locked.
+                std::lock_guard<std::mutex> lock(threadCache->Mutex);
+                if (threadCache->Allocator != nullptr) {
+                    threadCache->Allocator->ReturnThreadCache(threadCache.get());
+                }
+            }
+        }
+
+        // Direct-mapped by allocator ID. Since IDs are never re-used, a matching slot always
+        // belongs to a live allocator.
+        std::array<Slot, kThreadCacheSlotCount> Slots;
+
+        // Every thread cache of the thread, including those evicted from a slot.
+        std::unordered_map<uint64_t, ThreadCacheRef> ThreadCaches;
+    };
+
+    MagazineMemoryAllocator::MagazineMemoryAllocator(
+        uint64_t magazineSize,
+        std::unique_ptr<SlabCacheAllocator> slabCacheAllocator)
+        : MemoryAllocator(std::move(slabCacheAllocator)),
+          mMagazineSize(magazineSize),
+          mAllocatorID(GenerateAllocatorID()),
+          mSlabCacheAllocator(static_cast<SlabCacheAllocator*>(GetNextInChain())) {
+        ASSERT(mMagazineSize > 0);
+    }
+
+    MagazineMemoryAllocator::~MagazineMemoryAllocator() {
+        // Detach thread caches first so exiting threads no longer return magazines to the depot.
+        std::vector<std::shared_ptr<ThreadCache>> threadCaches;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            threadCaches = mThreadCaches;
+        }
+
+        for (auto& threadCache : threadCaches) {
+            std::lock_guard<std::mutex> lock(threadCache->Mutex);
+            threadCache->Allocator = nullptr;
+        }
+
+        ReleaseMemory();
+    }
+
+    MagazineMemoryAllocator::ThreadCache* MagazineMemoryAllocator::GetOrCreateThreadCache() {
+        static thread_local ThreadCacheSlots threadCacheSlots;
+
+        ThreadCacheSlots::Slot& slot = threadCacheSlots.Slots[mAllocatorID % kThreadCacheSlotCount];
+        if (slot.AllocatorID == mAllocatorID) {
+            return slot.Cache;
+        }
+
+        // Allocator IDs are never re-used, so entries of destroyed allocators are never looked up
+        // again. Since |this| is alive, its entry can be used without checking the owner.
+        std::unordered_map<uint64_t, ThreadCacheRef>& threadCaches = threadCacheSlots.ThreadCaches;
+        auto it = threadCaches.find(mAllocatorID);
+        if (it != threadCaches.end()) {
+            slot = {mAllocatorID, it->second.Cache};
+            return slot.Cache;
+        }
+
+        // Remove entries of destroyed allocators before adding another, so the thread never
+        // holds more entries than allocators it used which still exist.
+        for (auto entry = threadCaches.begin(); entry != threadCaches.end();) {
+            if (entry->second.Owner.expired()) {
+                entry = threadCaches.erase(entry);
+            } else {
+                ++entry;
+            }
+        }
+
+        std::shared_ptr<ThreadCache> threadCache = std::make_shared<ThreadCache>();
+        threadCache->Allocator = this;
+        threadCaches[mAllocatorID] = {threadCache.get(), threadCache};
+        slot = {mAllocatorID, threadCache.get()};
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        mThreadCaches.push_back(std::move(threadCache));
+        return slot.Cache;
+    }
+
+    void MagazineMemoryAllocator::ReturnThreadCache(ThreadCache* threadCache) {
+        std::vector<std::unique_ptr<Magazine>> magazinesToDrain;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            for (auto& cache : threadCache->MagazinesOfSize) {
+                Depot& depot = mDepots[cache.first];
+                for (std::unique_ptr<Magazine>* magazine :
+                     {&cache.second.Loaded, &cache.second.Previous}) {
+                    // Empty magazines are simply freed.
+                    if (*magazine == nullptr || (*magazine)->Rounds.empty()) {
+                        continue;
+                    }
+                    if (depot.FullMagazines.size() < kMaxFullMagazinesInDepot) {
+                        depot.FullMagazines.push_back(std::move(*magazine));
+                    } else {
+                        magazinesToDrain.push_back(std::move(*magazine));
+                    }
+                }
+            }
+
+            mThreadCaches.erase(
+                std::remove_if(mThreadCaches.begin(), mThreadCaches.end(),
+                               [threadCache](const std::shared_ptr<ThreadCache>& other) {
+                                   return other.get() == threadCache;
+                               }),
+                mThreadCaches.end());
+        }
+
+        threadCache->MagazinesOfSize.clear();
+        threadCache->Allocator = nullptr;
+
+        for (auto& magazine : magazinesToDrain) {
+            DrainMagazine(magazine.get());
+        }
+    }
+
+    std::unique_ptr<MagazineMemoryAllocator::Magazine> MagazineMemoryAllocator::CreateMagazine()
+        const {
+        std::unique_ptr<Magazine> magazine = std::make_unique<Magazine>();
+        magazine->Rounds.reserve(mMagazineSize);
+        return magazine;
+    }
+
+    bool MagazineMemoryAllocator::ExchangeForFullMagazine(uint64_t blockSize,
+                                                          std::unique_ptr<Magazine>* magazine) {
+        std::lock_guard<std::mutex> lock(mMutex);
+        Depot& depot = mDepots[blockSize];
+        if (depot.FullMagazines.empty()) {
+            return false;
+        }
+
+        if (*magazine != nullptr) {
+            ASSERT((*magazine)->Rounds.empty());
+            depot.EmptyMagazines.push_back(std::move(*magazine));
+        }
+
+        *magazine = std::move(depot.FullMagazines.back());
+        depot.FullMagazines.pop_back();
+        return true;
+    }
+
+    std::unique_ptr<MagazineMemoryAllocator::Magazine>
+    MagazineMemoryAllocator::ExchangeForEmptyMagazine(uint64_t blockSize,
+                                                      std::unique_ptr<Magazine>* magazine) {
+        ASSERT(*magazine != nullptr);
+
+        std::unique_ptr<Magazine> overflowMagazine;
+        std::unique_ptr<Magazine> emptyMagazine;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            Depot& depot = mDepots[blockSize];
+            if (depot.FullMagazines.size() < kMaxFullMagazinesInDepot) {
+                depot.FullMagazines.push_back(std::move(*magazine));
+            } else {
+                overflowMagazine = std::move(*magazine);
+            }
+
+            if (!depot.EmptyMagazines.empty()) {
+                emptyMagazine = std::move(depot.EmptyMagazines.back());
+                depot.EmptyMagazines.pop_back();
+            }
+        }
+
+        // Magazines are created outside the lock since it requires a heap allocation.
+        if (emptyMagazine == nullptr) {
+            emptyMagazine = CreateMagazine();
+        }
+
+        *magazine = std::move(emptyMagazine);
+        return overflowMagazine;
+    }
+
+    std::unique_ptr<MemoryAllocation> MagazineMemoryAllocator::RefillMagazine(
+        const MemoryAllocationRequest& request,
+        Magazine* magazine) {
+        TRACE_EVENT0(TraceEventCategory::kDefault, "MagazineMemoryAllocator.RefillMagazine");
+
+        std::unique_ptr<MemoryAllocation> allocation;
+        GPGMM_TRY_ASSIGN(GetNextInChain()->TryAllocateMemory(request), allocation);
+
+        if (request.NeverAllocate || magazine == nullptr) {
+            return allocation;
+        }
+
+        // Remaining rounds must only come from existing memory (ie. the current slab). Otherwise,
+        // refilling could create memory that may never be used.
+        MemoryAllocationRequest roundRequest = request;
+        roundRequest.NeverAllocate = true;
+        roundRequest.AlwaysPrefetch = false;
+
+        // Load the whole magazine in one batch so the next allocator is only locked once.
+        if (magazine->Rounds.size() < mMagazineSize) {
+            const std::vector<MemoryAllocationRequest> roundRequests(
+                mMagazineSize - magazine->Rounds.size(), roundRequest);
+            for (const auto& round : GetNextInChain()->TryAllocateMemoryBatch(
+                     roundRequests.data(), roundRequests.size())) {
+                if (round != nullptr) {
+                    magazine->Rounds.push_back(*round);
+                }
+            }
+        }
+
+        return allocation;
+    }
+
+    void MagazineMemoryAllocator::DrainMagazine(Magazine* magazine) {
+        std::vector<std::unique_ptr<MemoryAllocation>> rounds;
+        rounds.reserve(magazine->Rounds.size());
+        for (const MemoryAllocation& round : magazine->Rounds) {
+            rounds.push_back(std::make_unique<MemoryAllocation>(round));
+        }
+        magazine->Rounds.clear();
+
+        GetNextInChain()->DeallocateMemoryBatch(std::move(rounds));
+    }
+
+    std::unique_ptr<MemoryAllocation> MagazineMemoryAllocator::TryAllocateMemory(
+        const MemoryAllocationRequest& request) {
+        TRACE_EVENT0(TraceEventCategory::kDefault, "MagazineMemoryAllocator.TryAllocateMemory");
+
+        GPGMM_INVALID_IF(!ValidateRequest(request));
+
+        // Key magazines by the block size the slab cache allocates with, which de-allocated blocks
+        // also report, so both always use the same magazines.
+        const uint64_t blockSize = mSlabCacheAllocator->ComputeBlockSize(request);
+
+        ThreadCache* threadCache = GetOrCreateThreadCache();
+        ASSERT(threadCache != nullptr);
+
+        std::unique_ptr<MemoryAllocation> allocation;
+        {
+            std::lock_guard<std::mutex> lock(threadCache->Mutex);
+            MagazineCache& cache = threadCache->MagazinesOfSize[blockSize];
+
+            // If the loaded magazine is empty but the previous one is not, swap them. Otherwise,
+            // exchange the empty magazine with a full one from the depot.
+            if (cache.Loaded == nullptr || cache.Loaded->Rounds.empty()) {
+                if (cache.Previous != nullptr && !cache.Previous->Rounds.empty()) {
+                    std::swap(cache.Loaded, cache.Previous);
+                } else if (!ExchangeForFullMagazine(blockSize, &cache.Loaded)) {
+                    // Depot is also empty, refill the loaded magazine from the next allocator.
+                    if (cache.Loaded == nullptr) {
+                        cache.Loaded = CreateMagazine();
+                    }
+                    GPGMM_TRY_ASSIGN(RefillMagazine(request, cache.Loaded.get()), allocation);
+                }
+            }
+
+            if (allocation == nullptr) {
+                ASSERT(!cache.Loaded->Rounds.empty());
+                const MemoryAllocation& round = cache.Loaded->Rounds.back();
+                allocation = std::make_unique<MemoryAllocation>(
+                    this, round.GetMemory(), round.GetOffset(), round.GetMethod(),
+                    round.GetBlock(), request.SizeInBytes, round.GetMappedPointer());
+                cache.Loaded->Rounds.pop_back();
+                return allocation;
+            }
+        }
+
+        ASSERT(allocation != nullptr);
+
+        // Re-use the refilled allocation instead of creating another MemoryAllocation.
+        *allocation = MemoryAllocation(this, allocation->GetMemory(), allocation->GetOffset(),
+                                       allocation->GetMethod(), allocation->GetBlock(),
+                                       request.SizeInBytes, allocation->GetMappedPointer());
+        return allocation;
+    }
+
+    void MagazineMemoryAllocator::DeallocateMemory(std::unique_ptr<MemoryAllocation> allocation) {
+        TRACE_EVENT0(TraceEventCategory::kDefault, "MagazineMemoryAllocator.DeallocateMemory");
+
+        ASSERT(allocation != nullptr);
+
+        const uint64_t blockSize = allocation->GetSize();
+
+        // Rounds are kept as allocations of the next allocator so they can be returned as-is.
+        const MemoryAllocation round(GetNextInChain(), allocation->GetMemory(),
+                                     allocation->GetOffset(), allocation->GetMethod(),
+                                     allocation->GetBlock(), allocation->GetRequestSize(),
+                                     allocation->GetMappedPointer());
+
+        ThreadCache* threadCache = GetOrCreateThreadCache();
+        ASSERT(threadCache != nullptr);
+
+        std::unique_ptr<Magazine> overflowMagazine;
+        {
+            std::lock_guard<std::mutex> lock(threadCache->Mutex);
+            MagazineCache& cache = threadCache->MagazinesOfSize[blockSize];
+
+            if (cache.Loaded == nullptr) {
+                cache.Loaded = CreateMagazine();
+            }
+
+            // If the loaded magazine is full but the previous one is not, swap them. Otherwise,
+            // exchange the full magazine with an empty one from the depot.
+            if (cache.Loaded->Rounds.size() >= mMagazineSize) {
+                if (cache.Previous == nullptr || cache.Previous->Rounds.empty()) {
+                    std::swap(cache.Loaded, cache.Previous);
+                    if (cache.Loaded == nullptr) {
+                        cache.Loaded = CreateMagazine();
+                    }
+                } else {
+                    overflowMagazine = ExchangeForEmptyMagazine(blockSize, &cache.Previous);
+                    std::swap(cache.Loaded, cache.Previous);
+                }
+            }
+
+            cache.Loaded->Rounds.push_back(round);
+        }
+
+        // Drain outside of the thread cache lock since the next allocator could be slow.
+        if (overflowMagazine != nullptr) {
+            DrainMagazine(overflowMagazine.get());
+        }
+    }
+
+    uint64_t MagazineMemoryAllocator::ReleaseMemory(uint64_t bytesToRelease) {
+        TRACE_EVENT0(TraceEventCategory::kDefault, "MagazineMemoryAllocator.ReleaseMemory");
+
+        // Collect every magazine first then drain them without holding any lock.
+        std::vector<std::unique_ptr<Magazine>> magazinesToDrain;
+        std::vector<std::shared_ptr<ThreadCache>> threadCaches;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            for (auto& depot : mDepots) {
+                for (auto& magazine : depot.second.FullMagazines) {
+                    magazinesToDrain.push_back(std::move(magazine));
+                }
+            }
+            mDepots.clear();
+
+            // Referenced since exiting threads could remove their thread cache meanwhile.
+            threadCaches = mThreadCaches;
+        }
+
+        for (auto& threadCache : threadCaches) {
+            std::lock_guard<std::mutex> lock(threadCache->Mutex);
+            for (auto& cache : threadCache->MagazinesOfSize) {
+                if (cache.second.Loaded != nullptr) {
+                    magazinesToDrain.push_back(std::move(cache.second.Loaded));
+                }
+                if (cache.second.Previous != nullptr) {
+                    magazinesToDrain.push_back(std::move(cache.second.Previous));
+                }
+            }
+            threadCache->MagazinesOfSize.clear();
+        }
+
+        for (auto& magazine : magazinesToDrain) {
+            DrainMagazine(magazine.get());
+        }
+
+        return GetNextInChain()->ReleaseMemory(bytesToRelease);
+    }
+
+    uint64_t MagazineMemoryAllocator::ComputeCachedBlockCount(uint64_t* cachedBlockUsage) const {
+        uint64_t cachedBlockCount = 0;
+        *cachedBlockUsage = 0;
+
+        std::vector<std::shared_ptr<ThreadCache>> threadCaches;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            for (const auto& depot : mDepots) {
+                for (const auto& magazine : depot.second.FullMagazines) {
+                    cachedBlockCount += magazine->Rounds.size();
+                    *cachedBlockUsage += magazine->Rounds.size() * depot.first;
+                }
+            }
+
+            threadCaches = mThreadCaches;
+        }
+
+        for (const auto& threadCache : threadCaches) {
+            std::lock_guard<std::mutex> lock(threadCache->Mutex);
+            for (const auto& cache : threadCache->MagazinesOfSize) {
+                for (const Magazine* magazine :
+                     {cache.second.Loaded.get(), cache.second.Previous.get()}) {
+                    if (magazine != nullptr) {
+                        cachedBlockCount += magazine->Rounds.size();
+                        *cachedBlockUsage += magazine->Rounds.size() * cache.first;
+                    }
+                }
+            }
+        }
+
+        return cachedBlockCount;
+    }
+
+    MemoryAllocatorStats MagazineMemoryAllocator::GetStats() const {
+        MemoryAllocatorStats result = GetNextInChain()->GetStats();
+
+        // Cached blocks are free to re-use, so they must not be counted as used. Since other
+        // threads could allocate in-between, the counts are clamped rather than asserted.
+        uint64_t cachedBlockUsage = 0;
+        const uint64_t cachedBlockCount = ComputeCachedBlockCount(&cachedBlockUsage);
+
+        result.UsedBlockCount -= static_cast<uint32_t>(
+            std::min(static_cast<uint64_t>(result.UsedBlockCount), cachedBlockCount));
+        result.UsedBlockUsage -= std::min(result.UsedBlockUsage, cachedBlockUsage);
+
+        return result;
+    }
+
+    uint64_t MagazineMemoryAllocator::GetMemorySize() const {
+        return GetNextInChain()->GetMemorySize();
+    }
+
+    uint64_t MagazineMemoryAllocator::GetMemoryAlignment() const {
+        return GetNextInChain()->GetMemoryAlignment();
+    }
+
+    const char* MagazineMemoryAllocator::GetTypename() const {
+        return "MagazineMemoryAllocator";
+    }
+
+}  // namespace gpgmm
@@ -0,0 +1,144 @@
+// Copyright 2022 The GPGMM Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GPGMM_COMMON_MAGAZINEMEMORYALLOCATOR_H_
+#define GPGMM_COMMON_MAGAZINEMEMORYALLOCATOR_H_
+
+#include "gpgmm/common/MemoryAllocator.h"
+#include "gpgmm/common/SlabMemoryAllocator.h"
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace gpgmm {
+
+    // MagazineMemoryAllocator caches ready-to-use blocks, per-thread, in front of a
+    // SlabCacheAllocator. Blocks are grouped by the block size the slab cache allocates them with
+    // (ie. once rounded-up to the size class) into fixed-capacity stacks called "magazines".
+    // Each thread loads two magazines per size, so most allocations and de-allocations are a
+    // push or pop on a magazine owned by the calling thread and never contend with other
+    // threads.
+    //
+    // Once both magazines of a thread become empty (or full), they are exchanged in bulk with a
+    // shared "depot" of full and empty magazines. When the depot has no full magazines left,
+    // the next magazine is refilled from the slab allocator in one batch. Similarly, when the
+    // depot holds too many full magazines, the whole magazine is drained back to the slab
+    // allocator. Once a thread exits, its magazines are returned to the depot.
+    //
+    // Blocks held by magazines count as used by the slab allocator but not by this allocator.
+    // Call ReleaseMemory() to drain ALL magazines before releasing the underlying memory.
+    //
+    // Magazine implementation is closely based on Jeff Bonwick's paper "Magazines and Vmem:
+    // Extending the Slab Allocator to Many CPUs and Arbitrary Resources".
+    // https://www.usenix.org/legacy/event/usenix01/full_papers/bonwick/bonwick.pdf
+    //
+    class MagazineMemoryAllocator final : public MemoryAllocator {
+      public:
+        MagazineMemoryAllocator(uint64_t magazineSize,
+                                std::unique_ptr<SlabCacheAllocator> slabCacheAllocator);
+        ~MagazineMemoryAllocator() override;
+
+        // MemoryAllocator interface
+        std::unique_ptr<MemoryAllocation> TryAllocateMemory(
+            const MemoryAllocationRequest& request) override;
+        void DeallocateMemory(std::unique_ptr<MemoryAllocation> allocation) override;
+        uint64_t ReleaseMemory(uint64_t bytesToRelease = kInvalidSize) override;
+
+        uint64_t GetMemorySize() const override;
+        uint64_t GetMemoryAlignment() const override;
+
+        MemoryAllocatorStats GetStats() const override;
+
+        const char* GetTypename() const override;
+
+      private:
+        // Fixed-capacity stack of blocks (or "rounds") of the same size.
+        struct Magazine {
+            std::vector<MemoryAllocation> Rounds;
+        };
+
+        // Per-thread pair of magazines for a single block size.
+        struct MagazineCache {
+            std::unique_ptr<Magazine> Loaded;
+            std::unique_ptr<Magazine> Previous;
+        };
+
+        // Magazines owned by a single thread. The mutex is only contended when another thread
+        // drains or queries the cache (ie. ReleaseMemory or GetStats).
+        struct ThreadCache {
+            std::mutex Mutex;
+            std::unordered_map<uint64_t, MagazineCache> MagazinesOfSize;
+
+            // Guarded by |Mutex|. Reset once the allocator starts being destroyed.
+            MagazineMemoryAllocator* Allocator = nullptr;
+        };
+
+        // Thread's reference to the thread cache of an allocator. Only expires once the allocator
+        // was destroyed, so the entry can be removed.
+        struct ThreadCacheRef {
+            ThreadCache* Cache;
+            std::weak_ptr<ThreadCache> Owner;
+        };
+
+        // Thread caches of the allocators used by a thread. Returns their magazines to the depot
+        // once the thread exits.
+        struct ThreadCacheSlots;
+
+        // Magazines shared between ALL threads for a single block size. Magazines returned by
+        // exiting threads could be partially full.
+        struct Depot {
+            std::vector<std::unique_ptr<Magazine>> FullMagazines;
+            std::vector<std::unique_ptr<Magazine>> EmptyMagazines;
+        };
+
+        ThreadCache* GetOrCreateThreadCache();
+
+        // Moves the magazines of an exiting thread to the depot, draining what the depot cannot
+        // hold, then forgets the thread cache. Must be called with |threadCache->Mutex| held.
+        void ReturnThreadCache(ThreadCache* threadCache);
+
+        std::unique_ptr<Magazine> CreateMagazine() const;
+
+        // Exchanges an empty magazine for a full one from the depot. Returns false if the depot
+        // had no full magazine, leaving |magazine| unchanged.
+        bool ExchangeForFullMagazine(uint64_t blockSize, std::unique_ptr<Magazine>* magazine);
+
+        // Exchanges a full magazine for an empty one from the depot. Returns a full magazine to
+        // be drained if the depot could not accept it, or nullptr otherwise.
+        std::unique_ptr<Magazine> ExchangeForEmptyMagazine(uint64_t blockSize,
+                                                           std::unique_ptr<Magazine>* magazine);
+
+        // Allocates a new magazine of blocks from the next allocator. The first block is
+        // always returned and the remaining blocks are only loaded from existing memory.
+        std::unique_ptr<MemoryAllocation> RefillMagazine(const MemoryAllocationRequest& request,
+                                                         Magazine* magazine);
+
+        void DrainMagazine(Magazine* magazine);
+
+        uint64_t ComputeCachedBlockCount(uint64_t* cachedBlockUsage) const;
+
+        const uint64_t mMagazineSize;
+        const uint64_t mAllocatorID;
+
+        SlabCacheAllocator* const mSlabCacheAllocator;
+
+        // Guarded by |mMutex|.
+        std::unordered_map<uint64_t, Depot> mDepots;
+        std::vector<std::shared_ptr<ThreadCache>> mThreadCaches;
+    };
+
+}  // namespace gpgmm
+
+#endif  // GPGMM_COMMON_MAGAZINEMEMORYALLOCATOR_H_
@@ -17,6 +17,7 @@
 #define GPGMM_COMMON_MEMORYALLOCATION_H_
 
 #include "gpgmm/utils/Limits.h"
+#include "gpgmm/utils/PooledObject.h"
 #include "include/gpgmm.h"
 
 namespace gpgmm {
@@ -44,8 +45,12 @@ namespace gpgmm {
 
     It can represent a location in memory by one of two ways: 1) a range within a memory block or 2)
     a memory block of the entire memory range.
+
+    MemoryAllocation objects are pooled, so creating one with new (eg. std::make_unique) does not
+    use the heap once warm. Allocators pass the same object up the chain, re-assigning it in-place,
+    rather than creating another one per allocator.
     */
-    class MemoryAllocation {
+    class MemoryAllocation : public PooledObject<MemoryAllocation> {
       public:
         /** \brief Contructs an invalid memory allocation.
          */
@@ -164,6 +169,8 @@ namespace gpgmm {
         MemoryAllocator* mAllocator;
 
       private:
+        friend class DeferredMemoryAllocator;
+
         IMemoryObject* mMemory;
         uint64_t mOffset;  // Offset always local to the memory.
         AllocationMethod mMethod;
@@ -171,6 +178,9 @@ namespace gpgmm {
 
         uint64_t mRequestSize;
         uint8_t* mMappedPointer;
+
+        // Next pending free, linked in-place so deferring a free never allocates.
+        MemoryAllocation* mNextDeferredFree = nullptr;
     };
 }  // namespace gpgmm
 
@@ -0,0 +1,172 @@
+// Copyright 2022 The GPGMM Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "gpgmm/common/MemoryAllocationQueue.h"
+
+#include "gpgmm/common/TraceEvent.h"
+#include "gpgmm/common/WorkerThread.h"
+#include "gpgmm/utils/Assert.h"
+
+namespace gpgmm {
+
+    static constexpr const char* kAllocationQueueWorkerThreadName =
+        "GPGMM_ThreadAllocationQueueWorker";
+
+    // One task is posted per submission. Since cancelled submissions get removed, a task could
+    // find none left to serve.
+    class MemoryAllocationQueue::ServeSubmissionTask : public VoidCallback {
+      public:
+        explicit ServeSubmissionTask(MemoryAllocationQueue* queue) : mQueue(queue) {
+        }
+
+        void operator()() override {
+            mQueue->ServeNextSubmission();
+        }
+
+      private:
+        MemoryAllocationQueue* const mQueue;
+    };
+
+    MemoryAllocationQueue::MemoryAllocationQueue(MemoryAllocator* allocator,
+                                                 uint32_t numOfWorkers)
+        : mAllocator(allocator), mThreadPool(ThreadPool::Create(numOfWorkers)) {
+        ASSERT(mAllocator != nullptr);
+    }
+
+    MemoryAllocationQueue::~MemoryAllocationQueue() {
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            for (Submission& submission : mSubmissions) {
+                MemoryAllocationCompletion completion = {};
+                completion.UserData = submission.UserData;
+                completion.IsCancelled = true;
+                mCompletions.push_back(std::move(completion));
+            }
+            mSubmissions.clear();
+            mCompletionCondition.notify_all();
+
+            // Wait for the requests being served. The tasks left find nothing to serve.
+            mCompletionCondition.wait(lock, [this] { return mNumOfPendingTasks == 0; });
+        }
+
+        for (MemoryAllocationCompletion& completion : mCompletions) {
+            if (completion.Allocation != nullptr) {
+                MemoryAllocator* allocator = completion.Allocation->GetAllocator();
+                allocator->DeallocateMemory(std::move(completion.Allocation));
+            }
+        }
+    }
+
+    void MemoryAllocationQueue::Submit(const MemoryAllocationRequest& request, uint64_t userData) {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mSubmissions.push_back({request, userData});
+            mOutstandingCount++;
+            mNumOfPendingTasks++;
+        }
+        ThreadPool::PostTask(mThreadPool, std::make_shared<ServeSubmissionTask>(this),
+                             kAllocationQueueWorkerThreadName);
+    }
+
+    uint64_t MemoryAllocationQueue::Cancel(uint64_t userData) {
+        uint64_t numOfCancelled = 0;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            for (auto it = mSubmissions.begin(); it != mSubmissions.end();) {
+                if (it->UserData != userData) {
+                    it++;
+                    continue;
+                }
+
+                MemoryAllocationCompletion completion = {};
+                completion.UserData = userData;
+                completion.IsCancelled = true;
+                mCompletions.push_back(std::move(completion));
+
+                it = mSubmissions.erase(it);
+                numOfCancelled++;
+            }
+        }
+
+        if (numOfCancelled > 0) {
+            mCompletionCondition.notify_all();
+        }
+        return numOfCancelled;
+    }
+
+    bool MemoryAllocationQueue::TryGetCompletion(MemoryAllocationCompletion* completion) {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (mCompletions.empty()) {
+            return false;
+        }
+
+        *completion = std::move(mCompletions.front());
+        mCompletions.pop_front();
+        mOutstandingCount--;
+        return true;
+    }
+
+    bool MemoryAllocationQueue::WaitForCompletion(MemoryAllocationCompletion* completion) {
+        TRACE_EVENT0(TraceEventCategory::kDefault, "MemoryAllocationQueue.WaitForCompletion");
+
+        std::unique_lock<std::mutex> lock(mMutex);
+        mCompletionCondition.wait(
+            lock, [this] { return !mCompletions.empty() || mOutstandingCount == 0; });
+        if (mCompletions.empty()) {
+            return false;
+        }
+
+        *completion = std::move(mCompletions.front());
+        mCompletions.pop_front();
+        mOutstandingCount--;
+        return true;
+    }
+
+    uint64_t MemoryAllocationQueue::GetOutstandingCount() const {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mOutstandingCount;
+    }
+
+    void MemoryAllocationQueue::ServeNextSubmission() {
+        Submission submission = {};
+        bool hasSubmission = false;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            if (!mSubmissions.empty()) {
+                submission = mSubmissions.front();
+                mSubmissions.pop_front();
+                hasSubmission = true;
+            }
+        }
+
+        // Allocate without holding the lock so other requests can be submitted, served or
+        // completed meanwhile.
+        MemoryAllocationCompletion completion = {};
+        if (hasSubmission) {
+            completion.UserData = submission.UserData;
+            completion.Allocation = mAllocator->TryAllocateMemory(submission.Request);
+        }
+
+        // Notify while holding the lock since the queue could be destroyed as soon as the last
+        // task finishes.
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (hasSubmission) {
+            mCompletions.push_back(std::move(completion));
+        }
+        mNumOfPendingTasks--;
+        mCompletionCondition.notify_all();
+    }
+
+}  // namespace gpgmm
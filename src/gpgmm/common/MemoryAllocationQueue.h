@@ -0,0 +1,101 @@
+// Copyright 2022 The GPGMM Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef GPGMM_COMMON_MEMORYALLOCATIONQUEUE_H_
+#define GPGMM_COMMON_MEMORYALLOCATIONQUEUE_H_
+
+#include "gpgmm/common/MemoryAllocator.h"
+#include "gpgmm/utils/NonCopyable.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+
+namespace gpgmm {
+
+    class ThreadPool;
+
+    // Result of a request submitted to a MemoryAllocationQueue.
+    struct MemoryAllocationCompletion {
+        uint64_t UserData = 0;  // Value the request was submitted with.
+
+        // Allocated memory, or null if the request failed or was cancelled.
+        std::unique_ptr<MemoryAllocation> Allocation;
+
+        bool IsCancelled = false;
+    };
+
+    // MemoryAllocationQueue allocates many requests asynchronously through a single completion
+    // queue. Unlike TryAllocateMemoryAsync(), which returns an event per request, requests are
+    // tagged with user data and served by a pool of workers so the caller can poll or wait on
+    // whichever request completes first, in any order.
+    //
+    // Requests not yet served can be cancelled. Otherwise, every submitted request gets exactly one
+    // completion, which must be retrieved for the allocation to be owned by the caller.
+    class MemoryAllocationQueue : public NonCopyable {
+      public:
+        explicit MemoryAllocationQueue(MemoryAllocator* allocator, uint32_t numOfWorkers = 1);
+
+        // Completes the requests not yet served as cancelled, waits for the requests being served,
+        // then deallocates the completed allocations never retrieved.
+        ~MemoryAllocationQueue();
+
+        void Submit(const MemoryAllocationRequest& request, uint64_t userData);
+
+        // Completes every request of |userData| not yet served as cancelled. Returns the number of
+        // requests cancelled.
+        uint64_t Cancel(uint64_t userData);
+
+        // Retrieves a completed request without blocking. Returns false if none has completed.
+        bool TryGetCompletion(MemoryAllocationCompletion* completion);
+
+        // Blocks until a request completes and retrieves it. Returns false if there are no
+        // requests left to complete.
+        bool WaitForCompletion(MemoryAllocationCompletion* completion);
+
+        // Number of requests submitted but whose completion was not yet retrieved.
+        uint64_t GetOutstandingCount() const;
+
+      private:
+        struct Submission {
+            MemoryAllocationRequest Request;
+            uint64_t UserData;
+        };
+
+        class ServeSubmissionTask;
+
+        // Serves the oldest request not yet served, if any.
+        void ServeNextSubmission();
+
+        MemoryAllocator* const mAllocator;
+
+        mutable std::mutex mMutex;
+        std::condition_variable mCompletionCondition;
+
+        std::deque<Submission> mSubmissions;
+        std::deque<MemoryAllocationCompletion> mCompletions;
+        uint64_t mOutstandingCount = 0;
+
+        // Tasks posted but not yet finished, which the destructor must wait on.
+        uint64_t mNumOfPendingTasks = 0;
+
+        std::shared_ptr<ThreadPool> mThreadPool;
+    };
+
+}  // namespace gpgmm
+
+#endif  // GPGMM_COMMON_MEMORYALLOCATIONQUEUE_H_
@@ -16,8 +16,11 @@
 
 #include "gpgmm/common/EventMessage.h"
 #include "gpgmm/common/JSONSerializer.h"
+#include "gpgmm/common/MemoryAllocationQueue.h"
 #include "gpgmm/utils/Math.h"
 
+#include <algorithm>
+
 namespace gpgmm {
 
     static constexpr const char* kPrefetchMemoryWorkerThreadName = "GPGMM_ThreadBudgetChangeWorker";
@@ -54,10 +57,23 @@ namespace gpgmm {
 
         PrefetchedMemoryMisses += rhs.PrefetchedMemoryMisses;
         PrefetchedMemoryMissesEliminated += rhs.PrefetchedMemoryMissesEliminated;
+        PrefetchedMemoryWasted += rhs.PrefetchedMemoryWasted;
+        PrefetchedMemoryParkedUsage += rhs.PrefetchedMemoryParkedUsage;
+        PrefetchedMemorySalvagedUsage += rhs.PrefetchedMemorySalvagedUsage;
 
         SizeCacheMisses += rhs.SizeCacheMisses;
         SizeCacheHits += rhs.SizeCacheHits;
 
+        PendingFreeCount += rhs.PendingFreeCount;
+        PendingFreeUsage += rhs.PendingFreeUsage;
+
+        InternalFragmentationUsage += rhs.InternalFragmentationUsage;
+        ExternalFragmentationUsage += rhs.ExternalFragmentationUsage;
+        LargestFreeBlockSize = std::max(LargestFreeBlockSize, rhs.LargestFreeBlockSize);
+
+        GroupCount += rhs.GroupCount;
+        GroupMemoryCount += rhs.GroupMemoryCount;
+
         return *this;
     }
 
@@ -86,11 +102,11 @@ namespace gpgmm {
 
     // MemoryAllocator
 
-    MemoryAllocator::MemoryAllocator() : mThreadPool(ThreadPool::Create()) {
+    MemoryAllocator::MemoryAllocator() : mThreadPool(ThreadPool::GetOrCreateShared()) {
     }
 
     MemoryAllocator::MemoryAllocator(std::unique_ptr<MemoryAllocator> next)
-        : mThreadPool(ThreadPool::Create()) {
+        : mThreadPool(ThreadPool::GetOrCreateShared()) {
         InsertIntoChain(std::move(next));
     }
 
@@ -121,12 +137,38 @@ namespace gpgmm {
         return {};
     }
 
+    std::vector<std::unique_ptr<MemoryAllocation>> MemoryAllocator::TryAllocateMemoryBatch(
+        const MemoryAllocationRequest* requests,
+        uint64_t count) {
+        std::vector<std::unique_ptr<MemoryAllocation>> allocations(count);
+        for (uint64_t i = 0; i < count; i++) {
+            allocations[i] = TryAllocateMemory(requests[i]);
+        }
+        return allocations;
+    }
+
+    void MemoryAllocator::DeallocateMemoryBatch(
+        std::vector<std::unique_ptr<MemoryAllocation>> allocations) {
+        for (auto& allocation : allocations) {
+            if (allocation != nullptr) {
+                DeallocateMemory(std::move(allocation));
+            }
+        }
+    }
+
     std::shared_ptr<MemoryAllocationEvent> MemoryAllocator::TryAllocateMemoryAsync(
         const MemoryAllocationRequest& request) {
         std::shared_ptr<AllocateMemoryTask> task =
             std::make_shared<AllocateMemoryTask>(this, request);
         return std::make_shared<MemoryAllocationEvent>(
-            ThreadPool::PostTask(mThreadPool, task, kPrefetchMemoryWorkerThreadName), task);
+            ThreadPool::PostTask(mThreadPool, task, kPrefetchMemoryWorkerThreadName,
+                                 TaskPriority::kHigh),
+            task);
+    }
+
+    std::unique_ptr<MemoryAllocationQueue> MemoryAllocator::CreateAllocationQueue(
+        uint32_t numOfWorkers) {
+        return std::make_unique<MemoryAllocationQueue>(this, numOfWorkers);
     }
 
     uint64_t MemoryAllocator::ReleaseMemory(uint64_t bytesToRelease) {
@@ -137,6 +179,14 @@ namespace gpgmm {
         return 0;
     }
 
+    uint64_t MemoryAllocator::ReleaseMemoryOlderThan(std::chrono::steady_clock::duration duration) {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (GetNextInChain() != nullptr) {
+            return GetNextInChain()->ReleaseMemoryOlderThan(duration);
+        }
+        return 0;
+    }
+
     uint64_t MemoryAllocator::GetMemorySize() const {
         return kInvalidSize;
     }
@@ -145,11 +195,26 @@ namespace gpgmm {
         return kNoRequiredAlignment;
     }
 
+    uint64_t MemoryAllocator::GetAvailableForAllocation() const {
+        if (GetNextInChain() != nullptr) {
+            return GetNextInChain()->GetAvailableForAllocation();
+        }
+        return kInvalidSize;
+    }
+
     MemoryAllocatorStats MemoryAllocator::GetStats() const {
         std::lock_guard<std::mutex> lock(mMutex);
         return mStats;
     }
 
+    uint64_t MemoryAllocator::GetSizeClassStats(MemorySizeClassStats* pSizeClassStats,
+                                                uint64_t count) const {
+        if (GetNextInChain() != nullptr) {
+            return GetNextInChain()->GetSizeClassStats(pSizeClassStats, count);
+        }
+        return 0;
+    }
+
     const char* MemoryAllocator::GetTypename() const {
         return "MemoryAllocator";
     }
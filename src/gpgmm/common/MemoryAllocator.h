@@ -27,12 +27,16 @@
 #include "gpgmm/utils/Log.h"
 #include "include/gpgmm.h"
 
+#include <chrono>
 #include <memory>
 #include <mutex>
+#include <utility>
+#include <vector>
 
 namespace gpgmm {
 
     class AllocateMemoryTask;
+    class MemoryAllocationQueue;
 
     /** \brief MemoryAllocationEvent
 
@@ -50,6 +54,7 @@ namespace gpgmm {
 
         // Event overrides
         void Wait() override;
+        bool IsSignaled() override;
 
         /** \brief Acquire the memory allocation.
 
@@ -59,7 +64,6 @@ namespace gpgmm {
 
       private:
         void Signal() override;
-        bool IsSignaled() override;
 
         std::shared_ptr<AllocateMemoryTask> mTask;
         std::shared_ptr<Event> mEvent;
@@ -107,6 +111,14 @@ namespace gpgmm {
         A value of 0 means there is no memory available left to allocate from.
         */
         uint64_t AvailableForAllocation;
+
+        /** \brief Group of allocations used together.
+
+        Allocations of the same group are preferably sub-allocated from the same memory so fewer
+        memory objects must be resident to use them. Memory is never created only to keep groups
+        apart. A value of kNoGroupKey, or zero, means the allocation does not belong to any group.
+        */
+        uint64_t GroupKey;
     };
 
     class BlockAllocator;
@@ -154,6 +166,22 @@ namespace gpgmm {
         virtual std::unique_ptr<MemoryAllocation> TryAllocateMemory(
             const MemoryAllocationRequest& request);
 
+        /** \brief Create many memory allocations at once.
+
+        Equivalent to calling TryAllocateMemory for each request but allows the allocator to
+        amortize the per-call overhead (eg. locking) across the whole batch. Requests are allocated
+        in order and a request that cannot be full-filled does not fail the others.
+
+        @param requests Array of MemoryAllocationRequest that describes what to allocate.
+        @param count Number of requests in the array.
+
+        \return A vector of |count| pointers to MemoryAllocation, ordered like |requests|. An
+        element is NULL if the corresponding request could not be full-filled.
+        */
+        virtual std::vector<std::unique_ptr<MemoryAllocation>> TryAllocateMemoryBatch(
+            const MemoryAllocationRequest* requests,
+            uint64_t count);
+
         /** \brief Non-blocking version of TryAllocateMemory.
 
         Caller must wait for the event to complete before using the resulting allocation.
@@ -163,6 +191,18 @@ namespace gpgmm {
         std::shared_ptr<MemoryAllocationEvent> TryAllocateMemoryAsync(
             const MemoryAllocationRequest& request);
 
+        /** \brief Create a queue to allocate many requests asynchronously.
+
+        Unlike TryAllocateMemoryAsync, requests submitted to the queue are tagged with user data
+        and complete, in any order, through the queue so the caller can poll or wait on all of
+        them at once. The queue must be destroyed before this allocator.
+
+        @param numOfWorkers Number of requests that can be served concurrently.
+
+        \return A pointer to MemoryAllocationQueue. Must be non-null.
+        */
+        std::unique_ptr<MemoryAllocationQueue> CreateAllocationQueue(uint32_t numOfWorkers = 1);
+
         /** \brief Free a memory allocation.
 
         After DeallocateMemory is called, the MemoryAllocation is longer valid.
@@ -171,6 +211,16 @@ namespace gpgmm {
         */
         virtual void DeallocateMemory(std::unique_ptr<MemoryAllocation> allocation) = 0;
 
+        /** \brief Free many memory allocations at once.
+
+        Equivalent to calling DeallocateMemory for each allocation. NULL elements are ignored so
+        the result of TryAllocateMemoryBatch can be de-allocated as-is.
+
+        @param allocations MemoryAllocations to de-allocate.
+        */
+        virtual void DeallocateMemoryBatch(
+            std::vector<std::unique_ptr<MemoryAllocation>> allocations);
+
         /** \brief Return free memory back to the OS.
 
         @param bytesToRelease Amount of memory to release, in bytes. A value of UINT64_MAX
@@ -182,6 +232,17 @@ namespace gpgmm {
         */
         virtual uint64_t ReleaseMemory(uint64_t bytesToRelease);
 
+        /** \brief Return free memory, unused for at-least the specified duration, back to the OS.
+
+        Unlike ReleaseMemory(), recently used memory is kept so idle memory can be released without
+        releasing the memory being re-used.
+
+        @param duration Amount of time the free memory must have been unused for to be released.
+
+        \return Amount of memory, in bytes, released.
+        */
+        virtual uint64_t ReleaseMemoryOlderThan(std::chrono::steady_clock::duration duration);
+
         /** \brief Get the fixed-memory sized of the MemoryAllocator.
 
         If this allocator only allocates memory blocks using the same size, this value
@@ -202,6 +263,16 @@ namespace gpgmm {
         */
         virtual uint64_t GetMemoryAlignment() const;
 
+        /** \brief Get the amount of memory that could still be created by the MemoryAllocator.
+
+        Allocators that limit memory, like BudgetedMemoryAllocator, return how much memory is left
+        under their budget. Otherwise, the next allocator in the chain is consulted, or
+        kInvalidSize is returned to denote no limit.
+
+        \return Size of memory, in bytes.
+        */
+        virtual uint64_t GetAvailableForAllocation() const;
+
         /** \brief Get memory allocator usage.
 
         Should be overridden when a child or block allocator is used to avoid
@@ -211,6 +282,21 @@ namespace gpgmm {
         */
         virtual MemoryAllocatorStats GetStats() const;
 
+        /** \brief Get the usage of each size class.
+
+        Only reported by allocators that use size classes, ordered by block size. Otherwise, the
+        next allocator in the chain is consulted. Allocators combining others report the size
+        classes of each in turn.
+
+        @param[out] pSizeClassStats Array that receives up to |count| size classes. Can be NULL
+        if |count| is zero.
+        @param count Number of elements in the array.
+
+        \return Number of size classes, which could exceed |count|.
+        */
+        virtual uint64_t GetSizeClassStats(MemorySizeClassStats* pSizeClassStats,
+                                           uint64_t count) const;
+
         /** \brief Identifies the allocator type.
 
         The type is used for profiling and debugging purposes only.
@@ -251,6 +337,19 @@ namespace gpgmm {
             MemoryBlock* block = nullptr;
             GPGMM_TRY_ASSIGN(allocator->TryAllocateBlock(requestSize, alignment), block);
 
+            return TrySubAllocateMemory(allocator, block, neverAllocate,
+                                        std::forward<GetOrCreateMemoryFn>(GetOrCreateMemory));
+        }
+
+        // Same as above but for a block already allocated by |allocator|.
+        template <typename GetOrCreateMemoryFn>
+        static std::unique_ptr<MemoryAllocation> TrySubAllocateMemory(
+            BlockAllocator* allocator,
+            MemoryBlock* block,
+            bool neverAllocate,
+            GetOrCreateMemoryFn&& GetOrCreateMemory) {
+            ASSERT(block != nullptr);
+
             IMemoryObject* memory = GetOrCreateMemory(block);
             if (memory == nullptr) {
                 // NeverAllocate always fails, so suppress it.
@@ -271,7 +370,7 @@ namespace gpgmm {
             // This is because TrySubAllocateMemory() does not necessarily know how to map the
             // final sub-allocated block to created memory.
             return std::make_unique<MemoryAllocation>(
-                nullptr, memory, kInvalidOffset, AllocationMethod::kUndefined, block, requestSize);
+                nullptr, memory, kInvalidOffset, AllocationMethod::kUndefined, block, block->Size);
         }
 
         void InsertIntoChain(std::unique_ptr<MemoryAllocator> next);
@@ -15,6 +15,7 @@
 #ifndef GPGMM_COMMON_MEMORYBLOCK_H_
 #define GPGMM_COMMON_MEMORYBLOCK_H_
 
+#include "gpgmm/common/MemoryGroup.h"
 #include "gpgmm/utils/Limits.h"
 
 namespace gpgmm {
@@ -22,6 +23,12 @@ namespace gpgmm {
     struct MemoryBlock {
         uint64_t Offset = kInvalidOffset;
         uint64_t Size = kInvalidSize;
+
+        // Size originally requested, which could be smaller than |Size| once rounded up.
+        uint64_t RequestSize = kInvalidSize;
+
+        // Group of the allocation using the block, if any.
+        uint64_t GroupKey = kNoGroupKey;
     };
 
 }  // namespace gpgmm
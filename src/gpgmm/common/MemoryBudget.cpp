@@ -0,0 +1,146 @@
+// Copyright 2022 The GPGMM Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gpgmm/common/MemoryBudget.h"
+
+#include "gpgmm/common/TraceEvent.h"
+#include "gpgmm/common/WorkerThread.h"
+#include "gpgmm/utils/Assert.h"
+
+namespace gpgmm {
+
+    static constexpr const char* kOverBudgetWorkerThreadName = "GPGMM_ThreadOverBudgetWorker";
+
+    class MemoryBudget::OverBudgetTask : public VoidCallback {
+      public:
+        explicit OverBudgetTask(MemoryBudget* budget) : mBudget(budget) {
+        }
+
+        void operator()() override {
+            mBudget->RunOverBudgetCallbacks();
+        }
+
+      private:
+        MemoryBudget* const mBudget;
+    };
+
+    MemoryBudget::MemoryBudget(uint64_t hardLimit, uint64_t softLimit)
+        : mHardLimit(hardLimit),
+          mSoftLimit(softLimit),
+          mThreadPool(ThreadPool::GetOrCreateShared()) {
+    }
+
+    MemoryBudget::~MemoryBudget() {
+        // Callbacks scheduled on the worker pool refer to |this|.
+        WaitForOverBudgetCallbacks();
+        ASSERT(mUsage == 0u);
+    }
+
+    bool MemoryBudget::TryReserve(uint64_t size) {
+        const uint64_t hardLimit = mHardLimit.load();
+        uint64_t usage = mUsage.load();
+        do {
+            if (size > hardLimit || usage > hardLimit - size) {
+                return false;
+            }
+        } while (!mUsage.compare_exchange_weak(usage, usage + size));
+
+        RunOverBudgetCallbacksIfNeeded(usage + size);
+        return true;
+    }
+
+    void MemoryBudget::Reserve(uint64_t size) {
+        RunOverBudgetCallbacksIfNeeded(mUsage.fetch_add(size) + size);
+    }
+
+    void MemoryBudget::Release(uint64_t size) {
+        const uint64_t usage = mUsage.fetch_sub(size);
+        ASSERT(usage >= size);
+    }
+
+    void MemoryBudget::SetLimits(uint64_t hardLimit, uint64_t softLimit) {
+        mHardLimit = hardLimit;
+        mSoftLimit = softLimit;
+
+        RunOverBudgetCallbacksIfNeeded(mUsage.load());
+    }
+
+    void MemoryBudget::AddOverBudgetCallback(OverBudgetCallback callback) {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mOverBudgetCallbacks.push_back(std::move(callback));
+    }
+
+    void MemoryBudget::WaitForOverBudgetCallbacks() {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mOverBudgetCondition.wait(lock, [this] { return !mIsOverBudgetTaskPending.load(); });
+    }
+
+    uint64_t MemoryBudget::GetUsage() const {
+        return mUsage.load();
+    }
+
+    uint64_t MemoryBudget::GetHardLimit() const {
+        return mHardLimit.load();
+    }
+
+    uint64_t MemoryBudget::GetSoftLimit() const {
+        return mSoftLimit.load();
+    }
+
+    uint64_t MemoryBudget::GetAvailableForAllocation() const {
+        const uint64_t hardLimit = mHardLimit.load();
+        if (hardLimit == kInvalidSize) {
+            return kInvalidSize;
+        }
+
+        const uint64_t usage = mUsage.load();
+        return (usage < hardLimit) ? hardLimit - usage : 0;
+    }
+
+    void MemoryBudget::RunOverBudgetCallbacksIfNeeded(uint64_t usage) {
+        if (usage <= mSoftLimit.load() || mIsOverBudgetTaskPending.exchange(true)) {
+            return;
+        }
+
+        TRACE_EVENT_INSTANT0(TraceEventCategory::kDefault, "MemoryBudget.OverBudget");
+
+        // Never post with |mMutex| held, the task needs it.
+        ThreadPool::PostTask(mThreadPool, std::make_shared<OverBudgetTask>(this),
+                             kOverBudgetWorkerThreadName, TaskPriority::kNormal);
+    }
+
+    void MemoryBudget::RunOverBudgetCallbacks() {
+        std::vector<OverBudgetCallback> callbacks;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            callbacks = mOverBudgetCallbacks;
+        }
+
+        // Stop once a callback released enough memory.
+        for (const OverBudgetCallback& callback : callbacks) {
+            const uint64_t usage = mUsage.load();
+            const uint64_t softLimit = mSoftLimit.load();
+            if (usage <= softLimit) {
+                break;
+            }
+            callback(usage - softLimit);
+        }
+
+        // Notify with |mMutex| held so |this| cannot be destroyed by a waiter beforehand.
+        std::lock_guard<std::mutex> lock(mMutex);
+        mIsOverBudgetTaskPending = false;
+        mOverBudgetCondition.notify_all();
+    }
+
+}  // namespace gpgmm
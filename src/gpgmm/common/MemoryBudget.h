@@ -0,0 +1,97 @@
+// Copyright 2022 The GPGMM Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GPGMM_COMMON_MEMORYBUDGET_H_
+#define GPGMM_COMMON_MEMORYBUDGET_H_
+
+#include "gpgmm/utils/Limits.h"
+#include "gpgmm/utils/NonCopyable.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace gpgmm {
+
+    class ThreadPool;
+
+    // MemoryBudget limits the total size of memory created by one or more allocators. Unlike the
+    // per-request AvailableForAllocation, which the caller computes up front, the budget is shared
+    // and updated as memory gets created or destroyed so any allocator in the chain can check how
+    // much memory is left at the time it decides.
+    //
+    // Reservations never exceed the hard limit. The soft limit may be exceeded but once it is,
+    // over-budget callbacks are run on the shared worker pool so they can release memory from any
+    // allocator without re-entering the allocator that exceeded it.
+    class MemoryBudget : public NonCopyable {
+      public:
+        using OverBudgetCallback = std::function<void(uint64_t bytesOverBudget)>;
+
+        explicit MemoryBudget(uint64_t hardLimit = kInvalidSize, uint64_t softLimit = kInvalidSize);
+        ~MemoryBudget();
+
+        // Reserves |size| bytes unless the hard limit would be exceeded.
+        bool TryReserve(uint64_t size);
+
+        // Reserves |size| bytes regardless of the hard limit, for memory that already exists.
+        void Reserve(uint64_t size);
+
+        void Release(uint64_t size);
+
+        // Changes the limits, for example once the OS budget changed. Usage above the new hard
+        // limit is not released but subsequent reservations fail until back under it.
+        void SetLimits(uint64_t hardLimit, uint64_t softLimit);
+
+        // Called with the number of bytes over the soft limit once exceeded.
+        void AddOverBudgetCallback(OverBudgetCallback callback);
+
+        // Blocks until previously scheduled over-budget callbacks have run.
+        void WaitForOverBudgetCallbacks();
+
+        uint64_t GetUsage() const;
+        uint64_t GetHardLimit() const;
+        uint64_t GetSoftLimit() const;
+
+        // Bytes left before reaching the hard limit, or kInvalidSize if unlimited. The soft limit
+        // is not accounted for since it may be exceeded.
+        uint64_t GetAvailableForAllocation() const;
+
+      private:
+        class OverBudgetTask;
+
+        void RunOverBudgetCallbacksIfNeeded(uint64_t usage);
+        void RunOverBudgetCallbacks();
+
+        std::atomic<uint64_t> mUsage = {0};
+        std::atomic<uint64_t> mHardLimit;
+        std::atomic<uint64_t> mSoftLimit;
+
+        // At most one over-budget task is scheduled at any time. Only cleared with |mMutex| held
+        // so waiters are notified.
+        std::atomic<bool> mIsOverBudgetTaskPending = {false};
+
+        mutable std::mutex mMutex;
+        std::condition_variable mOverBudgetCondition;
+        std::vector<OverBudgetCallback> mOverBudgetCallbacks;
+
+        std::shared_ptr<ThreadPool> mThreadPool;
+    };
+
+}  // namespace gpgmm
+
+#endif  // GPGMM_COMMON_MEMORYBUDGET_H_
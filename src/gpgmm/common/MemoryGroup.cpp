@@ -0,0 +1,59 @@
+// Copyright 2022 The GPGMM Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gpgmm/common/MemoryGroup.h"
+
+#include "gpgmm/utils/Assert.h"
+
+namespace gpgmm {
+
+    void MemoryGroupTracker::AddAllocation(uint64_t groupKey, IMemoryObject* memory) {
+        ASSERT(groupKey != kNoGroupKey);
+        ASSERT(memory != nullptr);
+
+        if (mGroups[groupKey][memory]++ == 0) {
+            mGroupMemoryCount++;
+        }
+    }
+
+    void MemoryGroupTracker::RemoveAllocation(uint64_t groupKey, IMemoryObject* memory) {
+        ASSERT(groupKey != kNoGroupKey);
+
+        auto groupIt = mGroups.find(groupKey);
+        ASSERT(groupIt != mGroups.end());
+
+        MemoryAllocationCounts& memoryCounts = groupIt->second;
+        auto memoryIt = memoryCounts.find(memory);
+        ASSERT(memoryIt != memoryCounts.end());
+
+        if (--memoryIt->second > 0) {
+            return;
+        }
+
+        mGroupMemoryCount--;
+        memoryCounts.erase(memoryIt);
+        if (memoryCounts.empty()) {
+            mGroups.erase(groupIt);
+        }
+    }
+
+    uint64_t MemoryGroupTracker::GetGroupCount() const {
+        return mGroups.size();
+    }
+
+    uint64_t MemoryGroupTracker::GetGroupMemoryCount() const {
+        return mGroupMemoryCount;
+    }
+
+}  // namespace gpgmm
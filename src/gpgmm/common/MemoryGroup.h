@@ -0,0 +1,52 @@
+// Copyright 2022 The GPGMM Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GPGMM_COMMON_MEMORYGROUP_H_
+#define GPGMM_COMMON_MEMORYGROUP_H_
+
+#include <cstdint>
+#include <unordered_map>
+
+namespace gpgmm {
+
+    class IMemoryObject;
+
+    // Group key of allocations that do not belong to any group.
+    static constexpr uint64_t kNoGroupKey = 0;
+
+    // Counts the distinct memory objects containing the allocations of each group. Allocations
+    // used together should be packed into as few memory objects as possible so fewer memory
+    // objects need to be made resident. Not thread-safe.
+    class MemoryGroupTracker {
+      public:
+        void AddAllocation(uint64_t groupKey, IMemoryObject* memory);
+        void RemoveAllocation(uint64_t groupKey, IMemoryObject* memory);
+
+        // Number of groups with at-least one allocation.
+        uint64_t GetGroupCount() const;
+
+        // Sum, over every group, of the number of memory objects containing its allocations.
+        uint64_t GetGroupMemoryCount() const;
+
+      private:
+        // Number of allocations of the group per memory object.
+        using MemoryAllocationCounts = std::unordered_map<IMemoryObject*, uint64_t>;
+
+        std::unordered_map<uint64_t, MemoryAllocationCounts> mGroups;
+        uint64_t mGroupMemoryCount = 0;
+    };
+
+}  // namespace gpgmm
+
+#endif  // GPGMM_COMMON_MEMORYGROUP_H_
@@ -14,6 +14,7 @@
 
 #include "gpgmm/common/MemoryPool.h"
 
+#include "gpgmm/common/MemoryAllocator.h"
 #include "gpgmm/common/TraceEvent.h"
 
 namespace gpgmm {
@@ -26,6 +27,15 @@ namespace gpgmm {
         GPGMM_TRACE_EVENT_OBJECT_DESTROY(this);
     }
 
+    // static
+    uint64_t MemoryPoolBase::DeallocatePooledMemory(PooledMemory& pooledMemory) {
+        MemoryAllocation& allocation = pooledMemory.Allocation;
+        const uint64_t allocationSize = allocation.GetSize();
+        allocation.GetAllocator()->DeallocateMemory(std::make_unique<MemoryAllocation>(allocation));
+        allocation = {};
+        return allocationSize;
+    }
+
     uint64_t MemoryPoolBase::GetMemorySize() const {
         return mMemorySize;
     }
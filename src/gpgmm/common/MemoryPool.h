@@ -19,6 +19,7 @@
 #include "gpgmm/utils/Limits.h"
 #include "include/gpgmm.h"
 
+#include <chrono>
 #include <memory>
 
 namespace gpgmm {
@@ -39,7 +40,8 @@ namespace gpgmm {
     To grow the pool, created memory allocations are inserted into the pool by ReturnToPool().
 
     To shrink the pool, existing allocations can removed out by AcquireFromPool() or de-allocated
-    together by ReleasePool().
+    together by ReleasePool(). Allocations are stamped with the time they were returned so the pool
+    always de-allocates the least recently used ones first.
     */
     class MemoryPoolBase : public IMemoryPool {
       public:
@@ -73,6 +75,22 @@ namespace gpgmm {
         */
         virtual uint64_t ReleasePool(uint64_t bytesToRelease = kInvalidSize) = 0;
 
+        /** \brief Deallocate memory allocations returned to the pool before the specified time.
+
+        @param lastUsedTime Time before which returned memory allocations get released.
+
+        \return Total amount, in bytes, released by the pool.
+        */
+        virtual uint64_t ReleasePoolOlderThan(
+            std::chrono::steady_clock::time_point lastUsedTime) = 0;
+
+        /** \brief Get the time the least recently used memory allocation was returned.
+
+        \return Time the oldest memory allocation in the pool was returned, or the max time if the
+        pool is empty.
+        */
+        virtual std::chrono::steady_clock::time_point GetLeastRecentlyUsedTime() const = 0;
+
         /** \brief Get the size of the pool.
 
         \return Number of memory allocations in the pool.
@@ -98,28 +116,14 @@ namespace gpgmm {
         const char* GetTypename() const;
 
       protected:
-        // Shrinks the size of the pool in |mMemorySize| sizes until |bytesToRelease| is reached.
-        template <typename T>
-        uint64_t TrimPoolUntil(T& pool, uint64_t bytesToRelease) {
-            uint64_t totalBytesReleased = 0;
-            uint64_t lastIndex = 0;
-            for (auto& allocation : pool) {
-                totalBytesReleased += allocation.GetSize();
-                allocation.GetAllocator()->DeallocateMemory(
-                    std::make_unique<MemoryAllocation>(allocation));
-                lastIndex++;
-                if (totalBytesReleased >= bytesToRelease) {
-                    break;
-                }
-            }
-
-            // Last is non-inclusive or [first, last).
-            if (lastIndex > 0) {
-                pool.erase(pool.begin(), pool.begin() + lastIndex);
-            }
-
-            return totalBytesReleased;
-        }
+        // Memory allocation stored in the pool and the time it was returned.
+        struct PooledMemory {
+            MemoryAllocation Allocation;
+            std::chrono::steady_clock::time_point LastUsedTime;
+        };
+
+        // De-allocates the memory of |pooledMemory| and returns the amount, in bytes, released.
+        static uint64_t DeallocatePooledMemory(PooledMemory& pooledMemory);
 
       private:
         uint64_t mMemorySize;
@@ -15,18 +15,41 @@
 #include "gpgmm/common/PooledMemoryAllocator.h"
 
 #include "gpgmm/common/LIFOMemoryPool.h"
+#include "gpgmm/common/SizeClass.h"
 #include "gpgmm/common/TraceEvent.h"
 #include "gpgmm/utils/Assert.h"
 #include "gpgmm/utils/Math.h"
 
+#include <algorithm>
+
 namespace gpgmm {
 
+    namespace {
+
+        // Converts a watermark, specified by count and size, into a count.
+        uint64_t GetWatermarkCount(uint64_t count, uint64_t usage, uint64_t memorySize) {
+            if (usage == kInvalidSize) {
+                return count;
+            }
+            return std::min(count, usage / memorySize);
+        }
+
+    }  // namespace
+
     PooledMemoryAllocator::PooledMemoryAllocator(uint64_t memorySize,
                                                  uint64_t memoryAlignment,
-                                                 std::unique_ptr<MemoryAllocator> memoryAllocator)
+                                                 std::unique_ptr<MemoryAllocator> memoryAllocator,
+                                                 const PoolWatermarkPolicy& watermarkPolicy)
         : MemoryAllocator(std::move(memoryAllocator)),
           mPool(new LIFOMemoryPool(memorySize)),
-          mMemoryAlignment(memoryAlignment) {
+          mMemoryAlignment(memoryAlignment),
+          mHighWatermarkCount(GetWatermarkCount(watermarkPolicy.HighWatermarkCount,
+                                                watermarkPolicy.HighWatermarkUsage,
+                                                memorySize)),
+          mLowWatermarkCount(std::min(GetWatermarkCount(watermarkPolicy.LowWatermarkCount,
+                                                        watermarkPolicy.LowWatermarkUsage,
+                                                        memorySize),
+                                      mHighWatermarkCount)) {
         ASSERT(IsAligned(memorySize, mMemoryAlignment));
     }
 
@@ -40,6 +63,26 @@ namespace gpgmm {
 
         std::lock_guard<std::mutex> lock(mMutex);
 
+        return TryAllocateMemoryInternal(request);
+    }
+
+    std::vector<std::unique_ptr<MemoryAllocation>> PooledMemoryAllocator::TryAllocateMemoryBatch(
+        const MemoryAllocationRequest* requests,
+        uint64_t count) {
+        TRACE_EVENT0(TraceEventCategory::kDefault, "PooledMemoryAllocator.TryAllocateMemoryBatch");
+
+        std::vector<std::unique_ptr<MemoryAllocation>> allocations(count);
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        for (uint64_t i = 0; i < count; i++) {
+            allocations[i] = TryAllocateMemoryInternal(requests[i]);
+        }
+
+        return allocations;
+    }
+
+    std::unique_ptr<MemoryAllocation> PooledMemoryAllocator::TryAllocateMemoryInternal(
+        const MemoryAllocationRequest& request) {
         GPGMM_INVALID_IF(!ValidateRequest(request));
 
         MemoryAllocation allocation = mPool->AcquireFromPool();
@@ -65,6 +108,23 @@ namespace gpgmm {
 
         std::lock_guard<std::mutex> lock(mMutex);
 
+        DeallocateMemoryInternal(std::move(allocation));
+    }
+
+    void PooledMemoryAllocator::DeallocateMemoryBatch(
+        std::vector<std::unique_ptr<MemoryAllocation>> allocations) {
+        TRACE_EVENT0(TraceEventCategory::kDefault, "PooledMemoryAllocator.DeallocateMemoryBatch");
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        for (auto& allocation : allocations) {
+            if (allocation != nullptr) {
+                DeallocateMemoryInternal(std::move(allocation));
+            }
+        }
+    }
+
+    void PooledMemoryAllocator::DeallocateMemoryInternal(
+        std::unique_ptr<MemoryAllocation> allocation) {
         const uint64_t& allocationSize = allocation->GetSize();
         mStats.FreeMemoryUsage += allocationSize;
         mStats.UsedMemoryCount--;
@@ -75,14 +135,34 @@ namespace gpgmm {
 
         mPool->ReturnToPool(
             MemoryAllocation(GetNextInChain(), memory, allocation->GetRequestSize()));
+
+        // Trim the pool back down to the low watermark once above the high watermark.
+        const uint64_t poolSize = mPool->GetPoolSize();
+        if (poolSize > mHighWatermarkCount) {
+            const uint64_t bytesReleased =
+                mPool->ReleasePool((poolSize - mLowWatermarkCount) * mPool->GetMemorySize());
+            mStats.FreeMemoryUsage -= bytesReleased;
+
+            GPGMM_TRACE_EVENT_METRIC("GPU pool trimmed (KB)", GPGMM_BYTES_TO_KB(bytesReleased));
+        }
     }
 
     uint64_t PooledMemoryAllocator::ReleaseMemory(uint64_t bytesToRelease) {
+        std::lock_guard<std::mutex> lock(mMutex);
         const uint64_t bytesReleased = mPool->ReleasePool(bytesToRelease);
         mStats.FreeMemoryUsage -= bytesReleased;
         return bytesReleased;
     }
 
+    uint64_t PooledMemoryAllocator::ReleaseMemoryOlderThan(
+        std::chrono::steady_clock::duration duration) {
+        std::lock_guard<std::mutex> lock(mMutex);
+        const uint64_t bytesReleased =
+            mPool->ReleasePoolOlderThan(std::chrono::steady_clock::now() - duration);
+        mStats.FreeMemoryUsage -= bytesReleased;
+        return bytesReleased;
+    }
+
     uint64_t PooledMemoryAllocator::GetMemorySize() const {
         return mPool->GetMemorySize();
     }
@@ -21,26 +21,61 @@ namespace gpgmm {
 
     class MemoryPoolBase;
 
+    // Bounds the free memory kept by the pool. Once returned memory grows the pool above the high
+    // watermark, the pool is trimmed, least recently used first, down to the low watermark. Each
+    // watermark can be specified by count, size in bytes, or both, where the lower of the two is
+    // used. By default, the pool is never trimmed automatically.
+    struct PoolWatermarkPolicy {
+        // Max number of free memory allocations kept in the pool.
+        uint64_t HighWatermarkCount = kInvalidSize;
+
+        // Max total size, in bytes, of free memory allocations kept in the pool.
+        uint64_t HighWatermarkUsage = kInvalidSize;
+
+        // Number of free memory allocations kept once trimmed. Defaults to the high watermark.
+        uint64_t LowWatermarkCount = kInvalidSize;
+
+        // Total size, in bytes, of free memory allocations kept once trimmed. Defaults to the high
+        // watermark.
+        uint64_t LowWatermarkUsage = kInvalidSize;
+    };
+
     // |PooledMemoryAllocator| allocates memory of fixed size and same alignment using a pool.
     class PooledMemoryAllocator final : public MemoryAllocator {
       public:
         PooledMemoryAllocator(uint64_t memorySize,
                               uint64_t memoryAlignment,
-                              std::unique_ptr<MemoryAllocator> memoryAllocator);
+                              std::unique_ptr<MemoryAllocator> memoryAllocator,
+                              const PoolWatermarkPolicy& watermarkPolicy = {});
         ~PooledMemoryAllocator() override;
 
         // MemoryAllocator interface
         std::unique_ptr<MemoryAllocation> TryAllocateMemory(
             const MemoryAllocationRequest& request) override;
         void DeallocateMemory(std::unique_ptr<MemoryAllocation> allocation) override;
+        std::vector<std::unique_ptr<MemoryAllocation>> TryAllocateMemoryBatch(
+            const MemoryAllocationRequest* requests,
+            uint64_t count) override;
+        void DeallocateMemoryBatch(
+            std::vector<std::unique_ptr<MemoryAllocation>> allocations) override;
         uint64_t ReleaseMemory(uint64_t bytesToRelease = kInvalidSize) override;
+        uint64_t ReleaseMemoryOlderThan(std::chrono::steady_clock::duration duration) override;
         uint64_t GetMemorySize() const override;
         uint64_t GetMemoryAlignment() const override;
         const char* GetTypename() const override;
 
       private:
+        // Must be called with |mMutex| held.
+        std::unique_ptr<MemoryAllocation> TryAllocateMemoryInternal(
+            const MemoryAllocationRequest& request);
+        void DeallocateMemoryInternal(std::unique_ptr<MemoryAllocation> allocation);
+
         std::unique_ptr<MemoryPoolBase> mPool;
         uint64_t mMemoryAlignment;
+
+        // Watermarks, in number of memory allocations in the pool.
+        const uint64_t mHighWatermarkCount;
+        const uint64_t mLowWatermarkCount;
     };
 
 }  // namespace gpgmm
@@ -19,50 +19,23 @@
 #include "gpgmm/utils/Math.h"
 #include "gpgmm/utils/Utils.h"
 
-namespace gpgmm {
-
-    // Helper for FindSegment to find the middle of a linked-list.
-    LinkNode<MemorySegment>* GetMiddleSegment(LinkNode<MemorySegment>* start,
-                                              LinkNode<MemorySegment>* end) {
-        LinkNode<MemorySegment>* slow = start;
-        LinkNode<MemorySegment>* fast = start->next();
-        while (fast != end) {
-            fast = fast->next();
-            if (fast != end) {
-                slow = slow->next();
-                fast = fast->next();
-            }
-        }
+#include <algorithm>
+#include <queue>
 
-        return slow;
-    }
-
-    // Perform a slower, O(n) binary search, over a non-contigious array (linked-list).
-    LinkNode<MemorySegment>* FindSegment(LinkNode<MemorySegment>* start,
-                                         LinkNode<MemorySegment>* end,
-                                         uint64_t size) {
-        LinkNode<MemorySegment>* left = start;
-        LinkNode<MemorySegment>* right = end;
-
-        while (left != right) {
-            LinkNode<MemorySegment>* middle = GetMiddleSegment(left, right);
-            if (middle == nullptr) {
-                return nullptr;
-            }
-            if (middle->value()->GetMemorySize() == size) {
-                return middle;
+namespace gpgmm {
 
-            } else if (middle->value()->GetMemorySize() > size) {
-                // Smaller then middle, go left.
-                right = middle;
+    namespace {
 
-            } else {
-                // Larger then middle, go right.
-                left = middle->next();
-            }
+        // Returns the first segment no smaller than |memorySize|.
+        template <typename SegmentEntryT>
+        auto FindSegment(const std::vector<SegmentEntryT>& segments, uint64_t memorySize) {
+            return std::lower_bound(segments.begin(), segments.end(), memorySize,
+                                    [](const SegmentEntryT& entry, uint64_t size) {
+                                        return entry.MemorySize < size;
+                                    });
         }
-        return left;
-    }
+
+    }  // namespace
 
     // MemorySegment
 
@@ -70,9 +43,6 @@ namespace gpgmm {
     }
 
     MemorySegment::~MemorySegment() {
-        if (IsInList()) {
-            RemoveFromList();
-        }
         ReleasePool();
     }
 
@@ -80,8 +50,12 @@ namespace gpgmm {
 
     SegmentedMemoryAllocator::SegmentedMemoryAllocator(
         std::unique_ptr<MemoryAllocator> memoryAllocator,
-        uint64_t memoryAlignment)
-        : MemoryAllocator(std::move(memoryAllocator)), mMemoryAlignment(memoryAlignment) {
+        uint64_t memoryAlignment,
+        double segmentFitLimit)
+        : MemoryAllocator(std::move(memoryAllocator)),
+          mMemoryAlignment(memoryAlignment),
+          mSegmentFitLimit(segmentFitLimit) {
+        ASSERT(mSegmentFitLimit >= 0);
     }
 
     SegmentedMemoryAllocator::~SegmentedMemoryAllocator() {
@@ -89,34 +63,31 @@ namespace gpgmm {
     }
 
     MemorySegment* SegmentedMemoryAllocator::GetOrCreateFreeSegment(uint64_t memorySize) {
-        LinkNode<MemorySegment>* existingFreeSegment =
-            FindSegment(mFreeSegments.head(), mFreeSegments.tail(), memorySize);
-
-        // List is empty, append it at end.
-        if (existingFreeSegment == mFreeSegments.end()) {
-            ASSERT(mFreeSegments.empty());
-            MemorySegment* newFreeSegment = new MemorySegment{memorySize};
-            newFreeSegment->InsertAfter(mFreeSegments.tail());
-            return newFreeSegment;
-        }
-
-        ASSERT(existingFreeSegment->value() != nullptr);
+        auto it = FindSegment(mFreeSegments, memorySize);
 
         // Segment already exists, reuse it.
-        if (existingFreeSegment->value()->GetMemorySize() == memorySize) {
-            return existingFreeSegment->value();
+        if (it != mFreeSegments.end() && it->MemorySize == memorySize) {
+            return it->Segment.get();
         }
 
-        MemorySegment* newFreeSegment = new MemorySegment{memorySize};
-
         // Or insert a new segment in sorted order.
-        if (memorySize > existingFreeSegment->value()->GetMemorySize()) {
-            newFreeSegment->InsertAfter(existingFreeSegment);
-        } else {
-            newFreeSegment->InsertBefore(existingFreeSegment);
+        it = mFreeSegments.insert(
+            it, SegmentEntry{memorySize, std::make_unique<MemorySegment>(memorySize)});
+        return it->Segment.get();
+    }
+
+    MemorySegment* SegmentedMemoryAllocator::FindBestFitSegment(uint64_t memorySize) const {
+        const double maxMemorySize = memorySize * (1 + mSegmentFitLimit);
+
+        // Use the smallest larger segment that has free memory.
+        for (auto it = FindSegment(mFreeSegments, memorySize + 1);
+             it != mFreeSegments.end() && it->MemorySize <= maxMemorySize; it++) {
+            if (it->Segment->GetPoolSize() > 0) {
+                return it->Segment.get();
+            }
         }
 
-        return newFreeSegment;
+        return nullptr;
     }
 
     std::unique_ptr<MemoryAllocation> SegmentedMemoryAllocator::TryAllocateMemory(
@@ -125,12 +96,41 @@ namespace gpgmm {
 
         std::lock_guard<std::mutex> lock(mMutex);
 
+        return TryAllocateMemoryInternal(request);
+    }
+
+    std::vector<std::unique_ptr<MemoryAllocation>> SegmentedMemoryAllocator::TryAllocateMemoryBatch(
+        const MemoryAllocationRequest* requests,
+        uint64_t count) {
+        TRACE_EVENT0(TraceEventCategory::kDefault,
+                     "SegmentedMemoryAllocator.TryAllocateMemoryBatch");
+
+        std::vector<std::unique_ptr<MemoryAllocation>> allocations(count);
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        for (uint64_t i = 0; i < count; i++) {
+            allocations[i] = TryAllocateMemoryInternal(requests[i]);
+        }
+
+        return allocations;
+    }
+
+    std::unique_ptr<MemoryAllocation> SegmentedMemoryAllocator::TryAllocateMemoryInternal(
+        const MemoryAllocationRequest& request) {
         GPGMM_INVALID_IF(!ValidateRequest(request));
 
         const uint64_t memorySize = AlignTo(request.SizeInBytes, mMemoryAlignment);
         MemorySegment* segment = GetOrCreateFreeSegment(memorySize);
         ASSERT(segment != nullptr);
 
+        // Re-use larger memory before creating new memory, if allowed.
+        if (segment->GetPoolSize() == 0 && mSegmentFitLimit > 0) {
+            MemorySegment* bestFitSegment = FindBestFitSegment(memorySize);
+            if (bestFitSegment != nullptr) {
+                segment = bestFitSegment;
+            }
+        }
+
         MemoryAllocation allocation = segment->AcquireFromPool();
         if (allocation == GPGMM_ERROR_INVALID_ALLOCATION) {
             std::unique_ptr<MemoryAllocation> allocationPtr;
@@ -155,6 +155,24 @@ namespace gpgmm {
 
         std::lock_guard<std::mutex> lock(mMutex);
 
+        DeallocateMemoryInternal(std::move(allocation));
+    }
+
+    void SegmentedMemoryAllocator::DeallocateMemoryBatch(
+        std::vector<std::unique_ptr<MemoryAllocation>> allocations) {
+        TRACE_EVENT0(TraceEventCategory::kDefault,
+                     "SegmentedMemoryAllocator.DeallocateMemoryBatch");
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        for (auto& allocation : allocations) {
+            if (allocation != nullptr) {
+                DeallocateMemoryInternal(std::move(allocation));
+            }
+        }
+    }
+
+    void SegmentedMemoryAllocator::DeallocateMemoryInternal(
+        std::unique_ptr<MemoryAllocation> allocation) {
         ASSERT(allocation != nullptr);
 
         const uint64_t& allocationSize = allocation->GetSize();
@@ -175,30 +193,61 @@ namespace gpgmm {
     uint64_t SegmentedMemoryAllocator::ReleaseMemory(uint64_t bytesToRelease) {
         std::lock_guard<std::mutex> lock(mMutex);
 
-        uint64_t totalBytesReleased = 0;
-        for (auto& node : mFreeSegments) {
-            MemorySegment* segment = node.value();
+        // Release the least recently used memory first, regardless of which segment it belongs
+        // to, by always releasing from the segment whose oldest memory is the oldest.
+        using SegmentAndTime = std::pair<std::chrono::steady_clock::time_point, MemorySegment*>;
+        std::priority_queue<SegmentAndTime, std::vector<SegmentAndTime>, std::greater<>>
+            leastRecentlyUsedSegments;
+        for (auto& entry : mFreeSegments) {
+            MemorySegment* segment = entry.Segment.get();
             ASSERT(segment != nullptr);
-            const uint64_t bytesReleasedPerSegment = segment->ReleasePool(bytesToRelease);
-            bytesToRelease -= bytesReleasedPerSegment;
-            mStats.FreeMemoryUsage -= bytesReleasedPerSegment;
-            totalBytesReleased += bytesReleasedPerSegment;
+            if (segment->GetPoolSize() > 0) {
+                leastRecentlyUsedSegments.push({segment->GetLeastRecentlyUsedTime(), segment});
+            }
+        }
+
+        uint64_t totalBytesReleased = 0;
+        while (!leastRecentlyUsedSegments.empty() && totalBytesReleased < bytesToRelease) {
+            MemorySegment* segment = leastRecentlyUsedSegments.top().second;
+            leastRecentlyUsedSegments.pop();
 
-            if (totalBytesReleased >= bytesToRelease) {
-                break;
+            // Releasing the size of one memory releases only the oldest memory.
+            const uint64_t bytesReleased = segment->ReleasePool(segment->GetMemorySize());
+            mStats.FreeMemoryUsage -= bytesReleased;
+            totalBytesReleased += bytesReleased;
+
+            if (segment->GetPoolSize() > 0) {
+                leastRecentlyUsedSegments.push({segment->GetLeastRecentlyUsedTime(), segment});
             }
         }
 
         return totalBytesReleased;
     }
 
+    uint64_t SegmentedMemoryAllocator::ReleaseMemoryOlderThan(
+        std::chrono::steady_clock::duration duration) {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        const std::chrono::steady_clock::time_point lastUsedTime =
+            std::chrono::steady_clock::now() - duration;
+
+        uint64_t totalBytesReleased = 0;
+        for (auto& entry : mFreeSegments) {
+            const uint64_t bytesReleased = entry.Segment->ReleasePoolOlderThan(lastUsedTime);
+            mStats.FreeMemoryUsage -= bytesReleased;
+            totalBytesReleased += bytesReleased;
+        }
+
+        return totalBytesReleased;
+    }
+
     uint64_t SegmentedMemoryAllocator::GetMemoryAlignment() const {
         return mMemoryAlignment;
     }
 
     uint64_t SegmentedMemoryAllocator::GetSegmentSizeForTesting() const {
         std::lock_guard<std::mutex> lock(mMutex);
-        return std::distance(mFreeSegments.begin(), mFreeSegments.end());
+        return mFreeSegments.size();
     }
 
     const char* SegmentedMemoryAllocator::GetTypename() const {
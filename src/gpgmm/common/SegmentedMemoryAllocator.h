@@ -17,14 +17,14 @@
 
 #include "gpgmm/common/LIFOMemoryPool.h"
 #include "gpgmm/common/MemoryAllocator.h"
-#include "gpgmm/utils/LinkedList.h"
+
+#include <memory>
+#include <vector>
 
 namespace gpgmm {
 
-    // Represents one or more memory blocks managed in a pool.
-    // A memory segment is a node in a linked-list so it may be cached and reuse by the segmented
-    // allocator.
-    class MemorySegment final : public LIFOMemoryPool, public LinkNode<MemorySegment> {
+    // Represents one or more memory blocks, of the same size, managed in a pool.
+    class MemorySegment final : public LIFOMemoryPool {
       public:
         explicit MemorySegment(uint64_t memorySize);
         ~MemorySegment() override;
@@ -32,28 +32,53 @@ namespace gpgmm {
 
     // SegmentedMemoryAllocator maintains a sorted segmented list of memory pools to allocate
     // variable-size memory blocks.
+    //
+    // |segmentFitLimit| enables best-fit, where memory of a larger segment is re-used when the
+    // segment of the requested size has none free. It is the max fraction the larger segment's
+    // size could exceed the requested size by. A limit of 0 only re-uses memory of the same size.
     class SegmentedMemoryAllocator : public MemoryAllocator {
       public:
         SegmentedMemoryAllocator(std::unique_ptr<MemoryAllocator> memoryAllocator,
-                                 uint64_t memoryAlignment);
+                                 uint64_t memoryAlignment,
+                                 double segmentFitLimit = 0);
         ~SegmentedMemoryAllocator() override;
 
         // MemoryAllocator interface
         std::unique_ptr<MemoryAllocation> TryAllocateMemory(
             const MemoryAllocationRequest& request) override;
         void DeallocateMemory(std::unique_ptr<MemoryAllocation> allocation) override;
+        std::vector<std::unique_ptr<MemoryAllocation>> TryAllocateMemoryBatch(
+            const MemoryAllocationRequest* requests,
+            uint64_t count) override;
+        void DeallocateMemoryBatch(
+            std::vector<std::unique_ptr<MemoryAllocation>> allocations) override;
         uint64_t ReleaseMemory(uint64_t bytesToRelease = kInvalidSize) override;
+        uint64_t ReleaseMemoryOlderThan(std::chrono::steady_clock::duration duration) override;
         uint64_t GetMemoryAlignment() const override;
         const char* GetTypename() const override;
 
         uint64_t GetSegmentSizeForTesting() const;
 
       private:
+        // Must be called with |mMutex| held.
+        std::unique_ptr<MemoryAllocation> TryAllocateMemoryInternal(
+            const MemoryAllocationRequest& request);
+        void DeallocateMemoryInternal(std::unique_ptr<MemoryAllocation> allocation);
+
         MemorySegment* GetOrCreateFreeSegment(uint64_t memorySize);
+        MemorySegment* FindBestFitSegment(uint64_t memorySize) const;
+
+        // Segments are kept by-value in sorted order of size so a lookup binary searches
+        // contiguous sizes, instead of chasing pointers.
+        struct SegmentEntry {
+            uint64_t MemorySize;
+            std::unique_ptr<MemorySegment> Segment;
+        };
 
-        LinkedList<MemorySegment> mFreeSegments;
+        std::vector<SegmentEntry> mFreeSegments;
 
         const uint64_t mMemoryAlignment;
+        const double mSegmentFitLimit;
     };
 
 }  // namespace gpgmm
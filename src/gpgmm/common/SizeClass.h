@@ -15,6 +15,8 @@
 #ifndef GPGMM_COMMON_SIZECLASS_H_
 #define GPGMM_COMMON_SIZECLASS_H_
 
+#include "gpgmm/utils/Math.h"
+
 #include <array>
 
 // Convert sizes, in bytes, to/from SI prefix.
@@ -53,6 +55,54 @@ namespace gpgmm {
         return sizeArray;
     }
 
+    // Sizes are grouped into power-of-two ranges, then each range is split again into
+    // kSizeClassSubCount equally spaced size classes. This bounds the number of size classes by
+    // the log of the largest size while any size still maps to its class index in O(1).
+    static constexpr uint64_t kLog2SizeClassSubCount = 2;
+    static constexpr uint64_t kSizeClassSubCount = 1ull << kLog2SizeClassSubCount;
+
+    // Returns the smallest size of the size class at |index|, along with its granularity.
+    static constexpr SizeClassInfo GetSizeClassInfo(uint64_t index) {
+        if (index < kSizeClassSubCount) {
+            return {index, 1};
+        }
+        const uint64_t log2Size = index / kSizeClassSubCount + kLog2SizeClassSubCount - 1;
+        const uint64_t granularity = 1ull << (log2Size - kLog2SizeClassSubCount);
+        return {(1ull << log2Size) + (index % kSizeClassSubCount) * granularity, granularity};
+    }
+
+    // Generates array containing the first N size classes, indexed by size class.
+    template <size_t N>
+    static constexpr std::array<SizeClassInfo, N> GenerateSizeClasses() {
+        std::array<SizeClassInfo, N> sizeArray{};
+        for (size_t i = 0; i < N; ++i) {
+            sizeArray[i] = GetSizeClassInfo(i);
+        }
+        return sizeArray;
+    }
+
+    // Returns the index of the size class containing |size|, using only a few bit operations.
+    inline uint64_t GetSizeClassIndex(uint64_t size) {
+        if (size < kSizeClassSubCount) {
+            return size;
+        }
+        const uint64_t log2Size = Log2(size);
+        const uint64_t subIndex =
+            (size >> (log2Size - kLog2SizeClassSubCount)) & (kSizeClassSubCount - 1);
+        return (log2Size - kLog2SizeClassSubCount + 1) * kSizeClassSubCount + subIndex;
+    }
+
+    // Rounds |size| up to the next of |classesPerDoubling| equally spaced sizes within its
+    // power-of-two range, where |classesPerDoubling| is a power-of-two. Rounding wastes less than
+    // 1 / (|classesPerDoubling| + 1) of the rounded size.
+    inline uint64_t AlignToSizeClass(uint64_t size, uint64_t classesPerDoubling) {
+        if (size <= classesPerDoubling) {
+            return size;
+        }
+        const uint64_t granularity = (1ull << Log2(size)) / classesPerDoubling;
+        return AlignTo(size, granularity);
+    }
+
     class MemorySizeClass {
       protected:
         static constexpr auto GenerateAllClassSizes() {
@@ -20,49 +20,46 @@
 #include "gpgmm/utils/Math.h"
 #include "gpgmm/utils/Utils.h"
 
+#include <algorithm>
+
 namespace gpgmm {
 
+    static constexpr uint64_t kBitsPerWord = 64u;
+
     SlabBlockAllocator::SlabBlockAllocator(uint64_t blockCount, uint64_t blockSize)
-        : mBlockCount(blockCount), mBlockSize(blockSize), mNextFreeBlockIndex(0) {
+        : mBlockCount(blockCount), mBlockSize(blockSize) {
         ASSERT(mBlockCount > 0);
         ASSERT(mBlockSize > 0);
-
-        SlabBlock* head = new SlabBlock{};
-        head->Offset = 0;
-        head->Size = blockSize;
-        mFreeList.pHead = head;
     }
 
-    SlabBlockAllocator::SlabBlockAllocator(const SlabBlockAllocator& other)
-        : mFreeList(other.mFreeList),
-          mBlockCount(other.mBlockCount),
-          mBlockSize(other.mBlockSize),
-          mNextFreeBlockIndex(other.mNextFreeBlockIndex) {
-    }
+    void SlabBlockAllocator::CreateBlocks() {
+        ASSERT(mBlocks == nullptr);
+        ASSERT(mFreeBitmap == nullptr);
 
-    SlabBlockAllocator& SlabBlockAllocator::operator=(const SlabBlockAllocator& other) {
-        if (this == &other) {
-            return *this;
+        mBlocks = std::make_unique<SlabBlock[]>(mBlockCount);
+        for (uint64_t blockIndex = 0; blockIndex < mBlockCount; blockIndex++) {
+            mBlocks[blockIndex].Offset = blockIndex * mBlockSize;
+            mBlocks[blockIndex].Size = mBlockSize;
         }
-        mFreeList = other.mFreeList;
-        mBlockCount = other.mBlockCount;
-        mBlockSize = other.mBlockSize;
-        mNextFreeBlockIndex = other.mNextFreeBlockIndex;
-        return *this;
-    }
 
-    void SlabBlockAllocator::ReleaseBlocks() {
-        SlabBlock* head = mFreeList.pHead;
-        while (head != nullptr) {
-            ASSERT(head != nullptr);
-            SlabBlock* next = head->pNext;
-            SafeDelete(head);
-            head = next;
+        // Mark every block free, except the bits past the last block.
+        const uint64_t wordCount = (mBlockCount + kBitsPerWord - 1) / kBitsPerWord;
+        mFreeBitmap = std::make_unique<uint64_t[]>(wordCount);
+        for (uint64_t wordIndex = 0; wordIndex < wordCount; wordIndex++) {
+            mFreeBitmap[wordIndex] = ~0ull;
         }
 
-        // Invalidate the head to prevent calling ReleaseBlocks() again resulting into a
-        // use-after-free.
-        mFreeList.pHead = nullptr;
+        const uint64_t remainingBitCount = mBlockCount % kBitsPerWord;
+        if (remainingBitCount > 0) {
+            mFreeBitmap[wordCount - 1] = (1ull << remainingBitCount) - 1;
+        }
+
+        mFirstFreeWordIndex = 0;
+    }
+
+    void SlabBlockAllocator::ReleaseBlocks() {
+        mBlocks = nullptr;
+        mFreeBitmap = nullptr;
     }
 
     MemoryBlock* SlabBlockAllocator::TryAllocateBlock(uint64_t requestSize, uint64_t alignment) {
@@ -72,39 +69,77 @@ namespace gpgmm {
         // Offset must be equal to a multiple of |mBlockSize|.
         GPGMM_INVALID_IF(!IsAligned(mBlockSize, alignment));
 
-        // Pop off HEAD in the free-list.
-        SlabBlock* head = mFreeList.pHead;
-        if (head == nullptr) {
-            mFreeList.pHead = nullptr;
-        } else {
-            mFreeList.pHead = mFreeList.pHead->pNext;
+        if (mBlocks == nullptr) {
+            CreateBlocks();
         }
 
-        // And push new block at HEAD if not full.
-        if (mFreeList.pHead == nullptr && mNextFreeBlockIndex + 1 < mBlockCount) {
-            mFreeList.pHead = new SlabBlock{};
-            mFreeList.pHead->Offset = ++mNextFreeBlockIndex * mBlockSize;
-            mFreeList.pHead->Size = mBlockSize;
+        // Find the first word with a free block. Since blocks are always allocated from the
+        // lowest index, words before |mFirstFreeWordIndex| never need to be scanned again.
+        const uint64_t wordCount = (mBlockCount + kBitsPerWord - 1) / kBitsPerWord;
+        while (mFirstFreeWordIndex < wordCount && mFreeBitmap[mFirstFreeWordIndex] == 0) {
+            mFirstFreeWordIndex++;
         }
 
-        return head;
+        // Slab is full.
+        if (mFirstFreeWordIndex == wordCount) {
+            return nullptr;
+        }
+
+        uint64_t& freeBits = mFreeBitmap[mFirstFreeWordIndex];
+        const uint64_t blockIndex = mFirstFreeWordIndex * kBitsPerWord + ScanForward(freeBits);
+        ASSERT(blockIndex < mBlockCount);
+
+        // Mark the lowest free block as used.
+        freeBits &= freeBits - 1;
+
+        return &mBlocks[blockIndex];
     }
 
     void SlabBlockAllocator::DeallocateBlock(MemoryBlock* block) {
         ASSERT(block != nullptr);
+        ASSERT(mBlocks != nullptr);
 
-        SlabBlock* currBlock = static_cast<SlabBlock*>(block);
+        const uint64_t blockIndex = static_cast<SlabBlock*>(block) - mBlocks.get();
+        ASSERT(blockIndex < mBlockCount);
 
-        // Push block to HEAD
-        SlabBlock* head = mFreeList.pHead;
-        mFreeList.pHead = currBlock;
-        currBlock->pNext = head;
+        const uint64_t wordIndex = blockIndex / kBitsPerWord;
+        const uint64_t blockBit = 1ull << (blockIndex % kBitsPerWord);
+        ASSERT((mFreeBitmap[wordIndex] & blockBit) == 0);
+
+        // Mark the block as free.
+        mFreeBitmap[wordIndex] |= blockBit;
+        mFirstFreeWordIndex = std::min(mFirstFreeWordIndex, wordIndex);
     }
 
     uint64_t SlabBlockAllocator::GetBlockCount() const {
         return mBlockCount;
     }
 
+    std::vector<uint64_t> SlabBlockAllocator::GetFreeBlockOffsets(uint64_t maxCount) const {
+        std::vector<uint64_t> offsets;
+
+        // Blocks are not created until first allocated, so every block is free.
+        if (mFreeBitmap == nullptr) {
+            for (uint64_t blockIndex = 0; blockIndex < std::min(mBlockCount, maxCount);
+                 blockIndex++) {
+                offsets.push_back(blockIndex * mBlockSize);
+            }
+            return offsets;
+        }
+
+        const uint64_t wordCount = (mBlockCount + kBitsPerWord - 1) / kBitsPerWord;
+        for (uint64_t wordIndex = mFirstFreeWordIndex; wordIndex < wordCount; wordIndex++) {
+            uint64_t freeBits = mFreeBitmap[wordIndex];
+            while (freeBits != 0 && offsets.size() < maxCount) {
+                const uint64_t blockIndex = wordIndex * kBitsPerWord + ScanForward(freeBits);
+                offsets.push_back(blockIndex * mBlockSize);
+                freeBits &= freeBits - 1;
+            }
+        }
+
+        return offsets;
+    }
+
     const char* SlabBlockAllocator::GetTypename() const {
         return "SlabBlockAllocator";
     }
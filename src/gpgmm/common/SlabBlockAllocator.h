@@ -17,6 +17,9 @@
 
 #include "gpgmm/common/BlockAllocator.h"
 
+#include <memory>
+#include <vector>
+
 namespace gpgmm {
 
     struct Slab;
@@ -24,25 +27,29 @@ namespace gpgmm {
     // SlabBlock keeps a reference back to the slab to avoid creating a copy of the block with the
     // slab being allocated from.
     struct SlabBlock : public MemoryBlock {
-        SlabBlock* pNext = nullptr;
         Slab** ppSlab = nullptr;
     };
 
     // SlabBlockAllocator uses the slab allocation technique to satisfy an
     // a block-allocation request. A slab consists of contiguious memory carved up into
     // fixed-size blocks (also called "pages" or "chunks"). The slab allocator
-    // allocates within a slab by marking a block as "used" by removing it from
-    // the free-list. To deallocate, the same block is marked "free" by inserting it
-    // back to the free-list. This simple push/pop operation means
-    // slab block allocation is always fast.
+    // allocates within a slab by marking a block as "used" by clearing its bit in the slab's
+    // occupancy bitmap. To deallocate, the same bit is set again. The first free block is found by
+    // scanning the bitmap a word at a time, so slab block allocation is always fast.
+    //
+    // Block descriptors are stored contiguously, one per block, and created once per slab. They
+    // are owned by the allocator, so it can only be moved.
     class SlabBlockAllocator final : public BlockAllocator {
       public:
         SlabBlockAllocator() = default;
         SlabBlockAllocator(uint64_t blockCount, uint64_t blockSize);
         ~SlabBlockAllocator() override = default;
 
-        SlabBlockAllocator(const SlabBlockAllocator& other);
-        SlabBlockAllocator& operator=(const SlabBlockAllocator& other);
+        SlabBlockAllocator(const SlabBlockAllocator&) = delete;
+        SlabBlockAllocator& operator=(const SlabBlockAllocator&) = delete;
+
+        SlabBlockAllocator(SlabBlockAllocator&&) = default;
+        SlabBlockAllocator& operator=(SlabBlockAllocator&&) = default;
 
         void ReleaseBlocks();
 
@@ -52,19 +59,27 @@ namespace gpgmm {
 
         uint64_t GetBlockCount() const;
 
+        // Returns the offsets of up to |maxCount| free blocks, lowest first. This is also the
+        // order TryAllocateBlock() allocates them in.
+        std::vector<uint64_t> GetFreeBlockOffsets(uint64_t maxCount) const;
+
         const char* GetTypename() const override;
 
       private:
-        struct BlockList {
-            SlabBlock* pHead = nullptr;  // First free block in slab.
-        };
+        // Creates the block descriptors and bitmap upon first use since a slab could be created
+        // but never allocated from.
+        void CreateBlocks();
 
-        BlockList mFreeList;
+        // Descriptor of each block, indexed by block.
+        std::unique_ptr<SlabBlock[]> mBlocks;
+
+        // Bit is set if the block of the same index is free.
+        std::unique_ptr<uint64_t[]> mFreeBitmap;
+
+        uint64_t mFirstFreeWordIndex = 0;  // Bitmap words before this index have no free blocks.
 
         uint64_t mBlockCount = kInvalidSize;
         uint64_t mBlockSize = kInvalidSize;
-
-        uint64_t mNextFreeBlockIndex = kInvalidIndex;  // Next index or "slot" in the slab.
     };
 
 }  // namespace gpgmm
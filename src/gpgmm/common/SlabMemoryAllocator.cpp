@@ -18,18 +18,31 @@
 #include "gpgmm/common/Memory.h"
 #include "gpgmm/common/SizeClass.h"
 #include "gpgmm/utils/Assert.h"
+#include "gpgmm/utils/PlatformTime.h"
 #include "gpgmm/utils/Utils.h"
 
-#include <algorithm>  // std::max
+#include <algorithm>  // std::find_if, std::max, std::remove, std::sort
+#include <unordered_map>
 
 namespace gpgmm {
 
     // Disables pre-fetching from slabs that contain too few allocations.
     constexpr static uint64_t kSlabPrefetchMinBlockCount = 4u;
 
-    // Disables pre-fetching of memory objects that are under-utilizied.
+    // Disables pre-fetching of memory objects that are under-utilizied, until the time to create
+    // slab memory was measured.
     constexpr static double kSlabPrefetchUsageThreshold = 0.50;
 
+    // Pre-fetching starts once the slabs are expected to run out of free blocks within this
+    // multiple of the time to create slab memory, which leaves slack for the estimates.
+    constexpr static double kSlabPrefetchLeadTimeFactor = 1.5;
+
+    // Weight of the latest sample in the slab memory creation time estimate.
+    constexpr static double kSlabCreationTimeSmoothing = 1.0 / 4;
+
+    // Weight of the latest sample in the time between allocations estimate.
+    constexpr static double kAllocationIntervalSmoothing = 1.0 / 8;
+
     // Disables pre-fetching of memory objects that are too large.
     // Larger memory objects require more time on the device to allocate memory and could block a
     // subsequent allocation request using the device with a previously allocated memory object.
@@ -38,11 +51,28 @@ namespace gpgmm {
     // allocation.
     constexpr static uint64_t kSlabPrefetchMemorySizeThreshold = GPGMM_MB_TO_BYTES(64);
 
+    // Max. number of slabs whose memory is prefetched ahead of use, per slab allocator.
+    constexpr static uint64_t kMaxSlabPrefetchQueueDepth = 4u;
+
+    // Max. number of prefetched memory objects kept until a slab of their size is needed.
+    constexpr static uint64_t kMaxParkedSlabMemoryCount = 4u;
+
     // Coverage is the fraction of total misses that should be eliminated because of pre-fetching.
     // If coverage goes below the specified min. coverage threshold, a warning event will be
     // emitted.
     constexpr static double kPrefetchCoverageWarnMinThreshold = 0.50;
 
+    // Weight of the latest allocation or de-allocation in the allocation rate estimate.
+    constexpr static double kSlabDemandRateSmoothing = 1.0 / 64;
+
+    // Demand is considered growing while more than this fraction of recent events were
+    // allocations.
+    constexpr static double kSlabDemandGrowthThreshold = 0.6;
+
+    // Decay of the peak block count estimate, per slab sized from demand. Decaying per slab,
+    // rather than per allocation, keeps the estimate independent of the block size.
+    constexpr static double kSlabDemandPeakDecay = 0.75;
+
     // Slab contains a free-list of blocks and a reference to underlying memory.
     struct Slab {
         Slab(uint64_t blockCount, uint64_t blockSize, uint64_t indexInList)
@@ -74,8 +104,99 @@ namespace gpgmm {
         MemoryAllocation Allocation;
         uint64_t IndexInList = kInvalidIndex;
         uint64_t IndexInCache = kInvalidIndex;
+        uint64_t GroupKey = kNoGroupKey;  // Group the slab was first used by, until emptied.
     };
 
+    // SlabMemoryExchange
+
+    SlabMemoryExchange::SlabMemoryExchange(MemoryAllocator* memoryAllocator)
+        : mMemoryAllocator(memoryAllocator) {
+        ASSERT(mMemoryAllocator != nullptr);
+    }
+
+    SlabMemoryExchange::~SlabMemoryExchange() {
+        std::lock_guard<std::mutex> lock(mMutex);
+        ASSERT(mNextSlabSizes.empty());
+        ReleaseMemoryInternal(kInvalidSize);
+    }
+
+    void SlabMemoryExchange::SetNextSlabSize(const SlabMemoryAllocator* slabAllocator,
+                                             uint64_t slabSize) {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (slabSize == 0) {
+            mNextSlabSizes.erase(slabAllocator);
+        } else {
+            mNextSlabSizes[slabAllocator] = slabSize;
+        }
+    }
+
+    bool SlabMemoryExchange::TryOffer(const SlabMemoryAllocator* slabAllocator,
+                                      const MemoryAllocation& slabMemory) {
+        std::lock_guard<std::mutex> lock(mMutex);
+        const uint64_t slabSize = slabMemory.GetSize();
+
+        // Keep no more memory of the size than other slab allocators could take.
+        uint64_t slabAllocatorCount = 0;
+        for (const auto& nextSlabSize : mNextSlabSizes) {
+            if (nextSlabSize.first != slabAllocator && nextSlabSize.second == slabSize) {
+                slabAllocatorCount++;
+            }
+        }
+
+        const uint64_t slabMemoryCount =
+            std::count_if(mSlabMemory.begin(), mSlabMemory.end(),
+                          [slabSize](const MemoryAllocation& memory) {
+                              return memory.GetSize() == slabSize;
+                          });
+        if (slabMemoryCount >= slabAllocatorCount) {
+            return false;
+        }
+
+        mSlabMemory.push_back(slabMemory);
+        mStats.PrefetchedMemoryParkedUsage += slabSize;
+        return true;
+    }
+
+    std::unique_ptr<MemoryAllocation> SlabMemoryExchange::TryTake(uint64_t slabSize) {
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto it = std::find_if(
+            mSlabMemory.begin(), mSlabMemory.end(),
+            [slabSize](const MemoryAllocation& memory) { return memory.GetSize() == slabSize; });
+        if (it == mSlabMemory.end()) {
+            return {};
+        }
+
+        std::unique_ptr<MemoryAllocation> slabAllocation = std::make_unique<MemoryAllocation>(*it);
+        mSlabMemory.erase(it);
+        mStats.PrefetchedMemoryParkedUsage -= slabSize;
+        return slabAllocation;
+    }
+
+    uint64_t SlabMemoryExchange::ReleaseMemory(uint64_t bytesToRelease) {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return ReleaseMemoryInternal(bytesToRelease);
+    }
+
+    uint64_t SlabMemoryExchange::ReleaseMemoryInternal(uint64_t bytesToRelease) {
+        uint64_t bytesReleased = 0;
+        while (!mSlabMemory.empty() && bytesReleased < bytesToRelease) {
+            const uint64_t slabSize = mSlabMemory.front().GetSize();
+            mMemoryAllocator->DeallocateMemory(
+                std::make_unique<MemoryAllocation>(mSlabMemory.front()));
+            mSlabMemory.erase(mSlabMemory.begin());
+
+            mStats.PrefetchedMemoryParkedUsage -= slabSize;
+            mStats.PrefetchedMemoryWasted++;
+            bytesReleased += slabSize;
+        }
+        return bytesReleased;
+    }
+
+    MemoryAllocatorStats SlabMemoryExchange::GetStats() const {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mStats;
+    }
+
     // SlabMemoryAllocator
 
     SlabMemoryAllocator::SlabMemoryAllocator(uint64_t blockSize,
@@ -85,7 +206,10 @@ namespace gpgmm {
                                              double slabFragmentationLimit,
                                              bool allowSlabPrefetch,
                                              double slabGrowthFactor,
-                                             MemoryAllocator* memoryAllocator)
+                                             MemoryAllocator* memoryAllocator,
+                                             const SlabRetentionPolicy& retentionPolicy,
+                                             bool allowAdaptiveSlabSize,
+                                             SlabMemoryExchange* slabMemoryExchange)
         : mLastUsedSlabSize(0),
           mBlockSize(blockSize),
           mSlabAlignment(slabAlignment),
@@ -94,19 +218,38 @@ namespace gpgmm {
           mSlabFragmentationLimit(slabFragmentationLimit),
           mAllowSlabPrefetch(allowSlabPrefetch),
           mSlabGrowthFactor(slabGrowthFactor),
-          mMemoryAllocator(memoryAllocator) {
+          mRetentionPolicy(retentionPolicy),
+          mAllowAdaptiveSlabSize(allowAdaptiveSlabSize),
+          mMemoryAllocator(memoryAllocator),
+          mSlabMemoryExchange(slabMemoryExchange) {
         ASSERT(IsPowerOfTwo(mSlabAlignment));
         ASSERT(mMemoryAllocator != nullptr);
         ASSERT(mSlabGrowthFactor >= 1);
         ASSERT(IsAligned(mMaxSlabSize, mSlabAlignment));
         ASSERT(IsAligned(mMinSlabSize, mSlabAlignment));
         ASSERT(blockSize <= mMaxSlabSize);
+
+        if (mAllowSlabPrefetch) {
+            mPlatformTime.reset(CreatePlatformTime());
+        }
     }
 
     SlabMemoryAllocator::~SlabMemoryAllocator() {
-        if (mNextSlabAllocationEvent != nullptr) {
-            mNextSlabAllocationEvent->Wait();
-            mMemoryAllocator->DeallocateMemory(mNextSlabAllocationEvent->AcquireAllocation());
+        if (mSlabMemoryExchange != nullptr) {
+            mSlabMemoryExchange->SetNextSlabSize(this, 0);
+        }
+
+        // Memory prefetched but never used could still be used by another slab allocator.
+        for (PrefetchedSlab& prefetchedSlab : mPrefetchQueue) {
+            prefetchedSlab.Event->Wait();
+            ReleasePrefetchedSlabMemory(prefetchedSlab.Event->AcquireAllocation(),
+                                        /*allowRehome*/ true);
+        }
+
+        ReleaseParkedSlabMemory(kInvalidSize, /*allowRehome*/ true);
+
+        for (const RetainedSlab& retainedSlab : mRetainedSlabs) {
+            ReleaseSlabMemory(*retainedSlab.ppSlab);
         }
 
         for (SlabCache& cache : mCaches) {
@@ -155,6 +298,29 @@ namespace gpgmm {
         return slabSize;
     }
 
+    // Returns a slab size that covers the blocks needed to reach the recent peak again. While
+    // demand grows, the slab is at least as large as the used blocks combined.
+    uint64_t SlabMemoryAllocator::ComputeSlabSizeFromDemand() const {
+        const double usedBlockCount = static_cast<double>(mStats.UsedBlockCount);
+
+        double blockCount = std::max(mPeakBlockCountEstimate - usedBlockCount, 1.0);
+        if (mAllocationRateEstimate > kSlabDemandGrowthThreshold) {
+            blockCount = std::max(blockCount, usedBlockCount);
+        }
+
+        const double maxBlockCount = static_cast<double>(mMaxSlabSize / mBlockSize);
+        const uint64_t slabSize =
+            NextPowerOfTwo(static_cast<uint64_t>(std::min(blockCount, maxBlockCount)) * mBlockSize);
+        return std::min(std::max(slabSize, mMinSlabSize), mMaxSlabSize);
+    }
+
+    void SlabMemoryAllocator::UpdateDemandEstimate(bool isAllocation) {
+        mAllocationRateEstimate +=
+            kSlabDemandRateSmoothing * ((isAllocation ? 1.0 : 0.0) - mAllocationRateEstimate);
+        mPeakBlockCountEstimate =
+            std::max(static_cast<double>(mStats.UsedBlockCount), mPeakBlockCountEstimate);
+    }
+
     uint64_t SlabMemoryAllocator::FindNextFreeSlabOfSize(uint64_t slabSize) const {
         // Larger slabs are used first.
         for (uint64_t cacheIndex = 0; cacheIndex < mCaches.size(); cacheIndex++) {
@@ -196,11 +362,44 @@ namespace gpgmm {
 
         std::lock_guard<std::mutex> lock(mMutex);
 
-        GPGMM_INVALID_IF(request.SizeInBytes > mBlockSize);
+        return TryAllocateMemoryInternal(request);
+    }
 
+    std::vector<std::unique_ptr<MemoryAllocation>> SlabMemoryAllocator::TryAllocateMemoryBatch(
+        const MemoryAllocationRequest* requests,
+        uint64_t count) {
+        TRACE_EVENT0(TraceEventCategory::kDefault, "SlabMemoryAllocator.TryAllocateMemoryBatch");
+
+        std::vector<std::unique_ptr<MemoryAllocation>> allocations(count);
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        for (uint64_t i = 0; i < count; i++) {
+            allocations[i] = TryAllocateMemoryInternal(requests[i]);
+        }
+
+        return allocations;
+    }
+
+    Slab* SlabMemoryAllocator::FindGroupSlab(uint64_t groupKey) const {
+        if (groupKey == kNoGroupKey) {
+            return nullptr;
+        }
+
+        auto it = mGroupSlabs.find(groupKey);
+        if (it == mGroupSlabs.end()) {
+            return nullptr;
+        }
+
+        Slab* pSlab = *it->second;
+        return (pSlab->IsFull()) ? nullptr : pSlab;
+    }
+
+    Slab* SlabMemoryAllocator::FindOrCreateFreeSlab(const MemoryAllocationRequest& request,
+                                                    uint64_t availableForAllocation,
+                                                    uint64_t* slabSizeOut) {
         uint64_t slabSize =
             ComputeSlabSize(request.SizeInBytes, std::max(mMinSlabSize, mLastUsedSlabSize),
-                            request.AvailableForAllocation);
+                            availableForAllocation);
 
         // Slab cannot exceed memory size.
         if (slabSize > mMaxSlabSize) {
@@ -213,13 +412,44 @@ namespace gpgmm {
         SlabCache* pCache = GetOrCreateCache(slabSize);
         ASSERT(pCache != nullptr);
 
-        // Push a new free slab at free-list HEAD.
+        // Since slab sizes vary, first re-use a free slab of another size. Otherwise, size the
+        // memory of the next free slab from demand, including a free slab whose memory was
+        // released.
+        if (mAllowAdaptiveSlabSize && (pCache->FreeList.empty() ||
+                                       pCache->FreeList.back().Allocation.GetMemory() == nullptr)) {
+            uint64_t newSlabSize = FindNextFreeSlabOfSize(request.SizeInBytes);
+            if (newSlabSize == kInvalidSize) {
+                newSlabSize = ComputeSlabSize(request.SizeInBytes, ComputeSlabSizeFromDemand(),
+                                              availableForAllocation);
+                mPeakBlockCountEstimate *= kSlabDemandPeakDecay;
+            }
+            GPGMM_INVALID_IF(newSlabSize == kInvalidSize);
+
+            // Unlike growth, the slab size could also shrink once demand drops.
+            if (newSlabSize <= mMaxSlabSize && newSlabSize != slabSize) {
+                pCache = GetOrCreateCache(newSlabSize);
+                slabSize = newSlabSize;
+            }
+        }
+
+        // Re-use the most recently retained slab, of any slab size, before creating memory for
+        // a new slab.
+        const bool hasFreeSlabMemory =
+            !pCache->FreeList.empty() && pCache->FreeList.back().Allocation.GetMemory() != nullptr;
+        if (!hasFreeSlabMemory && !mRetainedSlabs.empty()) {
+            Slab* pRetainedSlab = *mRetainedSlabs.back().ppSlab;
+            *slabSizeOut = pRetainedSlab->Allocation.GetSize();
+            return pRetainedSlab;
+        }
+
+        // Push a new free slab at free-list HEAD. A free slab is used even if it holds another
+        // group since creating memory only to keep groups apart would grow the working set.
         if (pCache->FreeList.empty()) {
             // Get the next free slab.
-            if (mLastUsedSlabSize > 0) {
+            if (!mAllowAdaptiveSlabSize && mLastUsedSlabSize > 0) {
                 uint64_t newSlabSize = ComputeSlabSize(
                     request.SizeInBytes, static_cast<uint64_t>(slabSize * mSlabGrowthFactor),
-                    request.AvailableForAllocation);
+                    availableForAllocation);
                 GPGMM_INVALID_IF(newSlabSize == kInvalidSize);
 
                 // If the new slab size exceeds the limit, then re-use the previous, smaller size.
@@ -249,10 +479,38 @@ namespace gpgmm {
             pCache->Slabs.push_back(&pCache->FreeList.back());
         }
 
-        Slab* pFreeSlab = &pCache->FreeList.back();
-        ASSERT(pFreeSlab != nullptr);
+        *slabSizeOut = slabSize;
+        return &pCache->FreeList.back();
+    }
+
+    std::unique_ptr<MemoryAllocation> SlabMemoryAllocator::TryAllocateMemoryInternal(
+        const MemoryAllocationRequest& request) {
+        GPGMM_INVALID_IF(request.SizeInBytes > mBlockSize);
+
+        // The memory allocator could be budgeted and shared, so its headroom changes between
+        // requests and must be checked each time.
+        const uint64_t availableForAllocation = std::min(
+            request.AvailableForAllocation, mMemoryAllocator->GetAvailableForAllocation());
+
+        if (mPlatformTime != nullptr) {
+            UpdateAllocationIntervalEstimate();
+        }
+
+        // Prefer the slab already holding allocations of the same group, if it has room.
+        uint64_t slabSize = 0;
+        Slab* pFreeSlab = FindGroupSlab(request.GroupKey);
+        if (pFreeSlab != nullptr) {
+            slabSize = pFreeSlab->Allocation.GetSize();
+        } else {
+            GPGMM_TRY_ASSIGN(FindOrCreateFreeSlab(request, availableForAllocation, &slabSize),
+                             pFreeSlab);
+        }
+
+        SlabCache* pCache = GetOrCreateCache(slabSize);
+        ASSERT(pCache != nullptr);
         ASSERT(!pFreeSlab->IsFull());
 
+        bool hasWaitedForSlabMemory = false;
         std::unique_ptr<MemoryAllocation> subAllocation;
         GPGMM_TRY_ASSIGN(
             TrySubAllocateMemory(
@@ -263,32 +521,10 @@ namespace gpgmm {
                         return pFreeSlab->Allocation.GetMemory();
                     }
 
-                    // Or use pre-fetched memory if possible. Else, throw it away and create a new
-                    // slab.
-                    if (mNextSlabAllocationEvent != nullptr) {
-                        // Resolve the pending pre-fetched allocation.
-                        mNextSlabAllocationEvent->Wait();
-                        std::unique_ptr<MemoryAllocation> prefetchedSlabAllocation =
-                            mNextSlabAllocationEvent->AcquireAllocation();
-                        mNextSlabAllocationEvent.reset();
-
-                        // Assign pre-fetched memory to the slab.
-                        if (prefetchedSlabAllocation != nullptr &&
-                            prefetchedSlabAllocation->GetSize() == slabSize) {
-                            pFreeSlab->Allocation = *prefetchedSlabAllocation;
-                            mStats.PrefetchedMemoryMissesEliminated++;
-                            return pFreeSlab->Allocation.GetMemory();
-                        }
-
-                        if (prefetchedSlabAllocation != nullptr) {
-                            DebugEvent(GetTypename(), EventMessageId::kPrefetchFailed)
-                                << "Pre-fetch slab memory is incompatible (" << slabSize << " vs "
-                                << prefetchedSlabAllocation->GetSize() << " bytes.";
-                        }
-
-                        mStats.PrefetchedMemoryMisses++;
-
-                        mMemoryAllocator->DeallocateMemory(std::move(prefetchedSlabAllocation));
+                    // Or use pre-fetched memory if possible. Else, create a new slab.
+                    hasWaitedForSlabMemory = true;
+                    if (AcquirePrefetchedSlabMemory(pFreeSlab, slabSize)) {
+                        return pFreeSlab->Allocation.GetMemory();
                     }
 
                     // Create memory of specified slab size.
@@ -296,43 +532,82 @@ namespace gpgmm {
                     newSlabRequest.SizeInBytes = slabSize;
                     newSlabRequest.Alignment = mSlabAlignment;
 
+                    if (mPlatformTime != nullptr) {
+                        mPlatformTime->StartElapsedTime();
+                    }
+
                     std::unique_ptr<MemoryAllocation> slabAllocation;
                     GPGMM_TRY_ASSIGN(mMemoryAllocator->TryAllocateMemory(newSlabRequest),
                                      slabAllocation);
 
+                    if (mPlatformTime != nullptr) {
+                        UpdateSlabCreationTimeEstimate(mPlatformTime->EndElapsedTime());
+                    }
+
                     pFreeSlab->Allocation = *slabAllocation;
+                    OnSlabMemoryAcquired(*pFreeSlab);
 
                     return pFreeSlab->Allocation.GetMemory();
                 }),
             subAllocation);
 
+        // Time spent waiting for slab memory is not part of the time between allocations.
+        if (mPlatformTime != nullptr && hasWaitedForSlabMemory) {
+            mLastAllocationTime = mPlatformTime->GetAbsoluteTime();
+        }
+
+        // A retained slab is no longer empty once allocated from. Retained slabs are re-used
+        // newest first, so search from the back.
+        if (pFreeSlab->IsEmpty() && !mRetainedSlabs.empty()) {
+            Slab** ppFreeSlab = &pCache->Slabs[pFreeSlab->IndexInCache];
+            auto it = std::find_if(
+                mRetainedSlabs.rbegin(), mRetainedSlabs.rend(),
+                [ppFreeSlab](const RetainedSlab& slab) { return slab.ppSlab == ppFreeSlab; });
+            if (it != mRetainedSlabs.rend()) {
+                mRetainedSlabUsage -= pFreeSlab->Allocation.GetSize();
+                mRetainedSlabs.erase((it + 1).base());
+                UpdateRetainedSlabExpiry();
+            }
+        }
+
         // Slab is referenced seperately from its underlying memory because the memory used by the
         // slab could be already allocated by another allocator. Only once the last block on the
         // slab is deallocated, does the slab release its memory.
         pFreeSlab->UsedBlocksPerSlab++;
 
+        // Pack the next allocations of the group into the same slab.
+        if (request.GroupKey != kNoGroupKey && pFreeSlab->GroupKey == kNoGroupKey) {
+            pFreeSlab->GroupKey = request.GroupKey;
+            mGroupSlabs[request.GroupKey] = &pCache->Slabs[pFreeSlab->IndexInCache];
+        }
+
         // Remember the last allocated slab size so if a subsequent allocation requests a new slab,
         // the next slab size will be larger than the previous slab size.
+        // Since the next slab is usually created at the last size, memory of that size no longer
+        // needed by other slab allocators is re-homed here.
+        if (mSlabMemoryExchange != nullptr && slabSize != mLastUsedSlabSize) {
+            mSlabMemoryExchange->SetNextSlabSize(this, slabSize);
+        }
         mLastUsedSlabSize = slabSize;
 
         // Prefetch memory for future slab.
         //
-        // This check is overly conservative since waiting for the device to retrieve pre-fetched
-        // memory could block the next allocation from being created until the device becomes free.
-        //
-        // TODO: Measure if the slab allocation time remaining exceeds the prefetch memory task
-        // time before deciding to prefetch.
-        if (mAllowSlabPrefetch && mNextSlabAllocationEvent == nullptr &&
+        // Pre-fetching too early holds memory that is not used yet and could block the next
+        // allocation from being created until the device becomes free. So pre-fetch only once the
+        // slab is expected to run out by the time memory for the next slab would be created.
+        if (mAllowSlabPrefetch && mPrefetchQueue.size() < mPrefetchQueueDepth &&
             (request.AlwaysPrefetch ||
-             (IsPrefetchCoverageBelowThreshold() &&
-              pFreeSlab->GetUsedPercent() >= kSlabPrefetchUsageThreshold &&
+             (IsPrefetchCoverageBelowThreshold() && IsSlabExhaustedSoon(*pFreeSlab) &&
               pFreeSlab->GetBlockCount() >= kSlabPrefetchMinBlockCount))) {
             // If a subsequent TryAllocateMemory() uses a request size different than the current
             // request size, memory required for the next slab could be the wrong size. If so,
-            // pre-fetching did not pay off and the pre-fetched memory will be de-allocated instead.
+            // the pre-fetched memory is parked until a slab of its size is needed.
             uint64_t nextSlabSize = ComputeSlabSize(
-                request.SizeInBytes, static_cast<uint64_t>(mLastUsedSlabSize * mSlabGrowthFactor),
-                request.AvailableForAllocation);
+                request.SizeInBytes,
+                (mAllowAdaptiveSlabSize)
+                    ? ComputeSlabSizeFromDemand()
+                    : static_cast<uint64_t>(mLastUsedSlabSize * mSlabGrowthFactor),
+                availableForAllocation);
 
             // If the next slab size exceeds the limit, then re-use the previous, smaller size.
             if (nextSlabSize > mMaxSlabSize) {
@@ -342,9 +617,10 @@ namespace gpgmm {
             // If under growth phase (and accounting that the current slab will soon become
             // full), reset the slab size back to the last size. Otherwise, the pre-fetch will
             // always miss the cache since the larger slab cannot be used until enough smaller slabs
-            // become full first.
+            // become full first. Adaptive slab sizes already account for the slabs in use.
             const uint64_t numOfSlabsInNextSlabSize = nextSlabSize / mLastUsedSlabSize;
-            if (pCache->FullList.occupied_size() + 1 < numOfSlabsInNextSlabSize) {
+            if (!mAllowAdaptiveSlabSize &&
+                pCache->FullList.occupied_size() + 1 < numOfSlabsInNextSlabSize) {
                 nextSlabSize = mLastUsedSlabSize;
             }
 
@@ -354,7 +630,9 @@ namespace gpgmm {
                 newSlabRequest.Alignment = mSlabAlignment;
                 newSlabRequest.AlwaysPrefetch = false;
 
-                mNextSlabAllocationEvent = mMemoryAllocator->TryAllocateMemoryAsync(newSlabRequest);
+                mPrefetchQueue.push_back(
+                    {mMemoryAllocator->TryAllocateMemoryAsync(newSlabRequest), nextSlabSize,
+                     (mPlatformTime != nullptr) ? mPlatformTime->GetAbsoluteTime() : 0});
             }
         }
 
@@ -373,12 +651,27 @@ namespace gpgmm {
         // offset must be made relative to the slab's underlying memory and not the slab itself.
         const uint64_t offsetFromMemory = pFreeSlab->Allocation.GetOffset() + blockInSlab->Offset;
 
+        blockInSlab->RequestSize = request.SizeInBytes;
+        blockInSlab->GroupKey = request.GroupKey;
+
         mStats.UsedBlockCount++;
         mStats.UsedBlockUsage += blockInSlab->Size;
+        mStats.InternalFragmentationUsage += blockInSlab->Size - blockInSlab->RequestSize;
+        mStats.ExternalFragmentationUsage -= blockInSlab->Size;
+
+        UpdateDemandEstimate(/*isAllocation*/ true);
+
+        mGeneration++;
 
-        return std::make_unique<MemoryAllocation>(this, subAllocation->GetMemory(),
-                                                  offsetFromMemory, AllocationMethod::kSubAllocated,
-                                                  blockInSlab, request.SizeInBytes);
+        if (mGeneration > mRetainedSlabExpiryGeneration) {
+            ReleaseExpiredSlabs();
+        }
+
+        // Re-use the sub-allocation instead of creating another MemoryAllocation.
+        *subAllocation =
+            MemoryAllocation(this, subAllocation->GetMemory(), offsetFromMemory,
+                             AllocationMethod::kSubAllocated, blockInSlab, request.SizeInBytes);
+        return subAllocation;
     }
 
     void SlabMemoryAllocator::DeallocateMemory(std::unique_ptr<MemoryAllocation> subAllocation) {
@@ -386,10 +679,40 @@ namespace gpgmm {
 
         std::lock_guard<std::mutex> lock(mMutex);
 
+        DeallocateMemoryInternal(std::move(subAllocation));
+    }
+
+    void SlabMemoryAllocator::DeallocateMemoryBatch(
+        std::vector<std::unique_ptr<MemoryAllocation>> allocations) {
+        TRACE_EVENT0(TraceEventCategory::kDefault, "SlabMemoryAllocator.DeallocateMemoryBatch");
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        for (auto& allocation : allocations) {
+            if (allocation != nullptr) {
+                DeallocateMemoryInternal(std::move(allocation));
+            }
+        }
+    }
+
+    void SlabMemoryAllocator::DeallocateMemoryInternal(
+        std::unique_ptr<MemoryAllocation> subAllocation) {
         SlabBlock* blockInSlab = static_cast<SlabBlock*>(subAllocation->GetBlock());
         ASSERT(blockInSlab != nullptr);
 
-        Slab* pSlab = *(blockInSlab->ppSlab);
+        mStats.UsedBlockCount--;
+        mStats.UsedBlockUsage -= blockInSlab->Size;
+        mStats.InternalFragmentationUsage -= blockInSlab->Size - blockInSlab->RequestSize;
+
+        UpdateDemandEstimate(/*isAllocation*/ false);
+
+        DeallocateBlockInSlab(blockInSlab, subAllocation->GetMemory(), /*retainEmptySlab*/ true);
+    }
+
+    void SlabMemoryAllocator::DeallocateBlockInSlab(SlabBlock* blockInSlab,
+                                                    IMemoryObject* slabMemory,
+                                                    bool retainEmptySlab) {
+        Slab** ppSlab = blockInSlab->ppSlab;
+        Slab* pSlab = *ppSlab;
         ASSERT(pSlab != nullptr);
 
         SlabCache* pCache = GetOrCreateCache(pSlab->Allocation.GetSize());
@@ -401,31 +724,473 @@ namespace gpgmm {
                                     /*pDstList*/ &pCache->FreeList);
         }
 
-        mStats.UsedBlockCount--;
-        mStats.UsedBlockUsage -= blockInSlab->Size;
-
         pSlab->Allocator.DeallocateBlock(blockInSlab);
         pSlab->UsedBlocksPerSlab--;
 
-        IMemoryObject* slabMemory = subAllocation->GetMemory();
-        ASSERT(slabMemory != nullptr);
+        mStats.ExternalFragmentationUsage += blockInSlab->Size;
+
+        mGeneration++;
 
+        ASSERT(slabMemory != nullptr);
         slabMemory->RemoveSubAllocationRef();
 
         if (pSlab->IsEmpty()) {
-            mMemoryAllocator->DeallocateMemory(
-                std::make_unique<MemoryAllocation>(pSlab->Allocation));
-            pSlab->Allocation = {};  // Invalidate it
+            // An empty slab no longer belongs to the group.
+            if (pSlab->GroupKey != kNoGroupKey) {
+                auto it = mGroupSlabs.find(pSlab->GroupKey);
+                if (it != mGroupSlabs.end() && it->second == ppSlab) {
+                    mGroupSlabs.erase(it);
+                }
+                pSlab->GroupKey = kNoGroupKey;
+            }
+
+            if (retainEmptySlab) {
+                RetainOrReleaseSlabMemory(ppSlab);
+            } else {
+                ReleaseSlabMemory(pSlab);
+            }
+        }
+
+        if (mGeneration > mRetainedSlabExpiryGeneration) {
+            ReleaseExpiredSlabs();
         }
     }
 
+    SlabCompactionPlan SlabMemoryAllocator::PlanCompaction(
+        const std::vector<MemoryAllocation*>& allocations) {
+        TRACE_EVENT0(TraceEventCategory::kDefault, "SlabMemoryAllocator.PlanCompaction");
+
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        SlabCompactionPlan plan = {};
+        plan.Generation = mGeneration;
+
+        // Group the allocations by the slab they were allocated from.
+        std::unordered_map<Slab**, std::vector<MemoryAllocation*>> allocationsPerSlab;
+        for (MemoryAllocation* allocation : allocations) {
+            if (allocation == nullptr ||
+                allocation->GetMethod() != AllocationMethod::kSubAllocated) {
+                continue;
+            }
+            SlabBlock* blockInSlab = static_cast<SlabBlock*>(allocation->GetBlock());
+            ASSERT(blockInSlab != nullptr);
+            allocationsPerSlab[blockInSlab->ppSlab].push_back(allocation);
+        }
+
+        // Only partially used slabs can be emptied or moved into. Full slabs have neither
+        // free blocks to move into nor any space to reclaim.
+        std::vector<Slab**> slabs;
+        uint64_t freeBlockCount = 0;
+        for (SlabCache& cache : mCaches) {
+            for (Slab& slab : cache.FreeList) {
+                if (slab.Allocation.GetMemory() == nullptr || slab.IsEmpty()) {
+                    continue;
+                }
+                slabs.push_back(&cache.Slabs[slab.IndexInCache]);
+                freeBlockCount += slab.GetBlockCount() - slab.UsedBlocksPerSlab;
+            }
+        }
+
+        // Empty the least-utilized slabs first. Between equally used slabs, emptying the larger
+        // one reclaims more memory for the same bytes moved.
+        std::sort(slabs.begin(), slabs.end(), [](Slab** a, Slab** b) {
+            if ((*a)->UsedBlocksPerSlab != (*b)->UsedBlocksPerSlab) {
+                return (*a)->UsedBlocksPerSlab < (*b)->UsedBlocksPerSlab;
+            }
+            return (*a)->GetBlockCount() > (*b)->GetBlockCount();
+        });
+
+        // A slab can be emptied if every block is known to the caller and the remaining slabs
+        // have enough free blocks left to hold it.
+        std::vector<Slab**> srcSlabs;
+        std::vector<Slab**> dstSlabs;
+        uint64_t blocksToMove = 0;
+        for (Slab** ppSlab : slabs) {
+            const Slab* pSlab = *ppSlab;
+            const uint64_t slabFreeBlockCount = pSlab->GetBlockCount() - pSlab->UsedBlocksPerSlab;
+            auto it = allocationsPerSlab.find(ppSlab);
+            if (it == allocationsPerSlab.end() || it->second.size() != pSlab->UsedBlocksPerSlab ||
+                blocksToMove + pSlab->UsedBlocksPerSlab + slabFreeBlockCount > freeBlockCount) {
+                dstSlabs.push_back(ppSlab);
+                continue;
+            }
+
+            srcSlabs.push_back(ppSlab);
+            blocksToMove += pSlab->UsedBlocksPerSlab;
+            freeBlockCount -= slabFreeBlockCount;
+        }
+
+        if (srcSlabs.empty()) {
+            return plan;
+        }
+
+        // Free blocks to move into, in the order CommitCompaction() allocates them. The
+        // most-utilized slabs are filled first so they are more likely to become full.
+        std::vector<std::pair<Slab**, uint64_t>> dstBlocks;
+        for (auto it = dstSlabs.rbegin(); it != dstSlabs.rend() && dstBlocks.size() < blocksToMove;
+             ++it) {
+            const std::vector<uint64_t> freeBlockOffsets =
+                (**it)->Allocator.GetFreeBlockOffsets(blocksToMove - dstBlocks.size());
+            for (uint64_t blockOffset : freeBlockOffsets) {
+                dstBlocks.emplace_back(*it, blockOffset);
+            }
+        }
+        ASSERT(dstBlocks.size() == blocksToMove);
+
+        uint64_t dstBlockIndex = 0;
+        for (Slab** ppSrcSlab : srcSlabs) {
+            for (MemoryAllocation* allocation : allocationsPerSlab[ppSrcSlab]) {
+                Slab** ppDstSlab = dstBlocks[dstBlockIndex].first;
+                const uint64_t dstBlockOffset = dstBlocks[dstBlockIndex].second;
+                dstBlockIndex++;
+
+                SlabAllocationMove move = {};
+                move.Allocation = allocation;
+                move.SrcMemory = allocation->GetMemory();
+                move.SrcOffset = allocation->GetOffset();
+                move.DstMemory = (*ppDstSlab)->Allocation.GetMemory();
+                move.DstOffset = (*ppDstSlab)->Allocation.GetOffset() + dstBlockOffset;
+                move.SizeInBytes = allocation->GetSize();
+                move.ppDstSlab = ppDstSlab;
+
+                plan.BytesMoved += move.SizeInBytes;
+                plan.Moves.push_back(move);
+            }
+
+            plan.BytesReclaimed += (*ppSrcSlab)->Allocation.GetSize();
+        }
+
+        return plan;
+    }
+
+    bool SlabMemoryAllocator::CommitCompaction(const SlabCompactionPlan& plan) {
+        TRACE_EVENT0(TraceEventCategory::kDefault, "SlabMemoryAllocator.CommitCompaction");
+
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        // Blocks planned to be moved into could have since been allocated or slabs released.
+        if (plan.Generation != mGeneration) {
+            DebugEvent(GetTypename()) << "Compaction plan is stale and was not committed.";
+            return false;
+        }
+
+        for (const SlabAllocationMove& move : plan.Moves) {
+            Slab* pDstSlab = *(move.ppDstSlab);
+            ASSERT(pDstSlab != nullptr);
+
+            SlabCache* pDstCache = GetOrCreateCache(pDstSlab->Allocation.GetSize());
+            ASSERT(pDstCache != nullptr);
+
+            // Blocks are always allocated from the lowest free offset, which is the order the
+            // plan assigned them in.
+            SlabBlock* dstBlock =
+                static_cast<SlabBlock*>(pDstSlab->Allocator.TryAllocateBlock(mBlockSize));
+            ASSERT(dstBlock != nullptr);
+            ASSERT(pDstSlab->Allocation.GetOffset() + dstBlock->Offset == move.DstOffset);
+
+            MemoryAllocation* allocation = move.Allocation;
+            SlabBlock* srcBlock = static_cast<SlabBlock*>(allocation->GetBlock());
+
+            dstBlock->ppSlab = move.ppDstSlab;
+            dstBlock->RequestSize = srcBlock->RequestSize;
+            dstBlock->GroupKey = srcBlock->GroupKey;
+            pDstSlab->UsedBlocksPerSlab++;
+            move.DstMemory->AddSubAllocationRef();
+
+            mStats.ExternalFragmentationUsage -= dstBlock->Size;
+
+            if (pDstSlab->IsFull()) {
+                MoveSlabInCache(pDstSlab, pDstCache, /*pSrcList*/ &pDstCache->FreeList,
+                                /*pDstList*/ &pDstCache->FullList);
+            }
+
+            // Emptied slabs are always released since reclaiming them is the point.
+            DeallocateBlockInSlab(srcBlock, allocation->GetMemory(), /*retainEmptySlab*/ false);
+
+            *allocation = MemoryAllocation(allocation->GetAllocator(), move.DstMemory,
+                                           move.DstOffset, AllocationMethod::kSubAllocated,
+                                           dstBlock, allocation->GetRequestSize());
+        }
+
+        return true;
+    }
+
+    void SlabMemoryAllocator::OnSlabMemoryAcquired(const Slab& slab) {
+        // Every block of the slab is free until allocated.
+        mStats.ExternalFragmentationUsage += slab.Allocation.GetSize();
+        mUsedSlabBlockCount += slab.GetBlockCount();
+    }
+
+    void SlabMemoryAllocator::ReleaseSlabMemory(Slab* pSlab) {
+        ASSERT(pSlab->IsEmpty());
+
+        mStats.ExternalFragmentationUsage -= pSlab->Allocation.GetSize();
+        mUsedSlabBlockCount -= pSlab->GetBlockCount();
+
+        mMemoryAllocator->DeallocateMemory(std::make_unique<MemoryAllocation>(pSlab->Allocation));
+        pSlab->Allocation = {};  // Invalidate it
+    }
+
+    void SlabMemoryAllocator::RetainOrReleaseSlabMemory(Slab** ppSlab) {
+        Slab* pSlab = *ppSlab;
+        const uint64_t slabSize = pSlab->Allocation.GetSize();
+        if (mRetainedSlabs.size() < mRetentionPolicy.MaxEmptySlabCount &&
+            slabSize <= mRetentionPolicy.MaxEmptySlabUsage - mRetainedSlabUsage) {
+            mRetainedSlabs.push_back({ppSlab, mGeneration});
+            mRetainedSlabUsage += slabSize;
+            if (mRetainedSlabs.size() == 1) {
+                UpdateRetainedSlabExpiry();
+            }
+            return;
+        }
+
+        ReleaseSlabMemory(pSlab);
+    }
+
+    void SlabMemoryAllocator::ReleaseExpiredSlabs() {
+        while (!mRetainedSlabs.empty() &&
+               mGeneration - mRetainedSlabs.front().Generation > mRetentionPolicy.MaxEmptySlabAge) {
+            Slab* pSlab = *mRetainedSlabs.front().ppSlab;
+            mRetainedSlabUsage -= pSlab->Allocation.GetSize();
+            mRetainedSlabs.pop_front();
+            ReleaseSlabMemory(pSlab);
+        }
+
+        UpdateRetainedSlabExpiry();
+    }
+
+    void SlabMemoryAllocator::UpdateRetainedSlabExpiry() {
+        mRetainedSlabExpiryGeneration = kInvalidSize;
+        if (mRetainedSlabs.empty()) {
+            return;
+        }
+
+        const uint64_t retainedGeneration = mRetainedSlabs.front().Generation;
+        if (mRetentionPolicy.MaxEmptySlabAge < kInvalidSize - retainedGeneration) {
+            mRetainedSlabExpiryGeneration = retainedGeneration + mRetentionPolicy.MaxEmptySlabAge;
+        }
+    }
+
+    void SlabMemoryAllocator::UpdateAllocationIntervalEstimate() {
+        const double now = mPlatformTime->GetAbsoluteTime();
+        if (mLastAllocationTime > 0) {
+            // Idle periods only delay pre-fetching by as long as memory takes to be created.
+            double interval = now - mLastAllocationTime;
+            if (mSlabCreationTimeEstimate > 0) {
+                interval = std::min(interval, mSlabCreationTimeEstimate);
+            }
+
+            mAllocationIntervalEstimate =
+                (mAllocationIntervalEstimate == 0)
+                    ? interval
+                    : mAllocationIntervalEstimate +
+                          kAllocationIntervalSmoothing * (interval - mAllocationIntervalEstimate);
+        }
+        mLastAllocationTime = now;
+    }
+
+    void SlabMemoryAllocator::UpdateSlabCreationTimeEstimate(double creationTime) {
+        mSlabCreationTimeEstimate =
+            (mSlabCreationTimeEstimate == 0)
+                ? creationTime
+                : mSlabCreationTimeEstimate +
+                      kSlabCreationTimeSmoothing * (creationTime - mSlabCreationTimeEstimate);
+    }
+
+    bool SlabMemoryAllocator::IsSlabExhaustedSoon(const Slab& slab) const {
+        if (mSlabCreationTimeEstimate == 0 || mAllocationIntervalEstimate == 0) {
+            return slab.GetUsedPercent() >= kSlabPrefetchUsageThreshold;
+        }
+
+        // Every pending pre-fetch adds another slab of free blocks.
+        const uint64_t freeBlockCount = (slab.GetBlockCount() - slab.UsedBlocksPerSlab) +
+                                        mPrefetchQueue.size() * slab.GetBlockCount();
+        const double timeUntilExhausted = freeBlockCount * mAllocationIntervalEstimate;
+        return timeUntilExhausted <= mSlabCreationTimeEstimate * kSlabPrefetchLeadTimeFactor;
+    }
+
+    bool SlabMemoryAllocator::AcquirePrefetchedSlabMemory(Slab* pSlab, uint64_t slabSize) {
+        // Parked memory is used first since it was already created, then memory re-homed from
+        // another slab allocator.
+        std::unique_ptr<MemoryAllocation> slabAllocation;
+        auto parkedIt = std::find_if(
+            mParkedSlabMemory.begin(), mParkedSlabMemory.end(),
+            [slabSize](const MemoryAllocation& memory) { return memory.GetSize() == slabSize; });
+        if (parkedIt != mParkedSlabMemory.end()) {
+            slabAllocation = std::make_unique<MemoryAllocation>(*parkedIt);
+            mParkedSlabMemory.erase(parkedIt);
+            mStats.PrefetchedMemoryParkedUsage -= slabSize;
+        } else if (mSlabMemoryExchange != nullptr) {
+            slabAllocation = mSlabMemoryExchange->TryTake(slabSize);
+            if (slabAllocation != nullptr) {
+                mStats.PrefetchedMemorySalvagedUsage += slabSize;
+            }
+        }
+
+        if (slabAllocation == nullptr && mPrefetchQueue.empty() && mParkedSlabMemory.empty()) {
+            return false;
+        }
+
+        // Otherwise, use the oldest pre-fetch of the slab size. Completed pre-fetches of other
+        // sizes are parked so they no longer hold up the queue.
+        for (auto it = mPrefetchQueue.begin(); it != mPrefetchQueue.end();) {
+            if (slabAllocation == nullptr && it->SlabSize == slabSize) {
+                // Pre-fetching did not keep up with the slabs being used, so pre-fetch deeper.
+                const bool wasSignaled = it->Event->IsSignaled();
+                if (!wasSignaled && mPrefetchQueueDepth < kMaxSlabPrefetchQueueDepth) {
+                    mPrefetchQueueDepth++;
+                }
+
+                it->Event->Wait();
+
+                // A pre-fetch only completes as soon as waited on when it took longer than the
+                // slab creation time estimate, e.g. while the worker was busy, so measure it too.
+                if (!wasSignaled && mPlatformTime != nullptr) {
+                    UpdateSlabCreationTimeEstimate(mPlatformTime->GetAbsoluteTime() -
+                                                   it->IssueTime);
+                }
+                slabAllocation = it->Event->AcquireAllocation();
+                it = mPrefetchQueue.erase(it);
+
+                if (slabAllocation != nullptr && slabAllocation->GetSize() != slabSize) {
+                    ParkPrefetchedSlabMemory(std::move(slabAllocation));
+                }
+            } else if (it->SlabSize != slabSize && it->Event->IsSignaled()) {
+                ParkPrefetchedSlabMemory(it->Event->AcquireAllocation());
+                it = mPrefetchQueue.erase(it);
+            } else {
+                it++;
+            }
+        }
+
+        if (slabAllocation == nullptr) {
+            DebugEvent(GetTypename(), EventMessageId::kPrefetchFailed)
+                << "Pre-fetch slab memory is incompatible (" << slabSize << " bytes).";
+            mStats.PrefetchedMemoryMisses++;
+
+            // The pending pre-fetches are of the wrong size, so park them to make room for
+            // pre-fetches of the slab size.
+            for (PrefetchedSlab& prefetchedSlab : mPrefetchQueue) {
+                prefetchedSlab.Event->Wait();
+                ParkPrefetchedSlabMemory(prefetchedSlab.Event->AcquireAllocation());
+            }
+            mPrefetchQueue.clear();
+            return false;
+        }
+
+        pSlab->Allocation = *slabAllocation;
+        mStats.PrefetchedMemoryMissesEliminated++;
+        OnSlabMemoryAcquired(*pSlab);
+        return true;
+    }
+
+    void SlabMemoryAllocator::ParkPrefetchedSlabMemory(
+        std::unique_ptr<MemoryAllocation> slabAllocation) {
+        if (slabAllocation == nullptr) {
+            return;
+        }
+
+        // Another slab allocator needing a slab of the size next would use it sooner.
+        if (mSlabMemoryExchange != nullptr &&
+            mSlabMemoryExchange->TryOffer(this, *slabAllocation)) {
+            return;
+        }
+
+        mStats.PrefetchedMemoryParkedUsage += slabAllocation->GetSize();
+        mParkedSlabMemory.push_back(*slabAllocation);
+
+        // Pre-fetching ran too far ahead, so release the oldest and pre-fetch less deep.
+        if (mParkedSlabMemory.size() > kMaxParkedSlabMemoryCount) {
+            ReleaseParkedSlabMemory(mParkedSlabMemory.front().GetSize(), /*allowRehome*/ true);
+            if (mPrefetchQueueDepth > 1) {
+                mPrefetchQueueDepth--;
+            }
+        }
+    }
+
+    uint64_t SlabMemoryAllocator::ReleaseParkedSlabMemory(uint64_t bytesToRelease,
+                                                          bool allowRehome) {
+        uint64_t bytesReleased = 0;
+        while (!mParkedSlabMemory.empty() && bytesReleased < bytesToRelease) {
+            const uint64_t slabSize = mParkedSlabMemory.front().GetSize();
+            ReleasePrefetchedSlabMemory(
+                std::make_unique<MemoryAllocation>(mParkedSlabMemory.front()), allowRehome);
+            mParkedSlabMemory.erase(mParkedSlabMemory.begin());
+
+            mStats.PrefetchedMemoryParkedUsage -= slabSize;
+            bytesReleased += slabSize;
+        }
+        return bytesReleased;
+    }
+
+    void SlabMemoryAllocator::ReleasePrefetchedSlabMemory(
+        std::unique_ptr<MemoryAllocation> slabAllocation,
+        bool allowRehome) {
+        if (slabAllocation == nullptr) {
+            return;
+        }
+
+        if (allowRehome && mSlabMemoryExchange != nullptr &&
+            mSlabMemoryExchange->TryOffer(this, *slabAllocation)) {
+            return;
+        }
+
+        mMemoryAllocator->DeallocateMemory(std::move(slabAllocation));
+        mStats.PrefetchedMemoryWasted++;
+    }
+
+    uint64_t SlabMemoryAllocator::ReleaseMemory(uint64_t bytesToRelease) {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        // Parked memory is released first since it was never used.
+        uint64_t bytesReleased = ReleaseParkedSlabMemory(bytesToRelease, /*allowRehome*/ false);
+
+        // Release the largest slabs first so fewer slabs need to be re-created. Between slabs of
+        // the same size, the oldest is released first.
+        std::vector<RetainedSlab> slabsBySize(mRetainedSlabs.begin(), mRetainedSlabs.end());
+        std::stable_sort(slabsBySize.begin(), slabsBySize.end(),
+                         [](const RetainedSlab& a, const RetainedSlab& b) {
+                             return (*a.ppSlab)->Allocation.GetSize() >
+                                    (*b.ppSlab)->Allocation.GetSize();
+                         });
+
+        for (const RetainedSlab& retainedSlab : slabsBySize) {
+            if (bytesReleased >= bytesToRelease) {
+                break;
+            }
+
+            Slab* pSlab = *retainedSlab.ppSlab;
+            const uint64_t slabSize = pSlab->Allocation.GetSize();
+            ReleaseSlabMemory(pSlab);
+
+            mRetainedSlabUsage -= slabSize;
+            bytesReleased += slabSize;
+        }
+
+        // Keep the remaining slabs oldest first.
+        mRetainedSlabs.erase(std::remove_if(mRetainedSlabs.begin(), mRetainedSlabs.end(),
+                                            [](const RetainedSlab& slab) {
+                                                return (*slab.ppSlab)->Allocation.GetMemory() ==
+                                                       nullptr;
+                                            }),
+                             mRetainedSlabs.end());
+        UpdateRetainedSlabExpiry();
+
+        return bytesReleased;
+    }
+
+    uint64_t SlabMemoryAllocator::GetRetainedSlabUsage() const {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mRetainedSlabUsage;
+    }
+
     Slab* SlabMemoryAllocator::MoveSlabInCache(Slab* pSlab,
                                                SlabCache* pCache,
                                                StableList<Slab>* pSrcList,
                                                StableList<Slab>* pDstList) {
         const uint64_t srcIndex = pSlab->IndexInList;
         pSlab->IndexInList = pDstList->size();
-        pDstList->push_back(*pSlab);  // copy
+        pDstList->push_back(std::move(*pSlab));
         pSrcList->erase(srcIndex);
         pSlab = &pDstList->back();
 
@@ -442,6 +1207,10 @@ namespace gpgmm {
         result.UsedMemoryCount = info.UsedMemoryCount;
         result.UsedMemoryUsage = info.UsedMemoryUsage;
         result.FreeMemoryUsage = info.FreeMemoryUsage;
+
+        // Blocks are fixed-size so any free block is the largest.
+        result.LargestFreeBlockSize =
+            (mUsedSlabBlockCount > mStats.UsedBlockCount) ? mBlockSize : 0;
         return result;
     }
 
@@ -475,84 +1244,408 @@ namespace gpgmm {
                                            double slabFragmentationLimit,
                                            bool allowPrefetchSlab,
                                            double slabGrowthFactor,
-                                           std::unique_ptr<MemoryAllocator> memoryAllocator)
+                                           std::unique_ptr<MemoryAllocator> memoryAllocator,
+                                           const SlabRetentionPolicy& retentionPolicy,
+                                           bool allowAdaptiveSlabSize,
+                                           const SlabSizeClassPolicy& sizeClassPolicy)
         : MemoryAllocator(std::move(memoryAllocator)),
           mMaxSlabSize(maxSlabSize),
           mMinSlabSize(minSlabSize),
           mSlabAlignment(slabAlignment),
           mSlabFragmentationLimit(slabFragmentationLimit),
           mAllowSlabPrefetch(allowPrefetchSlab),
-          mSlabGrowthFactor(slabGrowthFactor) {
+          mSlabGrowthFactor(slabGrowthFactor),
+          mRetentionPolicy(retentionPolicy),
+          mAllowAdaptiveSlabSize(allowAdaptiveSlabSize),
+          mSizeClassPolicy(sizeClassPolicy),
+          mSlabMemoryExchange(allowPrefetchSlab
+                                  ? std::make_unique<SlabMemoryExchange>(GetNextInChain())
+                                  : nullptr),
+          mSizeClassEntries(GetSizeClassIndex(maxSlabSize) + 1) {
         ASSERT(IsPowerOfTwo(mMaxSlabSize));
         ASSERT(mSlabGrowthFactor >= 1);
+        ASSERT(mSizeClassPolicy.SizeClassesPerDoubling == 0 ||
+               IsPowerOfTwo(mSizeClassPolicy.SizeClassesPerDoubling));
     }
 
-    SlabCacheAllocator::~SlabCacheAllocator() {
-        mSizeCache.clear();
-    }
+    SlabCacheAllocator::~SlabCacheAllocator() = default;
 
     std::unique_ptr<MemoryAllocation> SlabCacheAllocator::TryAllocateMemory(
         const MemoryAllocationRequest& request) {
         TRACE_EVENT0(TraceEventCategory::kDefault, "SlabCacheAllocator.TryAllocateMemory");
 
-        std::lock_guard<std::mutex> lock(mMutex);
-
         GPGMM_INVALID_IF(!ValidateRequest(request));
 
-        const uint64_t blockSize = AlignTo(request.SizeInBytes, request.Alignment);
+        const uint64_t blockSize = ComputeBlockSize(request);
         GPGMM_INVALID_IF(blockSize > mMaxSlabSize);
 
-        // Create a slab allocator for the new entry.
-        auto entry =
-            mSizeCache.GetOrCreate(SlabAllocatorCacheEntry(blockSize), request.AlwaysCacheSize);
-        SlabMemoryAllocator* slabAllocator = entry->GetValue().SlabAllocator.get();
-        if (slabAllocator == nullptr) {
-            entry->GetValue().SlabAllocator = std::make_unique<SlabMemoryAllocator>(
-                blockSize, mMaxSlabSize, mMinSlabSize, mSlabAlignment, mSlabFragmentationLimit,
-                mAllowSlabPrefetch, mSlabGrowthFactor, GetNextInChain());
-            slabAllocator = entry->GetValue().SlabAllocator.get();
+        // Only the size cache lookup is guarded by |mMutex|. The slab allocator serializes
+        // itself, so requests of different sizes do not wait on each other.
+        SlabAllocatorCacheEntry* entry = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            entry = FindOrCreateSlabAllocatorEntry(blockSize, request.AlwaysCacheSize);
+
+            // Reference the entry so it cannot be removed once |mMutex| is released.
+            entry->RefCount++;
         }
 
+        SlabMemoryAllocator* slabAllocator = entry->SlabAllocator.get();
         ASSERT(slabAllocator != nullptr);
 
-        std::unique_ptr<MemoryAllocation> subAllocation;
-        GPGMM_TRY_ASSIGN(slabAllocator->TryAllocateMemory(request), subAllocation);
+        std::unique_ptr<MemoryAllocation> subAllocation = slabAllocator->TryAllocateMemory(request);
+        if (subAllocation == nullptr) {
+            ReleaseSlabAllocatorEntry(entry);
+            return {};
+        }
 
-        // Hold onto the cached allocator until the last allocation gets deallocated.
-        entry->Ref();
+        if (request.GroupKey != kNoGroupKey) {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mGroupTracker.AddAllocation(request.GroupKey, subAllocation->GetMemory());
+        }
 
-        return std::make_unique<MemoryAllocation>(
-            this, subAllocation->GetMemory(), subAllocation->GetOffset(),
-            subAllocation->GetMethod(), subAllocation->GetBlock(), request.SizeInBytes);
+        // The cached allocator remains referenced until the allocation gets deallocated. The
+        // sub-allocation is passed up the chain as-is, only re-assigned to |this| allocator.
+        *subAllocation = MemoryAllocation(this, subAllocation->GetMemory(),
+                                          subAllocation->GetOffset(), subAllocation->GetMethod(),
+                                          subAllocation->GetBlock(), request.SizeInBytes);
+        return subAllocation;
     }
 
     void SlabCacheAllocator::DeallocateMemory(std::unique_ptr<MemoryAllocation> subAllocation) {
         TRACE_EVENT0(TraceEventCategory::kDefault, "SlabCacheAllocator.DeallocateMemory");
 
-        std::lock_guard<std::mutex> lock(mMutex);
+        SlabAllocatorCacheEntry* entry = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            entry = FindSlabAllocatorEntry(subAllocation->GetSize());
+            ASSERT(entry != nullptr);
+
+            const uint64_t groupKey = subAllocation->GetBlock()->GroupKey;
+            if (groupKey != kNoGroupKey) {
+                mGroupTracker.RemoveAllocation(groupKey, subAllocation->GetMemory());
+            }
+        }
 
-        auto entry =
-            mSizeCache.GetOrCreate(SlabAllocatorCacheEntry(subAllocation->GetSize()), false);
-        SlabMemoryAllocator* slabAllocator = entry->GetValue().SlabAllocator.get();
+        // The entry remains referenced by |subAllocation| until it is released below.
+        SlabMemoryAllocator* slabAllocator = entry->SlabAllocator.get();
         ASSERT(slabAllocator != nullptr);
 
         slabAllocator->DeallocateMemory(std::move(subAllocation));
 
         // If this is the last sub-allocation, remove the cached allocator.
-        // Once |entry| goes out of scope, it will unlink itself from the cache.
-        entry->Unref();
+        ReleaseSlabAllocatorEntry(entry);
+    }
+
+    std::vector<std::unique_ptr<MemoryAllocation>> SlabCacheAllocator::TryAllocateMemoryBatch(
+        const MemoryAllocationRequest* requests,
+        uint64_t count) {
+        TRACE_EVENT0(TraceEventCategory::kDefault, "SlabCacheAllocator.TryAllocateMemoryBatch");
+
+        std::vector<std::unique_ptr<MemoryAllocation>> allocations(count);
+
+        // Group requests by block size so each slab allocator services its requests in a single
+        // call. Sorting by (size, index) keeps requests of the same size in order. Invalid
+        // requests are skipped and left unallocated.
+        std::vector<std::pair<uint64_t, uint64_t>> blockSizeAndIndex;
+        blockSizeAndIndex.reserve(count);
+        for (uint64_t i = 0; i < count; i++) {
+            if (!ValidateRequest(requests[i])) {
+                continue;
+            }
+            const uint64_t blockSize = ComputeBlockSize(requests[i]);
+            if (blockSize > mMaxSlabSize) {
+                continue;
+            }
+            blockSizeAndIndex.emplace_back(blockSize, i);
+        }
+
+        std::sort(blockSizeAndIndex.begin(), blockSizeAndIndex.end());
+
+        // Look up (and reference) the entry of every group under a single lock.
+        struct RequestGroup {
+            SlabAllocatorCacheEntry* Entry;
+            uint64_t Begin;
+            uint64_t End;
+        };
+
+        std::vector<RequestGroup> groups;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            uint64_t begin = 0;
+            while (begin < blockSizeAndIndex.size()) {
+                const uint64_t blockSize = blockSizeAndIndex[begin].first;
+                bool alwaysCacheSize = false;
+                uint64_t end = begin;
+                while (end < blockSizeAndIndex.size() &&
+                       blockSizeAndIndex[end].first == blockSize) {
+                    alwaysCacheSize |= requests[blockSizeAndIndex[end].second].AlwaysCacheSize;
+                    end++;
+                }
+
+                SlabAllocatorCacheEntry* entry =
+                    FindOrCreateSlabAllocatorEntry(blockSize, alwaysCacheSize);
+                entry->RefCount += end - begin;
+
+                groups.push_back({entry, begin, end});
+                begin = end;
+            }
+        }
+
+        std::vector<MemoryAllocationRequest> groupRequests;
+        for (const RequestGroup& group : groups) {
+            groupRequests.clear();
+            for (uint64_t i = group.Begin; i < group.End; i++) {
+                groupRequests.push_back(requests[blockSizeAndIndex[i].second]);
+            }
+
+            SlabMemoryAllocator* slabAllocator = group.Entry->SlabAllocator.get();
+            ASSERT(slabAllocator != nullptr);
+
+            std::vector<std::unique_ptr<MemoryAllocation>> subAllocations =
+                slabAllocator->TryAllocateMemoryBatch(groupRequests.data(), groupRequests.size());
+
+            uint64_t failedCount = 0;
+            for (uint64_t i = 0; i < subAllocations.size(); i++) {
+                std::unique_ptr<MemoryAllocation>& subAllocation = subAllocations[i];
+                if (subAllocation == nullptr) {
+                    failedCount++;
+                    continue;
+                }
+
+                const uint64_t requestIndex = blockSizeAndIndex[group.Begin + i].second;
+                const uint64_t groupKey = requests[requestIndex].GroupKey;
+                if (groupKey != kNoGroupKey) {
+                    std::lock_guard<std::mutex> lock(mMutex);
+                    mGroupTracker.AddAllocation(groupKey, subAllocation->GetMemory());
+                }
+
+                *subAllocation = MemoryAllocation(
+                    this, subAllocation->GetMemory(), subAllocation->GetOffset(),
+                    subAllocation->GetMethod(), subAllocation->GetBlock(),
+                    requests[requestIndex].SizeInBytes);
+                allocations[requestIndex] = std::move(subAllocation);
+            }
+
+            if (failedCount > 0) {
+                ReleaseSlabAllocatorEntry(group.Entry, failedCount);
+            }
+        }
+
+        return allocations;
+    }
+
+    void SlabCacheAllocator::DeallocateMemoryBatch(
+        std::vector<std::unique_ptr<MemoryAllocation>> allocations) {
+        TRACE_EVENT0(TraceEventCategory::kDefault, "SlabCacheAllocator.DeallocateMemoryBatch");
+
+        allocations.erase(std::remove(allocations.begin(), allocations.end(), nullptr),
+                          allocations.end());
+
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            for (const auto& allocation : allocations) {
+                const uint64_t groupKey = allocation->GetBlock()->GroupKey;
+                if (groupKey != kNoGroupKey) {
+                    mGroupTracker.RemoveAllocation(groupKey, allocation->GetMemory());
+                }
+            }
+        }
+
+        // Group allocations by block size so each slab allocator is only called once.
+        std::sort(allocations.begin(), allocations.end(),
+                  [](const std::unique_ptr<MemoryAllocation>& lhs,
+                     const std::unique_ptr<MemoryAllocation>& rhs) {
+                      return lhs->GetSize() < rhs->GetSize();
+                  });
+
+        std::vector<std::unique_ptr<MemoryAllocation>> groupAllocations;
+        uint64_t begin = 0;
+        while (begin < allocations.size()) {
+            const uint64_t blockSize = allocations[begin]->GetSize();
+
+            groupAllocations.clear();
+            uint64_t end = begin;
+            while (end < allocations.size() && allocations[end]->GetSize() == blockSize) {
+                groupAllocations.push_back(std::move(allocations[end]));
+                end++;
+            }
+
+            SlabAllocatorCacheEntry* entry = nullptr;
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                entry = FindSlabAllocatorEntry(blockSize);
+                ASSERT(entry != nullptr);
+            }
+
+            // The entry remains referenced by the group until it is released below.
+            SlabMemoryAllocator* slabAllocator = entry->SlabAllocator.get();
+            ASSERT(slabAllocator != nullptr);
+
+            slabAllocator->DeallocateMemoryBatch(std::move(groupAllocations));
+
+            ReleaseSlabAllocatorEntry(entry, end - begin);
+            begin = end;
+        }
+    }
+
+    uint64_t SlabCacheAllocator::ComputeBlockSize(const MemoryAllocationRequest& request) const {
+        const uint64_t blockSize = AlignTo(request.SizeInBytes, request.Alignment);
+        if (mSizeClassPolicy.SizeClassesPerDoubling == 0) {
+            return blockSize;
+        }
+
+        // The size class remains aligned since its granularity is a power-of-two no smaller than
+        // the alignment, or else the block size is already a multiple of it.
+        const uint64_t sizeClassBlockSize =
+            AlignToSizeClass(blockSize, mSizeClassPolicy.SizeClassesPerDoubling);
+        if (sizeClassBlockSize > mMaxSlabSize ||
+            sizeClassBlockSize - blockSize > mSizeClassPolicy.MaxWasteRatio * sizeClassBlockSize) {
+            return blockSize;
+        }
+
+        return sizeClassBlockSize;
+    }
+
+    SlabCacheAllocator::SlabAllocatorCacheEntry* SlabCacheAllocator::FindSlabAllocatorEntry(
+        uint64_t blockSize) {
+        const uint64_t sizeClassIndex = GetSizeClassIndex(blockSize);
+        ASSERT(sizeClassIndex < mSizeClassEntries.size());
+        SlabAllocatorCacheEntry* entry = &mSizeClassEntries[sizeClassIndex];
+        if (entry->SlabAllocator != nullptr && entry->BlockSize == blockSize) {
+            return entry;
+        }
+
+        if (mOverflowEntries.empty()) {
+            return nullptr;
+        }
+
+        auto it = mOverflowEntries.find(blockSize);
+        return (it != mOverflowEntries.end()) ? &it->second : nullptr;
+    }
+
+    SlabCacheAllocator::SlabAllocatorCacheEntry*
+    SlabCacheAllocator::FindOrCreateSlabAllocatorEntry(uint64_t blockSize, bool alwaysCacheSize) {
+        SlabAllocatorCacheEntry* entry = FindSlabAllocatorEntry(blockSize);
+        if (entry != nullptr) {
+            mSizeCacheStats.NumOfHits++;
+            return entry;
+        }
+
+        mSizeCacheStats.NumOfMisses++;
+
+        // Use the size class entry unless another block size of the same class has it.
+        entry = &mSizeClassEntries[GetSizeClassIndex(blockSize)];
+        if (entry->SlabAllocator != nullptr) {
+            entry = &mOverflowEntries[blockSize];
+        }
+
+        ASSERT(entry->SlabAllocator == nullptr);
+        entry->BlockSize = blockSize;
+        entry->IsAlwaysCached = alwaysCacheSize;
+        entry->SlabAllocator = std::make_unique<SlabMemoryAllocator>(
+            blockSize, mMaxSlabSize, mMinSlabSize, mSlabAlignment, mSlabFragmentationLimit,
+            mAllowSlabPrefetch, mSlabGrowthFactor, GetNextInChain(), mRetentionPolicy,
+            mAllowAdaptiveSlabSize, mSlabMemoryExchange.get());
+
+        return entry;
+    }
+
+    void SlabCacheAllocator::ReleaseSlabAllocatorEntry(SlabAllocatorCacheEntry* entry,
+                                                       uint64_t refCount) {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        ASSERT(entry->RefCount >= refCount);
+        entry->RefCount -= refCount;
+        // Keep the slab allocator while it retains slabs, until they are released.
+        if (entry->RefCount == 0 && !entry->IsAlwaysCached &&
+            entry->SlabAllocator->GetRetainedSlabUsage() == 0) {
+            RemoveSlabAllocatorEntry(entry);
+        }
+    }
+
+    void SlabCacheAllocator::RemoveSlabAllocatorEntry(SlabAllocatorCacheEntry* entry) {
+        entry->SlabAllocator.reset();
+        if (entry != &mSizeClassEntries[GetSizeClassIndex(entry->BlockSize)]) {
+            mOverflowEntries.erase(entry->BlockSize);
+        }
+    }
+
+    uint64_t SlabCacheAllocator::ReleaseMemory(uint64_t bytesToRelease) {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        uint64_t bytesReleased = 0;
+        auto releaseEntry = [&](SlabAllocatorCacheEntry* entry) {
+            if (entry->SlabAllocator == nullptr || bytesReleased >= bytesToRelease) {
+                return;
+            }
+            bytesReleased += entry->SlabAllocator->ReleaseMemory(bytesToRelease - bytesReleased);
+            if (entry->RefCount == 0 && !entry->IsAlwaysCached) {
+                entry->SlabAllocator.reset();
+            }
+        };
+
+        for (SlabAllocatorCacheEntry& entry : mSizeClassEntries) {
+            releaseEntry(&entry);
+        }
+
+        for (auto it = mOverflowEntries.begin(); it != mOverflowEntries.end();) {
+            releaseEntry(&it->second);
+            if (it->second.SlabAllocator == nullptr) {
+                it = mOverflowEntries.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        // Then memory re-homed but never taken, which could be from the slab allocators removed.
+        if (mSlabMemoryExchange != nullptr && bytesReleased < bytesToRelease) {
+            bytesReleased += mSlabMemoryExchange->ReleaseMemory(bytesToRelease - bytesReleased);
+        }
+
+        if (bytesReleased < bytesToRelease) {
+            bytesReleased += GetNextInChain()->ReleaseMemory(bytesToRelease - bytesReleased);
+        }
+
+        return bytesReleased;
     }
 
     MemoryAllocatorStats SlabCacheAllocator::GetStats() const {
         std::lock_guard<std::mutex> lock(mMutex);
 
         MemoryAllocatorStats result = {};
-        for (const auto& entry : mSizeCache) {
-            const MemoryAllocatorStats& info = entry->GetValue().SlabAllocator->GetStats();
+        auto addStats = [&result](const SlabAllocatorCacheEntry& entry) {
+            if (entry.SlabAllocator == nullptr) {
+                return;
+            }
+            const MemoryAllocatorStats& info = entry.SlabAllocator->GetStats();
             result.UsedBlockCount += info.UsedBlockCount;
             result.UsedBlockUsage += info.UsedBlockUsage;
             result.PrefetchedMemoryMisses += info.PrefetchedMemoryMisses;
             result.PrefetchedMemoryMissesEliminated += info.PrefetchedMemoryMissesEliminated;
+            result.PrefetchedMemoryWasted += info.PrefetchedMemoryWasted;
+            result.PrefetchedMemoryParkedUsage += info.PrefetchedMemoryParkedUsage;
+            result.PrefetchedMemorySalvagedUsage += info.PrefetchedMemorySalvagedUsage;
+            result.InternalFragmentationUsage += info.InternalFragmentationUsage;
+            result.ExternalFragmentationUsage += info.ExternalFragmentationUsage;
+            result.LargestFreeBlockSize =
+                std::max(result.LargestFreeBlockSize, info.LargestFreeBlockSize);
+        };
+
+        for (const SlabAllocatorCacheEntry& entry : mSizeClassEntries) {
+            addStats(entry);
+        }
+        for (const auto& overflowEntry : mOverflowEntries) {
+            addStats(overflowEntry.second);
+        }
+
+        result.GroupCount = mGroupTracker.GetGroupCount();
+        result.GroupMemoryCount = mGroupTracker.GetGroupMemoryCount();
+
+        if (mSlabMemoryExchange != nullptr) {
+            const MemoryAllocatorStats& exchangeInfo = mSlabMemoryExchange->GetStats();
+            result.PrefetchedMemoryWasted += exchangeInfo.PrefetchedMemoryWasted;
+            result.PrefetchedMemoryParkedUsage += exchangeInfo.PrefetchedMemoryParkedUsage;
         }
 
         // Memory allocator is common across slab allocators.
@@ -562,13 +1655,45 @@ namespace gpgmm {
         result.UsedMemoryUsage = info.UsedMemoryUsage;
 
         // Size cache is common across slab allocators.
-        const CacheStats& sizeCacheStats = mSizeCache.GetStats();
-        result.SizeCacheHits = sizeCacheStats.NumOfHits;
-        result.SizeCacheMisses = sizeCacheStats.NumOfMisses;
+        result.SizeCacheHits = mSizeCacheStats.NumOfHits;
+        result.SizeCacheMisses = mSizeCacheStats.NumOfMisses;
 
         return result;
     }
 
+    uint64_t SlabCacheAllocator::GetSizeClassStats(MemorySizeClassStats* pSizeClassStats,
+                                                   uint64_t count) const {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        std::vector<const SlabAllocatorCacheEntry*> entries;
+        for (const SlabAllocatorCacheEntry& entry : mSizeClassEntries) {
+            if (entry.SlabAllocator != nullptr) {
+                entries.push_back(&entry);
+            }
+        }
+        for (const auto& overflowEntry : mOverflowEntries) {
+            entries.push_back(&overflowEntry.second);
+        }
+
+        // Overflow entries are not ordered with the size class entries.
+        std::sort(entries.begin(), entries.end(),
+                  [](const SlabAllocatorCacheEntry* lhs, const SlabAllocatorCacheEntry* rhs) {
+                      return lhs->BlockSize < rhs->BlockSize;
+                  });
+
+        uint64_t sizeClassCount = 0;
+        for (const SlabAllocatorCacheEntry* entry : entries) {
+            if (sizeClassCount < count) {
+                const MemoryAllocatorStats& info = entry->SlabAllocator->GetStats();
+                pSizeClassStats[sizeClassCount] = {entry->BlockSize, info.UsedBlockCount,
+                                                   info.InternalFragmentationUsage};
+            }
+            sizeClassCount++;
+        }
+
+        return sizeClassCount;
+    }
+
     uint64_t SlabCacheAllocator::GetMemorySize() const {
         return GetNextInChain()->GetMemorySize();
     }
@@ -17,14 +17,111 @@
 
 #include "gpgmm/common/MemoryAllocator.h"
 #include "gpgmm/common/MemoryCache.h"
+#include "gpgmm/common/MemoryGroup.h"
+#include "gpgmm/common/SizeClass.h"
 #include "gpgmm/common/SlabBlockAllocator.h"
 #include "gpgmm/utils/Math.h"
+#include "gpgmm/utils/NonCopyable.h"
 #include "gpgmm/utils/StableList.h"
 
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 #include <vector>
 
 namespace gpgmm {
 
+    class PlatformTime;
+    class SlabMemoryAllocator;
+
+    // Relocation of a slab-allocated block into another slab.
+    struct SlabAllocationMove {
+        MemoryAllocation* Allocation = nullptr;  // Allocation to be rebound.
+
+        IMemoryObject* SrcMemory = nullptr;
+        uint64_t SrcOffset = 0;
+
+        IMemoryObject* DstMemory = nullptr;
+        uint64_t DstOffset = 0;
+
+        uint64_t SizeInBytes = 0;
+
+        Slab** ppDstSlab = nullptr;
+    };
+
+    // Moves that would empty the least-utilized slabs so their memory can be released.
+    struct SlabCompactionPlan {
+        std::vector<SlabAllocationMove> Moves;
+
+        uint64_t BytesMoved = 0;      // Bytes the caller must copy.
+        uint64_t BytesReclaimed = 0;  // Slab memory released once committed.
+
+        // Generation of the allocator the plan was made from. A plan is stale once the allocator
+        // allocates or de-allocates again.
+        uint64_t Generation = 0;
+
+        double GetBytesReclaimedPerByteMoved() const {
+            return SafeDivide(BytesReclaimed, BytesMoved);
+        }
+    };
+
+    // Limits the empty slabs that keep their memory instead of releasing it. Retaining empty slabs
+    // avoids re-creating memory when usage oscillates around a slab boundary. By default, empty
+    // slabs are never retained.
+    struct SlabRetentionPolicy {
+        // Max number of empty slabs retained, per slab allocator.
+        uint64_t MaxEmptySlabCount = 0;
+
+        // Max total size, in bytes, of empty slabs retained, per slab allocator.
+        uint64_t MaxEmptySlabUsage = kInvalidSize;
+
+        // Retained slabs are released once unused for more than this many allocations or
+        // de-allocations (or "generations") of the slab allocator. Age is not measured in time,
+        // so an idle slab allocator keeps its retained slabs until ReleaseMemory().
+        uint64_t MaxEmptySlabAge = kInvalidSize;
+    };
+
+    // Re-homes slab memory one slab allocator no longer needs, like a pre-fetch of the wrong size,
+    // to another slab allocator of the same SlabCacheAllocator that needs a slab of that size next,
+    // so the memory is not created twice. Memory is only kept while another slab allocator expects
+    // to need it, at most one slab each.
+    class SlabMemoryExchange final : public NonCopyable {
+      public:
+        explicit SlabMemoryExchange(MemoryAllocator* memoryAllocator);
+
+        // Returns the memory never taken to |memoryAllocator|.
+        ~SlabMemoryExchange();
+
+        // Sets the size of the slab |slabAllocator| expects to create next, or zero if none.
+        void SetNextSlabSize(const SlabMemoryAllocator* slabAllocator, uint64_t slabSize);
+
+        // Keeps |slabMemory| if another slab allocator than |slabAllocator| expects to need a slab
+        // of its size. Returns false, and does nothing, otherwise.
+        bool TryOffer(const SlabMemoryAllocator* slabAllocator, const MemoryAllocation& slabMemory);
+
+        // Takes memory of |slabSize| previously offered, or returns nullptr if none.
+        std::unique_ptr<MemoryAllocation> TryTake(uint64_t slabSize);
+
+        // Returns memory never taken to |memoryAllocator|, oldest first.
+        uint64_t ReleaseMemory(uint64_t bytesToRelease);
+
+        // Returns the usage and count of memory released without being taken.
+        MemoryAllocatorStats GetStats() const;
+
+      private:
+        // Must be called with |mMutex| held.
+        uint64_t ReleaseMemoryInternal(uint64_t bytesToRelease);
+
+        MemoryAllocator* const mMemoryAllocator;
+
+        mutable std::mutex mMutex;
+        std::unordered_map<const SlabMemoryAllocator*, uint64_t> mNextSlabSizes;
+        std::vector<MemoryAllocation> mSlabMemory;  // Oldest first.
+        MemoryAllocatorStats mStats = {};
+    };
+
     // SlabMemoryAllocator uses the slab allocation technique to sub-allocate slabs of device
     // memory. Unlike other allocators, the slab allocator eliminates memory fragmentation caused by
     // frequent allocation and de-allocations and always services requests in constant-time. The
@@ -37,7 +134,23 @@ namespace gpgmm {
     // allocated. A "full" slab means ALL blocks are allocated in the slab. This ensures a freely
     // available slab can be quickly allocated without a search. To de-allocate, the same slab is
     // cached on the block which is used to release the underlying slab memory once the last block
-    // is de-allocated.
+    // is de-allocated, unless the empty slab is retained by |retentionPolicy|. Retained slabs
+    // are re-used before creating memory for a new slab and released, largest first, by
+    // ReleaseMemory().
+    //
+    // New slabs grow by |slabGrowthFactor| unless |allowAdaptiveSlabSize| is true, in which case
+    // the slab size is chosen from a decaying estimate of the allocation rate and peak number of
+    // used blocks, between |minSlabSize| and |maxSlabSize|.
+    //
+    // If |allowSlabPrefetch| is true, memory for the next slabs is allocated ahead of use on the
+    // worker pool. Up to a few slabs are prefetched at once, more while slabs are used faster than
+    // their memory gets created. Prefetched memory of a size not needed yet is re-homed to another
+    // slab allocator through |slabMemoryExchange|, if one needs it next, or parked until a slab of
+    // that size is.
+    //
+    // Allocations of the same group (see MemoryAllocationRequest::GroupKey) are packed into the
+    // slab last used by the group, while it has a free block, so fewer slabs hold the group.
+    // Otherwise, any free slab is used, so groups never create slabs of their own.
     //
     // Slab allocator implementation is closely based on Jeff Bonwick's paper "The Slab Allocator".
     // https://people.eecs.berkeley.edu/~kubitron/courses/cs194-24-S13/hand-outs/bonwick_slab.pdf
@@ -51,27 +164,123 @@ namespace gpgmm {
                             double slabFragmentationLimit,
                             bool allowSlabPrefetch,
                             double slabGrowthFactor,
-                            MemoryAllocator* memoryAllocator);
+                            MemoryAllocator* memoryAllocator,
+                            const SlabRetentionPolicy& retentionPolicy = {},
+                            bool allowAdaptiveSlabSize = false,
+                            SlabMemoryExchange* slabMemoryExchange = nullptr);
         ~SlabMemoryAllocator() override;
 
         // MemoryAllocator interface
         std::unique_ptr<MemoryAllocation> TryAllocateMemory(
             const MemoryAllocationRequest& request) override;
         void DeallocateMemory(std::unique_ptr<MemoryAllocation> allocation) override;
+        std::vector<std::unique_ptr<MemoryAllocation>> TryAllocateMemoryBatch(
+            const MemoryAllocationRequest* requests,
+            uint64_t count) override;
+        void DeallocateMemoryBatch(
+            std::vector<std::unique_ptr<MemoryAllocation>> allocations) override;
+
+        // Releases parked prefetched memory, then retained empty slabs, largest first. The next
+        // allocator is not released.
+        uint64_t ReleaseMemory(uint64_t bytesToRelease = kInvalidSize) override;
 
         MemoryAllocatorStats GetStats() const override;
 
         const char* GetTypename() const override;
 
+        // Returns the total size, in bytes, of retained empty slabs.
+        uint64_t GetRetainedSlabUsage() const;
+
+        // Plans moves of |allocations| that would empty the least-utilized slabs into the free
+        // blocks of the most-utilized ones. Only slabs whose every allocation is in
+        // |allocations| can be emptied. The caller copies each move's source to its destination,
+        // then calls CommitCompaction().
+        SlabCompactionPlan PlanCompaction(const std::vector<MemoryAllocation*>& allocations);
+
+        // Rebinds every moved allocation to its destination and releases the emptied slabs.
+        // Returns false, and does nothing, if the allocator changed since |plan| was made.
+        bool CommitCompaction(const SlabCompactionPlan& plan);
+
       private:
+        // Must be called with |mMutex| held.
+        std::unique_ptr<MemoryAllocation> TryAllocateMemoryInternal(
+            const MemoryAllocationRequest& request);
+        void DeallocateMemoryInternal(std::unique_ptr<MemoryAllocation> subAllocation);
+
+        // Returns the block to its slab, releasing the slab memory once empty unless retained.
+        // Must be called with |mMutex| held.
+        void DeallocateBlockInSlab(SlabBlock* blockInSlab,
+                                   IMemoryObject* slabMemory,
+                                   bool retainEmptySlab);
+
+        // Accounts for memory newly assigned to |slab|. Must be called with |mMutex| held.
+        void OnSlabMemoryAcquired(const Slab& slab);
+
+        // Returns the memory of an empty slab to |mMemoryAllocator|.
+        // Must be called with |mMutex| held.
+        void ReleaseSlabMemory(Slab* pSlab);
+
+        // Retains the memory of an empty slab, if allowed, or releases it.
+        // Must be called with |mMutex| held.
+        void RetainOrReleaseSlabMemory(Slab** ppSlab);
+
+        // Releases retained slabs unused for longer than allowed.
+        // Must be called with |mMutex| held.
+        void ReleaseExpiredSlabs();
+
+        // Updates the generation the oldest retained slab expires after. Must be called with
+        // |mMutex| held whenever the oldest retained slab changes.
+        void UpdateRetainedSlabExpiry();
+
         uint64_t ComputeSlabSize(uint64_t requestSize,
                                  uint64_t baseSlabSize,
                                  uint64_t availableForAllocation) const;
 
         uint64_t FindNextFreeSlabOfSize(uint64_t slabSize) const;
 
+        // Returns the slab holding allocations of the group if it has a free block, or nullptr.
+        // Must be called with |mMutex| held.
+        Slab* FindGroupSlab(uint64_t groupKey) const;
+
+        // Returns the free slab to allocate from, of any group, creating it if none exist, and its
+        // size.
+        // Must be called with |mMutex| held.
+        Slab* FindOrCreateFreeSlab(const MemoryAllocationRequest& request,
+                                   uint64_t availableForAllocation,
+                                   uint64_t* slabSizeOut);
+
+        // Must be called with |mMutex| held.
+        uint64_t ComputeSlabSizeFromDemand() const;
+        void UpdateDemandEstimate(bool isAllocation);
+
         bool IsPrefetchCoverageBelowThreshold() const;
 
+        // Must be called with |mMutex| held.
+        void UpdateAllocationIntervalEstimate();
+        void UpdateSlabCreationTimeEstimate(double creationTime);
+
+        // Returns true if |slab| and the pending pre-fetches are expected to run out of free
+        // blocks, at the estimated allocation rate, before memory for another slab could be
+        // created. Must be called with |mMutex| held.
+        bool IsSlabExhaustedSoon(const Slab& slab) const;
+
+        // Assigns prefetched memory of the slab size to |pSlab|, if any, waiting for it if
+        // needed. Returns false if none was prefetched. Must be called with |mMutex| held.
+        bool AcquirePrefetchedSlabMemory(Slab* pSlab, uint64_t slabSize);
+
+        // Re-homes prefetched memory, not needed yet, to another slab allocator or keeps it for a
+        // later slab of its size, releasing the oldest if too much is already kept.
+        // Must be called with |mMutex| held.
+        void ParkPrefetchedSlabMemory(std::unique_ptr<MemoryAllocation> slabAllocation);
+
+        // Releases parked memory, oldest first. Must be called with |mMutex| held.
+        uint64_t ReleaseParkedSlabMemory(uint64_t bytesToRelease, bool allowRehome);
+
+        // Releases prefetched memory never used, unless |allowRehome| is true and another slab
+        // allocator takes it. Must be called with |mMutex| held.
+        void ReleasePrefetchedSlabMemory(std::unique_ptr<MemoryAllocation> slabAllocation,
+                                         bool allowRehome);
+
         // Group of one or more slabs of the same size.
         struct SlabCache {
             StableList<Slab> FreeList;  // Slabs that contain partial or empty
@@ -93,6 +302,31 @@ namespace gpgmm {
 
         uint64_t mLastUsedSlabSize = 0;
 
+        // Incremented whenever a block is allocated or de-allocated.
+        uint64_t mGeneration = 0;
+
+        // Total number of blocks in slabs with memory, used or not.
+        uint64_t mUsedSlabBlockCount = 0;
+
+        struct RetainedSlab {
+            Slab** ppSlab = nullptr;
+            uint64_t Generation = 0;  // When the slab became empty.
+        };
+
+        // Slab last used by each group of allocations.
+        std::unordered_map<uint64_t, Slab**> mGroupSlabs;
+
+        // Empty slabs with memory, oldest first.
+        std::deque<RetainedSlab> mRetainedSlabs;
+        uint64_t mRetainedSlabUsage = 0;
+
+        // Retained slabs only need to be checked for expiry once the generation exceeds this.
+        uint64_t mRetainedSlabExpiryGeneration = kInvalidSize;
+
+        // Decaying estimates of demand, updated on every allocation and de-allocation.
+        double mAllocationRateEstimate = 1;  // Fraction of events that were allocations.
+        double mPeakBlockCountEstimate = 0;  // Peak number of used blocks.
+
         const uint64_t mBlockSize;
         const uint64_t mSlabAlignment;
         const uint64_t mMaxSlabSize;
@@ -101,13 +335,50 @@ namespace gpgmm {
         const double mSlabFragmentationLimit;
         const bool mAllowSlabPrefetch;
         const double mSlabGrowthFactor;
+        const SlabRetentionPolicy mRetentionPolicy;
+        const bool mAllowAdaptiveSlabSize;
 
         MemoryAllocator* mMemoryAllocator = nullptr;
-        std::shared_ptr<MemoryAllocationEvent> mNextSlabAllocationEvent;
+
+        struct PrefetchedSlab {
+            std::shared_ptr<MemoryAllocationEvent> Event;
+            uint64_t SlabSize = 0;
+            double IssueTime = 0;  // Seconds, only measured when pre-fetching is allowed.
+        };
+
+        // Slab memory being prefetched, oldest first. The max depth grows when a slab had to
+        // wait for its prefetch and shrinks when prefetched memory was wasted.
+        std::deque<PrefetchedSlab> mPrefetchQueue;
+        uint64_t mPrefetchQueueDepth = 1;
+
+        // Prefetched memory whose size was not needed once it completed, oldest first.
+        std::vector<MemoryAllocation> mParkedSlabMemory;
+
+        SlabMemoryExchange* const mSlabMemoryExchange;
+
+        // Decaying estimates, in seconds, of the time to create slab memory and between
+        // allocations. Only measured when pre-fetching is allowed.
+        std::unique_ptr<PlatformTime> mPlatformTime;
+        double mSlabCreationTimeEstimate = 0;
+        double mAllocationIntervalEstimate = 0;
+        double mLastAllocationTime = 0;
+    };
+
+    // Rounds block sizes up into a bounded number of size classes so requests of similar sizes
+    // share the same slabs. By default, every block size has its own slabs.
+    struct SlabSizeClassPolicy {
+        // Number of size classes per power-of-two range of block sizes. Must be zero, which
+        // disables rounding, or a power-of-two.
+        uint64_t SizeClassesPerDoubling = 0;
+
+        // Max fraction of the rounded block size that could be unused. Block sizes that would
+        // waste more are not rounded.
+        double MaxWasteRatio = 1;
     };
 
     // SlabCacheAllocator slab-allocates |minBlockSize|-size aligned allocations from
-    // fixed-sized slabs.
+    // fixed-sized slabs, one slab allocator per block size or size class (see
+    // SlabSizeClassPolicy). Use MagazineMemoryAllocator in front to cache blocks per-thread.
     class SlabCacheAllocator : public MemoryAllocator {
       public:
         SlabCacheAllocator(uint64_t maxSlabSize,
@@ -116,7 +387,10 @@ namespace gpgmm {
                            double slabFragmentationLimit,
                            bool allowSlabPrefetch,
                            double slabGrowthFactor,
-                           std::unique_ptr<MemoryAllocator> memoryAllocator);
+                           std::unique_ptr<MemoryAllocator> memoryAllocator,
+                           const SlabRetentionPolicy& retentionPolicy = {},
+                           bool allowAdaptiveSlabSize = false,
+                           const SlabSizeClassPolicy& sizeClassPolicy = {});
 
         ~SlabCacheAllocator() override;
 
@@ -124,29 +398,54 @@ namespace gpgmm {
         std::unique_ptr<MemoryAllocation> TryAllocateMemory(
             const MemoryAllocationRequest& request) override;
         void DeallocateMemory(std::unique_ptr<MemoryAllocation> allocation) override;
+        std::vector<std::unique_ptr<MemoryAllocation>> TryAllocateMemoryBatch(
+            const MemoryAllocationRequest* requests,
+            uint64_t count) override;
+        void DeallocateMemoryBatch(
+            std::vector<std::unique_ptr<MemoryAllocation>> allocations) override;
+
+        // Releases retained empty slabs of every slab allocator, then the next allocator.
+        uint64_t ReleaseMemory(uint64_t bytesToRelease = kInvalidSize) override;
 
         MemoryAllocatorStats GetStats() const override;
+        uint64_t GetSizeClassStats(MemorySizeClassStats* pSizeClassStats,
+                                   uint64_t count) const override;
 
         uint64_t GetMemorySize() const override;
 
+        // Returns the block size of the slab allocator servicing |request|, which is also the
+        // size of the resulting allocation.
+        uint64_t ComputeBlockSize(const MemoryAllocationRequest& request) const;
+
       private:
         const char* GetTypename() const override;
 
-        class SlabAllocatorCacheEntry : public NonCopyable {
-          public:
-            explicit SlabAllocatorCacheEntry(uint64_t blockSize) : mBlockSize(blockSize) {
-            }
+        struct SlabAllocatorCacheEntry {
+            uint64_t BlockSize = 0;
 
-            uint64_t GetKey() const {
-                return mBlockSize;
-            }
+            // Number of allocations (or pending lookups) using the slab allocator. Once zero, the
+            // slab allocator is destroyed unless always cached or it retains empty slabs.
+            uint64_t RefCount = 0;
+            bool IsAlwaysCached = false;
 
             std::unique_ptr<SlabMemoryAllocator> SlabAllocator;
-
-          private:
-            const uint64_t mBlockSize;
         };
 
+        // Returns the entry for |blockSize| if it has a slab allocator, else nullptr. Must be
+        // called with |mMutex| held.
+        SlabAllocatorCacheEntry* FindSlabAllocatorEntry(uint64_t blockSize);
+
+        // Returns the entry for |blockSize|, creating its slab allocator if needed. Must be called
+        // with |mMutex| held.
+        SlabAllocatorCacheEntry* FindOrCreateSlabAllocatorEntry(uint64_t blockSize,
+                                                                bool alwaysCacheSize);
+
+        // Releases |refCount| references to the entry, removing the slab allocator once unused.
+        void ReleaseSlabAllocatorEntry(SlabAllocatorCacheEntry* entry, uint64_t refCount = 1);
+
+        // Destroys the slab allocator of the entry. Must be called with |mMutex| held.
+        void RemoveSlabAllocatorEntry(SlabAllocatorCacheEntry* entry);
+
         const uint64_t mMaxSlabSize;
         const uint64_t mMinSlabSize;
         const uint64_t mSlabAlignment;
@@ -154,8 +453,26 @@ namespace gpgmm {
         const double mSlabFragmentationLimit;
         const bool mAllowSlabPrefetch;
         const double mSlabGrowthFactor;
+        const SlabRetentionPolicy mRetentionPolicy;
+        const bool mAllowAdaptiveSlabSize;
+        const SlabSizeClassPolicy mSizeClassPolicy;
+
+        // Created if pre-fetching is allowed. Outlives the slab allocators using it.
+        std::unique_ptr<SlabMemoryExchange> mSlabMemoryExchange;
+
+        // Guarded by |mMutex|. Each slab allocator is guarded by its own lock.
+        // One entry per size class (see GetSizeClassIndex), created upfront and never resized so
+        // lookups index directly and entries remain valid while referenced.
+        std::vector<SlabAllocatorCacheEntry> mSizeClassEntries;
+
+        // Guarded by |mMutex|. Entries of block sizes whose size class entry is used by another
+        // block size. Rare since block sizes are usually aligned or rounded to the size class.
+        std::map<uint64_t, SlabAllocatorCacheEntry> mOverflowEntries;
+
+        CacheStats mSizeCacheStats;
 
-        MemoryCache<SlabAllocatorCacheEntry> mSizeCache;
+        // Guarded by |mMutex|. Counted here since a group could span slab allocators.
+        MemoryGroupTracker mGroupTracker;
     };
 
 }  // namespace gpgmm
@@ -0,0 +1,291 @@
+// Copyright 2022 The GPGMM Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gpgmm/common/TLSFBlockAllocator.h"
+
+#include "gpgmm/common/Error.h"
+#include "gpgmm/utils/Assert.h"
+#include "gpgmm/utils/Math.h"
+
+#include <algorithm>
+
+namespace gpgmm {
+
+    TLSFBlockAllocator::TLSFBlockAllocator(uint64_t maxBlockSize) : mMaxBlockSize(maxBlockSize) {
+        ASSERT(mMaxBlockSize > 0);
+
+        mFirstBlock = new TLSFBlock{};
+        mFirstBlock->Offset = 0;
+        mFirstBlock->Size = mMaxBlockSize;
+
+        InsertFreeBlock(mFirstBlock);
+    }
+
+    TLSFBlockAllocator::~TLSFBlockAllocator() {
+        TLSFBlock* block = mFirstBlock;
+        while (block != nullptr) {
+            TLSFBlock* next = block->pNextPhysical;
+            delete block;
+            block = next;
+        }
+        mFirstBlock = nullptr;
+    }
+
+    // static
+    TLSFBlockAllocator::SizeClassIndex TLSFBlockAllocator::ComputeSizeClassIndex(
+        uint64_t blockSize) {
+        ASSERT(blockSize > 0);
+
+        // Small blocks are indexed linearly by size in the first level.
+        if (blockSize < kSecondLevelIndexCount) {
+            return {0, static_cast<uint32_t>(blockSize)};
+        }
+
+        // Otherwise, the first level is the power-of-two range and the second level is the
+        // next |kSecondLevelIndexLog2| bits below the most significant bit.
+        const uint32_t log2Size = Log2(blockSize);
+        SizeClassIndex index = {};
+        index.FirstLevel = log2Size - kSecondLevelIndexLog2 + 1;
+        index.SecondLevel = static_cast<uint32_t>(
+            (blockSize >> (log2Size - kSecondLevelIndexLog2)) & (kSecondLevelIndexCount - 1));
+        return index;
+    }
+
+    // static
+    uint32_t TLSFBlockAllocator::ComputeFirstLevelIndex(uint64_t blockSize) {
+        return ComputeSizeClassIndex(blockSize).FirstLevel;
+    }
+
+    uint32_t TLSFBlockAllocator::GetLargestFreeFirstLevelIndex() const {
+        if (mFirstLevelBitmap == 0) {
+            return kInvalidFirstLevelIndex;
+        }
+        return Log2(mFirstLevelBitmap);
+    }
+
+    uint64_t TLSFBlockAllocator::GetLargestFreeBlockSize() const {
+        if (mFirstLevelBitmap == 0) {
+            return 0;
+        }
+
+        const uint32_t firstLevel = Log2(mFirstLevelBitmap);
+        const uint32_t secondLevel = Log2(mSecondLevelBitmaps[firstLevel]);
+
+        // Blocks of the same class could differ in size.
+        uint64_t largestFreeBlockSize = 0;
+        for (const TLSFBlock* block = mFreeLists[firstLevel][secondLevel]; block != nullptr;
+             block = block->pNextFree) {
+            largestFreeBlockSize = std::max(largestFreeBlockSize, block->Size);
+        }
+        return largestFreeBlockSize;
+    }
+
+    TLSFBlockAllocator::TLSFBlock* TLSFBlockAllocator::FindFreeBlock(uint64_t requestSize) const {
+        // Round-up the request to the next size class so ANY free block in the class fits.
+        uint64_t searchSize = requestSize;
+        if (searchSize >= kSecondLevelIndexCount) {
+            searchSize += (uint64_t{1} << (Log2(searchSize) - kSecondLevelIndexLog2)) - 1;
+        }
+
+        SizeClassIndex index = ComputeSizeClassIndex(searchSize);
+
+        // Use the smallest non-empty class of the same range, if any.
+        uint32_t secondLevelBitmap =
+            mSecondLevelBitmaps[index.FirstLevel] & (~0u << index.SecondLevel);
+        if (secondLevelBitmap == 0) {
+            // Otherwise, use the smallest non-empty class of the next larger range.
+            const uint64_t firstLevelBitmap =
+                (index.FirstLevel + 1 < kFirstLevelIndexCount)
+                    ? mFirstLevelBitmap & (~uint64_t{0} << (index.FirstLevel + 1))
+                    : 0;
+            if (firstLevelBitmap == 0) {
+                // No larger class exists but a block in the same class as the request could
+                // still fit (eg. the request is the entire range).
+                const SizeClassIndex requestIndex = ComputeSizeClassIndex(requestSize);
+                TLSFBlock* block = mFreeLists[requestIndex.FirstLevel][requestIndex.SecondLevel];
+                return (block != nullptr && block->Size >= requestSize) ? block : nullptr;
+            }
+
+            index.FirstLevel = ScanForward(firstLevelBitmap);
+            secondLevelBitmap = mSecondLevelBitmaps[index.FirstLevel];
+            ASSERT(secondLevelBitmap != 0);
+        }
+
+        index.SecondLevel = ScanForward(secondLevelBitmap);
+        return mFreeLists[index.FirstLevel][index.SecondLevel];
+    }
+
+    void TLSFBlockAllocator::InsertFreeBlock(TLSFBlock* block) {
+        const SizeClassIndex index = ComputeSizeClassIndex(block->Size);
+
+        TLSFBlock*& head = mFreeLists[index.FirstLevel][index.SecondLevel];
+        block->IsFree = true;
+        block->pPrevFree = nullptr;
+        block->pNextFree = head;
+        if (head != nullptr) {
+            head->pPrevFree = block;
+        }
+        head = block;
+
+        mFirstLevelBitmap |= (uint64_t{1} << index.FirstLevel);
+        mSecondLevelBitmaps[index.FirstLevel] |= (1u << index.SecondLevel);
+    }
+
+    void TLSFBlockAllocator::RemoveFreeBlock(TLSFBlock* block) {
+        ASSERT(block->IsFree);
+
+        const SizeClassIndex index = ComputeSizeClassIndex(block->Size);
+
+        TLSFBlock*& head = mFreeLists[index.FirstLevel][index.SecondLevel];
+        if (block->pPrevFree != nullptr) {
+            block->pPrevFree->pNextFree = block->pNextFree;
+        } else {
+            ASSERT(head == block);
+            head = block->pNextFree;
+        }
+
+        if (block->pNextFree != nullptr) {
+            block->pNextFree->pPrevFree = block->pPrevFree;
+        }
+
+        block->pPrevFree = nullptr;
+        block->pNextFree = nullptr;
+        block->IsFree = false;
+
+        // Clear the bitmaps once the class becomes empty.
+        if (head == nullptr) {
+            mSecondLevelBitmaps[index.FirstLevel] &= ~(1u << index.SecondLevel);
+            if (mSecondLevelBitmaps[index.FirstLevel] == 0) {
+                mFirstLevelBitmap &= ~(uint64_t{1} << index.FirstLevel);
+            }
+        }
+    }
+
+    TLSFBlockAllocator::TLSFBlock* TLSFBlockAllocator::SplitBlock(TLSFBlock* block,
+                                                                  uint64_t size) {
+        ASSERT(size < block->Size);
+
+        TLSFBlock* remainder = new TLSFBlock{};
+        remainder->Offset = block->Offset + size;
+        remainder->Size = block->Size - size;
+        remainder->pPrevPhysical = block;
+        remainder->pNextPhysical = block->pNextPhysical;
+        if (block->pNextPhysical != nullptr) {
+            block->pNextPhysical->pPrevPhysical = remainder;
+        }
+
+        block->pNextPhysical = remainder;
+        block->Size = size;
+
+        return remainder;
+    }
+
+    void TLSFBlockAllocator::MergeBlock(TLSFBlock* block, TLSFBlock* next) {
+        ASSERT(block->pNextPhysical == next);
+        ASSERT(block->Offset + block->Size == next->Offset);
+
+        block->Size += next->Size;
+        block->pNextPhysical = next->pNextPhysical;
+        if (next->pNextPhysical != nullptr) {
+            next->pNextPhysical->pPrevPhysical = block;
+        }
+
+        delete next;
+    }
+
+    MemoryBlock* TLSFBlockAllocator::TryAllocateBlock(uint64_t requestSize, uint64_t alignment) {
+        // Requested cannot be empty or exceed the range.
+        GPGMM_INVALID_IF(requestSize == 0 || requestSize > mMaxBlockSize);
+
+        GPGMM_INVALID_IF(!IsPowerOfTwo(alignment));
+
+        // Most blocks are already aligned when requests share the same alignment, so first try
+        // the free block that fits the request without padding.
+        TLSFBlock* block = FindFreeBlock(requestSize);
+        if (block != nullptr &&
+            AlignTo(block->Offset, alignment) + requestSize > block->Offset + block->Size) {
+            block = nullptr;
+        }
+
+        // Otherwise, find a larger block that fits the request at ANY offset.
+        if (block == nullptr && alignment > 1 && alignment - 1 <= mMaxBlockSize - requestSize) {
+            block = FindFreeBlock(requestSize + alignment - 1);
+        }
+
+        if (block == nullptr) {
+            return nullptr;
+        }
+
+        RemoveFreeBlock(block);
+
+        // Return the unaligned head of the block as a free block. The previous block cannot be
+        // free since free blocks are always merged.
+        const uint64_t padding = AlignTo(block->Offset, alignment) - block->Offset;
+        if (padding > 0) {
+            TLSFBlock* alignedBlock = SplitBlock(block, padding);
+            InsertFreeBlock(block);
+            block = alignedBlock;
+        }
+
+        // Return the unused tail of the block as a free block.
+        if (block->Size > requestSize) {
+            InsertFreeBlock(SplitBlock(block, requestSize));
+        }
+
+        block->IsFree = false;
+        return block;
+    }
+
+    void TLSFBlockAllocator::DeallocateBlock(MemoryBlock* block) {
+        ASSERT(block != nullptr);
+
+        TLSFBlock* freeBlock = static_cast<TLSFBlock*>(block);
+        ASSERT(!freeBlock->IsFree);
+
+        // Merge with the free blocks on either side.
+        TLSFBlock* prev = freeBlock->pPrevPhysical;
+        if (prev != nullptr && prev->IsFree) {
+            RemoveFreeBlock(prev);
+            MergeBlock(prev, freeBlock);
+            freeBlock = prev;
+        }
+
+        TLSFBlock* next = freeBlock->pNextPhysical;
+        if (next != nullptr && next->IsFree) {
+            RemoveFreeBlock(next);
+            MergeBlock(freeBlock, next);
+        }
+
+        InsertFreeBlock(freeBlock);
+    }
+
+    bool TLSFBlockAllocator::IsEmpty() const {
+        return mFirstBlock->IsFree && mFirstBlock->Size == mMaxBlockSize;
+    }
+
+    uint64_t TLSFBlockAllocator::ComputeTotalNumOfFreeBlocksForTesting() const {
+        uint64_t numOfFreeBlocks = 0;
+        for (TLSFBlock* block = mFirstBlock; block != nullptr; block = block->pNextPhysical) {
+            if (block->IsFree) {
+                numOfFreeBlocks++;
+            }
+        }
+        return numOfFreeBlocks;
+    }
+
+    const char* TLSFBlockAllocator::GetTypename() const {
+        return "TLSFBlockAllocator";
+    }
+
+}  // namespace gpgmm
@@ -0,0 +1,125 @@
+// Copyright 2022 The GPGMM Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GPGMM_COMMON_TLSFBLOCKALLOCATOR_H_
+#define GPGMM_COMMON_TLSFBLOCKALLOCATOR_H_
+
+#include "gpgmm/common/BlockAllocator.h"
+#include "gpgmm/utils/PooledObject.h"
+
+#include <cstdint>
+
+namespace gpgmm {
+
+    // TLSFBlockAllocator uses the two-level segregated fit (TLSF) technique to allocate
+    // variable-sized blocks in a range of |maxBlockSize| bytes. Unlike the buddy allocator, the
+    // allocated block is exactly the size requested and the remainder is returned back as a free
+    // block, so internal fragmentation is bounded by alignment only.
+    //
+    // Internally, free blocks are segregated into size classes using two levels: the first level
+    // is the power-of-two range of the block size and the second level linearly divides that range
+    // into |kSecondLevelIndexCount| classes. A bitmap per level marks non-empty free-lists so a
+    // suitable free block is always found with two bit scans, in O(1) time. Blocks keep links to
+    // their physical neighbors so a de-allocated block is immediately merged with adjacent free
+    // blocks, also in O(1) time.
+    //
+    // TLSF implementation is closely based on M. Masmano et al. paper "TLSF: a New Dynamic Memory
+    // Allocator for Real-Time Systems".
+    // http://www.gii.upv.es/tlsf/files/ecrts04_tlsf.pdf
+    //
+    class TLSFBlockAllocator final : public BlockAllocator {
+      private:
+        static constexpr uint32_t kSecondLevelIndexLog2 = 5;
+        static constexpr uint32_t kSecondLevelIndexCount = 1u << kSecondLevelIndexLog2;
+
+      public:
+        static constexpr uint32_t kFirstLevelIndexCount = 64 - kSecondLevelIndexLog2 + 1;
+        static constexpr uint32_t kInvalidFirstLevelIndex = kFirstLevelIndexCount;
+
+        explicit TLSFBlockAllocator(uint64_t maxBlockSize);
+        ~TLSFBlockAllocator() override;
+
+        // BlockAllocator interface
+        MemoryBlock* TryAllocateBlock(uint64_t requestSize, uint64_t alignment = 1) override;
+        void DeallocateBlock(MemoryBlock* block) override;
+
+        // Returns true if no blocks are allocated.
+        bool IsEmpty() const;
+
+        // Returns the size of the largest free block, or zero if none exists. Only the free-list
+        // of the largest non-empty size class is searched.
+        uint64_t GetLargestFreeBlockSize() const;
+
+        // Returns the first-level size class of the largest free block, or
+        // kInvalidFirstLevelIndex if none exists. Unlike GetLargestFreeBlockSize(), this is O(1).
+        uint32_t GetLargestFreeFirstLevelIndex() const;
+
+        // Returns the first-level size class which contains |blockSize|. Any block of a larger
+        // first-level size class is larger than |blockSize|.
+        static uint32_t ComputeFirstLevelIndex(uint64_t blockSize);
+
+        // For testing purposes only.
+        uint64_t ComputeTotalNumOfFreeBlocksForTesting() const;
+
+        const char* GetTypename() const override;
+
+      private:
+        // Blocks are split and merged upon every allocate and de-allocate, so their storage is
+        // pooled instead of using the heap each time.
+        struct TLSFBlock : public MemoryBlock, public PooledObject<TLSFBlock> {
+            // Adjacent blocks in the range, used to merge free blocks upon de-allocate.
+            TLSFBlock* pPrevPhysical = nullptr;
+            TLSFBlock* pNextPhysical = nullptr;
+
+            // Adjacent blocks in the same free-list, only valid when free.
+            TLSFBlock* pPrevFree = nullptr;
+            TLSFBlock* pNextFree = nullptr;
+
+            bool IsFree = true;
+        };
+
+        struct SizeClassIndex {
+            uint32_t FirstLevel = 0;
+            uint32_t SecondLevel = 0;
+        };
+
+        // Returns the size class which contains |blockSize|.
+        static SizeClassIndex ComputeSizeClassIndex(uint64_t blockSize);
+
+        // Returns a free block of at-least |requestSize| or nullptr if none exists.
+        TLSFBlock* FindFreeBlock(uint64_t requestSize) const;
+
+        void InsertFreeBlock(TLSFBlock* block);
+        void RemoveFreeBlock(TLSFBlock* block);
+
+        // Splits |block| so it becomes |size| and returns the remainder.
+        TLSFBlock* SplitBlock(TLSFBlock* block, uint64_t size);
+
+        // Merges |next| into |block| and deletes |next|.
+        void MergeBlock(TLSFBlock* block, TLSFBlock* next);
+
+        const uint64_t mMaxBlockSize;
+
+        TLSFBlock* mFirstBlock = nullptr;  // Block at offset zero, never merged away.
+
+        uint64_t mFirstLevelBitmap = 0;
+        uint32_t mSecondLevelBitmaps[kFirstLevelIndexCount] = {};
+
+        // Heads of free-lists indexed by size class.
+        TLSFBlock* mFreeLists[kFirstLevelIndexCount][kSecondLevelIndexCount] = {};
+    };
+
+}  // namespace gpgmm
+
+#endif  // GPGMM_COMMON_TLSFBLOCKALLOCATOR_H_
@@ -0,0 +1,247 @@
+// Copyright 2022 The GPGMM Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "gpgmm/common/TLSFMemoryAllocator.h"
+
+#include "gpgmm/common/EventMessage.h"
+#include "gpgmm/common/Memory.h"
+#include "gpgmm/common/TraceEvent.h"
+#include "gpgmm/utils/Math.h"
+
+#include <algorithm>
+
+namespace gpgmm {
+
+    TLSFMemoryAllocator::TLSFMemoryAllocator(uint64_t memorySize,
+                                             uint64_t memoryAlignment,
+                                             std::unique_ptr<MemoryAllocator> memoryAllocator)
+        : MemoryAllocator(std::move(memoryAllocator)),
+          mMemorySize(memorySize),
+          mMemoryAlignment(memoryAlignment) {
+        ASSERT(IsPowerOfTwo(mMemoryAlignment));
+        ASSERT(IsAligned(mMemorySize, mMemoryAlignment));
+    }
+
+    std::unique_ptr<MemoryAllocation> TLSFMemoryAllocator::TryAllocateMemory(
+        const MemoryAllocationRequest& request) {
+        TRACE_EVENT0(TraceEventCategory::kDefault, "TLSFMemoryAllocator.TryAllocateMemory");
+
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        GPGMM_INVALID_IF(!ValidateRequest(request));
+
+        // Request cannot exceed memory size.
+        GPGMM_INVALID_IF(request.SizeInBytes > mMemorySize);
+
+        // Attempt to sub-allocate from existing memory whose largest free block is in the same
+        // size class as the request, which could fit.
+        const uint32_t firstLevelIndex =
+            TLSFBlockAllocator::ComputeFirstLevelIndex(request.SizeInBytes);
+        TLSFHeap* heap = FindFreeHeap(firstLevelIndex);
+        if (heap != nullptr) {
+            std::unique_ptr<MemoryAllocation> subAllocation = TrySubAllocateFromHeap(heap, request);
+            if (subAllocation != nullptr) {
+                return subAllocation;
+            }
+
+            // Otherwise, use memory whose largest free block is in a larger size class, which
+            // always fits, even once padded for alignment.
+            const uint32_t fitFirstLevelIndex =
+                TLSFBlockAllocator::ComputeFirstLevelIndex(request.SizeInBytes +
+                                                           request.Alignment - 1) +
+                1;
+            if (heap->FreeFirstLevelIndex < fitFirstLevelIndex) {
+                heap = FindFreeHeap(fitFirstLevelIndex);
+                if (heap != nullptr) {
+                    subAllocation = TrySubAllocateFromHeap(heap, request);
+                    if (subAllocation != nullptr) {
+                        return subAllocation;
+                    }
+                }
+            }
+        }
+
+        if (request.NeverAllocate) {
+            return {};
+        }
+
+        // No existing memory could fit the request, allocate new memory for it.
+        MemoryAllocationRequest newRequest = request;
+        newRequest.SizeInBytes = mMemorySize;
+        newRequest.Alignment = mMemoryAlignment;
+
+        std::unique_ptr<MemoryAllocation> memoryAllocation;
+        GPGMM_TRY_ASSIGN(GetNextInChain()->TryAllocateMemory(newRequest), memoryAllocation);
+
+        std::unique_ptr<TLSFHeap> newHeapOwner = std::make_unique<TLSFHeap>(mMemorySize);
+        newHeapOwner->Allocation = *memoryAllocation;
+
+        TLSFHeap* newHeap = newHeapOwner.get();
+        mHeapOfMemory[memoryAllocation->GetMemory()] = std::move(newHeapOwner);
+        UpdateFreeHeap(newHeap);
+
+        // New memory is free until sub-allocated.
+        mStats.ExternalFragmentationUsage += mMemorySize;
+
+        std::unique_ptr<MemoryAllocation> subAllocation = TrySubAllocateFromHeap(newHeap, request);
+        if (subAllocation == nullptr) {
+            RemoveHeap(newHeap);
+        }
+
+        return subAllocation;
+    }
+
+    TLSFMemoryAllocator::TLSFHeap* TLSFMemoryAllocator::FindFreeHeap(
+        uint32_t firstLevelIndex) const {
+        if (firstLevelIndex >= TLSFBlockAllocator::kFirstLevelIndexCount) {
+            return nullptr;
+        }
+
+        const uint64_t freeHeapsBitmap = mFreeHeapsBitmap & (~uint64_t{0} << firstLevelIndex);
+        if (freeHeapsBitmap == 0) {
+            return nullptr;
+        }
+
+        return mFreeHeaps[ScanForward(freeHeapsBitmap)].head()->value();
+    }
+
+    void TLSFMemoryAllocator::RemoveFreeHeap(TLSFHeap* heap) {
+        if (!heap->IsInList()) {
+            return;
+        }
+
+        heap->RemoveFromList();
+        if (mFreeHeaps[heap->FreeFirstLevelIndex].empty()) {
+            mFreeHeapsBitmap &= ~(uint64_t{1} << heap->FreeFirstLevelIndex);
+        }
+        heap->FreeFirstLevelIndex = TLSFBlockAllocator::kInvalidFirstLevelIndex;
+    }
+
+    void TLSFMemoryAllocator::UpdateFreeHeap(TLSFHeap* heap) {
+        const uint32_t firstLevelIndex = heap->BlockAllocator.GetLargestFreeFirstLevelIndex();
+        if (firstLevelIndex == heap->FreeFirstLevelIndex) {
+            return;
+        }
+
+        RemoveFreeHeap(heap);
+        if (firstLevelIndex == TLSFBlockAllocator::kInvalidFirstLevelIndex) {
+            return;
+        }
+
+        heap->FreeFirstLevelIndex = firstLevelIndex;
+        heap->InsertAfter(mFreeHeaps[firstLevelIndex].tail());
+        mFreeHeapsBitmap |= (uint64_t{1} << firstLevelIndex);
+    }
+
+    std::unique_ptr<MemoryAllocation> TLSFMemoryAllocator::TrySubAllocateFromHeap(
+        TLSFHeap* heap,
+        const MemoryAllocationRequest& request) {
+        std::unique_ptr<MemoryAllocation> subAllocation;
+        GPGMM_TRY_ASSIGN(
+            TrySubAllocateMemory(&heap->BlockAllocator, request.SizeInBytes, request.Alignment,
+                                 request.NeverAllocate,
+                                 [&](const auto&) -> IMemoryObject* {
+                                     return heap->Allocation.GetMemory();
+                                 }),
+            subAllocation);
+
+        UpdateFreeHeap(heap);
+
+        MemoryBlock* block = subAllocation->GetBlock();
+        block->RequestSize = request.SizeInBytes;
+
+        mStats.UsedBlockCount++;
+        mStats.UsedBlockUsage += block->Size;
+        mStats.InternalFragmentationUsage += block->Size - block->RequestSize;
+        mStats.ExternalFragmentationUsage -= block->Size;
+
+        // Re-use the sub-allocation instead of creating another MemoryAllocation.
+        *subAllocation =
+            MemoryAllocation(/*allocator*/ this, subAllocation->GetMemory(), block->Offset,
+                             AllocationMethod::kSubAllocated, block, request.SizeInBytes);
+        return subAllocation;
+    }
+
+    void TLSFMemoryAllocator::DeallocateMemory(std::unique_ptr<MemoryAllocation> subAllocation) {
+        TRACE_EVENT0(TraceEventCategory::kDefault, "TLSFMemoryAllocator.DeallocateMemory");
+
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        ASSERT(subAllocation != nullptr);
+
+        IMemoryObject* memory = subAllocation->GetMemory();
+        ASSERT(memory != nullptr);
+
+        auto it = mHeapOfMemory.find(memory);
+        ASSERT(it != mHeapOfMemory.end());
+
+        TLSFHeap* heap = it->second.get();
+
+        MemoryBlock* block = subAllocation->GetBlock();
+        mStats.UsedBlockCount--;
+        mStats.UsedBlockUsage -= block->Size;
+        mStats.InternalFragmentationUsage -= block->Size - block->RequestSize;
+        mStats.ExternalFragmentationUsage += block->Size;
+
+        heap->BlockAllocator.DeallocateBlock(block);
+
+        if (memory->RemoveSubAllocationRef()) {
+            ASSERT(heap->BlockAllocator.IsEmpty());
+            RemoveHeap(heap);
+        } else {
+            UpdateFreeHeap(heap);
+        }
+    }
+
+    void TLSFMemoryAllocator::RemoveHeap(TLSFHeap* heap) {
+        const MemoryAllocation allocation = heap->Allocation;
+
+        RemoveFreeHeap(heap);
+
+        mHeapOfMemory.erase(allocation.GetMemory());
+        mStats.ExternalFragmentationUsage -= mMemorySize;
+
+        GetNextInChain()->DeallocateMemory(std::make_unique<MemoryAllocation>(allocation));
+    }
+
+    uint64_t TLSFMemoryAllocator::GetMemorySize() const {
+        return mMemorySize;
+    }
+
+    uint64_t TLSFMemoryAllocator::GetMemoryAlignment() const {
+        return mMemoryAlignment;
+    }
+
+    MemoryAllocatorStats TLSFMemoryAllocator::GetStats() const {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        MemoryAllocatorStats result = mStats;
+        const MemoryAllocatorStats& memoryInfo = GetNextInChain()->GetStats();
+        result.UsedMemoryCount = memoryInfo.UsedMemoryCount;
+        result.UsedMemoryUsage = memoryInfo.UsedMemoryUsage;
+        result.FreeMemoryUsage = memoryInfo.FreeMemoryUsage;
+
+        for (const auto& heapOfMemory : mHeapOfMemory) {
+            result.LargestFreeBlockSize =
+                std::max(result.LargestFreeBlockSize,
+                         heapOfMemory.second->BlockAllocator.GetLargestFreeBlockSize());
+        }
+        return result;
+    }
+
+    const char* TLSFMemoryAllocator::GetTypename() const {
+        return "TLSFMemoryAllocator";
+    }
+
+}  // namespace gpgmm
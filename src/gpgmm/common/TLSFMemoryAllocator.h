@@ -0,0 +1,102 @@
+// Copyright 2022 The GPGMM Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GPGMM_COMMON_TLSFMEMORYALLOCATOR_H_
+#define GPGMM_COMMON_TLSFMEMORYALLOCATOR_H_
+
+#include "gpgmm/common/MemoryAllocator.h"
+#include "gpgmm/common/TLSFBlockAllocator.h"
+#include "gpgmm/utils/LinkedList.h"
+
+#include <memory>
+#include <unordered_map>
+
+namespace gpgmm {
+
+    // TLSFMemoryAllocator uses the TLSF allocator to sub-allocate variable-sized blocks of device
+    // memory created by MemoryAllocator clients. Unlike the buddy allocator, requests are not
+    // rounded-up to a power-of-two and, unlike the slab allocator, blocks of any size share the
+    // same memory.
+    //
+    // Each memory of |memorySize| is sub-allocated by its own TLSF allocator. Like free blocks,
+    // memory is segregated by the first-level size class of its largest free block, with a bitmap
+    // marking the non-empty classes, so memory that fits the request is found with a bit scan, in
+    // O(1) time, regardless of the amount of memory. Requests are sub-allocated from the memory
+    // with the smallest largest free block that could fit (ie. good-fit), oldest first, so emptier
+    // memory is more likely to become unused and be released once the last block is
+    // de-allocated.
+    class TLSFMemoryAllocator final : public MemoryAllocator {
+      public:
+        TLSFMemoryAllocator(uint64_t memorySize,
+                            uint64_t memoryAlignment,
+                            std::unique_ptr<MemoryAllocator> memoryAllocator);
+
+        // MemoryAllocator interface
+        std::unique_ptr<MemoryAllocation> TryAllocateMemory(
+            const MemoryAllocationRequest& request) override;
+        void DeallocateMemory(std::unique_ptr<MemoryAllocation> subAllocation) override;
+
+        uint64_t GetMemorySize() const override;
+        uint64_t GetMemoryAlignment() const override;
+        MemoryAllocatorStats GetStats() const override;
+        const char* GetTypename() const override;
+
+      private:
+        // Memory and the TLSF allocator which sub-allocates it.
+        struct TLSFHeap : public LinkNode<TLSFHeap> {
+            explicit TLSFHeap(uint64_t memorySize) : BlockAllocator(memorySize) {
+            }
+
+            ~TLSFHeap() {
+                if (IsInList()) {
+                    RemoveFromList();
+                }
+            }
+
+            TLSFBlockAllocator BlockAllocator;
+            MemoryAllocation Allocation;
+
+            // Size class of |mFreeHeaps| the heap is in, if any.
+            uint32_t FreeFirstLevelIndex = TLSFBlockAllocator::kInvalidFirstLevelIndex;
+        };
+
+        // Returns the oldest heap whose largest free block is in the smallest size class of at
+        // least |firstLevelIndex|, or nullptr if none exists.
+        TLSFHeap* FindFreeHeap(uint32_t firstLevelIndex) const;
+
+        std::unique_ptr<MemoryAllocation> TrySubAllocateFromHeap(
+            TLSFHeap* heap,
+            const MemoryAllocationRequest& request);
+
+        // Moves |heap| to the size class of its largest free block.
+        void UpdateFreeHeap(TLSFHeap* heap);
+        void RemoveFreeHeap(TLSFHeap* heap);
+
+        void RemoveHeap(TLSFHeap* heap);
+
+        const uint64_t mMemorySize;
+        const uint64_t mMemoryAlignment;
+
+        // Guarded by |mMutex|.
+        std::unordered_map<IMemoryObject*, std::unique_ptr<TLSFHeap>> mHeapOfMemory;
+
+        // Heaps with free blocks, indexed by the first-level size class of their largest free
+        // block and ordered from oldest to newest. Guarded by |mMutex|.
+        LinkedList<TLSFHeap> mFreeHeaps[TLSFBlockAllocator::kFirstLevelIndexCount];
+        uint64_t mFreeHeapsBitmap = 0;
+    };
+
+}  // namespace gpgmm
+
+#endif  // GPGMM_COMMON_TLSFMEMORYALLOCATOR_H_
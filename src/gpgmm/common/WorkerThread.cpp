@@ -15,14 +15,24 @@
 #include "gpgmm/common/WorkerThread.h"
 
 #include "gpgmm/common/TraceEvent.h"
+#include "gpgmm/utils/Assert.h"
 #include "gpgmm/utils/PlatformUtils.h"
 
+#include <algorithm>
+#include <array>
 #include <condition_variable>
+#include <deque>
 #include <functional>
+#include <queue>
 #include <thread>
+#include <vector>
 
 namespace gpgmm {
 
+    // Number of workers in the shared pool. Tasks are short (eg. prefetching memory), so a few
+    // workers are enough no matter the number of cores.
+    static constexpr uint32_t kMaxNumOfSharedWorkers = 4u;
+
     class AsyncEventImpl final : public Event {
       public:
         AsyncEventImpl() = default;
@@ -59,7 +69,8 @@ namespace gpgmm {
         ~AsyncThreadPoolImpl() override = default;
 
         std::shared_ptr<Event> postTaskImpl(std::shared_ptr<VoidCallback> callback,
-                                            const char* name) override {
+                                            const char* name,
+                                            TaskPriority priority) override {
             std::shared_ptr<Event> event = std::make_shared<AsyncEventImpl>();
             std::thread thread([callback, event, name]() {
                 SetThreadName(name);
@@ -70,6 +81,260 @@ namespace gpgmm {
             thread.detach();
             return event;
         }
+
+        std::shared_ptr<Event> postDelayedTaskImpl(std::shared_ptr<VoidCallback> callback,
+                                                   const char* name,
+                                                   std::chrono::steady_clock::duration delay,
+                                                   TaskPriority priority) override {
+            std::shared_ptr<Event> event = std::make_shared<AsyncEventImpl>();
+            std::thread thread([callback, event, name, delay]() {
+                SetThreadName(name);
+                TRACE_EVENT_METADATA1(TraceEventCategory::kMetadata, "thread_name", "name", name);
+                std::this_thread::sleep_for(delay);
+                (*callback)();
+                event->Signal();
+            });
+            thread.detach();
+            return event;
+        }
+    };
+
+    // Runs tasks on a fixed set of long-lived workers. Each worker owns a queue per priority.
+    // Tasks are posted round-robin and a worker without tasks of its own steals from the others,
+    // so one long task cannot hold back the tasks queued behind it. Delayed tasks are kept aside,
+    // ordered by due time, and get queued by the first worker to find them due.
+    //
+    // At most kMaxTasksPerWorker tasks per worker can be queued. Once full, low priority tasks are
+    // dropped: their callback never runs but their event still gets signaled. Any other task
+    // blocks the poster until a worker makes room, unless posted by a worker, which would
+    // otherwise wait on itself.
+    class WorkerThreadPoolImpl final : public ThreadPool {
+      public:
+        explicit WorkerThreadPoolImpl(uint32_t numOfWorkers) : mState(std::make_shared<State>()) {
+            ASSERT(numOfWorkers > 0);
+            mState->Queues.resize(numOfWorkers);
+            mState->MaxNumOfQueuedTasks = kMaxTasksPerWorker * numOfWorkers;
+            for (uint32_t i = 0; i < numOfWorkers; i++) {
+                mWorkers.emplace_back(RunWorker, mState, i);
+            }
+        }
+
+        ~WorkerThreadPoolImpl() override {
+            {
+                std::lock_guard<std::mutex> lock(mState->Mutex);
+                mState->IsShutdown = true;
+            }
+            mState->TaskCondition.notify_all();
+
+            // The last reference could be released by a task, so a worker must never join itself.
+            // Once detached, the worker only uses the state it holds a reference to.
+            for (std::thread& worker : mWorkers) {
+                if (worker.get_id() == std::this_thread::get_id()) {
+                    worker.detach();
+                } else {
+                    worker.join();
+                }
+            }
+
+            // Delayed tasks not yet due never run but must not leave their waiters blocked.
+            std::lock_guard<std::mutex> lock(mState->Mutex);
+            while (!mState->DelayedTasks.empty()) {
+                mState->DelayedTasks.top().PostedTask.SignalEvent->Signal();
+                mState->DelayedTasks.pop();
+            }
+        }
+
+        std::shared_ptr<Event> postTaskImpl(std::shared_ptr<VoidCallback> callback,
+                                            const char* name,
+                                            TaskPriority priority) override {
+            std::shared_ptr<Event> event = std::make_shared<AsyncEventImpl>();
+            {
+                std::unique_lock<std::mutex> lock(mState->Mutex);
+                if (mState->NumOfQueuedTasks >= mState->MaxNumOfQueuedTasks) {
+                    if (priority == TaskPriority::kLow) {
+                        lock.unlock();
+                        TRACE_EVENT_INSTANT0(TraceEventCategory::kDefault,
+                                             "WorkerThreadPool.DropTask");
+                        event->Signal();
+                        return event;
+                    }
+
+                    if (!IsWorkerThread()) {
+                        TRACE_EVENT0(TraceEventCategory::kDefault, "WorkerThreadPool.WaitForRoom");
+                        mState->RoomCondition.wait(lock, [this] {
+                            return mState->NumOfQueuedTasks < mState->MaxNumOfQueuedTasks;
+                        });
+                    }
+                }
+
+                // Use the next queue in round-robin order.
+                const size_t queueIndex = mState->NextQueueIndex++ % mState->Queues.size();
+                PushTask(mState.get(), queueIndex, {callback, event, name}, priority);
+            }
+            mState->TaskCondition.notify_one();
+
+            return event;
+        }
+
+        std::shared_ptr<Event> postDelayedTaskImpl(std::shared_ptr<VoidCallback> callback,
+                                                   const char* name,
+                                                   std::chrono::steady_clock::duration delay,
+                                                   TaskPriority priority) override {
+            std::shared_ptr<Event> event = std::make_shared<AsyncEventImpl>();
+            {
+                std::lock_guard<std::mutex> lock(mState->Mutex);
+                mState->DelayedTasks.push(
+                    {Clock::now() + delay, priority, Task{callback, event, name}});
+            }
+
+            // Wake a worker so it waits until the new task is due, should it be the earliest.
+            mState->TaskCondition.notify_one();
+
+            return event;
+        }
+
+      private:
+        using Clock = std::chrono::steady_clock;
+
+        static constexpr size_t kNumOfPriorities = static_cast<size_t>(TaskPriority::kLow) + 1;
+
+        struct Task {
+            std::shared_ptr<VoidCallback> Callback;
+            std::shared_ptr<Event> SignalEvent;
+            const char* Name;
+        };
+
+        struct DelayedTask {
+            Clock::time_point DueTime;
+            TaskPriority Priority;
+            Task PostedTask;
+
+            bool operator>(const DelayedTask& other) const {
+                return DueTime > other.DueTime;
+            }
+        };
+
+        using WorkQueue = std::array<std::deque<Task>, kNumOfPriorities>;
+
+        // Shared with the workers so a detached worker never outlives it.
+        struct State {
+            std::mutex Mutex;
+            std::condition_variable TaskCondition;  // Signaled once a task was queued.
+            std::condition_variable RoomCondition;  // Signaled once a queued task was taken.
+            bool IsShutdown = false;
+
+            // Indexed by worker.
+            std::vector<WorkQueue> Queues;
+            size_t NextQueueIndex = 0;
+            uint64_t NumOfQueuedTasks = 0;
+            uint64_t MaxNumOfQueuedTasks = 0;
+
+            // Earliest due first.
+            std::priority_queue<DelayedTask, std::vector<DelayedTask>, std::greater<DelayedTask>>
+                DelayedTasks;
+        };
+
+        bool IsWorkerThread() const {
+            const std::thread::id threadId = std::this_thread::get_id();
+            return std::any_of(mWorkers.begin(), mWorkers.end(), [&](const std::thread& worker) {
+                return worker.get_id() == threadId;
+            });
+        }
+
+        static void RunWorker(std::shared_ptr<State> state, size_t workerIndex) {
+            SetThreadName(kWorkerThreadName);
+            TRACE_EVENT_METADATA1(TraceEventCategory::kMetadata, "thread_name", "name",
+                                  kWorkerThreadName);
+
+            while (true) {
+                // Take a queued task or exit once shutdown and no tasks remain.
+                Task task = {};
+                {
+                    std::unique_lock<std::mutex> lock(state->Mutex);
+                    QueueDueTasks(state.get(), workerIndex);
+                    while (!state->IsShutdown && state->NumOfQueuedTasks == 0) {
+                        if (state->DelayedTasks.empty()) {
+                            state->TaskCondition.wait(lock);
+                        } else {
+                            state->TaskCondition.wait_until(lock,
+                                                            state->DelayedTasks.top().DueTime);
+                        }
+                        QueueDueTasks(state.get(), workerIndex);
+                    }
+                    if (state->NumOfQueuedTasks == 0) {
+                        return;
+                    }
+                    PopTask(state.get(), workerIndex, &task);
+                }
+                state->RoomCondition.notify_one();
+
+                RunTask(task);
+            }
+        }
+
+        // Moves the delayed tasks that became due to the worker's own queue. Only called by
+        // workers, so the queue could exceed its bound. Must be called with |state->Mutex| held.
+        static void QueueDueTasks(State* state, size_t workerIndex) {
+            const Clock::time_point now = Clock::now();
+            uint64_t numOfDueTasks = 0;
+            while (!state->DelayedTasks.empty() && state->DelayedTasks.top().DueTime <= now) {
+                const DelayedTask& dueTask = state->DelayedTasks.top();
+                PushTask(state, workerIndex, dueTask.PostedTask, dueTask.Priority);
+                state->DelayedTasks.pop();
+                numOfDueTasks++;
+            }
+
+            if (numOfDueTasks > 1) {
+                state->TaskCondition.notify_all();
+            }
+        }
+
+        // Must be called with |state->Mutex| held.
+        static void PushTask(State* state,
+                             size_t queueIndex,
+                             const Task& task,
+                             TaskPriority priority) {
+            state->Queues[queueIndex][static_cast<size_t>(priority)].push_back(task);
+            state->NumOfQueuedTasks++;
+        }
+
+        // Pops the highest priority task, preferring the oldest task of the worker's own queue
+        // over stealing the newest task from another worker. At least one task must be queued.
+        // Must be called with |state->Mutex| held.
+        static void PopTask(State* state, size_t workerIndex, Task* task) {
+            ASSERT(state->NumOfQueuedTasks > 0);
+            const size_t numOfQueues = state->Queues.size();
+            for (size_t priority = 0; priority < kNumOfPriorities; priority++) {
+                for (size_t i = 0; i < numOfQueues; i++) {
+                    std::deque<Task>& tasks =
+                        state->Queues[(workerIndex + i) % numOfQueues][priority];
+                    if (tasks.empty()) {
+                        continue;
+                    }
+                    if (i == 0) {
+                        *task = std::move(tasks.front());
+                        tasks.pop_front();
+                    } else {
+                        *task = std::move(tasks.back());
+                        tasks.pop_back();
+                    }
+                    state->NumOfQueuedTasks--;
+                    return;
+                }
+            }
+            UNREACHABLE();
+        }
+
+        static void RunTask(const Task& task) {
+            TRACE_EVENT0(TraceEventCategory::kDefault, "WorkerThreadPool.RunTask");
+            (*task.Callback)();
+            task.SignalEvent->Signal();
+        }
+
+        static constexpr const char* kWorkerThreadName = "GPGMM_WorkerThread";
+
+        std::shared_ptr<State> mState;
+        std::vector<std::thread> mWorkers;
     };
 
     // Event
@@ -81,19 +346,51 @@ namespace gpgmm {
     // ThreadPool
 
     // static
-    std::shared_ptr<ThreadPool> ThreadPool::Create() {
+    std::shared_ptr<ThreadPool> ThreadPool::Create(uint32_t numOfWorkers) {
+        return std::shared_ptr<ThreadPool>(new WorkerThreadPoolImpl(numOfWorkers));
+    }
+
+    // static
+    std::shared_ptr<ThreadPool> ThreadPool::GetOrCreateShared() {
+        static std::mutex sharedPoolMutex;
+        static std::weak_ptr<ThreadPool> sharedPool;
+
+        std::lock_guard<std::mutex> lock(sharedPoolMutex);
+        std::shared_ptr<ThreadPool> pool = sharedPool.lock();
+        if (pool == nullptr) {
+            pool = Create(std::max(1u, std::min(kMaxNumOfSharedWorkers,
+                                                std::thread::hardware_concurrency())));
+            sharedPool = pool;
+        }
+        return pool;
+    }
+
+    // static
+    std::shared_ptr<ThreadPool> ThreadPool::CreateThreadPerTask() {
         return std::shared_ptr<ThreadPool>(new AsyncThreadPoolImpl());
     }
 
     // static
     std::shared_ptr<Event> ThreadPool::PostTask(std::shared_ptr<ThreadPool> pool,
                                                 std::shared_ptr<VoidCallback> callback,
-                                                const char* name) {
-        std::shared_ptr<Event> event = pool->postTaskImpl(callback, name);
+                                                const char* name,
+                                                TaskPriority priority) {
+        std::shared_ptr<Event> event = pool->postTaskImpl(callback, name, priority);
         if (event != nullptr) {
             event->SetThreadPool(pool);
         }
         return event;
     }
 
+    // static
+    std::shared_ptr<Event> ThreadPool::PostDelayedTask(std::shared_ptr<ThreadPool> pool,
+                                                       std::shared_ptr<VoidCallback> callback,
+                                                       const char* name,
+                                                       std::chrono::steady_clock::duration delay,
+                                                       TaskPriority priority) {
+        // Unlike PostTask, the event must not keep the pool alive since the pool holds on to it
+        // until the task is due.
+        return pool->postDelayedTaskImpl(callback, name, delay, priority);
+    }
+
 }  // namespace gpgmm
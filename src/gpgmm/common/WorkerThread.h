@@ -17,6 +17,8 @@
 
 #include "gpgmm/utils/NonCopyable.h"
 
+#include <chrono>
+#include <cstdint>
 #include <memory>
 
 namespace gpgmm {
@@ -31,6 +33,14 @@ namespace gpgmm {
 
     class ThreadPool;
 
+    // Order in which queued tasks get run by a ThreadPool, highest first. Low priority tasks
+    // must be optional since they get dropped once the pool is full.
+    enum class TaskPriority {
+        kHigh = 0,
+        kNormal = 1,
+        kLow = 2,
+    };
+
     /** \brief An event that we can wait on.
 
     Used for waiting for results or joining worker threads.
@@ -73,16 +83,47 @@ namespace gpgmm {
         ThreadPool() = default;
         virtual ~ThreadPool() = default;
 
-        static std::shared_ptr<ThreadPool> Create();
+        // Number of tasks that can be queued per worker before the pool is full. Posting to a
+        // full pool drops low priority tasks, without running them but still signaling their
+        // event, and blocks the poster of any other task until a worker makes room.
+        static constexpr uint64_t kMaxTasksPerWorker = 64;
+
+        // Creates a pool of |numOfWorkers| long-lived worker threads. Workers are joined once
+        // the pool is destroyed, after every queued task was run.
+        static std::shared_ptr<ThreadPool> Create(uint32_t numOfWorkers);
+
+        // Returns the pool shared by ALL allocators in the process. The pool is created on first
+        // use and destroyed once no longer referenced.
+        static std::shared_ptr<ThreadPool> GetOrCreateShared();
+
+        // Creates a pool that spawns a new thread for every task. Only used for comparison.
+        static std::shared_ptr<ThreadPool> CreateThreadPerTask();
 
         static std::shared_ptr<Event> PostTask(std::shared_ptr<ThreadPool> pool,
                                                std::shared_ptr<VoidCallback> callback,
-                                               const char* name);
+                                               const char* name,
+                                               TaskPriority priority = TaskPriority::kNormal);
+
+        // Same as PostTask but the callback only runs once |delay| has elapsed. Callbacks not yet
+        // due when the pool gets destroyed never run, but their events still get signaled.
+        static std::shared_ptr<Event> PostDelayedTask(
+            std::shared_ptr<ThreadPool> pool,
+            std::shared_ptr<VoidCallback> callback,
+            const char* name,
+            std::chrono::steady_clock::duration delay,
+            TaskPriority priority = TaskPriority::kNormal);
 
       private:
         // Return event to wait on until the callback runs.
         virtual std::shared_ptr<Event> postTaskImpl(std::shared_ptr<VoidCallback> callback,
-                                                    const char* name) = 0;
+                                                    const char* name,
+                                                    TaskPriority priority) = 0;
+
+        virtual std::shared_ptr<Event> postDelayedTaskImpl(
+            std::shared_ptr<VoidCallback> callback,
+            const char* name,
+            std::chrono::steady_clock::duration delay,
+            TaskPriority priority) = 0;
     };
 
 }  // namespace gpgmm
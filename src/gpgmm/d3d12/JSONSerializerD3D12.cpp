@@ -47,6 +47,14 @@ namespace gpgmm::d3d12 {
         dict.AddItem("MaxResourceHeapSize", desc.MaxResourceHeapSize);
         dict.AddItem("MemoryFragmentationLimit", desc.MemoryFragmentationLimit);
         dict.AddItem("MemoryGrowthFactor", desc.MemoryGrowthFactor);
+        dict.AddItem("SizeClassesPerDoubling", desc.SizeClassesPerDoubling);
+        dict.AddItem("MaxSizeClassWaste", desc.MaxSizeClassWaste);
+        dict.AddItem("ThreadCacheSize", desc.ThreadCacheSize);
+        dict.AddItem("IdleTrimInterval", desc.IdleTrimInterval);
+        dict.AddItem("MaxEmptySlabCount", desc.MaxEmptySlabCount);
+        dict.AddItem("MaxEmptySlabUsage", desc.MaxEmptySlabUsage);
+        dict.AddItem("MaxEmptySlabAge", desc.MaxEmptySlabAge);
+        dict.AddItem("SegmentFitLimit", desc.SegmentFitLimit);
         return dict;
     }
 
@@ -65,6 +73,7 @@ namespace gpgmm::d3d12 {
         JSONDict dict;
         dict.AddItem("Flags", desc.Flags);
         dict.AddItem("HeapType", desc.HeapType);
+        dict.AddItem("GroupKey", desc.GroupKey);
         return dict;
     }
 
@@ -284,7 +284,7 @@ namespace gpgmm::d3d12 {
           mFlushEventBuffersOnDestruct(descriptor.RecordOptions.EventScope &
                                        EVENT_RECORD_SCOPE_PER_INSTANCE),
           mResidencyFence(std::move(residencyFence)),
-          mThreadPool(ThreadPool::Create()) {
+          mThreadPool(ThreadPool::Create(/*numOfWorkers*/ 1)) {
         GPGMM_TRACE_EVENT_OBJECT_NEW(this);
 
         ASSERT(mDevice != nullptr);
@@ -134,6 +134,7 @@ namespace gpgmm::d3d12 {
         VideoMemorySegment mNonLocalVideoMemorySegment;
         RESIDENCY_STATS mStats = {};
 
+        // Dedicated to the long-lived budget update task, which never returns its worker.
         std::shared_ptr<ThreadPool> mThreadPool;
         std::shared_ptr<BudgetUpdateEvent> mBudgetNotificationUpdateEvent;
     };
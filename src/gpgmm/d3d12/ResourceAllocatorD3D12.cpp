@@ -17,11 +17,17 @@
 
 #include "gpgmm/common/BuddyMemoryAllocator.h"
 #include "gpgmm/common/DedicatedMemoryAllocator.h"
+#include "gpgmm/common/DeferredMemoryAllocator.h"
+#include "gpgmm/common/BudgetedMemoryAllocator.h"
 #include "gpgmm/common/Defaults.h"
 #include "gpgmm/common/EventMessage.h"
+#include "gpgmm/common/IdleMemoryTrimmer.h"
+#include "gpgmm/common/MagazineMemoryAllocator.h"
+#include "gpgmm/common/MemoryBudget.h"
 #include "gpgmm/common/PooledMemoryAllocator.h"
 #include "gpgmm/common/SegmentedMemoryAllocator.h"
 #include "gpgmm/common/SlabMemoryAllocator.h"
+#include "gpgmm/common/TLSFMemoryAllocator.h"
 #include "gpgmm/common/TraceEvent.h"
 #include "gpgmm/d3d12/BackendD3D12.h"
 #include "gpgmm/d3d12/BufferAllocatorD3D12.h"
@@ -466,6 +472,14 @@ namespace gpgmm::d3d12 {
                                                ? allocatorDescriptor.MemoryGrowthFactor
                                                : kDefaultMemoryGrowthFactor;
 
+        newDescriptor.SizeClassesPerDoubling =
+            (allocatorDescriptor.SizeClassesPerDoubling > 0)
+                ? static_cast<uint32_t>(PrevPowerOfTwo(allocatorDescriptor.SizeClassesPerDoubling))
+                : 0;
+        newDescriptor.MaxSizeClassWaste = (allocatorDescriptor.MaxSizeClassWaste > 0)
+                                              ? allocatorDescriptor.MaxSizeClassWaste
+                                              : 1;
+
         // By default, slab-allocate from a sorted segmented list.
         if (newDescriptor.PoolAlgorithm == ALLOCATOR_ALGORITHM_DEFAULT) {
             newDescriptor.PoolAlgorithm = ALLOCATOR_ALGORITHM_SEGMENTED_POOL;
@@ -575,6 +589,16 @@ namespace gpgmm::d3d12 {
         const bool isUMA =
             (IsResidencyEnabled()) ? residencyManager->IsUMA() : mCaps->IsAdapterUMA();
 
+        // Heaps created in the same memory segment share its budget, whose limits follow the
+        // residency budget. Exceeding it releases unused heaps instead of evicting used ones.
+        if (IsResidencyEnabled()) {
+            for (std::shared_ptr<MemoryBudget>& budget : mMemoryBudgetOfSegment) {
+                budget = std::make_shared<MemoryBudget>();
+                budget->AddOverBudgetCallback(
+                    [this](uint64_t bytesOverBudget) { ReleaseMemory(bytesOverBudget); });
+            }
+        }
+
         for (uint32_t resourceHeapTypeIndex = 0; resourceHeapTypeIndex < kNumOfResourceHeapTypes;
              resourceHeapTypeIndex++) {
             const RESOURCE_HEAP_TYPE& resourceHeapType =
@@ -656,6 +680,43 @@ namespace gpgmm::d3d12 {
             }
 #endif  // !defined(GPGMM_DISABLE_SIZE_CACHE)
         }
+
+        if (descriptor.IdleTrimInterval > 0) {
+            IdleMemoryTrimPolicy idleTrimPolicy = {};
+            idleTrimPolicy.IdleInterval =
+                std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                    std::chrono::duration<double>(descriptor.IdleTrimInterval));
+            mIdleMemoryTrimmer = std::make_unique<IdleMemoryTrimmer>(this, idleTrimPolicy);
+        }
+    }
+
+    std::unique_ptr<MemoryAllocator> ResourceAllocator::CreateBudgetedAllocator(
+        const D3D12_HEAP_PROPERTIES& heapProperties,
+        std::unique_ptr<MemoryAllocator> underlyingAllocator) {
+        if (!IsResidencyEnabled()) {
+            return underlyingAllocator;
+        }
+
+        ResidencyManager* residencyManager =
+            static_cast<ResidencyManager*>(mResidencyManager.Get());
+        const DXGI_MEMORY_SEGMENT_GROUP segment =
+            GetMemorySegmentGroup(heapProperties.MemoryPoolPreference, residencyManager->IsUMA());
+
+        return std::make_unique<BudgetedMemoryAllocator>(std::move(underlyingAllocator),
+                                                         mMemoryBudgetOfSegment[segment]);
+    }
+
+    std::unique_ptr<MemoryAllocator> ResourceAllocator::CreateDeferredAllocator(
+        bool isDeferred,
+        std::unique_ptr<MemoryAllocator> underlyingAllocator) {
+        if (!isDeferred) {
+            return underlyingAllocator;
+        }
+
+        std::unique_ptr<DeferredMemoryAllocator> deferredAllocator =
+            std::make_unique<DeferredMemoryAllocator>(std::move(underlyingAllocator));
+        mDeferredAllocators.push_back(deferredAllocator.get());
+        return deferredAllocator;
     }
 
     std::unique_ptr<MemoryAllocator> ResourceAllocator::CreatePoolAllocator(
@@ -663,6 +724,7 @@ namespace gpgmm::d3d12 {
         uint64_t memorySize,
         uint64_t memoryAlignment,
         bool isAlwaysOnDemand,
+        double segmentFitLimit,
         std::unique_ptr<MemoryAllocator> underlyingAllocator) {
         if (isAlwaysOnDemand) {
             return underlyingAllocator;
@@ -674,8 +736,8 @@ namespace gpgmm::d3d12 {
                                                                std::move(underlyingAllocator));
             }
             case ALLOCATOR_ALGORITHM_SEGMENTED_POOL: {
-                return std::make_unique<SegmentedMemoryAllocator>(std::move(underlyingAllocator),
-                                                                  memoryAlignment);
+                return std::make_unique<SegmentedMemoryAllocator>(
+                    std::move(underlyingAllocator), memoryAlignment, segmentFitLimit);
             }
             default: {
                 UNREACHABLE();
@@ -691,6 +753,10 @@ namespace gpgmm::d3d12 {
         double memoryFragmentationLimit,
         double memoryGrowthFactor,
         bool isPrefetchAllowed,
+        const SlabRetentionPolicy& retentionPolicy,
+        bool isAdaptiveSlabSizeAllowed,
+        const SlabSizeClassPolicy& sizeClassPolicy,
+        uint32_t threadCacheSize,
         std::unique_ptr<MemoryAllocator> underlyingAllocator) {
         const uint64_t maxResourceHeapSize = mCaps->GetMaxResourceHeapSize();
         switch (algorithm) {
@@ -705,19 +771,35 @@ namespace gpgmm::d3d12 {
             case ALLOCATOR_ALGORITHM_SLAB: {
                 // Min slab size is always equal to the memory size because the
                 // slab allocator aligns the slab size at allocate-time.
-                return std::make_unique<SlabCacheAllocator>(
-                    /*maxSlabSize*/ PrevPowerOfTwo(maxResourceHeapSize),
-                    /*minSlabSize*/ memorySize,
-                    /*slabAlignment*/ memoryAlignment,
-                    /*slabFragmentationLimit*/ memoryFragmentationLimit,
-                    /*allowSlabPrefetch*/ isPrefetchAllowed,
-                    /*slabGrowthFactor*/ memoryGrowthFactor,
-                    /*memoryAllocator*/ std::move(underlyingAllocator));
+                std::unique_ptr<SlabCacheAllocator> slabCacheAllocator =
+                    std::make_unique<SlabCacheAllocator>(
+                        /*maxSlabSize*/ PrevPowerOfTwo(maxResourceHeapSize),
+                        /*minSlabSize*/ memorySize,
+                        /*slabAlignment*/ memoryAlignment,
+                        /*slabFragmentationLimit*/ memoryFragmentationLimit,
+                        /*allowSlabPrefetch*/ isPrefetchAllowed,
+                        /*slabGrowthFactor*/ memoryGrowthFactor,
+                        /*memoryAllocator*/ std::move(underlyingAllocator),
+                        /*retentionPolicy*/ retentionPolicy,
+                        /*allowAdaptiveSlabSize*/ isAdaptiveSlabSizeAllowed,
+                        /*sizeClassPolicy*/ sizeClassPolicy);
+                if (threadCacheSize == 0) {
+                    return slabCacheAllocator;
+                }
+                return std::make_unique<MagazineMemoryAllocator>(
+                    /*magazineSize*/ threadCacheSize,
+                    /*slabCacheAllocator*/ std::move(slabCacheAllocator));
             }
             case ALLOCATOR_ALGORITHM_DEDICATED: {
                 return std::make_unique<DedicatedMemoryAllocator>(
                     /*memoryAllocator*/ std::move(underlyingAllocator));
             }
+            case ALLOCATOR_ALGORITHM_TLSF: {
+                return std::make_unique<TLSFMemoryAllocator>(
+                    /*memorySize*/ memorySize,
+                    /*memoryAlignment*/ memoryAlignment,
+                    /*memoryAllocator*/ std::move(underlyingAllocator));
+            }
             default: {
                 UNREACHABLE();
                 return {};
@@ -725,27 +807,53 @@ namespace gpgmm::d3d12 {
         }
     }
 
+    // static
+    SlabRetentionPolicy ResourceAllocator::GetRetentionPolicy(const ALLOCATOR_DESC& descriptor) {
+        SlabRetentionPolicy retentionPolicy = {};
+        retentionPolicy.MaxEmptySlabCount = descriptor.MaxEmptySlabCount;
+        retentionPolicy.MaxEmptySlabUsage =
+            (descriptor.MaxEmptySlabUsage > 0) ? descriptor.MaxEmptySlabUsage : kInvalidSize;
+        retentionPolicy.MaxEmptySlabAge =
+            (descriptor.MaxEmptySlabAge > 0) ? descriptor.MaxEmptySlabAge : kInvalidSize;
+        return retentionPolicy;
+    }
+
+    // static
+    SlabSizeClassPolicy ResourceAllocator::GetSizeClassPolicy(const ALLOCATOR_DESC& descriptor) {
+        SlabSizeClassPolicy sizeClassPolicy = {};
+        sizeClassPolicy.SizeClassesPerDoubling = descriptor.SizeClassesPerDoubling;
+        sizeClassPolicy.MaxWasteRatio = descriptor.MaxSizeClassWaste;
+        return sizeClassPolicy;
+    }
+
     std::unique_ptr<MemoryAllocator> ResourceAllocator::CreateResourceAllocator(
         const ALLOCATOR_DESC& descriptor,
         D3D12_HEAP_FLAGS heapFlags,
         const D3D12_HEAP_PROPERTIES& heapProperties,
         uint64_t heapAlignment) {
-        std::unique_ptr<MemoryAllocator> resourceHeapAllocator =
-            std::make_unique<ResourceHeapAllocator>(mResidencyManager.Get(), mDevice.Get(),
-                                                    heapProperties, heapFlags);
+        std::unique_ptr<MemoryAllocator> resourceHeapAllocator = CreateBudgetedAllocator(
+            heapProperties, std::make_unique<ResourceHeapAllocator>(
+                                mResidencyManager.Get(), mDevice.Get(), heapProperties, heapFlags));
 
         const uint64_t heapSize =
             std::max(heapAlignment, AlignTo(descriptor.PreferredResourceHeapSize, heapAlignment));
 
         std::unique_ptr<MemoryAllocator> pooledOrNonPooledAllocator = CreatePoolAllocator(
             descriptor.PoolAlgorithm, heapSize, heapAlignment,
-            (descriptor.Flags & ALLOCATOR_FLAG_ALWAYS_ON_DEMAND), std::move(resourceHeapAllocator));
+            (descriptor.Flags & ALLOCATOR_FLAG_ALWAYS_ON_DEMAND), descriptor.SegmentFitLimit,
+            std::move(resourceHeapAllocator));
 
-        return CreateSubAllocator(
+        std::unique_ptr<MemoryAllocator> subAllocator = CreateSubAllocator(
             descriptor.SubAllocationAlgorithm, heapSize, heapAlignment,
             descriptor.MemoryFragmentationLimit, descriptor.MemoryGrowthFactor,
             /*allowSlabPrefetch*/ !(descriptor.Flags & ALLOCATOR_FLAG_DISABLE_MEMORY_PREFETCH),
+            GetRetentionPolicy(descriptor),
+            /*allowAdaptiveSlabSize*/ (descriptor.Flags & ALLOCATOR_FLAG_ADAPTIVE_HEAP_SIZE),
+            GetSizeClassPolicy(descriptor), descriptor.ThreadCacheSize,
             std::move(pooledOrNonPooledAllocator));
+
+        return CreateDeferredAllocator((descriptor.Flags & ALLOCATOR_FLAG_DEFER_DEALLOCATE),
+                                       std::move(subAllocator));
     }
 
     std::unique_ptr<MemoryAllocator> ResourceAllocator::CreateSmallBufferAllocator(
@@ -754,29 +862,47 @@ namespace gpgmm::d3d12 {
         const D3D12_HEAP_PROPERTIES& heapProperties,
         uint64_t heapAlignment,
         D3D12_RESOURCE_STATES initialResourceState) {
-        std::unique_ptr<MemoryAllocator> smallBufferOnlyAllocator =
+        std::unique_ptr<MemoryAllocator> smallBufferOnlyAllocator = CreateBudgetedAllocator(
+            heapProperties,
             std::make_unique<BufferAllocator>(this, heapProperties, heapFlags,
-                                              D3D12_RESOURCE_FLAG_NONE, initialResourceState);
+                                              D3D12_RESOURCE_FLAG_NONE, initialResourceState));
 
         std::unique_ptr<MemoryAllocator> pooledOrNonPooledAllocator =
             CreatePoolAllocator(descriptor.PoolAlgorithm, heapAlignment, heapAlignment,
                                 (descriptor.Flags & ALLOCATOR_FLAG_ALWAYS_ON_DEMAND),
-                                std::move(smallBufferOnlyAllocator));
+                                descriptor.SegmentFitLimit, std::move(smallBufferOnlyAllocator));
 
         const uint64_t heapSize =
             std::max(heapAlignment, AlignTo(descriptor.PreferredResourceHeapSize, heapAlignment));
 
         // Any amount of fragmentation must be allowed for small buffers since the allocation can
         // be smaller then the resource heap alignment.
-        return CreateSubAllocator(descriptor.SubAllocationAlgorithm, heapSize, heapAlignment,
-                                  /*memoryFragmentationLimit*/ 1, descriptor.MemoryGrowthFactor,
-                                  /*allowSlabPrefetch*/ false,
-                                  std::move(pooledOrNonPooledAllocator));
+        std::unique_ptr<MemoryAllocator> subAllocator =
+            CreateSubAllocator(descriptor.SubAllocationAlgorithm, heapSize, heapAlignment,
+                               /*memoryFragmentationLimit*/ 1, descriptor.MemoryGrowthFactor,
+                               /*allowSlabPrefetch*/ false, GetRetentionPolicy(descriptor),
+                               /*allowAdaptiveSlabSize*/
+                               (descriptor.Flags & ALLOCATOR_FLAG_ADAPTIVE_HEAP_SIZE),
+                               GetSizeClassPolicy(descriptor), descriptor.ThreadCacheSize,
+                               std::move(pooledOrNonPooledAllocator));
+
+        return CreateDeferredAllocator((descriptor.Flags & ALLOCATOR_FLAG_DEFER_DEALLOCATE),
+                                       std::move(subAllocator));
     }
 
     ResourceAllocator::~ResourceAllocator() {
         GPGMM_TRACE_EVENT_OBJECT_DESTROY(this);
 
+        // Over-budget callbacks release memory from the allocators being destroyed.
+        for (const std::shared_ptr<MemoryBudget>& budget : mMemoryBudgetOfSegment) {
+            if (budget != nullptr) {
+                budget->WaitForOverBudgetCallbacks();
+            }
+        }
+
+        // Stop trimming before the allocators being trimmed get destroyed.
+        mIdleMemoryTrimmer = nullptr;
+
         // Give the debug allocator the first chance to report leaks.
         if (mDebugAllocator) {
             mDebugAllocator->ReportLiveAllocations();
@@ -806,6 +932,34 @@ namespace gpgmm::d3d12 {
         return "ResourceAllocator";
     }
 
+    MemoryBudget* ResourceAllocator::UpdateMemoryBudget(
+        const DXGI_MEMORY_SEGMENT_GROUP& memorySegmentGroup) {
+        ResidencyManager* residencyManager =
+            static_cast<ResidencyManager*>(mResidencyManager.Get());
+        MemoryBudget* budget = mMemoryBudgetOfSegment[memorySegmentGroup].get();
+        ASSERT(budget != nullptr);
+
+        // A zero budget means the OS budget was not yet received, so leave it unlimited.
+        const DXGI_QUERY_VIDEO_MEMORY_INFO* videoMemoryInfo =
+            residencyManager->GetVideoMemoryInfo(memorySegmentGroup);
+        if (videoMemoryInfo->Budget == 0) {
+            return budget;
+        }
+
+        // The OS usage also counts heaps created by this allocator, which the budget already
+        // tracks as they get created or released. Only usage from elsewhere reduces its share.
+        const uint64_t usage = budget->GetUsage();
+        const uint64_t otherUsage =
+            (videoMemoryInfo->CurrentUsage > usage) ? videoMemoryInfo->CurrentUsage - usage : 0;
+        const uint64_t softLimit =
+            (videoMemoryInfo->Budget > otherUsage) ? videoMemoryInfo->Budget - otherUsage : 0;
+
+        // Heaps may still be created over budget and get evicted by residency, so only the soft
+        // limit is set.
+        budget->SetLimits(budget->GetHardLimit(), softLimit);
+        return budget;
+    }
+
     uint64_t ResourceAllocator::ReleaseMemory(uint64_t bytesToRelease) {
         std::lock_guard<std::mutex> lock(mMutex);
         uint64_t bytesReleased = 0;
@@ -815,34 +969,36 @@ namespace gpgmm::d3d12 {
             // heaps will more likely exceed the amount of bytes needed then smaller ones. But if
             // this causes over-trimming, then smaller heaps would be better.
             // TODO: Consider adding controls to change policy.
-            bytesReleased +=
-                mSmallBufferAllocatorOfType[resourceHeapTypeIndex]->ReleaseMemory(bytesToRelease);
+            // Only the remainder is requested from each allocator so the total released stays
+            // within |bytesToRelease|.
+            bytesReleased += mSmallBufferAllocatorOfType[resourceHeapTypeIndex]->ReleaseMemory(
+                bytesToRelease - bytesReleased);
             if (bytesReleased >= bytesToRelease) {
                 break;
             }
 
             bytesReleased +=
                 mDedicatedResourceAllocatorOfType[resourceHeapTypeIndex]->ReleaseMemory(
-                    bytesToRelease);
+                    bytesToRelease - bytesReleased);
             if (bytesReleased >= bytesToRelease) {
                 break;
             }
 
-            bytesReleased +=
-                mResourceAllocatorOfType[resourceHeapTypeIndex]->ReleaseMemory(bytesToRelease);
+            bytesReleased += mResourceAllocatorOfType[resourceHeapTypeIndex]->ReleaseMemory(
+                bytesToRelease - bytesReleased);
             if (bytesReleased >= bytesToRelease) {
                 break;
             }
 
             bytesReleased +=
                 mMSAADedicatedResourceAllocatorOfType[resourceHeapTypeIndex]->ReleaseMemory(
-                    bytesToRelease);
+                    bytesToRelease - bytesReleased);
             if (bytesReleased >= bytesToRelease) {
                 break;
             }
 
-            bytesReleased +=
-                mMSAAResourceAllocatorOfType[resourceHeapTypeIndex]->ReleaseMemory(bytesToRelease);
+            bytesReleased += mMSAAResourceAllocatorOfType[resourceHeapTypeIndex]->ReleaseMemory(
+                bytesToRelease - bytesReleased);
             if (bytesReleased >= bytesToRelease) {
                 break;
             }
@@ -856,6 +1012,15 @@ namespace gpgmm::d3d12 {
         return bytesReleased;
     }
 
+    uint64_t ResourceAllocator::FlushDeferredFrees() {
+        std::lock_guard<std::mutex> lock(mMutex);
+        uint64_t count = 0;
+        for (DeferredMemoryAllocator* allocator : mDeferredAllocators) {
+            count += allocator->FlushDeferredFrees();
+        }
+        return count;
+    }
+
     HRESULT ResourceAllocator::CreateResource(const ALLOCATION_DESC& allocationDescriptor,
                                               const D3D12_RESOURCE_DESC& resourceDescriptor,
                                               D3D12_RESOURCE_STATES initialResourceState,
@@ -866,6 +1031,10 @@ namespace gpgmm::d3d12 {
             (CREATE_RESOURCE_DESC{allocationDescriptor, resourceDescriptor, initialResourceState,
                                   pClearValue}));
 
+        if (mIdleMemoryTrimmer != nullptr) {
+            mIdleMemoryTrimmer->RecordActivity();
+        }
+
         std::lock_guard<std::mutex> lock(mMutex);
         ComPtr<IResourceAllocation> allocation;
         ReturnIfFailed(CreateResourceInternal(allocationDescriptor, resourceDescriptor,
@@ -994,6 +1163,7 @@ namespace gpgmm::d3d12 {
             (allocationDescriptor.Flags & ALLOCATION_FLAG_ALWAYS_PREFETCH_MEMORY);
         request.AlwaysCacheSize = (allocationDescriptor.Flags & ALLOCATION_FLAG_ALWAYS_CACHE_SIZE);
         request.AvailableForAllocation = mCaps->GetMaxResourceHeapSize();
+        request.GroupKey = allocationDescriptor.GroupKey;
 
         // Apply extra padding to the resource heap size, if specified.
         // Padding can only be applied to standalone non-committed resources.
@@ -1021,25 +1191,23 @@ namespace gpgmm::d3d12 {
             heapProperties.MemoryPoolPreference =
                 GetMemoryPool(heapProperties, residencyManager->IsUMA());
 
-            const DXGI_MEMORY_SEGMENT_GROUP segment = GetMemorySegmentGroup(
-                heapProperties.MemoryPoolPreference, residencyManager->IsUMA());
-
-            DXGI_QUERY_VIDEO_MEMORY_INFO* currentVideoInfo =
-                residencyManager->GetVideoMemoryInfo(segment);
+            const MemoryBudget* budget = UpdateMemoryBudget(GetMemorySegmentGroup(
+                heapProperties.MemoryPoolPreference, residencyManager->IsUMA()));
 
             // If over-budget, only free memory is considered available.
             // TODO: Consider optimizing GetInfoInternal().
-            if (currentVideoInfo->CurrentUsage > currentVideoInfo->Budget) {
+            const uint64_t usage = budget->GetUsage();
+            const uint64_t softLimit = budget->GetSoftLimit();
+            if (usage > softLimit) {
                 request.AvailableForAllocation = GetInfoInternal().FreeMemoryUsage;
 
-                DebugEvent(GetTypename())
-                    << "Current usage exceeded budget ("
-                    << std::to_string(currentVideoInfo->CurrentUsage) << " vs "
-                    << std::to_string(currentVideoInfo->Budget) + " bytes).";
+                DebugEvent(GetTypename()) << "Current usage exceeded budget ("
+                                          << std::to_string(usage) << " vs "
+                                          << std::to_string(softLimit) + " bytes).";
 
             } else {
                 request.AvailableForAllocation =
-                    currentVideoInfo->Budget - currentVideoInfo->CurrentUsage;
+                    std::min(request.AvailableForAllocation, softLimit - usage);
             }
         }
 
@@ -1369,6 +1537,31 @@ namespace gpgmm::d3d12 {
         return GetInfoInternal();
     }
 
+    uint64_t ResourceAllocator::GetSizeClassStats(MemorySizeClassStats* pSizeClassStats,
+                                                  uint64_t count) const {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        uint64_t sizeClassCount = 0;
+        auto addSizeClassStats = [&](const MemoryAllocator* allocator) {
+            const uint64_t writtenCount = std::min(sizeClassCount, count);
+            sizeClassCount += allocator->GetSizeClassStats(pSizeClassStats + writtenCount,
+                                                           count - writtenCount);
+        };
+
+        for (uint32_t resourceHeapTypeIndex = 0; resourceHeapTypeIndex < kNumOfResourceHeapTypes;
+             resourceHeapTypeIndex++) {
+            addSizeClassStats(mSmallBufferAllocatorOfType[resourceHeapTypeIndex].get());
+
+            addSizeClassStats(mMSAADedicatedResourceAllocatorOfType[resourceHeapTypeIndex].get());
+            addSizeClassStats(mMSAAResourceAllocatorOfType[resourceHeapTypeIndex].get());
+
+            addSizeClassStats(mResourceAllocatorOfType[resourceHeapTypeIndex].get());
+            addSizeClassStats(mDedicatedResourceAllocatorOfType[resourceHeapTypeIndex].get());
+        }
+
+        return sizeClassCount;
+    }
+
     RESOURCE_ALLOCATOR_STATS ResourceAllocator::GetInfoInternal() const {
         TRACE_EVENT0(TraceEventCategory::kDefault, "ResourceAllocator.GetInfo");
 
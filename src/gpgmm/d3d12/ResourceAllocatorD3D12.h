@@ -24,6 +24,15 @@
 #include <array>
 #include <memory>
 #include <string>
+#include <vector>
+
+namespace gpgmm {
+    class DeferredMemoryAllocator;
+    class IdleMemoryTrimmer;
+    class MemoryBudget;
+    struct SlabRetentionPolicy;
+    struct SlabSizeClassPolicy;
+}  // namespace gpgmm
 
 namespace gpgmm::d3d12 {
 
@@ -57,7 +66,10 @@ namespace gpgmm::d3d12 {
         HRESULT CreateResource(ComPtr<ID3D12Resource> committedResource,
                                IResourceAllocation** ppResourceAllocationOut) override;
         uint64_t ReleaseMemory(uint64_t bytesToRelease) override;
+        uint64_t FlushDeferredFrees() override;
         RESOURCE_ALLOCATOR_STATS GetStats() const override;
+        uint64_t GetSizeClassStats(MemorySizeClassStats* pSizeClassStats,
+                                   uint64_t count) const override;
         HRESULT CheckFeatureSupport(ALLOCATOR_FEATURE feature,
                                     void* pFeatureSupportData,
                                     uint32_t featureSupportDataSize) const override;
@@ -93,11 +105,20 @@ namespace gpgmm::d3d12 {
             uint64_t heapAlignment,
             D3D12_RESOURCE_STATES initialResourceState);
 
+        std::unique_ptr<MemoryAllocator> CreateBudgetedAllocator(
+            const D3D12_HEAP_PROPERTIES& heapProperties,
+            std::unique_ptr<MemoryAllocator> underlyingAllocator);
+
+        std::unique_ptr<MemoryAllocator> CreateDeferredAllocator(
+            bool isDeferred,
+            std::unique_ptr<MemoryAllocator> underlyingAllocator);
+
         std::unique_ptr<MemoryAllocator> CreatePoolAllocator(
             ALLOCATOR_ALGORITHM algorithm,
             uint64_t memorySize,
             uint64_t memoryAlignment,
             bool isAlwaysOnDemand,
+            double segmentFitLimit,
             std::unique_ptr<MemoryAllocator> underlyingAllocator);
 
         std::unique_ptr<MemoryAllocator> CreateSubAllocator(
@@ -107,8 +128,15 @@ namespace gpgmm::d3d12 {
             double memoryFragmentationLimit,
             double memoryGrowthFactor,
             bool isPrefetchAllowed,
+            const SlabRetentionPolicy& retentionPolicy,
+            bool isAdaptiveSlabSizeAllowed,
+            const SlabSizeClassPolicy& sizeClassPolicy,
+            uint32_t threadCacheSize,
             std::unique_ptr<MemoryAllocator> underlyingAllocator);
 
+        static SlabRetentionPolicy GetRetentionPolicy(const ALLOCATOR_DESC& descriptor);
+        static SlabSizeClassPolicy GetSizeClassPolicy(const ALLOCATOR_DESC& descriptor);
+
         HRESULT CreatePlacedResource(IHeap* const resourceHeap,
                                      uint64_t resourceOffset,
                                      const D3D12_RESOURCE_DESC* resourceDescriptor,
@@ -135,6 +163,8 @@ namespace gpgmm::d3d12 {
 
         RESOURCE_ALLOCATOR_STATS GetInfoInternal() const;
 
+        MemoryBudget* UpdateMemoryBudget(const DXGI_MEMORY_SEGMENT_GROUP& memorySegmentGroup);
+
         ComPtr<ID3D12Device> mDevice;
         ComPtr<IResidencyManager> mResidencyManager;
 
@@ -149,6 +179,11 @@ namespace gpgmm::d3d12 {
 
         static constexpr uint64_t kNumOfResourceHeapTypes = 12u;
 
+        // Shared by every allocator creating heaps in the same memory segment, indexed by
+        // DXGI_MEMORY_SEGMENT_GROUP. Only created when residency is enabled. Must outlive the
+        // allocators below since they release from it.
+        std::array<std::shared_ptr<MemoryBudget>, 2> mMemoryBudgetOfSegment;
+
         std::array<std::unique_ptr<MemoryAllocator>, kNumOfResourceHeapTypes>
             mDedicatedResourceAllocatorOfType;
         std::array<std::unique_ptr<MemoryAllocator>, kNumOfResourceHeapTypes>
@@ -162,7 +197,12 @@ namespace gpgmm::d3d12 {
         std::array<std::unique_ptr<MemoryAllocator>, kNumOfResourceHeapTypes>
             mSmallBufferAllocatorOfType;
 
+        // Top of the allocators above when ALLOCATOR_FLAG_DEFER_DEALLOCATE is used.
+        std::vector<DeferredMemoryAllocator*> mDeferredAllocators;
+
         std::unique_ptr<DebugResourceAllocator> mDebugAllocator;
+
+        std::unique_ptr<IdleMemoryTrimmer> mIdleMemoryTrimmer;
     };
 
 }  // namespace gpgmm::d3d12
@@ -40,6 +40,28 @@ namespace gpgmm {
 #endif
     }
 
+    uint32_t ScanForward(uint64_t bits) {
+        ASSERT(bits != 0);
+#if defined(GPGMM_COMPILER_MSVC)
+#    if defined(GPGMM_PLATFORM_64_BIT)
+        unsigned long firstBitIndex = 0ul;
+        unsigned char ret = _BitScanForward64(&firstBitIndex, bits);
+        ASSERT(ret != 0);
+        return firstBitIndex;
+#    else   // defined(GPGMM_PLATFORM_64_BIT)
+        unsigned long firstBitIndex = 0ul;
+        if (_BitScanForward(&firstBitIndex, bits & 0xFFFFFFFF)) {
+            return firstBitIndex;
+        }
+        unsigned char ret = _BitScanForward(&firstBitIndex, bits >> 32);
+        ASSERT(ret != 0);
+        return firstBitIndex + 32;
+#    endif  // defined(GPGMM_PLATFORM_64_BIT)
+#else       // defined(GPGMM_COMPILER_MSVC)
+        return static_cast<uint32_t>(__builtin_ctzll(bits));
+#endif      // defined(GPGMM_COMPILER_MSVC)
+    }
+
     uint32_t Log2(uint32_t number) {
         ASSERT(number != 0);
 #if defined(GPGMM_COMPILER_MSVC)
@@ -27,6 +27,7 @@ namespace gpgmm {
 
     // The following are not valid for 0
     uint32_t ScanForward(uint32_t bits);
+    uint32_t ScanForward(uint64_t bits);
     uint32_t Log2(uint32_t number);
     uint32_t Log2(uint64_t number);
     uint64_t PrevPowerOfTwo(uint64_t number);
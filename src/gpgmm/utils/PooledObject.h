@@ -0,0 +1,256 @@
+// Copyright 2022 The GPGMM Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef GPGMM_UTILS_POOLEDOBJECT_H_
+#define GPGMM_UTILS_POOLEDOBJECT_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+namespace gpgmm {
+
+    /** \brief PooledObject re-uses the storage of deleted objects of type T.
+
+    Deriving from PooledObject<T> overrides new and delete of T so storage of deleted objects is
+    cached in an intrusive free-list, per-thread, and returned by the next new on the same thread.
+    Once warm, creating and destroying objects on the same thread never calls the general-purpose
+    heap nor takes any lock.
+
+    Storage always returns to the thread that created it. Objects deleted by another thread are
+    pushed onto a lock-free list of the owning thread, which takes them back once its own
+    free-list runs out. Otherwise, a thread that only deletes objects would cache storage it never
+    re-uses while the creating thread keeps calling the heap. Storage still in use once the owning
+    thread exits is returned to the heap when deleted.
+
+    Only storage of exactly sizeof(T) is cached, preceded by a pointer-sized header to find the
+    owning thread. Larger, derived types always use the heap.
+
+    \code
+    class MyObject : public PooledObject<MyObject> { ... };
+
+    std::unique_ptr<MyObject> obj = std::make_unique<MyObject>(); // Re-uses storage.
+    \endcode
+    */
+    template <typename T, uint64_t MaxCachedObjectsPerThread = 1024>
+    class PooledObject {
+      public:
+        static void* operator new(size_t size) {
+            static_assert(sizeof(T) >= sizeof(FreeNode), "Object too small to be pooled.");
+            if (size != sizeof(T)) {
+                return ::operator new(size);
+            }
+
+            FreeList* freeList = GetFreeList();
+            if (freeList == nullptr) {
+                return CreateStorage(nullptr);
+            }
+
+            if (freeList->pHead == nullptr) {
+                ReclaimRemoteStorage(freeList);
+            }
+
+            if (freeList->pHead != nullptr) {
+                FreeNode* node = freeList->pHead;
+                freeList->pHead = node->pNext;
+                freeList->Count--;
+                return node;
+            }
+
+            return CreateStorage(freeList->Owner);
+        }
+
+        static void operator delete(void* ptr, size_t size) {
+            if (ptr == nullptr) {
+                return;
+            }
+
+            if (size != sizeof(T)) {
+                ::operator delete(ptr);
+                return;
+            }
+
+            StorageOwner* owner = GetStorageHeader(ptr)->Owner;
+            if (owner == nullptr) {
+                DestroyStorage(ptr);
+                return;
+            }
+
+            FreeList* freeList = GetFreeList();
+            if (freeList != nullptr && freeList->Owner == owner) {
+                if (freeList->Count < MaxCachedObjectsPerThread) {
+                    FreeNode* node = static_cast<FreeNode*>(ptr);
+                    node->pNext = freeList->pHead;
+                    freeList->pHead = node;
+                    freeList->Count++;
+                } else {
+                    DestroyStorage(ptr);
+                }
+                return;
+            }
+
+            PushRemoteStorage(owner, static_cast<FreeNode*>(ptr));
+        }
+
+      protected:
+        PooledObject() = default;
+        ~PooledObject() = default;
+
+      private:
+        // Overlays the storage of a deleted object.
+        struct FreeNode {
+            FreeNode* pNext;
+        };
+
+        // Shared between the thread that created the storage and the threads deleting objects in
+        // it. Referenced by the owning thread and by every storage it created, so it outlives
+        // the owning thread until all of that storage was returned to the heap.
+        struct StorageOwner {
+            std::atomic<FreeNode*> pRemoteHead{nullptr};  // Deleted by other threads.
+            std::atomic<uint64_t> RefCount{1};
+            std::atomic<bool> IsThreadExited{false};
+        };
+
+        // Precedes the storage of every object of exactly sizeof(T).
+        struct StorageHeader {
+            StorageOwner* Owner;
+        };
+
+        struct FreeList {
+            FreeList() : Owner(new StorageOwner()) {
+            }
+
+            ~FreeList() {
+                while (pHead != nullptr) {
+                    FreeNode* next = pHead->pNext;
+                    DestroyStorage(pHead);
+                    pHead = next;
+                }
+
+                // Objects deleted by other threads from now on are returned to the heap by
+                // whichever thread observes the exit, see PushRemoteStorage.
+                Owner->IsThreadExited.store(true);
+                DestroyRemoteStorage(Owner);
+                ReleaseStorageOwner(Owner);
+
+                IsDestroyed() = true;
+            }
+
+            FreeNode* pHead = nullptr;
+            uint64_t Count = 0;
+            StorageOwner* const Owner;
+        };
+
+        static constexpr size_t GetStorageHeaderSize() {
+            static_assert(alignof(T) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__,
+                          "Object too aligned to be pooled.");
+            return (sizeof(StorageHeader) + alignof(T) - 1) / alignof(T) * alignof(T);
+        }
+
+        static StorageHeader* GetStorageHeader(void* ptr) {
+            return reinterpret_cast<StorageHeader*>(static_cast<char*>(ptr) -
+                                                    GetStorageHeaderSize());
+        }
+
+        static void* CreateStorage(StorageOwner* owner) {
+            char* storage =
+                static_cast<char*>(::operator new(GetStorageHeaderSize() + sizeof(T)));
+            new (storage) StorageHeader{owner};
+            if (owner != nullptr) {
+                owner->RefCount.fetch_add(1, std::memory_order_relaxed);
+            }
+            return storage + GetStorageHeaderSize();
+        }
+
+        static void DestroyStorage(void* ptr) {
+            StorageHeader* header = GetStorageHeader(ptr);
+            StorageOwner* owner = header->Owner;
+            ::operator delete(header);
+            if (owner != nullptr) {
+                ReleaseStorageOwner(owner);
+            }
+        }
+
+        static void ReleaseStorageOwner(StorageOwner* owner) {
+            if (owner->RefCount.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                delete owner;
+            }
+        }
+
+        static void PushRemoteStorage(StorageOwner* owner, FreeNode* node) {
+            // Keep |owner| alive since the owning thread could re-use and free |node| once pushed.
+            owner->RefCount.fetch_add(1, std::memory_order_relaxed);
+
+            node->pNext = owner->pRemoteHead.load(std::memory_order_relaxed);
+            while (!owner->pRemoteHead.compare_exchange_weak(node->pNext, node)) {
+            }
+
+            // Either the exiting thread sees |node| or |node| sees the thread exited.
+            if (owner->IsThreadExited.load()) {
+                DestroyRemoteStorage(owner);
+            }
+
+            ReleaseStorageOwner(owner);
+        }
+
+        // Moves storage deleted by other threads to the thread's free-list, up to the max.
+        static void ReclaimRemoteStorage(FreeList* freeList) {
+            StorageOwner* owner = freeList->Owner;
+            if (owner->pRemoteHead.load(std::memory_order_relaxed) == nullptr) {
+                return;
+            }
+
+            FreeNode* node = owner->pRemoteHead.exchange(nullptr);
+            while (node != nullptr) {
+                FreeNode* next = node->pNext;
+                if (freeList->Count < MaxCachedObjectsPerThread) {
+                    node->pNext = freeList->pHead;
+                    freeList->pHead = node;
+                    freeList->Count++;
+                } else {
+                    DestroyStorage(node);
+                }
+                node = next;
+            }
+        }
+
+        static void DestroyRemoteStorage(StorageOwner* owner) {
+            FreeNode* node = owner->pRemoteHead.exchange(nullptr);
+            while (node != nullptr) {
+                FreeNode* next = node->pNext;
+                DestroyStorage(node);
+                node = next;
+            }
+        }
+
+        // Objects could be deleted after the thread's free-list was destroyed (ie. by another
+        // thread_local destructor), which then use the heap.
+        static bool& IsDestroyed() {
+            static thread_local bool isDestroyed = false;
+            return isDestroyed;
+        }
+
+        static FreeList* GetFreeList() {
+            if (IsDestroyed()) {
+                return nullptr;
+            }
+            static thread_local FreeList freeList;
+            return &freeList;
+        }
+    };
+
+}  // namespace gpgmm
+
+#endif  // GPGMM_UTILS_POOLEDOBJECT_H_
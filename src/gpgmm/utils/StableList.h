@@ -399,11 +399,16 @@ namespace gpgmm {
         }
 
         iterator begin() {
-            return {this, 0};
+            iterator it = {this, 0};
+            // Skip over the first item if erased.
+            if (!empty() && !mChunks.front()->mOccupied[0]) {
+                ++it;
+            }
+            return it;
         }
 
         const_iterator begin() const {
-            return {this, 0};
+            return const_cast<StableList<T, ChunkSize>*>(this)->begin();
         }
 
         const_iterator cbegin() const {
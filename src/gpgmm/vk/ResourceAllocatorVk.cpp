@@ -15,12 +15,17 @@
 #include "gpgmm/vk/ResourceAllocatorVk.h"
 
 #include "gpgmm/common/BuddyMemoryAllocator.h"
+#include "gpgmm/common/BudgetedMemoryAllocator.h"
 #include "gpgmm/common/Defaults.h"
+#include "gpgmm/common/DeferredMemoryAllocator.h"
 #include "gpgmm/common/EventMessage.h"
+#include "gpgmm/common/MagazineMemoryAllocator.h"
+#include "gpgmm/common/MemoryBudget.h"
 #include "gpgmm/common/PooledMemoryAllocator.h"
 #include "gpgmm/common/SegmentedMemoryAllocator.h"
 #include "gpgmm/common/SizeClass.h"
 #include "gpgmm/common/SlabMemoryAllocator.h"
+#include "gpgmm/common/TLSFMemoryAllocator.h"
 #include "gpgmm/vk/BackendVk.h"
 #include "gpgmm/vk/CapsVk.h"
 #include "gpgmm/vk/DeviceMemoryAllocatorVk.h"
@@ -41,6 +46,13 @@ namespace gpgmm::vk {
         SafeDelete(allocator);
     }
 
+    uint64_t gpFlushDeferredFrees(GpResourceAllocator allocator) {
+        if (allocator == VK_NULL_HANDLE) {
+            return 0;
+        }
+        return allocator->FlushDeferredFrees();
+    }
+
     VkResult gpCreateBuffer(GpResourceAllocator allocator,
                             const VkBufferCreateInfo* pBufferCreateInfo,
                             VkBuffer* bufferOut,
@@ -230,6 +242,12 @@ namespace gpgmm::vk {
                                                ? newInfo.memoryFragmentationLimit
                                                : kDefaultFragmentationLimit;
 
+        newInfo.sizeClassesPerDoubling =
+            (newInfo.sizeClassesPerDoubling > 0)
+                ? static_cast<uint32_t>(PrevPowerOfTwo(newInfo.sizeClassesPerDoubling))
+                : 0;
+        newInfo.maxSizeClassWaste = (newInfo.maxSizeClassWaste > 0) ? newInfo.maxSizeClassWaste : 1;
+
         // By default, slab-allocate from a sorted segmented list.
         if (newInfo.poolAlgorithm == GP_ALLOCATOR_ALGORITHM_DEFAULT) {
             newInfo.poolAlgorithm = GP_ALLOCATOR_ALGORITHM_SEGMENTED_POOL;
@@ -256,17 +274,23 @@ namespace gpgmm::vk {
             mMemoryTypes.assign(memoryProperties.memoryTypes,
                                 memoryProperties.memoryTypes + memoryProperties.memoryTypeCount);
 
-            std::vector<VkMemoryHeap> memoryHeaps;
-            memoryHeaps.assign(memoryProperties.memoryHeaps,
-                               memoryProperties.memoryHeaps + memoryProperties.memoryHeapCount);
+            // Memory types of the same heap share its budget. Without a residency budget to
+            // follow, only the heap size limits how much device memory can be created.
+            for (uint32_t heapIndex = 0; heapIndex < memoryProperties.memoryHeapCount;
+                 heapIndex++) {
+                mMemoryBudgetsPerHeap.push_back(
+                    std::make_shared<MemoryBudget>(memoryProperties.memoryHeaps[heapIndex].size));
+            }
 
             for (uint32_t memoryTypeIndex = 0; memoryTypeIndex < mMemoryTypes.size();
                  memoryTypeIndex++) {
-                mDeviceAllocatorsPerType.emplace_back(
-                    CreateDeviceMemoryAllocator(info, memoryTypeIndex, kNoRequiredAlignment));
+                mDeviceAllocatorsPerType.emplace_back(CreateDeferredAllocator(
+                    info,
+                    CreateDeviceMemoryAllocator(info, memoryTypeIndex, kNoRequiredAlignment)));
 
-                mResourceAllocatorsPerType.emplace_back(
-                    CreateResourceSubAllocator(info, memoryTypeIndex, kNoRequiredAlignment));
+                mResourceAllocatorsPerType.emplace_back(CreateDeferredAllocator(
+                    info,
+                    CreateResourceSubAllocator(info, memoryTypeIndex, kNoRequiredAlignment)));
             }
         }
     }
@@ -336,6 +360,7 @@ namespace gpgmm::vk {
         request.AlwaysCacheSize = false;
         request.AlwaysPrefetch = (info.flags & GP_ALLOCATION_CREATE_ALWAYS_PREFETCH_MEMORY);
         request.AvailableForAllocation = kInvalidSize;
+        request.GroupKey = info.groupKey;
 
         // Attempt to allocate using the most effective allocator.
         MemoryAllocator* allocator = nullptr;
@@ -370,6 +395,14 @@ namespace gpgmm::vk {
         allocation->GetAllocator()->DeallocateMemory(std::unique_ptr<MemoryAllocation>(allocation));
     }
 
+    uint64_t GpResourceAllocator_T::FlushDeferredFrees() {
+        uint64_t count = 0;
+        for (DeferredMemoryAllocator* allocator : mDeferredAllocators) {
+            count += allocator->FlushDeferredFrees();
+        }
+        return count;
+    }
+
     VkDevice GpResourceAllocator_T::GetDevice() const {
         return mDevice;
     }
@@ -382,12 +415,27 @@ namespace gpgmm::vk {
         return mCaps.get();
     }
 
+    std::unique_ptr<MemoryAllocator> GpResourceAllocator_T::CreateDeferredAllocator(
+        const GpAllocatorCreateInfo& info,
+        std::unique_ptr<MemoryAllocator> underlyingAllocator) {
+        if (!(info.flags & GP_ALLOCATOR_CREATE_DEFER_DEALLOCATE)) {
+            return underlyingAllocator;
+        }
+
+        std::unique_ptr<DeferredMemoryAllocator> deferredAllocator =
+            std::make_unique<DeferredMemoryAllocator>(std::move(underlyingAllocator));
+        mDeferredAllocators.push_back(deferredAllocator.get());
+        return deferredAllocator;
+    }
+
     std::unique_ptr<MemoryAllocator> GpResourceAllocator_T::CreateDeviceMemoryAllocator(
         const GpAllocatorCreateInfo& info,
         uint64_t memoryTypeIndex,
         uint64_t memoryAlignment) {
         std::unique_ptr<MemoryAllocator> deviceMemoryAllocator =
-            std::make_unique<DeviceMemoryAllocator>(this, memoryTypeIndex);
+            std::make_unique<BudgetedMemoryAllocator>(
+                std::make_unique<DeviceMemoryAllocator>(this, memoryTypeIndex),
+                mMemoryBudgetsPerHeap[mMemoryTypes[memoryTypeIndex].heapIndex]);
 
         if (!(info.flags & GP_ALLOCATOR_CREATE_ALWAYS_ON_DEMAND)) {
             switch (info.poolAlgorithm) {
@@ -398,7 +446,7 @@ namespace gpgmm::vk {
                 }
                 case GP_ALLOCATOR_ALGORITHM_SEGMENTED_POOL: {
                     return std::make_unique<SegmentedMemoryAllocator>(
-                        std::move(deviceMemoryAllocator), memoryAlignment);
+                        std::move(deviceMemoryAllocator), memoryAlignment, info.segmentFitLimit);
                 }
                 default: {
                     UNREACHABLE();
@@ -432,14 +480,41 @@ namespace gpgmm::vk {
                     /*memoryAllocator*/ std::move(pooledOrNonPooledAllocator));
             }
             case GP_ALLOCATOR_ALGORITHM_SLAB: {
-                return std::make_unique<SlabCacheAllocator>(
-                    /*maxSlabSize*/ kMaxDeviceMemorySize,
-                    /*minSlabSize*/ std::max(memoryAlignment, info.preferredDeviceMemorySize),
-                    /*slabAlignment*/ memoryAlignment,
-                    /*slabFragmentationLimit*/ info.memoryFragmentationLimit,
-                    /*allowSlabPrefetch*/
-                    !(info.flags & GP_ALLOCATOR_CREATE_DISABLE_MEMORY_PREFETCH),
-                    /*slabGrowthFactor*/ memoryGrowthFactor,
+                SlabRetentionPolicy retentionPolicy = {};
+                retentionPolicy.MaxEmptySlabCount = info.maxEmptySlabCount;
+                retentionPolicy.MaxEmptySlabUsage =
+                    (info.maxEmptySlabUsage > 0) ? info.maxEmptySlabUsage : kInvalidSize;
+                retentionPolicy.MaxEmptySlabAge =
+                    (info.maxEmptySlabAge > 0) ? info.maxEmptySlabAge : kInvalidSize;
+
+                SlabSizeClassPolicy sizeClassPolicy = {};
+                sizeClassPolicy.SizeClassesPerDoubling = info.sizeClassesPerDoubling;
+                sizeClassPolicy.MaxWasteRatio = info.maxSizeClassWaste;
+                std::unique_ptr<SlabCacheAllocator> slabCacheAllocator =
+                    std::make_unique<SlabCacheAllocator>(
+                        /*maxSlabSize*/ kMaxDeviceMemorySize,
+                        /*minSlabSize*/ std::max(memoryAlignment, info.preferredDeviceMemorySize),
+                        /*slabAlignment*/ memoryAlignment,
+                        /*slabFragmentationLimit*/ info.memoryFragmentationLimit,
+                        /*allowSlabPrefetch*/
+                        !(info.flags & GP_ALLOCATOR_CREATE_DISABLE_MEMORY_PREFETCH),
+                        /*slabGrowthFactor*/ memoryGrowthFactor,
+                        /*memoryAllocator*/ std::move(pooledOrNonPooledAllocator),
+                        /*retentionPolicy*/ retentionPolicy,
+                        /*allowAdaptiveSlabSize*/
+                        (info.flags & GP_ALLOCATOR_CREATE_ADAPTIVE_MEMORY_SIZE),
+                        /*sizeClassPolicy*/ sizeClassPolicy);
+                if (info.threadCacheSize == 0) {
+                    return slabCacheAllocator;
+                }
+                return std::make_unique<MagazineMemoryAllocator>(
+                    /*magazineSize*/ info.threadCacheSize,
+                    /*slabCacheAllocator*/ std::move(slabCacheAllocator));
+            }
+            case GP_ALLOCATOR_ALGORITHM_TLSF: {
+                return std::make_unique<TLSFMemoryAllocator>(
+                    /*memorySize*/ std::max(memoryAlignment, info.preferredDeviceMemorySize),
+                    /*memoryAlignment*/ memoryAlignment,
                     /*memoryAllocator*/ std::move(pooledOrNonPooledAllocator));
             }
             default: {
@@ -19,8 +19,14 @@
 #include "gpgmm/vk/FunctionsVk.h"
 #include "include/gpgmm_vk.h"
 
+#include <memory>
 #include <vector>
 
+namespace gpgmm {
+    class DeferredMemoryAllocator;
+    class MemoryBudget;
+}  // namespace gpgmm
+
 namespace gpgmm::vk {
 
     struct GpResourceAllocation_T final : public MemoryAllocation {
@@ -40,6 +46,8 @@ namespace gpgmm::vk {
 
         void DeallocateMemory(GpResourceAllocation allocation);
 
+        uint64_t FlushDeferredFrees();
+
         void GetBufferMemoryRequirements(VkBuffer buffer, VkMemoryRequirements* requirementsOut);
         void GetImageMemoryRequirements(VkImage image, VkMemoryRequirements* requirementsOut);
 
@@ -56,6 +64,10 @@ namespace gpgmm::vk {
                                      const GpResourceAllocationCreateInfo& allocationInfo,
                                      uint32_t* memoryTypeIndexOut);
 
+        std::unique_ptr<MemoryAllocator> CreateDeferredAllocator(
+            const GpAllocatorCreateInfo& info,
+            std::unique_ptr<MemoryAllocator> underlyingAllocator);
+
         std::unique_ptr<MemoryAllocator> CreateDeviceMemoryAllocator(
             const GpAllocatorCreateInfo& info,
             uint64_t memoryTypeIndex,
@@ -70,9 +82,15 @@ namespace gpgmm::vk {
         VulkanFunctions mVulkanFunctions;
         std::unique_ptr<Caps> mCaps;
 
+        // Must outlive the allocators below since they release from it.
+        std::vector<std::shared_ptr<MemoryBudget>> mMemoryBudgetsPerHeap;
+
         std::vector<std::unique_ptr<MemoryAllocator>> mResourceAllocatorsPerType;
         std::vector<std::unique_ptr<MemoryAllocator>> mDeviceAllocatorsPerType;
         std::vector<VkMemoryType> mMemoryTypes;
+
+        // Top of the allocators above when GP_ALLOCATOR_CREATE_DEFER_DEALLOCATE is used.
+        std::vector<DeferredMemoryAllocator*> mDeferredAllocators;
     };
 
 }  // namespace gpgmm::vk
@@ -59,6 +59,23 @@ namespace gpgmm {
         virtual void SetPool(IMemoryPool* pool) = 0;
     };
 
+    /** \struct MemorySizeClassStats
+    Usage of blocks rounded up to the same size class.
+    */
+    struct MemorySizeClassStats {
+        /** \brief Size, in bytes, of every block in the size class.
+         */
+        uint64_t BlockSize;
+
+        /** \brief Number of used blocks in the size class.
+         */
+        uint64_t UsedBlockCount;
+
+        /** \brief Total size, in bytes, used blocks exceed their requested size by.
+         */
+        uint64_t InternalFragmentationUsage;
+    };
+
     /** \struct MemoryAllocatorStats
     Additional information about the memory allocator usage.
     */
@@ -91,6 +108,19 @@ namespace gpgmm {
          */
         uint64_t PrefetchedMemoryMissesEliminated;
 
+        /** \brief Number of prefetched memory objects released without ever being used.
+         */
+        uint64_t PrefetchedMemoryWasted;
+
+        /** \brief Total size, in bytes, of prefetched memory kept until its size is needed.
+         */
+        uint64_t PrefetchedMemoryParkedUsage;
+
+        /** \brief Total size, in bytes, of prefetched memory not needed by the allocator that
+        prefetched it but used by another allocator instead of being released.
+         */
+        uint64_t PrefetchedMemorySalvagedUsage;
+
         /** \brief Requested size was NOT cached.
          */
         uint64_t SizeCacheMisses;
@@ -99,6 +129,51 @@ namespace gpgmm {
          */
         uint64_t SizeCacheHits;
 
+        /** \brief Number of de-allocations deferred but not yet completed.
+
+        Memory of a pending free is still counted as used until the free completes.
+        */
+        uint64_t PendingFreeCount;
+
+        /** \brief Total size, in bytes, of de-allocations deferred but not yet completed.
+         */
+        uint64_t PendingFreeUsage;
+
+        /** \brief Total size, in bytes, used blocks exceed their requested size by.
+
+        Internal fragmentation caused by rounding up the request size (ie. to a power-of-two or to
+        a fixed block size).
+        */
+        uint64_t InternalFragmentationUsage;
+
+        /** \brief Total size, in bytes, of free space within used memory.
+
+        External fragmentation caused by free blocks that cannot be released since other blocks
+        in the same memory are still used.
+        */
+        uint64_t ExternalFragmentationUsage;
+
+        /** \brief Size, in bytes, of the largest free block within used memory.
+
+        Largest request size that could be sub-allocated without creating memory. When summed
+        together, the larger size is kept.
+        */
+        uint64_t LargestFreeBlockSize;
+
+        /** \brief Number of allocation groups with at-least one allocation.
+
+        Only reported by allocators that pack allocations of the same group together.
+        */
+        uint64_t GroupCount;
+
+        /** \brief Number of memory objects containing the allocations of each group, summed over
+        every group.
+
+        Divided by GroupCount, it is the average number of memory objects a group of allocations
+        is spread across, which is ideally one.
+        */
+        uint64_t GroupMemoryCount;
+
         /** \brief Adds or sums together two infos.
          */
         MemoryAllocatorStats& operator+=(const MemoryAllocatorStats& rhs);
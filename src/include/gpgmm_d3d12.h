@@ -725,6 +725,24 @@ namespace gpgmm::d3d12 {
         to be released, it will report details on any leaked allocations as log messages.
         */
         ALLOCATOR_FLAG_NEVER_LEAK_MEMORY = 0x20,
+
+        /** \brief Sizes new resource heaps from the observed demand.
+
+        Instead of growing by |MemoryGrowthFactor|, resource heaps get sized from the recent rate
+        of resource creation and peak number of resources, per allocation size. Only used by
+        ALLOCATOR_ALGORITHM_SLAB.
+        */
+        ALLOCATOR_FLAG_ADAPTIVE_HEAP_SIZE = 0x40,
+
+        /** \brief Defers de-allocation of resource allocations.
+
+        Releasing a resource allocation only queues it, without taking any allocator lock, so
+        threads that only release resources (eg. upon fence retirement) never contend with the
+        thread creating them. Queued allocations are de-allocated in bulk by the next resource
+        creation or by FlushDeferredFrees(). Until then, they still count as used and are also
+        reported by PendingFreeCount and PendingFreeUsage.
+        */
+        ALLOCATOR_FLAG_DEFER_DEALLOCATE = 0x80,
     };
 
     DEFINE_ENUM_FLAG_OPERATORS(ALLOCATOR_FLAGS)
@@ -802,6 +820,18 @@ namespace gpgmm::d3d12 {
         Dedicated allocation allocates/deallocates in O(1) time using O(N * pageSize) space.
         */
         ALLOCATOR_ALGORITHM_DEDICATED = 5,
+
+        /** \brief Use the two-level segregated fit (TLSF) mechanism.
+
+        TLSF allocates/deallocates in O(1) time using O(N) space.
+
+        TLSF allocates exactly the size requested, so internal fragmentation is bounded by the
+        alignment, and resources of different sizes share the same resource heap. TLSF could
+        externally fragment when many small resources outlive larger ones.
+
+        Requests larger than PreferredResourceHeapSize are not sub-allocated.
+        */
+        ALLOCATOR_ALGORITHM_TLSF = 6,
     };
 
     /** \struct ALLOCATOR_DESC
@@ -920,6 +950,89 @@ namespace gpgmm::d3d12 {
         Optional parameter. When 0 is specified, the default of 1.25 is used (or 25% growth).
         */
         double MemoryGrowthFactor;
+
+        /** \brief Number of size classes per power-of-two range of allocation sizes.
+
+        Rounds up allocation sizes to the next size class so allocations of similar sizes share the
+        same resource heaps, trading some unused memory for fewer resource heaps. Only used by
+        ALLOCATOR_ALGORITHM_SLAB.
+
+        Optional parameter. When 0 is specified, every allocation size gets its own resource
+        heaps. Otherwise, the value gets rounded down to a power-of-two.
+        */
+        uint32_t SizeClassesPerDoubling;
+
+        /** \brief Max fraction of the size class that could be left unused by an allocation.
+
+        Allocation sizes that would exceed this limit once rounded-up to the size class are not
+        rounded and get their own resource heaps instead.
+
+        Optional parameter. When 0 is specified, the unused memory is only bounded by
+        |SizeClassesPerDoubling|.
+        */
+        double MaxSizeClassWaste;
+
+        /** \brief Time, in seconds, without resources created before cached memory gets released
+        in the background.
+
+        Memory gets released gradually, in small steps, and stops being released as soon as
+        resources get created again.
+
+        Optional parameter. When 0 is specified, cached memory is only released by calling
+        ReleaseMemory.
+        */
+        double IdleTrimInterval;
+
+        /** \brief Number of resource heap blocks, per allocation size, each thread keeps cached
+        for re-use.
+
+        Cached blocks are created and released by the calling thread without synchronizing with
+        other threads. Only used by ALLOCATOR_ALGORITHM_SLAB.
+
+        Optional parameter. When 0 is specified, blocks are not cached per-thread.
+        */
+        uint32_t ThreadCacheSize;
+
+        /** \brief Max number of empty resource heaps retained, per allocation size, for re-use.
+
+        Otherwise, a resource heap gets released as soon as the last resource placed in it gets
+        released. Retained resource heaps are released, largest first, by ReleaseMemory. Only used
+        by ALLOCATOR_ALGORITHM_SLAB.
+
+        Optional parameter. When 0 is specified, empty resource heaps are never retained.
+        */
+        uint64_t MaxEmptySlabCount;
+
+        /** \brief Max total size, in bytes, of the empty resource heaps retained, per allocation
+        size.
+
+        Optional parameter. When 0 is specified, the size retained is only bounded by
+        |MaxEmptySlabCount|.
+        */
+        uint64_t MaxEmptySlabUsage;
+
+        /** \brief Number of resources created or released, per allocation size, before an
+        unused retained resource heap gets released.
+
+        Age is counted in these allocation "generations", not in time. Retained resource heaps
+        of an allocation size no longer used are kept until ReleaseMemory is called.
+
+        Optional parameter. When 0 is specified, retained resource heaps are only released by
+        ReleaseMemory.
+        */
+        uint64_t MaxEmptySlabAge;
+
+        /** \brief Max fraction a pooled resource heap could exceed the requested resource heap
+        size by and still be re-used.
+
+        A larger resource heap is only re-used when no pooled resource heap of the requested size
+        exists, trading some unused memory for fewer resource heaps created. Only used by
+        ALLOCATOR_ALGORITHM_SEGMENTED_POOL.
+
+        Optional parameter. When 0 is specified, only resource heaps of the requested size are
+        re-used.
+        */
+        double SegmentFitLimit;
     };
 
     /** \enum ALLOCATION_FLAGS
@@ -1055,6 +1168,16 @@ namespace gpgmm::d3d12 {
         */
         uint64_t RequireResourceHeapPadding;
 
+        /** \brief Group of allocations used together.
+
+        Resources of the same group, for example the vertex, index and constant buffers of one
+        mesh, are preferably sub-allocated from the same resource heap so fewer heaps need to be
+        made resident to use them.
+
+        Optional parameter. By default, or zero, the allocation does not belong to any group.
+        */
+        uint64_t GroupKey;
+
         /** \brief Associates a name with the given allocation.
 
         Optional parameter. By default, no name is associated.
@@ -1171,6 +1294,16 @@ namespace gpgmm::d3d12 {
         */
         virtual uint64_t ReleaseMemory(uint64_t bytesToRelease) = 0;
 
+        /** \brief De-allocate resource allocations whose de-allocation was deferred.
+
+        Only used with ALLOCATOR_FLAG_DEFER_DEALLOCATE. Apps could call FlushDeferredFrees() when
+        resource creation stops for a period of time, otherwise deferred allocations keep their
+        memory until the next resource gets created.
+
+        \return Number of resource allocations de-allocated.
+        */
+        virtual uint64_t FlushDeferredFrees() = 0;
+
         /** \brief  Return the current allocator usage.
 
         Returned info can be used to monitor memory usage per allocator.
@@ -1181,6 +1314,20 @@ namespace gpgmm::d3d12 {
         */
         virtual RESOURCE_ALLOCATOR_STATS GetStats() const = 0;
 
+        /** \brief Return the usage of each size class.
+
+        Size classes are only used by slab allocators (see ALLOCATOR_DESC::SizeClassesPerDoubling).
+        Size classes of each resource heap type are returned in turn, ordered by block size.
+
+        @param[out] pSizeClassStats Array that receives up to |count| size classes. Can be NULL
+        if |count| is zero.
+        @param count Number of elements in the array.
+
+        \return Number of size classes, which could exceed |count|.
+        */
+        virtual uint64_t GetSizeClassStats(MemorySizeClassStats* pSizeClassStats,
+                                           uint64_t count) const = 0;
+
         /** \brief Gets information about the features that are supported by the resource allocator.
 
         @param feature A constant from the ALLOCATOR_FEATURE enumeration describing the feature(s)
@@ -63,6 +63,23 @@ namespace gpgmm::vk {
         VK_KHR_get_physical_device_properties2.
         */
         GP_ALLOCATOR_CREATE_ALWAYS_IN_BUDGET = 0x10,
+
+        /** \brief Sizes new device memory from the observed demand.
+
+        Instead of growing by |memoryGrowthFactor|, device memory gets sized from the recent rate
+        of resource creation and peak number of resources, per allocation size. Only used by
+        GP_ALLOCATOR_ALGORITHM_SLAB.
+        */
+        GP_ALLOCATOR_CREATE_ADAPTIVE_MEMORY_SIZE = 0x20,
+
+        /** \brief Defers de-allocation of resource allocations.
+
+        Destroying a resource allocation only queues it, without taking any allocator lock, so
+        threads that only destroy resources never contend with the thread creating them. Queued
+        allocations are de-allocated in bulk by the next resource creation or by
+        gpFlushDeferredFrees().
+        */
+        GP_ALLOCATOR_CREATE_DEFER_DEALLOCATE = 0x40,
     };
 
     /** \enum GpAllocatorAlgorithm
@@ -124,6 +141,18 @@ namespace gpgmm::vk {
         Segmented pool allocate/deallocates in O(Log2) time using O(N * K) space.
         */
         GP_ALLOCATOR_ALGORITHM_SEGMENTED_POOL = 4,
+
+        /** \brief Use the two-level segregated fit (TLSF) mechanism.
+
+        TLSF allocates/deallocates in O(1) time using O(N) space.
+
+        TLSF allocates exactly the size requested, so internal fragmentation is bounded by the
+        alignment, and resources of different sizes share the same device memory. TLSF could
+        externally fragment when many small resources outlive larger ones.
+
+        Requests larger than preferredDeviceMemorySize are not sub-allocated.
+        */
+        GP_ALLOCATOR_ALGORITHM_TLSF = 5,
     };
 
     struct VulkanFunctions;
@@ -225,6 +254,78 @@ namespace gpgmm::vk {
         Optional parameter. When 0 is specified, the default of 1.25 is used (or 25% growth).
         */
         double memoryGrowthFactor;
+
+        /** \brief Number of size classes per power-of-two range of allocation sizes.
+
+        Rounds up allocation sizes to the next size class so allocations of similar sizes share the
+        same device memory, trading some unused memory for fewer device memory allocations. Only
+        used by GP_ALLOCATOR_ALGORITHM_SLAB.
+
+        Optional parameter. When 0 is specified, every allocation size gets its own device
+        memory. Otherwise, the value gets rounded down to a power-of-two.
+        */
+        uint32_t sizeClassesPerDoubling;
+
+        /** \brief Max fraction of the size class that could be left unused by an allocation.
+
+        Allocation sizes that would exceed this limit once rounded-up to the size class are not
+        rounded and get their own device memory instead.
+
+        Optional parameter. When 0 is specified, the unused memory is only bounded by
+        |sizeClassesPerDoubling|.
+        */
+        double maxSizeClassWaste;
+
+        /** \brief Number of device memory blocks, per allocation size, each thread keeps cached
+        for re-use.
+
+        Cached blocks are created and released by the calling thread without synchronizing with
+        other threads. Only used by GP_ALLOCATOR_ALGORITHM_SLAB.
+
+        Optional parameter. When 0 is specified, blocks are not cached per-thread.
+        */
+        uint32_t threadCacheSize;
+
+        /** \brief Max number of empty device memory blocks retained, per allocation size, for
+        re-use.
+
+        Otherwise, device memory gets released as soon as the last resource bound to it gets
+        released. Only used by GP_ALLOCATOR_ALGORITHM_SLAB.
+
+        Optional parameter. When 0 is specified, empty device memory is never retained.
+        */
+        uint64_t maxEmptySlabCount;
+
+        /** \brief Max total size, in bytes, of the empty device memory retained, per allocation
+        size.
+
+        Optional parameter. When 0 is specified, the size retained is only bounded by
+        |maxEmptySlabCount|.
+        */
+        uint64_t maxEmptySlabUsage;
+
+        /** \brief Number of resources created or released, per allocation size, before unused
+        retained device memory gets released.
+
+        Age is counted in these allocation "generations", not in time. Retained device memory of
+        an allocation size no longer used is kept until the allocator gets destroyed.
+
+        Optional parameter. When 0 is specified, retained device memory is never released for
+        being unused.
+        */
+        uint64_t maxEmptySlabAge;
+
+        /** \brief Max fraction pooled device memory could exceed the requested device memory size
+        by and still be re-used.
+
+        Larger device memory is only re-used when no pooled device memory of the requested size
+        exists, trading some unused memory for fewer device memory allocations. Only used by
+        GP_ALLOCATOR_ALGORITHM_SEGMENTED_POOL.
+
+        Optional parameter. When 0 is specified, only device memory of the requested size is
+        re-used.
+        */
+        double segmentFitLimit;
     };
 
     /** \enum GpResourceAllocationCreateFlags
@@ -274,6 +375,13 @@ namespace gpgmm::vk {
         /** \brief Bitmask to specify required memory properties for the allocation.
          */
         VkMemoryPropertyFlags requiredPropertyFlags;
+
+        /** \brief Group of allocations used together, preferably sub-allocated from the same
+        device memory.
+
+        Optional parameter. By default, or zero, the allocation does not belong to any group.
+        */
+        uint64_t groupKey;
     };
 
     /** \brief  Create allocator used to create and manage video memory for the App specified device
@@ -294,6 +402,16 @@ namespace gpgmm::vk {
     */
     GPGMM_EXPORT void gpDestroyResourceAllocator(GpResourceAllocator allocator);
 
+    /** \brief  De-allocate resource allocations whose de-allocation was deferred.
+
+    Only used with GP_ALLOCATOR_CREATE_DEFER_DEALLOCATE.
+
+    @param allocator A GpResourceAllocator used to create the allocations.
+
+    \return Number of resource allocations de-allocated.
+    */
+    GPGMM_EXPORT uint64_t gpFlushDeferredFrees(GpResourceAllocator allocator);
+
     /** \brief  Create a buffer allocation.
 
     @param allocator A GpResourceAllocator used to create the buffer and allocation.
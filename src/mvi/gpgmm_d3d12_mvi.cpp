@@ -427,10 +427,19 @@ namespace gpgmm::d3d12 {
         return 0;
     }
 
+    uint64_t ResourceAllocator::FlushDeferredFrees() {
+        return 0;
+    }
+
     RESOURCE_ALLOCATOR_STATS ResourceAllocator::GetStats() const {
         return mStats;
     }
 
+    uint64_t ResourceAllocator::GetSizeClassStats(MemorySizeClassStats* pSizeClassStats,
+                                                  uint64_t count) const {
+        return 0;
+    }
+
     HRESULT ResourceAllocator::CheckFeatureSupport(ALLOCATOR_FEATURE feature,
                                                    void* pFeatureSupportData,
                                                    uint32_t featureSupportDataSize) const {
@@ -203,7 +203,10 @@ namespace gpgmm::d3d12 {
         HRESULT CreateResource(Microsoft::WRL::ComPtr<ID3D12Resource> committedResource,
                                IResourceAllocation** ppResourceAllocationOut) override;
         uint64_t ReleaseMemory(uint64_t bytesToRelease) override;
+        uint64_t FlushDeferredFrees() override;
         RESOURCE_ALLOCATOR_STATS GetStats() const override;
+        uint64_t GetSizeClassStats(MemorySizeClassStats* pSizeClassStats,
+                                   uint64_t count) const override;
         HRESULT CheckFeatureSupport(ALLOCATOR_FEATURE feature,
                                     void* pFeatureSupportData,
                                     uint32_t featureSupportDataSize) const override;
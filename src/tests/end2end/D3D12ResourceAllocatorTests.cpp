@@ -278,6 +278,24 @@ TEST_F(D3D12ResourceAllocatorTests, CreateBufferSubAllocated) {
         }
     }
 
+    // ALLOCATOR_ALGORITHM_TLSF
+    {
+        ALLOCATOR_DESC newAllocatorDesc = allocatorDesc;
+        newAllocatorDesc.SubAllocationAlgorithm = ALLOCATOR_ALGORITHM_TLSF;
+
+        ComPtr<IResourceAllocator> resourceAllocator;
+        ASSERT_SUCCEEDED(CreateResourceAllocator(newAllocatorDesc, &resourceAllocator, nullptr));
+        ASSERT_NE(resourceAllocator, nullptr);
+
+        for (auto& alloc : GenerateBufferAllocations()) {
+            ComPtr<IResourceAllocation> allocation;
+            EXPECT_EQ(SUCCEEDED(resourceAllocator->CreateResource(
+                          allocationDesc, CreateBasicBufferDesc(alloc.size, alloc.alignment),
+                          D3D12_RESOURCE_STATE_COMMON, nullptr, &allocation)),
+                      alloc.succeeds);
+        }
+    }
+
     // ALLOCATOR_ALGORITHM_BUDDY_SYSTEM + ALLOCATOR_ALGORITHM_FIXED_POOL
     {
         ALLOCATOR_DESC newAllocatorDesc = allocatorDesc;
@@ -450,6 +468,25 @@ TEST_F(D3D12ResourceAllocatorTests, CreateBufferWithPreferredHeapSize) {
         EXPECT_EQ(allocation->GetMemory()->GetSize(), GPGMM_MB_TO_BYTES(16));
     }
 
+    // ALLOCATOR_ALGORITHM_TLSF
+    {
+        ALLOCATOR_DESC newAllocatorDesc = allocatorDesc;
+        newAllocatorDesc.SubAllocationAlgorithm = ALLOCATOR_ALGORITHM_TLSF;
+        newAllocatorDesc.PreferredResourceHeapSize = GPGMM_MB_TO_BYTES(12);
+
+        ComPtr<IResourceAllocator> resourceAllocator;
+        ASSERT_SUCCEEDED(CreateResourceAllocator(newAllocatorDesc, &resourceAllocator, nullptr));
+        ASSERT_NE(resourceAllocator, nullptr);
+
+        ComPtr<IResourceAllocation> allocation;
+        ASSERT_SUCCEEDED(
+            resourceAllocator->CreateResource({}, CreateBasicBufferDesc(kBufferOf4MBAllocationSize),
+                                              D3D12_RESOURCE_STATE_COMMON, nullptr, &allocation));
+
+        // TLSF allocator does not require heaps to be in powers-of-two sizes.
+        EXPECT_EQ(allocation->GetMemory()->GetSize(), GPGMM_MB_TO_BYTES(12));
+    }
+
     // ALLOCATOR_ALGORITHM_DEDICATED
     {
         ALLOCATOR_DESC newAllocatorDesc = allocatorDesc;
@@ -1265,6 +1302,56 @@ TEST_F(D3D12ResourceAllocatorTests, CreateBufferNeverPooled) {
     }
 }
 
+TEST_F(D3D12ResourceAllocatorTests, CreateBufferDeferDeallocate) {
+    ALLOCATOR_DESC allocatorDesc = CreateBasicAllocatorDesc();
+    allocatorDesc.Flags |= ALLOCATOR_FLAG_DEFER_DEALLOCATE;
+
+    ComPtr<IResourceAllocator> resourceAllocator;
+    ASSERT_SUCCEEDED(CreateResourceAllocator(allocatorDesc, &resourceAllocator, nullptr));
+    ASSERT_NE(resourceAllocator, nullptr);
+
+    ALLOCATION_DESC allocationDesc = {};
+    allocationDesc.HeapType = D3D12_HEAP_TYPE_DEFAULT;
+
+    // Released buffer stays pending until flushed.
+    {
+        ComPtr<IResourceAllocation> allocation;
+        ASSERT_SUCCEEDED(resourceAllocator->CreateResource(
+            allocationDesc, CreateBasicBufferDesc(kBufferOf4MBAllocationSize),
+            D3D12_RESOURCE_STATE_COMMON, nullptr, &allocation));
+        ASSERT_NE(allocation, nullptr);
+    }
+
+    EXPECT_EQ(resourceAllocator->GetStats().PendingFreeCount, 1u);
+    EXPECT_EQ(resourceAllocator->GetStats().PendingFreeUsage, kBufferOf4MBAllocationSize);
+
+    EXPECT_EQ(resourceAllocator->FlushDeferredFrees(), 1u);
+    EXPECT_EQ(resourceAllocator->FlushDeferredFrees(), 0u);
+
+    EXPECT_EQ(resourceAllocator->GetStats().PendingFreeCount, 0u);
+    EXPECT_EQ(resourceAllocator->GetStats().UsedBlockCount, 0u);
+
+    // Creating another buffer flushes the pending ones first.
+    {
+        ComPtr<IResourceAllocation> allocation;
+        ASSERT_SUCCEEDED(resourceAllocator->CreateResource(
+            allocationDesc, CreateBasicBufferDesc(kBufferOf4MBAllocationSize),
+            D3D12_RESOURCE_STATE_COMMON, nullptr, &allocation));
+        ASSERT_NE(allocation, nullptr);
+    }
+
+    {
+        ComPtr<IResourceAllocation> allocation;
+        ASSERT_SUCCEEDED(resourceAllocator->CreateResource(
+            allocationDesc, CreateBasicBufferDesc(kBufferOf4MBAllocationSize),
+            D3D12_RESOURCE_STATE_COMMON, nullptr, &allocation));
+        ASSERT_NE(allocation, nullptr);
+        EXPECT_EQ(resourceAllocator->GetStats().PendingFreeCount, 0u);
+    }
+
+    EXPECT_EQ(resourceAllocator->FlushDeferredFrees(), 1u);
+}
+
 TEST_F(D3D12ResourceAllocatorTests, CreateBufferPooled) {
     constexpr uint64_t bufferSize = kBufferOf4MBAllocationSize;
 
@@ -16,11 +16,20 @@
 
 #include "gpgmm/common/BuddyMemoryAllocator.h"
 #include "gpgmm/common/DedicatedMemoryAllocator.h"
+#include "gpgmm/common/MagazineMemoryAllocator.h"
+#include "gpgmm/common/MemoryAllocationQueue.h"
 #include "gpgmm/common/SegmentedMemoryAllocator.h"
 #include "gpgmm/common/SizeClass.h"
 #include "gpgmm/common/SlabMemoryAllocator.h"
+#include "gpgmm/common/TLSFMemoryAllocator.h"
+#include "gpgmm/common/WorkerThread.h"
 #include "tests/DummyMemoryAllocator.h"
 
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <set>
+#include <thread>
 #include <vector>
 
 using namespace gpgmm;
@@ -28,6 +37,51 @@ using namespace gpgmm;
 static constexpr double kDisableSlabGrowth = 1.0;
 static constexpr uint64_t kMemoryAlignment = 1;
 
+// Counts the memory created by the backing allocator.
+class CountingMemoryAllocator final : public DummyMemoryAllocator {
+  public:
+    std::unique_ptr<MemoryAllocation> TryAllocateMemory(
+        const MemoryAllocationRequest& request) override {
+        std::unique_ptr<MemoryAllocation> allocation =
+            DummyMemoryAllocator::TryAllocateMemory(request);
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        mAllocationCount++;
+        mPeakMemoryUsage = std::max(mPeakMemoryUsage, mStats.UsedMemoryUsage);
+        return allocation;
+    }
+
+    uint64_t GetAllocationCount() const {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mAllocationCount;
+    }
+
+    uint64_t GetPeakMemoryUsage() const {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mPeakMemoryUsage;
+    }
+
+  private:
+    uint64_t mAllocationCount = 0;
+    uint64_t mPeakMemoryUsage = 0;
+};
+
+// Delays the memory created by the backing allocator, like a device would.
+class SlowMemoryAllocator final : public DummyMemoryAllocator {
+  public:
+    explicit SlowMemoryAllocator(std::chrono::microseconds latency) : mLatency(latency) {
+    }
+
+    std::unique_ptr<MemoryAllocation> TryAllocateMemory(
+        const MemoryAllocationRequest& request) override {
+        std::this_thread::sleep_for(mLatency);
+        return DummyMemoryAllocator::TryAllocateMemory(request);
+    }
+
+  private:
+    const std::chrono::microseconds mLatency;
+};
+
 class MemoryAllocatorPerfTests : public benchmark::Fixture {
   public:
     MemoryAllocationRequest CreateBasicRequest(uint64_t size, uint64_t alignment = 1) {
@@ -128,6 +182,15 @@ BENCHMARK_DEFINE_F(SingleSizeAllocationPerfTests, BuddySystem)(benchmark::State&
     }
 }
 
+BENCHMARK_DEFINE_F(SingleSizeAllocationPerfTests, TLSF)(benchmark::State& state) {
+    TLSFMemoryAllocator allocator(state.range(0), kMemoryAlignment,
+                                  std::make_unique<DummyMemoryAllocator>());
+
+    for (auto _ : state) {
+        SingleStep(state, &allocator, CreateBasicRequest(state.range(2)));
+    }
+}
+
 BENCHMARK_DEFINE_F(SingleSizeAllocationPerfTests, Standalone)(benchmark::State& state) {
     DedicatedMemoryAllocator allocator(std::make_unique<DummyMemoryAllocator>());
 
@@ -144,6 +207,931 @@ BENCHMARK_DEFINE_F(SingleSizeAllocationPerfTests, SegmentedPool)(benchmark::Stat
     }
 }
 
+// Tests allocates and frees memory of random sizes from a pool that holds many distinct sizes,
+// like resource heaps of user-defined sizes.
+class ManySegmentsAllocationPerfTests : public MemoryAllocatorPerfTests {
+  public:
+    void Run(benchmark::State& state, MemoryAllocator* allocator) {
+        // Create a segment for every size, each with free memory to re-use.
+        std::vector<uint64_t> sizes;
+        for (int64_t i = 1; i <= state.range(0); i++) {
+            sizes.push_back(i * state.range(1));
+        }
+
+        std::mt19937_64 generator(/*seed*/ 42);
+        std::shuffle(sizes.begin(), sizes.end(), generator);
+        for (uint64_t size : sizes) {
+            auto allocation = allocator->TryAllocateMemory(CreateBasicRequest(size));
+            if (allocation == nullptr) {
+                state.SkipWithError("Unable to allocate. Skipping.");
+                return;
+            }
+            allocator->DeallocateMemory(std::move(allocation));
+        }
+
+        std::uniform_int_distribution<uint64_t> indices(0, sizes.size() - 1);
+        for (auto _ : state) {
+            auto allocation =
+                allocator->TryAllocateMemory(CreateBasicRequest(sizes[indices(generator)]));
+            if (allocation == nullptr) {
+                state.SkipWithError("Unable to allocate. Skipping.");
+                break;
+            }
+            allocator->DeallocateMemory(std::move(allocation));
+        }
+
+        allocator->ReleaseMemory(kInvalidSize);
+    }
+
+    static void GenerateParams(benchmark::internal::Benchmark* benchmark) {
+        benchmark->ArgNames({"segments", "granularity"});
+        benchmark->Args({16, GPGMM_KB_TO_BYTES(64)});
+        benchmark->Args({256, GPGMM_KB_TO_BYTES(64)});
+        benchmark->Args({4096, GPGMM_KB_TO_BYTES(64)});
+    }
+};
+
+BENCHMARK_DEFINE_F(ManySegmentsAllocationPerfTests, SegmentedPool)(benchmark::State& state) {
+    SegmentedMemoryAllocator allocator(std::make_unique<DummyMemoryAllocator>(), kMemoryAlignment);
+    Run(state, &allocator);
+}
+
+BENCHMARK_DEFINE_F(ManySegmentsAllocationPerfTests, SegmentedPool_BestFit)
+(benchmark::State& state) {
+    SegmentedMemoryAllocator allocator(std::make_unique<DummyMemoryAllocator>(), kMemoryAlignment,
+                                       /*segmentFitLimit*/ 0.25);
+    Run(state, &allocator);
+}
+
+// Tests allocates memory of mixed sizes, frees half of it, allocates again then frees it all.
+// Reports the fraction of memory used by the requested sizes once the allocations were churned.
+class MixedSizeAllocationPerfTests : public MemoryAllocatorPerfTests {
+  public:
+    void SingleStep(benchmark::State& state,
+                    MemoryAllocator* allocator,
+                    const std::vector<uint64_t>& requestSizes) {
+        std::vector<std::unique_ptr<MemoryAllocation>> allocations;
+        auto allocate = [&](uint64_t requestSize) {
+            auto allocation =
+                allocator->TryAllocateMemory(CreateBasicRequest(requestSize, kRequestAlignment));
+            if (allocation == nullptr) {
+                state.SkipWithError("Unable to allocate. Skipping.");
+                return false;
+            }
+            allocations.push_back(std::move(allocation));
+            return true;
+        };
+
+        for (uint64_t requestSize : requestSizes) {
+            if (!allocate(requestSize)) {
+                return;
+            }
+        }
+
+        // Free every other allocation then re-allocate the freed sizes in reverse order.
+        std::vector<uint64_t> freedSizes;
+        for (size_t i = 0; i < allocations.size(); i += 2) {
+            freedSizes.push_back(allocations[i]->GetRequestSize());
+            allocator->DeallocateMemory(std::move(allocations[i]));
+        }
+
+        for (auto it = freedSizes.rbegin(); it != freedSizes.rend(); ++it) {
+            if (!allocate(*it)) {
+                return;
+            }
+        }
+
+        uint64_t requestedUsage = 0;
+        for (auto& allocation : allocations) {
+            if (allocation != nullptr) {
+                requestedUsage += allocation->GetRequestSize();
+            }
+        }
+
+        const MemoryAllocatorStats stats = allocator->GetStats();
+        state.counters["Utilization"] = SafeDivide(requestedUsage, stats.UsedMemoryUsage);
+        state.counters["MemoryUsage"] = static_cast<double>(stats.UsedMemoryUsage);
+
+        for (auto& allocation : allocations) {
+            if (allocation != nullptr) {
+                allocator->DeallocateMemory(std::move(allocation));
+            }
+        }
+    }
+
+    // Sizes are random but repeatable so every allocator sees the same requests.
+    static std::vector<uint64_t> GenerateRequestSizes(const benchmark::State& state) {
+        std::mt19937_64 generator(/*seed*/ 42);
+        std::uniform_int_distribution<uint64_t> distribution(1, state.range(1));
+
+        std::vector<uint64_t> requestSizes;
+        for (int i = 0; i < state.range(2); i++) {
+            requestSizes.push_back(AlignTo(distribution(generator), kRequestAlignment));
+        }
+        return requestSizes;
+    }
+
+    static void GenerateParams(benchmark::internal::Benchmark* benchmark) {
+        static const uint64_t kMemorySize = GPGMM_MB_TO_BYTES(4);
+        static const uint64_t kNumOfAllocations = 64u;
+
+        benchmark->ArgNames({"memory", "max", "count"});
+        benchmark->Args({kMemorySize, GPGMM_KB_TO_BYTES(64), kNumOfAllocations});
+        benchmark->Args({kMemorySize, GPGMM_KB_TO_BYTES(512), kNumOfAllocations});
+        benchmark->Args({kMemorySize, GPGMM_MB_TO_BYTES(4), kNumOfAllocations});
+    }
+
+  protected:
+    static constexpr uint64_t kRequestAlignment = 256;
+};
+
+BENCHMARK_DEFINE_F(MixedSizeAllocationPerfTests, SlabCache)(benchmark::State& state) {
+    SlabCacheAllocator allocator(state.range(0), state.range(0), kMemoryAlignment,
+                                 /*slabFragmentationLimit*/ 1, /*allowPrefetch*/ false,
+                                 kDisableSlabGrowth, std::make_unique<DummyMemoryAllocator>());
+
+    const std::vector<uint64_t> requestSizes = GenerateRequestSizes(state);
+    for (auto _ : state) {
+        SingleStep(state, &allocator, requestSizes);
+    }
+}
+
+BENCHMARK_DEFINE_F(MixedSizeAllocationPerfTests, BuddySystem)(benchmark::State& state) {
+    BuddyMemoryAllocator allocator(GPGMM_GB_TO_BYTES(16), state.range(0), kMemoryAlignment,
+                                   std::make_unique<DummyMemoryAllocator>());
+
+    const std::vector<uint64_t> requestSizes = GenerateRequestSizes(state);
+    for (auto _ : state) {
+        SingleStep(state, &allocator, requestSizes);
+    }
+}
+
+BENCHMARK_DEFINE_F(MixedSizeAllocationPerfTests, TLSF)(benchmark::State& state) {
+    TLSFMemoryAllocator allocator(state.range(0), kMemoryAlignment,
+                                  std::make_unique<DummyMemoryAllocator>());
+
+    const std::vector<uint64_t> requestSizes = GenerateRequestSizes(state);
+    for (auto _ : state) {
+        SingleStep(state, &allocator, requestSizes);
+    }
+}
+
+// Tests allocates one block past a full slab then frees it, repeatedly, so usage oscillates
+// around the slab boundary. Reports the number of backing allocations per iteration.
+class OscillatingAllocationPerfTests : public MemoryAllocatorPerfTests {
+  public:
+    void OscillateStep(benchmark::State& state,
+                       MemoryAllocator* allocator,
+                       const MemoryAllocationRequest& request) const {
+        const uint64_t blocksPerSlab = state.range(0) / state.range(1);
+
+        std::vector<std::unique_ptr<MemoryAllocation>> allocations;
+        for (uint64_t i = 0; i < blocksPerSlab; i++) {
+            auto allocation = allocator->TryAllocateMemory(request);
+            if (allocation == nullptr) {
+                state.SkipWithError("Unable to allocate. Skipping.");
+                return;
+            }
+            allocations.push_back(std::move(allocation));
+        }
+
+        for (int i = 0; i < state.range(2); i++) {
+            auto allocation = allocator->TryAllocateMemory(request);
+            if (allocation == nullptr) {
+                state.SkipWithError("Unable to allocate. Skipping.");
+                break;
+            }
+            allocator->DeallocateMemory(std::move(allocation));
+        }
+
+        for (auto& allocation : allocations) {
+            allocator->DeallocateMemory(std::move(allocation));
+        }
+    }
+
+    void Run(benchmark::State& state, const SlabRetentionPolicy& retentionPolicy) {
+        std::unique_ptr<CountingMemoryAllocator> memoryAllocator =
+            std::make_unique<CountingMemoryAllocator>();
+        {
+            SlabMemoryAllocator allocator(state.range(1), state.range(0), state.range(0),
+                                          kMemoryAlignment, /*slabFragmentationLimit*/ 1,
+                                          /*allowPrefetch*/ false, kDisableSlabGrowth,
+                                          memoryAllocator.get(), retentionPolicy);
+
+            for (auto _ : state) {
+                OscillateStep(state, &allocator, CreateBasicRequest(state.range(1)));
+            }
+        }
+
+        state.counters["BackingAllocations"] =
+            benchmark::Counter(static_cast<double>(memoryAllocator->GetAllocationCount()),
+                               benchmark::Counter::kAvgIterations);
+    }
+
+    static void GenerateParams(benchmark::internal::Benchmark* benchmark) {
+        static const uint64_t kSlabSize = GPGMM_MB_TO_BYTES(4);
+
+        benchmark->ArgNames({"slab", "size", "count"});
+        benchmark->Args({kSlabSize, GPGMM_KB_TO_BYTES(64), 16});
+        benchmark->Args({kSlabSize, GPGMM_KB_TO_BYTES(64), 256});
+        benchmark->Args({kSlabSize, GPGMM_MB_TO_BYTES(1), 256});
+    }
+};
+
+BENCHMARK_DEFINE_F(OscillatingAllocationPerfTests, Slab_NoRetention)(benchmark::State& state) {
+    Run(state, {});
+}
+
+BENCHMARK_DEFINE_F(OscillatingAllocationPerfTests, Slab_Retention)(benchmark::State& state) {
+    SlabRetentionPolicy retentionPolicy = {};
+    retentionPolicy.MaxEmptySlabCount = 2;
+    Run(state, retentionPolicy);
+}
+
+// Tests replays a trace of frames where each frame grows or shrinks the number of used blocks,
+// like an application streaming resources in and out. Compares fixed slab growth against slab
+// sizes chosen from demand by reporting the peak memory and number of backing allocations.
+class ReplayAllocationPerfTests : public MemoryAllocatorPerfTests {
+  public:
+    void ReplayStep(benchmark::State& state,
+                    MemoryAllocator* allocator,
+                    const std::vector<uint64_t>& trace) {
+        std::vector<std::unique_ptr<MemoryAllocation>> allocations;
+        for (uint64_t usedBlockCount : trace) {
+            while (allocations.size() < usedBlockCount) {
+                auto allocation = allocator->TryAllocateMemory(CreateBasicRequest(state.range(2)));
+                if (allocation == nullptr) {
+                    state.SkipWithError("Unable to allocate. Skipping.");
+                    break;
+                }
+                allocations.push_back(std::move(allocation));
+            }
+
+            while (allocations.size() > usedBlockCount) {
+                allocator->DeallocateMemory(std::move(allocations.back()));
+                allocations.pop_back();
+            }
+        }
+
+        for (auto& allocation : allocations) {
+            allocator->DeallocateMemory(std::move(allocation));
+        }
+    }
+
+    void Run(benchmark::State& state, double slabGrowthFactor, bool allowAdaptiveSlabSize) {
+        const std::vector<uint64_t> trace = GenerateTrace(state);
+
+        std::unique_ptr<CountingMemoryAllocator> memoryAllocator =
+            std::make_unique<CountingMemoryAllocator>();
+        {
+            SlabMemoryAllocator allocator(state.range(2), state.range(1), state.range(0),
+                                          kMemoryAlignment, /*slabFragmentationLimit*/ 1,
+                                          /*allowPrefetch*/ false, slabGrowthFactor,
+                                          memoryAllocator.get(), /*retentionPolicy*/ {},
+                                          allowAdaptiveSlabSize);
+
+            for (auto _ : state) {
+                ReplayStep(state, &allocator, trace);
+            }
+        }
+
+        state.counters["BackingAllocations"] =
+            benchmark::Counter(static_cast<double>(memoryAllocator->GetAllocationCount()),
+                               benchmark::Counter::kAvgIterations);
+        state.counters["PeakMemoryUsage"] =
+            static_cast<double>(memoryAllocator->GetPeakMemoryUsage());
+    }
+
+    // Frames are random but repeatable so every allocator replays the same trace. Most frames
+    // change the number of used blocks a little, some change it a lot.
+    static std::vector<uint64_t> GenerateTrace(const benchmark::State& state) {
+        static constexpr uint64_t kNumOfFrames = 256;
+
+        std::mt19937_64 generator(/*seed*/ 42);
+        std::uniform_int_distribution<uint64_t> usedBlockCounts(0, state.range(3));
+        std::uniform_int_distribution<uint64_t> frameKinds(0, 7);
+
+        std::vector<uint64_t> trace;
+        uint64_t usedBlockCount = 0;
+        for (uint64_t i = 0; i < kNumOfFrames; i++) {
+            if (frameKinds(generator) == 0) {
+                usedBlockCount = usedBlockCounts(generator);
+            } else {
+                usedBlockCount = (usedBlockCount + usedBlockCounts(generator)) / 2;
+            }
+            trace.push_back(usedBlockCount);
+        }
+        return trace;
+    }
+
+    static void GenerateParams(benchmark::internal::Benchmark* benchmark) {
+        static const uint64_t kMinSlabSize = GPGMM_KB_TO_BYTES(64);
+        static const uint64_t kMaxSlabSize = GPGMM_MB_TO_BYTES(64);
+
+        benchmark->ArgNames({"min", "max", "size", "used"});
+        benchmark->Args({kMinSlabSize, kMaxSlabSize, /*256B*/ 256, 4096});
+        benchmark->Args({kMinSlabSize, kMaxSlabSize, GPGMM_KB_TO_BYTES(8), 1024});
+        benchmark->Args({kMinSlabSize, kMaxSlabSize, GPGMM_KB_TO_BYTES(64), 256});
+    }
+};
+
+BENCHMARK_DEFINE_F(ReplayAllocationPerfTests, Slab_FixedGrowth)(benchmark::State& state) {
+    Run(state, /*slabGrowthFactor*/ 2, /*allowAdaptiveSlabSize*/ false);
+}
+
+BENCHMARK_DEFINE_F(ReplayAllocationPerfTests, Slab_AdaptiveSize)(benchmark::State& state) {
+    Run(state, kDisableSlabGrowth, /*allowAdaptiveSlabSize*/ true);
+}
+
+// Tests allocates many buffers of distinct sizes, like user-defined resources, then frees them
+// all. Compares a slab allocator per size against one per size class by reporting the number of
+// backing allocations and the unused memory of the allocated blocks.
+class DistinctSizeAllocationPerfTests : public MemoryAllocatorPerfTests {
+  public:
+    void Run(benchmark::State& state, uint64_t sizeClassesPerDoubling) {
+        std::mt19937_64 generator(/*seed*/ 42);
+        std::uniform_int_distribution<uint64_t> sizes(state.range(1), state.range(2));
+
+        std::vector<MemoryAllocationRequest> requests;
+        for (int64_t i = 0; i < state.range(3); i++) {
+            requests.push_back(CreateBasicRequest(sizes(generator)));
+        }
+
+        SlabSizeClassPolicy sizeClassPolicy = {};
+        sizeClassPolicy.SizeClassesPerDoubling = sizeClassesPerDoubling;
+
+        std::unique_ptr<CountingMemoryAllocator> memoryAllocator =
+            std::make_unique<CountingMemoryAllocator>();
+        CountingMemoryAllocator* countingAllocator = memoryAllocator.get();
+
+        SlabCacheAllocator allocator(state.range(0), state.range(0), kMemoryAlignment,
+                                     /*slabFragmentationLimit*/ 1, /*allowPrefetch*/ false,
+                                     kDisableSlabGrowth, std::move(memoryAllocator),
+                                     /*retentionPolicy*/ {}, /*allowAdaptiveSlabSize*/ false,
+                                     sizeClassPolicy);
+
+        uint64_t internalFragmentationUsage = 0;
+        for (auto _ : state) {
+            std::vector<std::unique_ptr<MemoryAllocation>> allocations;
+            for (const MemoryAllocationRequest& request : requests) {
+                auto allocation = allocator.TryAllocateMemory(request);
+                if (allocation == nullptr) {
+                    state.SkipWithError("Unable to allocate. Skipping.");
+                    break;
+                }
+                allocations.push_back(std::move(allocation));
+            }
+
+            internalFragmentationUsage = allocator.GetStats().InternalFragmentationUsage;
+
+            for (auto& allocation : allocations) {
+                allocator.DeallocateMemory(std::move(allocation));
+            }
+        }
+
+        state.counters["BackingAllocations"] =
+            benchmark::Counter(static_cast<double>(countingAllocator->GetAllocationCount()),
+                               benchmark::Counter::kAvgIterations);
+        state.counters["InternalFragmentationUsage"] =
+            static_cast<double>(internalFragmentationUsage);
+    }
+
+    static void GenerateParams(benchmark::internal::Benchmark* benchmark) {
+        static const uint64_t kSlabSize = GPGMM_MB_TO_BYTES(4);
+
+        benchmark->ArgNames({"slab", "min", "max", "count"});
+        benchmark->Args({kSlabSize, /*256B*/ 256, GPGMM_KB_TO_BYTES(4), 1024});
+        benchmark->Args({kSlabSize, GPGMM_KB_TO_BYTES(4), GPGMM_KB_TO_BYTES(64), 256});
+    }
+};
+
+BENCHMARK_DEFINE_F(DistinctSizeAllocationPerfTests, SlabCache_PerSize)(benchmark::State& state) {
+    Run(state, /*sizeClassesPerDoubling*/ 0);
+}
+
+BENCHMARK_DEFINE_F(DistinctSizeAllocationPerfTests, SlabCache_SizeClass)
+(benchmark::State& state) {
+    Run(state, /*sizeClassesPerDoubling*/ 8);
+}
+
+// Tests allocates many small buffers of a few sizes, like a frame would, then frees them all.
+// Compares the per-call path against TryAllocateMemoryBatch and DeallocateMemoryBatch.
+class BatchAllocationPerfTests : public MemoryAllocatorPerfTests {
+  public:
+    std::vector<MemoryAllocationRequest> CreateRequests(uint64_t count) {
+        static constexpr uint64_t kRequestSizes[] = {256, 512, GPGMM_KB_TO_BYTES(1),
+                                                     GPGMM_KB_TO_BYTES(4)};
+        std::vector<MemoryAllocationRequest> requests;
+        for (uint64_t i = 0; i < count; i++) {
+            requests.push_back(CreateBasicRequest(kRequestSizes[i % 4]));
+        }
+        return requests;
+    }
+
+    void PerCallStep(benchmark::State& state,
+                     MemoryAllocator* allocator,
+                     const std::vector<MemoryAllocationRequest>& requests) {
+        std::vector<std::unique_ptr<MemoryAllocation>> allocations;
+        for (const MemoryAllocationRequest& request : requests) {
+            auto allocation = allocator->TryAllocateMemory(request);
+            if (allocation == nullptr) {
+                state.SkipWithError("Unable to allocate. Skipping.");
+                return;
+            }
+            allocations.push_back(std::move(allocation));
+        }
+
+        for (auto& allocation : allocations) {
+            allocator->DeallocateMemory(std::move(allocation));
+        }
+    }
+
+    void BatchStep(benchmark::State& state,
+                   MemoryAllocator* allocator,
+                   const std::vector<MemoryAllocationRequest>& requests) {
+        std::vector<std::unique_ptr<MemoryAllocation>> allocations =
+            allocator->TryAllocateMemoryBatch(requests.data(), requests.size());
+        for (const auto& allocation : allocations) {
+            if (allocation == nullptr) {
+                state.SkipWithError("Unable to allocate. Skipping.");
+                break;
+            }
+        }
+
+        allocator->DeallocateMemoryBatch(std::move(allocations));
+    }
+
+    static void GenerateParams(benchmark::internal::Benchmark* benchmark) {
+        static const uint64_t kMemorySize = GPGMM_MB_TO_BYTES(4);
+
+        benchmark->ArgNames({"memory", "count"});
+        benchmark->Args({kMemorySize, 64});
+        benchmark->Args({kMemorySize, 256});
+        benchmark->Args({kMemorySize, 1024});
+    }
+};
+
+BENCHMARK_DEFINE_F(BatchAllocationPerfTests, SlabCache_PerCall)(benchmark::State& state) {
+    SlabCacheAllocator allocator(state.range(0), state.range(0), kMemoryAlignment,
+                                 /*slabFragmentationLimit*/ 1, /*allowPrefetch*/ false,
+                                 kDisableSlabGrowth, std::make_unique<DummyMemoryAllocator>());
+
+    const std::vector<MemoryAllocationRequest> requests = CreateRequests(state.range(1));
+    for (auto _ : state) {
+        PerCallStep(state, &allocator, requests);
+    }
+}
+
+BENCHMARK_DEFINE_F(BatchAllocationPerfTests, SlabCache_Batch)(benchmark::State& state) {
+    SlabCacheAllocator allocator(state.range(0), state.range(0), kMemoryAlignment,
+                                 /*slabFragmentationLimit*/ 1, /*allowPrefetch*/ false,
+                                 kDisableSlabGrowth, std::make_unique<DummyMemoryAllocator>());
+
+    const std::vector<MemoryAllocationRequest> requests = CreateRequests(state.range(1));
+    for (auto _ : state) {
+        BatchStep(state, &allocator, requests);
+    }
+}
+
+BENCHMARK_DEFINE_F(BatchAllocationPerfTests, BuddySystem_PerCall)(benchmark::State& state) {
+    BuddyMemoryAllocator allocator(GPGMM_GB_TO_BYTES(16), state.range(0), kMemoryAlignment,
+                                   std::make_unique<DummyMemoryAllocator>());
+
+    const std::vector<MemoryAllocationRequest> requests = CreateRequests(state.range(1));
+    for (auto _ : state) {
+        PerCallStep(state, &allocator, requests);
+    }
+}
+
+BENCHMARK_DEFINE_F(BatchAllocationPerfTests, BuddySystem_Batch)(benchmark::State& state) {
+    BuddyMemoryAllocator allocator(GPGMM_GB_TO_BYTES(16), state.range(0), kMemoryAlignment,
+                                   std::make_unique<DummyMemoryAllocator>());
+
+    const std::vector<MemoryAllocationRequest> requests = CreateRequests(state.range(1));
+    for (auto _ : state) {
+        BatchStep(state, &allocator, requests);
+    }
+}
+
+BENCHMARK_DEFINE_F(BatchAllocationPerfTests, SegmentedPool_PerCall)(benchmark::State& state) {
+    SegmentedMemoryAllocator allocator(std::make_unique<DummyMemoryAllocator>(), kMemoryAlignment);
+
+    const std::vector<MemoryAllocationRequest> requests = CreateRequests(state.range(1));
+    for (auto _ : state) {
+        PerCallStep(state, &allocator, requests);
+    }
+}
+
+BENCHMARK_DEFINE_F(BatchAllocationPerfTests, SegmentedPool_Batch)(benchmark::State& state) {
+    SegmentedMemoryAllocator allocator(std::make_unique<DummyMemoryAllocator>(), kMemoryAlignment);
+
+    const std::vector<MemoryAllocationRequest> requests = CreateRequests(state.range(1));
+    for (auto _ : state) {
+        BatchStep(state, &allocator, requests);
+    }
+}
+
+// Tests allocates a burst of blocks, doing some work between each, until many slabs are used
+// then frees them all. Backing memory is slow to create so slabs past the first stall unless
+// their memory was prefetched in time.
+class BurstAllocationPerfTests : public MemoryAllocatorPerfTests {
+  public:
+    void Run(benchmark::State& state, bool allowPrefetch) {
+        SlowMemoryAllocator memoryAllocator(std::chrono::microseconds(state.range(2)));
+        SlabMemoryAllocator allocator(state.range(1), state.range(0), state.range(0),
+                                      kMemoryAlignment, /*slabFragmentationLimit*/ 1,
+                                      allowPrefetch, kDisableSlabGrowth, &memoryAllocator);
+
+        const uint64_t blockCount = state.range(0) / state.range(1) * state.range(3);
+        const MemoryAllocationRequest request = CreateBasicRequest(state.range(1));
+
+        // Allocations waiting on memory for at-least a quarter of the latency were not covered
+        // by prefetching.
+        const auto stallDuration = std::chrono::microseconds(state.range(2) / 4);
+
+        uint64_t stallCount = 0;
+        std::chrono::steady_clock::duration allocateDuration = {};
+        for (auto _ : state) {
+            std::vector<std::unique_ptr<MemoryAllocation>> allocations;
+            for (uint64_t i = 0; i < blockCount; i++) {
+                const auto allocateStart = std::chrono::steady_clock::now();
+                auto allocation = allocator.TryAllocateMemory(request);
+                if (allocation == nullptr) {
+                    state.SkipWithError("Unable to allocate. Skipping.");
+                    return;
+                }
+                const auto allocateEnd = std::chrono::steady_clock::now();
+                if (allocateEnd - allocateStart >= stallDuration) {
+                    stallCount++;
+                }
+                allocateDuration += allocateEnd - allocateStart;
+                allocations.push_back(std::move(allocation));
+
+                // Busy-wait to simulate using the allocation.
+                const auto workEnd =
+                    std::chrono::steady_clock::now() + std::chrono::microseconds(state.range(4));
+                while (std::chrono::steady_clock::now() < workEnd) {
+                }
+            }
+
+            for (auto& allocation : allocations) {
+                allocator.DeallocateMemory(std::move(allocation));
+            }
+        }
+
+        const MemoryAllocatorStats stats = allocator.GetStats();
+        state.counters["PrefetchHits"] =
+            benchmark::Counter(static_cast<double>(stats.PrefetchedMemoryMissesEliminated),
+                               benchmark::Counter::kAvgIterations);
+        state.counters["PrefetchCoverage"] = std::max(
+            0.0, 1.0 - static_cast<double>(stallCount) /
+                           static_cast<double>(state.iterations() * state.range(3)));
+        state.counters["AllocateTimeUs"] = benchmark::Counter(
+            std::chrono::duration<double, std::micro>(allocateDuration).count(),
+            benchmark::Counter::kAvgIterations);
+        state.counters["PrefetchWasted"] =
+            benchmark::Counter(static_cast<double>(stats.PrefetchedMemoryWasted),
+                               benchmark::Counter::kAvgIterations);
+    }
+
+    static void GenerateParams(benchmark::internal::Benchmark* benchmark) {
+        static const uint64_t kSlabSize = GPGMM_KB_TO_BYTES(64);
+
+        benchmark->ArgNames({"slab", "size", "latency", "slabs", "work"});
+        benchmark->Args({kSlabSize, GPGMM_KB_TO_BYTES(4), /*us*/ 200, 16, /*us*/ 50});
+        benchmark->Args({kSlabSize, GPGMM_KB_TO_BYTES(4), /*us*/ 200, 16, /*us*/ 20});
+        benchmark->Args({kSlabSize, GPGMM_KB_TO_BYTES(4), /*us*/ 200, 16, /*us*/ 5});
+    }
+};
+
+BENCHMARK_DEFINE_F(BurstAllocationPerfTests, Slab_NoPrefetch)(benchmark::State& state) {
+    Run(state, /*allowPrefetch*/ false);
+}
+
+BENCHMARK_DEFINE_F(BurstAllocationPerfTests, Slab_Prefetch)(benchmark::State& state) {
+    Run(state, /*allowPrefetch*/ true);
+}
+
+// Tests allocates many slow to create memory objects asynchronously, doing some work once each
+// completes, like a streaming loader would, then frees them all. Compares waiting on an event per
+// request against waiting on a single completion queue.
+class StreamingAllocationPerfTests : public MemoryAllocatorPerfTests {
+  public:
+    // Busy-wait to simulate using the allocation.
+    void DoWork(benchmark::State& state) const {
+        const auto workEnd =
+            std::chrono::steady_clock::now() + std::chrono::microseconds(state.range(2));
+        while (std::chrono::steady_clock::now() < workEnd) {
+        }
+    }
+
+    // Same number of workers as the shared pool used by TryAllocateMemoryAsync.
+    static uint32_t GetNumOfWorkers() {
+        return std::max(1u, std::min(4u, std::thread::hardware_concurrency()));
+    }
+
+    static void GenerateParams(benchmark::internal::Benchmark* benchmark) {
+        benchmark->ArgNames({"count", "latency", "work"});
+        benchmark->Args({64, /*us*/ 0, /*us*/ 10});
+        benchmark->Args({256, /*us*/ 0, /*us*/ 10});
+        benchmark->Args({64, /*us*/ 50, /*us*/ 10});
+    }
+};
+
+BENCHMARK_DEFINE_F(StreamingAllocationPerfTests, EventPerRequest)(benchmark::State& state) {
+    SlowMemoryAllocator allocator(std::chrono::microseconds(state.range(1)));
+    const MemoryAllocationRequest request = CreateBasicRequest(GPGMM_KB_TO_BYTES(64));
+
+    for (auto _ : state) {
+        std::vector<std::shared_ptr<MemoryAllocationEvent>> events;
+        for (int i = 0; i < state.range(0); i++) {
+            events.push_back(allocator.TryAllocateMemoryAsync(request));
+        }
+
+        std::vector<std::unique_ptr<MemoryAllocation>> allocations;
+        for (auto& event : events) {
+            event->Wait();
+            allocations.push_back(event->AcquireAllocation());
+            DoWork(state);
+        }
+
+        for (auto& allocation : allocations) {
+            allocator.DeallocateMemory(std::move(allocation));
+        }
+    }
+}
+
+BENCHMARK_DEFINE_F(StreamingAllocationPerfTests, CompletionQueue)(benchmark::State& state) {
+    SlowMemoryAllocator allocator(std::chrono::microseconds(state.range(1)));
+    MemoryAllocationQueue queue(&allocator, GetNumOfWorkers());
+    const MemoryAllocationRequest request = CreateBasicRequest(GPGMM_KB_TO_BYTES(64));
+
+    for (auto _ : state) {
+        for (int i = 0; i < state.range(0); i++) {
+            queue.Submit(request, /*userData*/ i);
+        }
+
+        std::vector<std::unique_ptr<MemoryAllocation>> allocations;
+        MemoryAllocationCompletion completion = {};
+        while (queue.WaitForCompletion(&completion)) {
+            allocations.push_back(std::move(completion.Allocation));
+            DoWork(state);
+        }
+
+        for (auto& allocation : allocations) {
+            allocator.DeallocateMemory(std::move(allocation));
+        }
+    }
+}
+
+// Tests allocates the buffers of many meshes, interleaved like a loader would, then frees them all.
+// Compares the memory objects spanned by each mesh with and without group keys.
+class GroupedAllocationPerfTests : public MemoryAllocatorPerfTests {
+  public:
+    void Run(benchmark::State& state, MemoryAllocator* allocator, bool useGroupKeys) {
+        // Vertex, index and constant buffers of each mesh.
+        static constexpr uint64_t kRequestSizes[] = {GPGMM_KB_TO_BYTES(4), GPGMM_KB_TO_BYTES(1),
+                                                     256};
+
+        const uint64_t groupCount = state.range(1);
+        const uint64_t allocationsPerSize = state.range(2);
+
+        uint64_t groupMemoryCount = 0;
+        for (auto _ : state) {
+            std::vector<std::unique_ptr<MemoryAllocation>> allocations;
+            std::vector<std::set<IMemoryObject*>> groupMemories(groupCount);
+            for (uint64_t requestSize : kRequestSizes) {
+                for (uint64_t i = 0; i < allocationsPerSize; i++) {
+                    for (uint64_t group = 0; group < groupCount; group++) {
+                        MemoryAllocationRequest request = CreateBasicRequest(requestSize);
+                        request.GroupKey = (useGroupKeys) ? group + 1 : kNoGroupKey;
+
+                        std::unique_ptr<MemoryAllocation> allocation =
+                            allocator->TryAllocateMemory(request);
+                        if (allocation == nullptr) {
+                            state.SkipWithError("Unable to allocate. Skipping.");
+                            return;
+                        }
+                        groupMemories[group].insert(allocation->GetMemory());
+                        allocations.push_back(std::move(allocation));
+                    }
+                }
+            }
+
+            groupMemoryCount = 0;
+            for (const auto& memories : groupMemories) {
+                groupMemoryCount += memories.size();
+            }
+
+            for (auto& allocation : allocations) {
+                allocator->DeallocateMemory(std::move(allocation));
+            }
+        }
+
+        state.counters["MemoryPerGroup"] =
+            static_cast<double>(groupMemoryCount) / static_cast<double>(groupCount);
+    }
+
+    static void GenerateParams(benchmark::internal::Benchmark* benchmark) {
+        static const uint64_t kMemorySize = GPGMM_KB_TO_BYTES(64);
+
+        benchmark->ArgNames({"memory", "groups", "count"});
+        benchmark->Args({kMemorySize, 16, 4});
+        benchmark->Args({kMemorySize, 64, 4});
+    }
+};
+
+BENCHMARK_DEFINE_F(GroupedAllocationPerfTests, SlabCache)(benchmark::State& state) {
+    SlabCacheAllocator allocator(state.range(0), state.range(0), kMemoryAlignment,
+                                 /*slabFragmentationLimit*/ 1, /*allowPrefetch*/ false,
+                                 kDisableSlabGrowth, std::make_unique<DummyMemoryAllocator>());
+    Run(state, &allocator, /*useGroupKeys*/ false);
+}
+
+BENCHMARK_DEFINE_F(GroupedAllocationPerfTests, SlabCache_GroupKey)(benchmark::State& state) {
+    SlabCacheAllocator allocator(state.range(0), state.range(0), kMemoryAlignment,
+                                 /*slabFragmentationLimit*/ 1, /*allowPrefetch*/ false,
+                                 kDisableSlabGrowth, std::make_unique<DummyMemoryAllocator>());
+    Run(state, &allocator, /*useGroupKeys*/ true);
+}
+
+BENCHMARK_DEFINE_F(GroupedAllocationPerfTests, BuddySystem)(benchmark::State& state) {
+    BuddyMemoryAllocator allocator(GPGMM_GB_TO_BYTES(16), state.range(0), kMemoryAlignment,
+                                   std::make_unique<DummyMemoryAllocator>());
+    Run(state, &allocator, /*useGroupKeys*/ false);
+}
+
+BENCHMARK_DEFINE_F(GroupedAllocationPerfTests, BuddySystem_GroupKey)(benchmark::State& state) {
+    BuddyMemoryAllocator allocator(GPGMM_GB_TO_BYTES(16), state.range(0), kMemoryAlignment,
+                                   std::make_unique<DummyMemoryAllocator>());
+    Run(state, &allocator, /*useGroupKeys*/ true);
+}
+
+// Tests many threads allocating then freeing blocks of a single size from the same allocator.
+class MultiThreadedAllocationPerfTests : public MemoryAllocatorPerfTests {
+  public:
+    void SingleStep(benchmark::State& state,
+                    MemoryAllocator* allocator,
+                    const MemoryAllocationRequest& request) const {
+        std::vector<std::unique_ptr<MemoryAllocation>> allocations;
+        for (int i = 0; i < state.range(1); i++) {
+            auto allocation = allocator->TryAllocateMemory(request);
+            if (allocation == nullptr) {
+                state.SkipWithError("Unable to allocate. Skipping.");
+                return;
+            }
+            allocations.push_back(std::move(allocation));
+        }
+
+        for (auto& allocation : allocations) {
+            allocator->DeallocateMemory(std::move(allocation));
+        }
+    }
+
+    void RunSteps(benchmark::State& state) {
+        // The allocator is shared, so only the first thread creates and destroys it. Every
+        // thread waits for the others before entering and after leaving the loop.
+        for (auto _ : state) {
+            SingleStep(state, mAllocator.get(), CreateBasicRequest(state.range(0)));
+        }
+
+        state.SetItemsProcessed(state.iterations() * state.range(1));
+    }
+
+    static void GenerateParams(benchmark::internal::Benchmark* benchmark) {
+        static const uint64_t kNumOfAllocations = 64u;
+
+        benchmark->ArgNames({"size", "count"});
+        benchmark->Args({/*256B*/ 256, kNumOfAllocations});
+        benchmark->Args({GPGMM_KB_TO_BYTES(8), kNumOfAllocations});
+        benchmark->Args({GPGMM_KB_TO_BYTES(64), kNumOfAllocations});
+        benchmark->ThreadRange(1, 8);
+        benchmark->UseRealTime();
+    }
+
+  protected:
+    static constexpr uint64_t kMaxSlabSize = GPGMM_MB_TO_BYTES(4);
+    static constexpr uint64_t kMinSlabSize = GPGMM_KB_TO_BYTES(64);
+    static constexpr uint64_t kMagazineSize = 32;
+
+    static std::unique_ptr<MemoryAllocator> mAllocator;
+};
+
+std::unique_ptr<MemoryAllocator> MultiThreadedAllocationPerfTests::mAllocator;
+
+BENCHMARK_DEFINE_F(MultiThreadedAllocationPerfTests, SlabCache)(benchmark::State& state) {
+    if (state.thread_index() == 0) {
+        mAllocator = std::make_unique<SlabCacheAllocator>(
+            kMaxSlabSize, kMinSlabSize, kMemoryAlignment, /*slabFragmentationLimit*/ 1,
+            /*allowPrefetch*/ false, kDisableSlabGrowth, std::make_unique<DummyMemoryAllocator>());
+    }
+
+    RunSteps(state);
+
+    if (state.thread_index() == 0) {
+        mAllocator.reset();
+    }
+}
+
+BENCHMARK_DEFINE_F(MultiThreadedAllocationPerfTests, MagazineSlabCache)
+(benchmark::State& state) {
+    if (state.thread_index() == 0) {
+        mAllocator = std::make_unique<MagazineMemoryAllocator>(
+            kMagazineSize,
+            std::make_unique<SlabCacheAllocator>(
+                kMaxSlabSize, kMinSlabSize, kMemoryAlignment, /*slabFragmentationLimit*/ 1,
+                /*allowPrefetch*/ false, kDisableSlabGrowth,
+                std::make_unique<DummyMemoryAllocator>()));
+    }
+
+    RunSteps(state);
+
+    if (state.thread_index() == 0) {
+        mAllocator.reset();
+    }
+}
+
+// Tests posting tasks to a thread pool then waiting for them all to run.
+class ThreadPoolPerfTests : public MemoryAllocatorPerfTests {
+  public:
+    class NoopTask : public VoidCallback {
+      public:
+        void operator()() override {
+        }
+    };
+
+    // Allocates then frees memory the size of a slab, like a slab prefetch would.
+    class PrefetchTask : public VoidCallback {
+      public:
+        PrefetchTask(MemoryAllocator* allocator, const MemoryAllocationRequest& request)
+            : mAllocator(allocator), mRequest(request) {
+        }
+
+        void operator()() override {
+            mAllocator->DeallocateMemory(mAllocator->TryAllocateMemory(mRequest));
+        }
+
+      private:
+        MemoryAllocator* const mAllocator;
+        const MemoryAllocationRequest mRequest;
+    };
+
+    void SingleStep(benchmark::State& state,
+                    std::shared_ptr<ThreadPool> pool,
+                    std::shared_ptr<VoidCallback> task) const {
+        std::vector<std::shared_ptr<Event>> events;
+        for (int i = 0; i < state.range(0); i++) {
+            events.push_back(ThreadPool::PostTask(pool, task, "ThreadPoolPerfTests"));
+        }
+
+        for (auto& event : events) {
+            event->Wait();
+        }
+    }
+
+    static void GenerateParams(benchmark::internal::Benchmark* benchmark) {
+        benchmark->ArgNames({"count"});
+        benchmark->Arg(1);
+        benchmark->Arg(16);
+        benchmark->Arg(64);
+        benchmark->UseRealTime();
+    }
+};
+
+BENCHMARK_DEFINE_F(ThreadPoolPerfTests, ThreadPerTask_Noop)(benchmark::State& state) {
+    std::shared_ptr<ThreadPool> pool = ThreadPool::CreateThreadPerTask();
+    for (auto _ : state) {
+        SingleStep(state, pool, std::make_shared<NoopTask>());
+    }
+}
+
+BENCHMARK_DEFINE_F(ThreadPoolPerfTests, WorkerPool_Noop)(benchmark::State& state) {
+    std::shared_ptr<ThreadPool> pool = ThreadPool::GetOrCreateShared();
+    for (auto _ : state) {
+        SingleStep(state, pool, std::make_shared<NoopTask>());
+    }
+}
+
+BENCHMARK_DEFINE_F(ThreadPoolPerfTests, ThreadPerTask_Prefetch)(benchmark::State& state) {
+    std::shared_ptr<ThreadPool> pool = ThreadPool::CreateThreadPerTask();
+    DummyMemoryAllocator allocator;
+    for (auto _ : state) {
+        SingleStep(state, pool,
+                   std::make_shared<PrefetchTask>(&allocator,
+                                                  CreateBasicRequest(GPGMM_MB_TO_BYTES(4))));
+    }
+}
+
+BENCHMARK_DEFINE_F(ThreadPoolPerfTests, WorkerPool_Prefetch)(benchmark::State& state) {
+    std::shared_ptr<ThreadPool> pool = ThreadPool::GetOrCreateShared();
+    DummyMemoryAllocator allocator;
+    for (auto _ : state) {
+        SingleStep(state, pool,
+                   std::make_shared<PrefetchTask>(&allocator,
+                                                  CreateBasicRequest(GPGMM_MB_TO_BYTES(4))));
+    }
+}
+
 // Register each as benchmark
 BENCHMARK_REGISTER_F(SingleSizeAllocationPerfTests, SlabCache_Warm)
     ->Apply(SingleSizeAllocationPerfTests::GenerateParams);
@@ -153,10 +1141,89 @@ BENCHMARK_REGISTER_F(SingleSizeAllocationPerfTests, Slab)
     ->Apply(SingleSizeAllocationPerfTests::GenerateParams);
 BENCHMARK_REGISTER_F(SingleSizeAllocationPerfTests, BuddySystem)
     ->Apply(SingleSizeAllocationPerfTests::GenerateParams);
+BENCHMARK_REGISTER_F(SingleSizeAllocationPerfTests, TLSF)
+    ->Apply(SingleSizeAllocationPerfTests::GenerateParams);
 BENCHMARK_REGISTER_F(SingleSizeAllocationPerfTests, Standalone)
     ->Apply(SingleSizeAllocationPerfTests::GenerateParams);
 BENCHMARK_REGISTER_F(SingleSizeAllocationPerfTests, SegmentedPool)
     ->Apply(SingleSizeAllocationPerfTests::GenerateParams);
 
+BENCHMARK_REGISTER_F(ManySegmentsAllocationPerfTests, SegmentedPool)
+    ->Apply(ManySegmentsAllocationPerfTests::GenerateParams);
+BENCHMARK_REGISTER_F(ManySegmentsAllocationPerfTests, SegmentedPool_BestFit)
+    ->Apply(ManySegmentsAllocationPerfTests::GenerateParams);
+
+BENCHMARK_REGISTER_F(MixedSizeAllocationPerfTests, SlabCache)
+    ->Apply(MixedSizeAllocationPerfTests::GenerateParams);
+BENCHMARK_REGISTER_F(MixedSizeAllocationPerfTests, BuddySystem)
+    ->Apply(MixedSizeAllocationPerfTests::GenerateParams);
+BENCHMARK_REGISTER_F(MixedSizeAllocationPerfTests, TLSF)
+    ->Apply(MixedSizeAllocationPerfTests::GenerateParams);
+
+BENCHMARK_REGISTER_F(OscillatingAllocationPerfTests, Slab_NoRetention)
+    ->Apply(OscillatingAllocationPerfTests::GenerateParams);
+BENCHMARK_REGISTER_F(OscillatingAllocationPerfTests, Slab_Retention)
+    ->Apply(OscillatingAllocationPerfTests::GenerateParams);
+
+BENCHMARK_REGISTER_F(ReplayAllocationPerfTests, Slab_FixedGrowth)
+    ->Apply(ReplayAllocationPerfTests::GenerateParams);
+BENCHMARK_REGISTER_F(ReplayAllocationPerfTests, Slab_AdaptiveSize)
+    ->Apply(ReplayAllocationPerfTests::GenerateParams);
+
+BENCHMARK_REGISTER_F(DistinctSizeAllocationPerfTests, SlabCache_PerSize)
+    ->Apply(DistinctSizeAllocationPerfTests::GenerateParams);
+BENCHMARK_REGISTER_F(DistinctSizeAllocationPerfTests, SlabCache_SizeClass)
+    ->Apply(DistinctSizeAllocationPerfTests::GenerateParams);
+
+BENCHMARK_REGISTER_F(BatchAllocationPerfTests, SlabCache_PerCall)
+    ->Apply(BatchAllocationPerfTests::GenerateParams);
+BENCHMARK_REGISTER_F(BatchAllocationPerfTests, SlabCache_Batch)
+    ->Apply(BatchAllocationPerfTests::GenerateParams);
+BENCHMARK_REGISTER_F(BatchAllocationPerfTests, BuddySystem_PerCall)
+    ->Apply(BatchAllocationPerfTests::GenerateParams);
+BENCHMARK_REGISTER_F(BatchAllocationPerfTests, BuddySystem_Batch)
+    ->Apply(BatchAllocationPerfTests::GenerateParams);
+BENCHMARK_REGISTER_F(BatchAllocationPerfTests, SegmentedPool_PerCall)
+    ->Apply(BatchAllocationPerfTests::GenerateParams);
+BENCHMARK_REGISTER_F(BatchAllocationPerfTests, SegmentedPool_Batch)
+    ->Apply(BatchAllocationPerfTests::GenerateParams);
+
+BENCHMARK_REGISTER_F(BurstAllocationPerfTests, Slab_NoPrefetch)
+    ->Apply(BurstAllocationPerfTests::GenerateParams)
+    ->UseRealTime();
+BENCHMARK_REGISTER_F(BurstAllocationPerfTests, Slab_Prefetch)
+    ->Apply(BurstAllocationPerfTests::GenerateParams)
+    ->UseRealTime();
+
+BENCHMARK_REGISTER_F(StreamingAllocationPerfTests, EventPerRequest)
+    ->Apply(StreamingAllocationPerfTests::GenerateParams)
+    ->UseRealTime();
+BENCHMARK_REGISTER_F(StreamingAllocationPerfTests, CompletionQueue)
+    ->Apply(StreamingAllocationPerfTests::GenerateParams)
+    ->UseRealTime();
+
+BENCHMARK_REGISTER_F(GroupedAllocationPerfTests, SlabCache)
+    ->Apply(GroupedAllocationPerfTests::GenerateParams);
+BENCHMARK_REGISTER_F(GroupedAllocationPerfTests, SlabCache_GroupKey)
+    ->Apply(GroupedAllocationPerfTests::GenerateParams);
+BENCHMARK_REGISTER_F(GroupedAllocationPerfTests, BuddySystem)
+    ->Apply(GroupedAllocationPerfTests::GenerateParams);
+BENCHMARK_REGISTER_F(GroupedAllocationPerfTests, BuddySystem_GroupKey)
+    ->Apply(GroupedAllocationPerfTests::GenerateParams);
+
+BENCHMARK_REGISTER_F(MultiThreadedAllocationPerfTests, SlabCache)
+    ->Apply(MultiThreadedAllocationPerfTests::GenerateParams);
+BENCHMARK_REGISTER_F(MultiThreadedAllocationPerfTests, MagazineSlabCache)
+    ->Apply(MultiThreadedAllocationPerfTests::GenerateParams);
+
+BENCHMARK_REGISTER_F(ThreadPoolPerfTests, ThreadPerTask_Noop)
+    ->Apply(ThreadPoolPerfTests::GenerateParams);
+BENCHMARK_REGISTER_F(ThreadPoolPerfTests, WorkerPool_Noop)
+    ->Apply(ThreadPoolPerfTests::GenerateParams);
+BENCHMARK_REGISTER_F(ThreadPoolPerfTests, ThreadPerTask_Prefetch)
+    ->Apply(ThreadPoolPerfTests::GenerateParams);
+BENCHMARK_REGISTER_F(ThreadPoolPerfTests, WorkerPool_Prefetch)
+    ->Apply(ThreadPoolPerfTests::GenerateParams);
+
 // Run the benchmarks
 BENCHMARK_MAIN();
@@ -28,6 +28,13 @@ class DummyBuddyBlockAllocator {
         return mAllocator.TryAllocateBlock(requestSize, alignment);
     }
 
+    MemoryBlock* TryAllocateBlockInRange(uint64_t requestSize,
+                                         uint64_t rangeOffset,
+                                         uint64_t rangeSize,
+                                         uint64_t alignment = 1) {
+        return mAllocator.TryAllocateBlockInRange(requestSize, alignment, rangeOffset, rangeSize);
+    }
+
     void DeallocateBlock(MemoryBlock* block) {
         mAllocator.DeallocateBlock(block);
     }
@@ -288,7 +295,7 @@ TEST(BuddyBlockAllocatorTests, SameSizeVariousAlignment) {
     //                 --------------------------------
     //      1       16 |       S       |       S      |       S - split
     //                 --------------------------------       F - free
-    //      2       8  |   Aa  |   F   |  Ab   |  Ac  |       A - allocated
+    //      2       8  |   Aa  |   Ac  |  Ab   |  F   |       A - allocated
     //                 --------------------------------
     //
     DummyBuddyBlockAllocator allocator(32);
@@ -305,8 +312,8 @@ TEST(BuddyBlockAllocatorTests, SameSizeVariousAlignment) {
     // Check that we cannot fit another.
     ASSERT_EQ(allocator.TryAllocateBlock(8, 16), nullptr);
 
-    // Allocate Ac (zero splits and Ab's buddy is now the first free block).
-    ASSERT_EQ(allocator.TryAllocateBlock(8, 8)->Offset, 24u);
+    // Allocate Ac (zero splits and Aa's buddy is the lowest free block).
+    ASSERT_EQ(allocator.TryAllocateBlock(8, 8)->Offset, 8u);
 
     ASSERT_EQ(allocator.ComputeTotalNumOfFreeBlocksForTesting(), 1u);
 }
@@ -342,3 +349,48 @@ TEST(BuddyBlockAllocatorTests, VariousSizeSameAlignment) {
 
     ASSERT_EQ(allocator.ComputeTotalNumOfFreeBlocksForTesting(), 0u);
 }
+
+// Verify blocks are only allocated from within the range.
+TEST(BuddyBlockAllocatorTests, AllocateInRange) {
+    //  After one 8 byte allocation then 8 and 16 byte allocations within [0, 32) and [32, 64):
+    //
+    //  Level          --------------------------------
+    //      0       64 |               S              |
+    //                 --------------------------------
+    //      1       32 |       S       |       S      |       S - split
+    //                 --------------------------------       F - free
+    //      2       16 |   S   |  Ac   |   S   |  F   |       A - allocated
+    //                 --------------------------------
+    //      3       8  | Aa| F |       | Ab| Ad|      |
+    //                 --------------------------------
+    //
+    constexpr uint64_t maxBlockSize = 64;
+    DummyBuddyBlockAllocator allocator(maxBlockSize);
+
+    // Allocate block Aa.
+    ASSERT_EQ(allocator.TryAllocateBlock(8)->Offset, 0u);
+
+    // Allocate block Ab, even though lower free blocks exist outside the range.
+    ASSERT_EQ(allocator.TryAllocateBlockInRange(8, /*rangeOffset*/ 32, /*rangeSize*/ 32)->Offset,
+              32u);
+
+    // Allocate block Ac.
+    ASSERT_EQ(allocator.TryAllocateBlockInRange(16, /*rangeOffset*/ 0, /*rangeSize*/ 32)->Offset,
+              16u);
+
+    // Range is too small or has no free block large enough.
+    ASSERT_EQ(allocator.TryAllocateBlockInRange(64, /*rangeOffset*/ 0, /*rangeSize*/ 32), nullptr);
+    ASSERT_EQ(allocator.TryAllocateBlockInRange(16, /*rangeOffset*/ 0, /*rangeSize*/ 32), nullptr);
+
+    // Allocate block Ad.
+    ASSERT_EQ(allocator.TryAllocateBlockInRange(8, /*rangeOffset*/ 32, /*rangeSize*/ 32)->Offset,
+              40u);
+
+    // Blocks containing the range are split down to it.
+    DummyBuddyBlockAllocator emptyAllocator(maxBlockSize);
+    MemoryBlock* block =
+        emptyAllocator.TryAllocateBlockInRange(8, /*rangeOffset*/ 32, /*rangeSize*/ 32);
+    ASSERT_NE(block, nullptr);
+    ASSERT_EQ(block->Offset, 32u);
+    ASSERT_EQ(emptyAllocator.ComputeTotalNumOfFreeBlocksForTesting(), 3u);
+}
@@ -303,7 +303,7 @@ TEST_F(BuddyMemoryAllocatorTests, SameSizeVariousAlignment) {
     // max heap size  -> -------------------------------------------------------
     //                   |     H0     |     H1     |     H2     |              |
     //                   -------------------------------------------------------
-    //                   |  A1  |     |  A2  |     |  A3  |  A4 |              |
+    //                   |  A1  |  A4 |  A2  |     |  A3  |     |              |
     //                   -------------------------------------------------------
     //
     constexpr uint64_t maxBlockSize = 512;
@@ -346,18 +346,19 @@ TEST_F(BuddyMemoryAllocatorTests, SameSizeVariousAlignment) {
         allocator.TryAllocateMemory(CreateBasicRequest(64, 64));
     ASSERT_NE(allocation4, nullptr);
     ASSERT_EQ(allocation4->GetSize(), 64u);
-    ASSERT_EQ(allocation4->GetBlock()->Offset, 320u);
+    ASSERT_EQ(allocation4->GetBlock()->Offset, 64u);
     ASSERT_EQ(allocation4->GetOffset(), 64u);
     ASSERT_EQ(allocation4->GetMethod(), AllocationMethod::kSubAllocated);
 
+    // Lowest free block is always used first.
     ASSERT_EQ(allocator.GetStats().UsedMemoryCount, 3u);
-    ASSERT_EQ(allocation3->GetMemory(), allocation4->GetMemory());
+    ASSERT_EQ(allocation1->GetMemory(), allocation4->GetMemory());
 
     allocator.DeallocateMemory(std::move(allocation1));
-    ASSERT_EQ(allocator.GetStats().UsedMemoryCount, 2u);
+    ASSERT_EQ(allocator.GetStats().UsedMemoryCount, 3u);
 
     allocator.DeallocateMemory(std::move(allocation2));
-    ASSERT_EQ(allocator.GetStats().UsedMemoryCount, 1u);
+    ASSERT_EQ(allocator.GetStats().UsedMemoryCount, 2u);
 
     allocator.DeallocateMemory(std::move(allocation3));
     ASSERT_EQ(allocator.GetStats().UsedMemoryCount, 1u);
@@ -553,3 +554,139 @@ TEST_F(BuddyMemoryAllocatorTests, DestroyHeaps) {
 
     allocator.ReleaseMemory(kReleaseAllMemory);
 }
+
+// Verify a batch is allocated like the same requests made one at a time.
+TEST_F(BuddyMemoryAllocatorTests, AllocateBatch) {
+    constexpr uint64_t kMaxBlockSize = 512;
+    BuddyMemoryAllocator allocator(kMaxBlockSize, kDefaultMemorySize, kDefaultMemoryAlignment,
+                                   std::make_unique<DummyMemoryAllocator>());
+
+    std::vector<MemoryAllocationRequest> requests;
+    requests.push_back(CreateBasicRequest(kDefaultMemorySize / 2, 1));
+    requests.push_back(CreateBasicRequest(kDefaultMemorySize * 2, 1));  // Too large, fails.
+    requests.push_back(CreateBasicRequest(kDefaultMemorySize / 2, 1));
+    requests.push_back(CreateBasicRequest(kDefaultMemorySize, 1));
+
+    std::vector<std::unique_ptr<MemoryAllocation>> allocations =
+        allocator.TryAllocateMemoryBatch(requests.data(), requests.size());
+    ASSERT_EQ(allocations.size(), requests.size());
+
+    EXPECT_EQ(allocations[1], nullptr);
+    ASSERT_NE(allocations[0], nullptr);
+    ASSERT_NE(allocations[2], nullptr);
+    ASSERT_NE(allocations[3], nullptr);
+
+    // Both halves share the first memory.
+    EXPECT_EQ(allocations[0]->GetMemory(), allocations[2]->GetMemory());
+    EXPECT_EQ(allocations[0]->GetOffset(), 0u);
+    EXPECT_EQ(allocations[2]->GetOffset(), kDefaultMemorySize / 2);
+    EXPECT_NE(allocations[3]->GetMemory(), allocations[0]->GetMemory());
+
+    EXPECT_EQ(allocator.GetStats().UsedBlockCount, 3u);
+    EXPECT_EQ(allocator.GetStats().UsedMemoryCount, 2u);
+
+    allocator.DeallocateMemoryBatch(std::move(allocations));
+
+    EXPECT_EQ(allocator.GetStats().UsedBlockCount, 0u);
+    EXPECT_EQ(allocator.GetStats().UsedMemoryCount, 0u);
+}
+
+// Verify fragmentation is tracked on every allocate and de-allocate.
+TEST_F(BuddyMemoryAllocatorTests, FragmentationStats) {
+    constexpr uint64_t maxBlockSize = kDefaultMemorySize * 2;
+    BuddyMemoryAllocator allocator(maxBlockSize, kDefaultMemorySize, kDefaultMemoryAlignment,
+                                   std::make_unique<DummyMemoryAllocator>());
+
+    // 20 bytes is rounded up to a 32 byte block, leaving 64 and 32 byte free blocks in memory.
+    std::unique_ptr<MemoryAllocation> allocationA =
+        allocator.TryAllocateMemory(CreateBasicRequest(20, 1));
+    ASSERT_NE(allocationA, nullptr);
+    EXPECT_EQ(allocator.GetStats().InternalFragmentationUsage, 12u);
+    EXPECT_EQ(allocator.GetStats().ExternalFragmentationUsage, kDefaultMemorySize - 32);
+    EXPECT_EQ(allocator.GetStats().LargestFreeBlockSize, 64u);
+
+    // 5 bytes is rounded up to an 8 byte block.
+    std::unique_ptr<MemoryAllocation> allocationB =
+        allocator.TryAllocateMemory(CreateBasicRequest(5, 1));
+    ASSERT_NE(allocationB, nullptr);
+    EXPECT_EQ(allocator.GetStats().InternalFragmentationUsage, 12u + 3u);
+    EXPECT_EQ(allocator.GetStats().ExternalFragmentationUsage, kDefaultMemorySize - 32 - 8);
+    EXPECT_EQ(allocator.GetStats().LargestFreeBlockSize, 64u);
+
+    // Fully used memory is not fragmented.
+    std::unique_ptr<MemoryAllocation> allocationC =
+        allocator.TryAllocateMemory(CreateBasicRequest(100, 1));
+    ASSERT_NE(allocationC, nullptr);
+    EXPECT_NE(allocationC->GetMemory(), allocationA->GetMemory());
+    EXPECT_EQ(allocator.GetStats().InternalFragmentationUsage, 12u + 3u + 28u);
+    EXPECT_EQ(allocator.GetStats().ExternalFragmentationUsage, kDefaultMemorySize - 32 - 8);
+
+    allocator.DeallocateMemory(std::move(allocationA));
+    EXPECT_EQ(allocator.GetStats().InternalFragmentationUsage, 3u + 28u);
+    EXPECT_EQ(allocator.GetStats().ExternalFragmentationUsage, kDefaultMemorySize - 8);
+
+    allocator.DeallocateMemory(std::move(allocationB));
+    allocator.DeallocateMemory(std::move(allocationC));
+
+    EXPECT_EQ(allocator.GetStats().InternalFragmentationUsage, 0u);
+    EXPECT_EQ(allocator.GetStats().ExternalFragmentationUsage, 0u);
+    EXPECT_EQ(allocator.GetStats().LargestFreeBlockSize, 0u);
+}
+
+// Verify allocations of the same group are sub-allocated from the same memory.
+TEST_F(BuddyMemoryAllocatorTests, GroupKey) {
+    constexpr uint64_t maxBlockSize = kDefaultMemorySize * 4;
+    BuddyMemoryAllocator allocator(maxBlockSize, kDefaultMemorySize, kDefaultMemoryAlignment,
+                                   std::make_unique<DummyMemoryAllocator>());
+
+    // Fill the first memory so the group starts in the second.
+    std::unique_ptr<MemoryAllocation> allocation =
+        allocator.TryAllocateMemory(CreateBasicRequest(kDefaultMemorySize, 1));
+    ASSERT_NE(allocation, nullptr);
+
+    MemoryAllocationRequest request = CreateBasicRequest(kDefaultMemorySize / 2, 1);
+    request.GroupKey = 1;
+
+    std::unique_ptr<MemoryAllocation> allocationA = allocator.TryAllocateMemory(request);
+    ASSERT_NE(allocationA, nullptr);
+    EXPECT_EQ(allocator.GetStats().UsedMemoryCount, 2u);
+
+    // Release the first memory so it would be the lowest free block.
+    allocator.DeallocateMemory(std::move(allocation));
+    EXPECT_EQ(allocator.GetStats().UsedMemoryCount, 1u);
+
+    // The group re-uses its memory instead of creating memory at the lowest free block.
+    std::unique_ptr<MemoryAllocation> allocationB = allocator.TryAllocateMemory(request);
+    ASSERT_NE(allocationB, nullptr);
+    EXPECT_EQ(allocationB->GetMemory(), allocationA->GetMemory());
+    EXPECT_EQ(allocator.GetStats().UsedMemoryCount, 1u);
+    EXPECT_EQ(allocator.GetStats().GroupCount, 1u);
+    EXPECT_EQ(allocator.GetStats().GroupMemoryCount, 1u);
+
+    // Another group uses the lowest free block since the memory of the group is full.
+    MemoryAllocationRequest otherRequest = request;
+    otherRequest.GroupKey = 2;
+    std::unique_ptr<MemoryAllocation> allocationC = allocator.TryAllocateMemory(otherRequest);
+    ASSERT_NE(allocationC, nullptr);
+    EXPECT_NE(allocationC->GetMemory(), allocationA->GetMemory());
+    EXPECT_EQ(allocator.GetStats().GroupCount, 2u);
+    EXPECT_EQ(allocator.GetStats().GroupMemoryCount, 2u);
+
+    // Once its memory is full, the group spills into the memory of another group instead of
+    // creating memory.
+    std::unique_ptr<MemoryAllocation> allocationD = allocator.TryAllocateMemory(request);
+    ASSERT_NE(allocationD, nullptr);
+    EXPECT_EQ(allocationD->GetMemory(), allocationC->GetMemory());
+    EXPECT_EQ(allocator.GetStats().UsedMemoryCount, 2u);
+    EXPECT_EQ(allocator.GetStats().GroupMemoryCount, 3u);
+
+    allocator.DeallocateMemory(std::move(allocationA));
+    allocator.DeallocateMemory(std::move(allocationB));
+    allocator.DeallocateMemory(std::move(allocationC));
+    allocator.DeallocateMemory(std::move(allocationD));
+
+    EXPECT_EQ(allocator.GetStats().GroupCount, 0u);
+    EXPECT_EQ(allocator.GetStats().GroupMemoryCount, 0u);
+    EXPECT_EQ(allocator.GetStats().UsedMemoryCount, 0u);
+}
+
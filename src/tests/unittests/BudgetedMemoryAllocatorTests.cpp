@@ -0,0 +1,197 @@
+// Copyright 2022 The GPGMM Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include "gpgmm/common/BudgetedMemoryAllocator.h"
+#include "gpgmm/common/MemoryBudget.h"
+#include "gpgmm/common/PooledMemoryAllocator.h"
+#include "gpgmm/common/SlabMemoryAllocator.h"
+#include "tests/DummyMemoryAllocator.h"
+
+#include <vector>
+
+using namespace gpgmm;
+
+static constexpr uint64_t kDefaultMemorySize = 128u;
+static constexpr uint64_t kDefaultMemoryAlignment = 1u;
+
+class BudgetedMemoryAllocatorTests : public testing::Test {
+  public:
+    MemoryAllocationRequest CreateBasicRequest(uint64_t size, uint64_t alignment) {
+        MemoryAllocationRequest request = {};
+        request.SizeInBytes = size;
+        request.Alignment = alignment;
+        request.NeverAllocate = false;
+        request.AlwaysCacheSize = false;
+        request.AlwaysPrefetch = false;
+        request.AvailableForAllocation = kInvalidSize;
+        return request;
+    }
+};
+
+// Verify memory is created until the hard limit is reached.
+TEST_F(BudgetedMemoryAllocatorTests, HardLimit) {
+    std::shared_ptr<MemoryBudget> budget =
+        std::make_shared<MemoryBudget>(/*hardLimit*/ kDefaultMemorySize * 2);
+    BudgetedMemoryAllocator allocator(std::make_unique<DummyMemoryAllocator>(), budget);
+
+    std::unique_ptr<MemoryAllocation> firstAllocation = allocator.TryAllocateMemory(
+        CreateBasicRequest(kDefaultMemorySize, kDefaultMemoryAlignment));
+    ASSERT_NE(firstAllocation, nullptr);
+    EXPECT_EQ(firstAllocation->GetSize(), kDefaultMemorySize);
+    EXPECT_EQ(budget->GetUsage(), kDefaultMemorySize);
+    EXPECT_EQ(allocator.GetAvailableForAllocation(), kDefaultMemorySize);
+
+    std::unique_ptr<MemoryAllocation> secondAllocation = allocator.TryAllocateMemory(
+        CreateBasicRequest(kDefaultMemorySize, kDefaultMemoryAlignment));
+    ASSERT_NE(secondAllocation, nullptr);
+    EXPECT_EQ(allocator.GetAvailableForAllocation(), 0u);
+
+    EXPECT_EQ(allocator.TryAllocateMemory(CreateBasicRequest(1, kDefaultMemoryAlignment)),
+              nullptr);
+    EXPECT_EQ(allocator.GetStats().UsedMemoryCount, 2u);
+
+    allocator.DeallocateMemory(std::move(firstAllocation));
+    EXPECT_EQ(budget->GetUsage(), kDefaultMemorySize);
+
+    allocator.DeallocateMemory(std::move(secondAllocation));
+    EXPECT_EQ(budget->GetUsage(), 0u);
+    EXPECT_EQ(allocator.GetStats().UsedMemoryCount, 0u);
+}
+
+// Verify a failed allocation does not use the budget.
+TEST_F(BudgetedMemoryAllocatorTests, AllocationFailed) {
+    std::shared_ptr<MemoryBudget> budget = std::make_shared<MemoryBudget>();
+    BudgetedMemoryAllocator allocator(std::make_unique<DummyMemoryAllocator>(), budget);
+
+    MemoryAllocationRequest request =
+        CreateBasicRequest(kDefaultMemorySize, kDefaultMemoryAlignment);
+    request.NeverAllocate = true;
+    EXPECT_EQ(allocator.TryAllocateMemory(request), nullptr);
+    EXPECT_EQ(budget->GetUsage(), 0u);
+}
+
+// Verify allocators sharing a budget limit each other.
+TEST_F(BudgetedMemoryAllocatorTests, SharedBudget) {
+    std::shared_ptr<MemoryBudget> budget =
+        std::make_shared<MemoryBudget>(/*hardLimit*/ kDefaultMemorySize);
+    BudgetedMemoryAllocator firstAllocator(std::make_unique<DummyMemoryAllocator>(), budget);
+    BudgetedMemoryAllocator secondAllocator(std::make_unique<DummyMemoryAllocator>(), budget);
+
+    std::unique_ptr<MemoryAllocation> allocation = firstAllocator.TryAllocateMemory(
+        CreateBasicRequest(kDefaultMemorySize, kDefaultMemoryAlignment));
+    ASSERT_NE(allocation, nullptr);
+
+    EXPECT_EQ(secondAllocator.GetAvailableForAllocation(), 0u);
+    EXPECT_EQ(secondAllocator.TryAllocateMemory(
+                  CreateBasicRequest(kDefaultMemorySize, kDefaultMemoryAlignment)),
+              nullptr);
+
+    firstAllocator.DeallocateMemory(std::move(allocation));
+
+    allocation = secondAllocator.TryAllocateMemory(
+        CreateBasicRequest(kDefaultMemorySize, kDefaultMemoryAlignment));
+    ASSERT_NE(allocation, nullptr);
+    secondAllocator.DeallocateMemory(std::move(allocation));
+}
+
+// Verify pooled memory counts against the budget until released by the over-budget callback.
+TEST_F(BudgetedMemoryAllocatorTests, ReleasePooledMemoryOverBudget) {
+    std::shared_ptr<MemoryBudget> budget = std::make_shared<MemoryBudget>();
+    PooledMemoryAllocator allocator(
+        kDefaultMemorySize, kDefaultMemoryAlignment,
+        std::make_unique<BudgetedMemoryAllocator>(std::make_unique<DummyMemoryAllocator>(),
+                                                  budget));
+
+    budget->AddOverBudgetCallback(
+        [&](uint64_t bytesOverBudget) { allocator.ReleaseMemory(bytesOverBudget); });
+
+    std::vector<std::unique_ptr<MemoryAllocation>> allocations;
+    for (uint64_t i = 0; i < 3; i++) {
+        allocations.push_back(allocator.TryAllocateMemory(
+            CreateBasicRequest(kDefaultMemorySize, kDefaultMemoryAlignment)));
+        ASSERT_NE(allocations.back(), nullptr);
+    }
+
+    for (auto& allocation : allocations) {
+        allocator.DeallocateMemory(std::move(allocation));
+    }
+
+    EXPECT_EQ(budget->GetUsage(), kDefaultMemorySize * 3);
+
+    budget->SetLimits(/*hardLimit*/ kInvalidSize, /*softLimit*/ kDefaultMemorySize * 2);
+    budget->WaitForOverBudgetCallbacks();
+
+    EXPECT_EQ(budget->GetUsage(), kDefaultMemorySize * 2);
+    EXPECT_EQ(allocator.GetStats().FreeMemoryUsage, kDefaultMemorySize * 2);
+}
+
+// Verify slabs are sized to stay under the budget shared with the memory allocator.
+TEST_F(BudgetedMemoryAllocatorTests, SlabUnderBudget) {
+    constexpr uint64_t kHardLimit = kDefaultMemorySize * 3;
+    std::shared_ptr<MemoryBudget> budget = std::make_shared<MemoryBudget>(kHardLimit);
+
+    SlabCacheAllocator allocator(
+        /*maxSlabSize*/ kDefaultMemorySize * 4, kDefaultMemorySize, kDefaultMemoryAlignment,
+        /*slabFragmentationLimit*/ 0.125, /*allowSlabPrefetch*/ false, /*slabGrowthFactor*/ 2,
+        std::make_unique<BudgetedMemoryAllocator>(std::make_unique<DummyMemoryAllocator>(),
+                                                  budget));
+
+    // Growing slabs eventually exceed the budget, which must fail instead of creating them.
+    std::vector<std::unique_ptr<MemoryAllocation>> allocations;
+    while (true) {
+        std::unique_ptr<MemoryAllocation> allocation =
+            allocator.TryAllocateMemory(CreateBasicRequest(32, kDefaultMemoryAlignment));
+        if (allocation == nullptr) {
+            break;
+        }
+        allocations.push_back(std::move(allocation));
+    }
+
+    EXPECT_GT(allocations.size(), 0u);
+    EXPECT_LE(budget->GetUsage(), kHardLimit);
+    EXPECT_EQ(budget->GetUsage(), allocations.size() * 32);
+
+    for (auto& allocation : allocations) {
+        allocator.DeallocateMemory(std::move(allocation));
+    }
+}
+
+// Verify slabs keep getting created past the soft limit.
+TEST_F(BudgetedMemoryAllocatorTests, SlabOverSoftLimit) {
+    constexpr uint64_t kSoftLimit = kDefaultMemorySize;
+    std::shared_ptr<MemoryBudget> budget =
+        std::make_shared<MemoryBudget>(/*hardLimit*/ kInvalidSize, kSoftLimit);
+
+    SlabCacheAllocator allocator(
+        /*maxSlabSize*/ kDefaultMemorySize, kDefaultMemorySize, kDefaultMemoryAlignment,
+        /*slabFragmentationLimit*/ 0.125, /*allowSlabPrefetch*/ false, /*slabGrowthFactor*/ 1,
+        std::make_unique<BudgetedMemoryAllocator>(std::make_unique<DummyMemoryAllocator>(),
+                                                  budget));
+
+    std::vector<std::unique_ptr<MemoryAllocation>> allocations;
+    for (uint64_t i = 0; i < (kSoftLimit * 3) / 32; i++) {
+        allocations.push_back(
+            allocator.TryAllocateMemory(CreateBasicRequest(32, kDefaultMemoryAlignment)));
+        ASSERT_NE(allocations.back(), nullptr);
+    }
+
+    EXPECT_GT(budget->GetUsage(), kSoftLimit);
+    budget->WaitForOverBudgetCallbacks();
+
+    for (auto& allocation : allocations) {
+        allocator.DeallocateMemory(std::move(allocation));
+    }
+}
@@ -0,0 +1,153 @@
+// Copyright 2022 The GPGMM Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include "gpgmm/common/DeferredMemoryAllocator.h"
+#include "gpgmm/common/SlabMemoryAllocator.h"
+#include "tests/DummyMemoryAllocator.h"
+
+#include <thread>
+#include <vector>
+
+using namespace gpgmm;
+
+class DeferredMemoryAllocatorTests : public testing::Test {
+  public:
+    MemoryAllocationRequest CreateBasicRequest(uint64_t size, uint64_t alignment) {
+        MemoryAllocationRequest request = {};
+        request.SizeInBytes = size;
+        request.Alignment = alignment;
+        request.NeverAllocate = false;
+        request.AlwaysCacheSize = false;
+        request.AlwaysPrefetch = false;
+        request.AvailableForAllocation = kInvalidSize;
+        return request;
+    }
+
+    std::unique_ptr<DeferredMemoryAllocator> CreateAllocator() {
+        return std::make_unique<DeferredMemoryAllocator>(std::make_unique<SlabCacheAllocator>(
+            kDefaultSlabSize, kDefaultSlabSize, kDefaultSlabAlignment,
+            kDefaultSlabFragmentationLimit, kNoSlabPrefetchAllowed, kDisableSlabGrowth,
+            std::make_unique<DummyMemoryAllocator>()));
+    }
+
+    static constexpr uint64_t kDefaultSlabSize = 256u;
+    static constexpr uint64_t kDefaultSlabAlignment = 1u;
+    static constexpr double kDefaultSlabFragmentationLimit = 0.125;
+    static constexpr double kDisableSlabGrowth = 1.0;
+    static constexpr bool kNoSlabPrefetchAllowed = false;
+};
+
+// Verify a de-allocation stays pending until flushed.
+TEST_F(DeferredMemoryAllocatorTests, FlushDeferredFrees) {
+    constexpr uint64_t kBlockSize = 16;
+    std::unique_ptr<DeferredMemoryAllocator> allocator = CreateAllocator();
+
+    std::unique_ptr<MemoryAllocation> allocation =
+        allocator->TryAllocateMemory(CreateBasicRequest(kBlockSize, 1));
+    ASSERT_NE(allocation, nullptr);
+    EXPECT_EQ(allocation->GetAllocator(), allocator.get());
+
+    allocator->DeallocateMemory(std::move(allocation));
+
+    // Pending frees still hold memory.
+    EXPECT_EQ(allocator->GetStats().PendingFreeCount, 1u);
+    EXPECT_EQ(allocator->GetStats().PendingFreeUsage, kBlockSize);
+    EXPECT_EQ(allocator->GetStats().UsedBlockCount, 1u);
+    EXPECT_EQ(allocator->GetStats().UsedMemoryCount, 1u);
+
+    EXPECT_EQ(allocator->FlushDeferredFrees(), 1u);
+
+    EXPECT_EQ(allocator->GetStats().PendingFreeCount, 0u);
+    EXPECT_EQ(allocator->GetStats().PendingFreeUsage, 0u);
+    EXPECT_EQ(allocator->GetStats().UsedBlockCount, 0u);
+    EXPECT_EQ(allocator->GetStats().UsedMemoryCount, 0u);
+
+    // Nothing left to flush.
+    EXPECT_EQ(allocator->FlushDeferredFrees(), 0u);
+}
+
+// Verify the next allocation completes pending frees before allocating.
+TEST_F(DeferredMemoryAllocatorTests, FlushOnAllocate) {
+    constexpr uint64_t kBlockSize = 16;
+    std::unique_ptr<DeferredMemoryAllocator> allocator = CreateAllocator();
+
+    std::vector<MemoryAllocationRequest> requests(4, CreateBasicRequest(kBlockSize, 1));
+    std::vector<std::unique_ptr<MemoryAllocation>> allocations =
+        allocator->TryAllocateMemoryBatch(requests.data(), requests.size());
+
+    const IMemoryObject* memory = allocations.front()->GetMemory();
+    const uint64_t offset = allocations.front()->GetOffset();
+
+    allocator->DeallocateMemoryBatch(std::move(allocations));
+    EXPECT_EQ(allocator->GetStats().PendingFreeCount, requests.size());
+    EXPECT_EQ(allocator->GetStats().UsedBlockCount, requests.size());
+
+    std::unique_ptr<MemoryAllocation> allocation =
+        allocator->TryAllocateMemory(CreateBasicRequest(kBlockSize, 1));
+    ASSERT_NE(allocation, nullptr);
+
+    // The freed block is re-used.
+    EXPECT_EQ(allocation->GetMemory(), memory);
+    EXPECT_EQ(allocation->GetOffset(), offset);
+
+    EXPECT_EQ(allocator->GetStats().PendingFreeCount, 0u);
+    EXPECT_EQ(allocator->GetStats().UsedBlockCount, 1u);
+
+    allocator->DeallocateMemory(std::move(allocation));
+    allocator->ReleaseMemory();
+
+    EXPECT_EQ(allocator->GetStats().PendingFreeCount, 0u);
+    EXPECT_EQ(allocator->GetStats().UsedMemoryUsage, 0u);
+}
+
+// Verify de-allocations from many threads are all completed by a single flush.
+TEST_F(DeferredMemoryAllocatorTests, DeallocateManyThreaded) {
+    constexpr uint64_t kThreadCount = 8;
+    constexpr uint64_t kAllocationsPerThread = 64;
+    constexpr uint64_t kBlockSize = 16;
+    std::unique_ptr<DeferredMemoryAllocator> allocator = CreateAllocator();
+
+    std::vector<std::vector<std::unique_ptr<MemoryAllocation>>> allocationsPerThread(
+        kThreadCount);
+    for (auto& allocations : allocationsPerThread) {
+        for (uint64_t i = 0; i < kAllocationsPerThread; i++) {
+            allocations.push_back(allocator->TryAllocateMemory(CreateBasicRequest(kBlockSize, 1)));
+            ASSERT_NE(allocations.back(), nullptr);
+        }
+    }
+
+    std::vector<std::thread> threads(kThreadCount);
+    for (uint64_t i = 0; i < threads.size(); i++) {
+        threads[i] = std::thread([&, i]() {
+            for (auto& allocation : allocationsPerThread[i]) {
+                allocator->DeallocateMemory(std::move(allocation));
+            }
+        });
+    }
+
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(allocator->GetStats().PendingFreeCount, kThreadCount * kAllocationsPerThread);
+    EXPECT_EQ(allocator->GetStats().PendingFreeUsage,
+              kThreadCount * kAllocationsPerThread * kBlockSize);
+
+    EXPECT_EQ(allocator->FlushDeferredFrees(), kThreadCount * kAllocationsPerThread);
+
+    EXPECT_EQ(allocator->GetStats().UsedBlockCount, 0u);
+    EXPECT_EQ(allocator->GetStats().UsedMemoryUsage, 0u);
+}
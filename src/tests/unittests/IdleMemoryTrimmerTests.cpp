@@ -0,0 +1,181 @@
+// Copyright 2022 The GPGMM Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <gtest/gtest.h>
+
+#include "gpgmm/common/IdleMemoryTrimmer.h"
+#include "tests/DummyMemoryAllocator.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <thread>
+
+using namespace gpgmm;
+
+static constexpr uint64_t kDefaultStepSize = 4u;
+
+// Retains an arbitrary amount of memory that only gets released on request.
+class RetainingMemoryAllocator : public DummyMemoryAllocator {
+  public:
+    void RetainMemory(uint64_t bytes) {
+        mRetainedBytes += bytes;
+    }
+
+    uint64_t ReleaseMemory(uint64_t bytesToRelease) override {
+        mReleaseCount++;
+        mMaxBytesToRelease = std::max(mMaxBytesToRelease.load(), bytesToRelease);
+
+        const uint64_t bytesReleased = std::min(bytesToRelease, mRetainedBytes.load());
+        mRetainedBytes -= bytesReleased;
+        return bytesReleased;
+    }
+
+    uint64_t GetRetainedBytes() const {
+        return mRetainedBytes;
+    }
+
+    uint64_t GetReleaseCount() const {
+        return mReleaseCount;
+    }
+
+    uint64_t GetMaxBytesToRelease() const {
+        return mMaxBytesToRelease;
+    }
+
+  private:
+    std::atomic<uint64_t> mRetainedBytes = {0};
+    std::atomic<uint64_t> mReleaseCount = {0};
+    std::atomic<uint64_t> mMaxBytesToRelease = {0};
+};
+
+class IdleMemoryTrimmerTests : public testing::Test {
+  public:
+    IdleMemoryTrimPolicy CreateBasicPolicy(std::chrono::steady_clock::duration idleInterval) {
+        IdleMemoryTrimPolicy policy = {};
+        policy.IdleInterval = idleInterval;
+        policy.MaxBytesPerStep = kDefaultStepSize;
+        policy.StepInterval = std::chrono::milliseconds(1);
+        return policy;
+    }
+
+    // Returns false if |condition| did not hold in time.
+    bool WaitUntil(std::function<bool()> condition) {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (!condition()) {
+            if (std::chrono::steady_clock::now() > deadline) {
+                return false;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return true;
+    }
+};
+
+// Verify memory gets released in bounded steps once idle.
+TEST_F(IdleMemoryTrimmerTests, TrimWhenIdle) {
+    RetainingMemoryAllocator allocator;
+    allocator.RetainMemory(kDefaultStepSize * 2 + 1);
+
+    IdleMemoryTrimmer trimmer(&allocator, CreateBasicPolicy(std::chrono::milliseconds(10)));
+
+    ASSERT_TRUE(WaitUntil([&] { return trimmer.GetBytesReleased() == kDefaultStepSize * 2 + 1; }));
+    EXPECT_EQ(allocator.GetRetainedBytes(), 0u);
+    EXPECT_EQ(allocator.GetReleaseCount(), 3u);
+    EXPECT_EQ(allocator.GetMaxBytesToRelease(), kDefaultStepSize);
+    EXPECT_EQ(trimmer.GetTrimPassCount(), 1u);
+}
+
+// Verify nothing gets released while allocation activity continues.
+TEST_F(IdleMemoryTrimmerTests, NoTrimWhenActive) {
+    RetainingMemoryAllocator allocator;
+    allocator.RetainMemory(kDefaultStepSize);
+
+    IdleMemoryTrimmer trimmer(&allocator, CreateBasicPolicy(std::chrono::seconds(5)));
+
+    const auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(100);
+    while (std::chrono::steady_clock::now() < end) {
+        trimmer.RecordActivity();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    EXPECT_EQ(trimmer.GetTrimPassCount(), 0u);
+    EXPECT_EQ(allocator.GetReleaseCount(), 0u);
+    EXPECT_EQ(allocator.GetRetainedBytes(), kDefaultStepSize);
+}
+
+// Verify a pass stops once allocation activity resumes.
+TEST_F(IdleMemoryTrimmerTests, StopWhenActive) {
+    RetainingMemoryAllocator allocator;
+    allocator.RetainMemory(kDefaultStepSize * 1000);
+
+    IdleMemoryTrimPolicy policy = CreateBasicPolicy(std::chrono::milliseconds(10));
+    policy.StepInterval = std::chrono::milliseconds(5);
+
+    IdleMemoryTrimmer trimmer(&allocator, policy);
+    ASSERT_TRUE(WaitUntil([&] { return trimmer.GetBytesReleased() > 0; }));
+
+    // Activity never stops, so the pass cannot resume.
+    std::atomic<bool> isDone = {false};
+    std::thread activity([&] {
+        while (!isDone) {
+            trimmer.RecordActivity();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    });
+
+    // At most one step could already be in progress.
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    const uint64_t bytesReleased = trimmer.GetBytesReleased();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    EXPECT_LE(trimmer.GetBytesReleased(), bytesReleased + kDefaultStepSize);
+    EXPECT_GT(allocator.GetRetainedBytes(), 0u);
+
+    isDone = true;
+    activity.join();
+}
+
+// Verify trimming resumes after the next idle period.
+TEST_F(IdleMemoryTrimmerTests, TrimAgainWhenIdle) {
+    RetainingMemoryAllocator allocator;
+    allocator.RetainMemory(kDefaultStepSize);
+
+    IdleMemoryTrimmer trimmer(&allocator, CreateBasicPolicy(std::chrono::milliseconds(10)));
+    ASSERT_TRUE(WaitUntil([&] { return allocator.GetRetainedBytes() == 0; }));
+    ASSERT_TRUE(WaitUntil([&] { return trimmer.GetBytesReleased() == kDefaultStepSize; }));
+
+    allocator.RetainMemory(kDefaultStepSize);
+    trimmer.RecordActivity();
+
+    ASSERT_TRUE(WaitUntil([&] { return trimmer.GetBytesReleased() == kDefaultStepSize * 2; }));
+    EXPECT_EQ(allocator.GetRetainedBytes(), 0u);
+    EXPECT_EQ(trimmer.GetTrimPassCount(), 2u);
+}
+
+// Verify the trimmer can be destroyed while a pass is in progress.
+TEST_F(IdleMemoryTrimmerTests, DestroyWhileTrimming) {
+    RetainingMemoryAllocator allocator;
+    allocator.RetainMemory(kDefaultStepSize * 1000);
+
+    {
+        IdleMemoryTrimmer trimmer(&allocator, CreateBasicPolicy(std::chrono::milliseconds(1)));
+        ASSERT_TRUE(WaitUntil([&] { return trimmer.GetBytesReleased() > 0; }));
+    }
+
+    const uint64_t retainedBytes = allocator.GetRetainedBytes();
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    EXPECT_EQ(allocator.GetRetainedBytes(), retainedBytes);
+}
@@ -0,0 +1,289 @@
+// Copyright 2022 The GPGMM Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include "gpgmm/common/MagazineMemoryAllocator.h"
+#include "gpgmm/common/SlabMemoryAllocator.h"
+#include "tests/DummyMemoryAllocator.h"
+
+#include <thread>
+#include <vector>
+
+using namespace gpgmm;
+
+class MagazineMemoryAllocatorTests : public testing::Test {
+  public:
+    MemoryAllocationRequest CreateBasicRequest(uint64_t size,
+                                               uint64_t alignment,
+                                               bool neverAllocate = false) {
+        MemoryAllocationRequest request = {};
+        request.SizeInBytes = size;
+        request.Alignment = alignment;
+        request.NeverAllocate = neverAllocate;
+        request.AlwaysCacheSize = false;
+        request.AlwaysPrefetch = false;
+        request.AvailableForAllocation = kInvalidSize;
+        return request;
+    }
+
+    std::unique_ptr<MagazineMemoryAllocator> CreateAllocator(uint64_t magazineSize) {
+        return std::make_unique<MagazineMemoryAllocator>(
+            magazineSize,
+            std::make_unique<SlabCacheAllocator>(
+                kDefaultSlabSize, kDefaultSlabSize, kDefaultSlabAlignment,
+                kDefaultSlabFragmentationLimit, kNoSlabPrefetchAllowed, kDisableSlabGrowth,
+                std::make_unique<DummyMemoryAllocator>()));
+    }
+
+    static constexpr uint64_t kDefaultSlabSize = 256u;
+    static constexpr uint64_t kDefaultSlabAlignment = 1u;
+    static constexpr double kDefaultSlabFragmentationLimit = 0.125;
+    static constexpr double kDisableSlabGrowth = 1.0;
+    static constexpr bool kNoSlabPrefetchAllowed = false;
+};
+
+// Verify a de-allocated block is cached and re-used by the next allocation of the same size.
+TEST_F(MagazineMemoryAllocatorTests, SingleSize) {
+    constexpr uint64_t kBlockSize = 16;
+    std::unique_ptr<MagazineMemoryAllocator> allocator = CreateAllocator(/*magazineSize*/ 4);
+
+    std::unique_ptr<MemoryAllocation> allocation =
+        allocator->TryAllocateMemory(CreateBasicRequest(kBlockSize, 1));
+    ASSERT_NE(allocation, nullptr);
+    EXPECT_EQ(allocation->GetSize(), kBlockSize);
+    EXPECT_EQ(allocation->GetAllocator(), allocator.get());
+
+    const IMemoryObject* memory = allocation->GetMemory();
+    const uint64_t offset = allocation->GetOffset();
+
+    allocator->DeallocateMemory(std::move(allocation));
+
+    // Cached block must not be counted as used.
+    EXPECT_EQ(allocator->GetStats().UsedBlockCount, 0u);
+    EXPECT_EQ(allocator->GetStats().UsedBlockUsage, 0u);
+    EXPECT_EQ(allocator->GetStats().UsedMemoryCount, 1u);
+
+    allocation = allocator->TryAllocateMemory(CreateBasicRequest(kBlockSize, 1));
+    ASSERT_NE(allocation, nullptr);
+    EXPECT_EQ(allocation->GetMemory(), memory);
+    EXPECT_EQ(allocation->GetOffset(), offset);
+
+    allocator->DeallocateMemory(std::move(allocation));
+}
+
+// Verify a de-allocated block is re-used by the next allocation of the same size class.
+TEST_F(MagazineMemoryAllocatorTests, SizeClass) {
+    SlabSizeClassPolicy sizeClassPolicy = {};
+    sizeClassPolicy.SizeClassesPerDoubling = 4;
+
+    MagazineMemoryAllocator allocator(
+        /*magazineSize*/ 4,
+        std::make_unique<SlabCacheAllocator>(
+            kDefaultSlabSize, kDefaultSlabSize, kDefaultSlabAlignment,
+            kDefaultSlabFragmentationLimit, kNoSlabPrefetchAllowed, kDisableSlabGrowth,
+            std::make_unique<DummyMemoryAllocator>(), /*retentionPolicy*/ SlabRetentionPolicy{},
+            /*allowAdaptiveSlabSize*/ false, sizeClassPolicy));
+
+    // Both sizes are rounded-up to the same size class of 20 bytes.
+    std::unique_ptr<MemoryAllocation> allocation =
+        allocator.TryAllocateMemory(CreateBasicRequest(17, 1));
+    ASSERT_NE(allocation, nullptr);
+    EXPECT_EQ(allocation->GetSize(), 20u);
+
+    const IMemoryObject* memory = allocation->GetMemory();
+    const uint64_t offset = allocation->GetOffset();
+
+    allocator.DeallocateMemory(std::move(allocation));
+
+    allocation = allocator.TryAllocateMemory(CreateBasicRequest(19, 1));
+    ASSERT_NE(allocation, nullptr);
+    EXPECT_EQ(allocation->GetMemory(), memory);
+    EXPECT_EQ(allocation->GetOffset(), offset);
+
+    allocator.DeallocateMemory(std::move(allocation));
+}
+
+// Verify allocators created one after another on the same thread each get their own cache.
+TEST_F(MagazineMemoryAllocatorTests, RecreateAllocator) {
+    constexpr uint64_t kBlockSize = 16;
+    for (uint32_t i = 0; i < 4; i++) {
+        std::unique_ptr<MagazineMemoryAllocator> allocator = CreateAllocator(/*magazineSize*/ 4);
+
+        std::unique_ptr<MemoryAllocation> allocation =
+            allocator->TryAllocateMemory(CreateBasicRequest(kBlockSize, 1));
+        ASSERT_NE(allocation, nullptr);
+        EXPECT_EQ(allocation->GetAllocator(), allocator.get());
+
+        allocator->DeallocateMemory(std::move(allocation));
+        EXPECT_EQ(allocator->GetStats().UsedBlockCount, 0u);
+    }
+}
+
+// Verify the first allocation refills the magazine from existing slab memory only.
+TEST_F(MagazineMemoryAllocatorTests, RefillMagazine) {
+    constexpr uint64_t kBlockSize = 16;
+    constexpr uint64_t kMagazineSize = 4;
+    std::unique_ptr<MagazineMemoryAllocator> allocator = CreateAllocator(kMagazineSize);
+
+    std::vector<std::unique_ptr<MemoryAllocation>> allocations;
+    allocations.push_back(allocator->TryAllocateMemory(CreateBasicRequest(kBlockSize, 1)));
+    ASSERT_NE(allocations.back(), nullptr);
+
+    // One block was allocated and a magazine worth of blocks were cached.
+    EXPECT_EQ(allocator->GetStats().UsedBlockCount, 1u);
+    EXPECT_EQ(allocator->GetNextInChain()->GetStats().UsedBlockCount, 1u + kMagazineSize);
+    EXPECT_EQ(allocator->GetStats().UsedMemoryCount, 1u);
+
+    // Cached blocks are used before any new slab gets created.
+    for (uint64_t i = 0; i < kMagazineSize; i++) {
+        allocations.push_back(allocator->TryAllocateMemory(CreateBasicRequest(kBlockSize, 1)));
+        ASSERT_NE(allocations.back(), nullptr);
+        EXPECT_EQ(allocations.back()->GetMemory(), allocations.front()->GetMemory());
+    }
+
+    EXPECT_EQ(allocator->GetStats().UsedBlockCount, 1u + kMagazineSize);
+    EXPECT_EQ(allocator->GetStats().UsedMemoryCount, 1u);
+
+    // Refill stops once the slab is full, leaving no blocks cached.
+    constexpr uint64_t kBlocksPerSlab = kDefaultSlabSize / kBlockSize;
+    while (allocations.size() < kBlocksPerSlab) {
+        allocations.push_back(allocator->TryAllocateMemory(CreateBasicRequest(kBlockSize, 1)));
+        ASSERT_NE(allocations.back(), nullptr);
+    }
+
+    EXPECT_EQ(allocator->GetStats().UsedBlockCount, kBlocksPerSlab);
+    EXPECT_EQ(allocator->GetNextInChain()->GetStats().UsedBlockCount, kBlocksPerSlab);
+    EXPECT_EQ(allocator->GetStats().UsedMemoryCount, 1u);
+
+    for (auto& allocation : allocations) {
+        allocator->DeallocateMemory(std::move(allocation));
+    }
+}
+
+// Verify NeverAllocate does not create memory nor refill the magazine.
+TEST_F(MagazineMemoryAllocatorTests, NeverAllocate) {
+    constexpr uint64_t kBlockSize = 16;
+    std::unique_ptr<MagazineMemoryAllocator> allocator = CreateAllocator(/*magazineSize*/ 4);
+
+    EXPECT_EQ(allocator->TryAllocateMemory(CreateBasicRequest(kBlockSize, 1, true)), nullptr);
+    EXPECT_EQ(allocator->GetStats().UsedMemoryCount, 0u);
+
+    // Once cached, NeverAllocate is served from the magazine.
+    std::unique_ptr<MemoryAllocation> allocation =
+        allocator->TryAllocateMemory(CreateBasicRequest(kBlockSize, 1));
+    ASSERT_NE(allocation, nullptr);
+
+    std::unique_ptr<MemoryAllocation> cachedAllocation =
+        allocator->TryAllocateMemory(CreateBasicRequest(kBlockSize, 1, true));
+    ASSERT_NE(cachedAllocation, nullptr);
+    EXPECT_EQ(cachedAllocation->GetMemory(), allocation->GetMemory());
+
+    allocator->DeallocateMemory(std::move(cachedAllocation));
+    allocator->DeallocateMemory(std::move(allocation));
+}
+
+// Verify ReleaseMemory drains every magazine so the underlying memory can be released.
+TEST_F(MagazineMemoryAllocatorTests, ReleaseMemory) {
+    constexpr uint64_t kBlockSize = 16;
+    constexpr uint64_t kMagazineSize = 2;
+    std::unique_ptr<MagazineMemoryAllocator> allocator = CreateAllocator(kMagazineSize);
+
+    // Allocate enough blocks to fill both per-thread magazines and the depot.
+    std::vector<std::unique_ptr<MemoryAllocation>> allocations;
+    for (uint64_t i = 0; i < kMagazineSize * 8; i++) {
+        allocations.push_back(allocator->TryAllocateMemory(CreateBasicRequest(kBlockSize, 1)));
+        ASSERT_NE(allocations.back(), nullptr);
+    }
+
+    for (auto& allocation : allocations) {
+        allocator->DeallocateMemory(std::move(allocation));
+    }
+
+    EXPECT_EQ(allocator->GetStats().UsedBlockCount, 0u);
+    EXPECT_GT(allocator->GetNextInChain()->GetStats().UsedBlockCount, 0u);
+    EXPECT_GT(allocator->GetStats().UsedMemoryUsage, 0u);
+
+    allocator->ReleaseMemory();
+
+    EXPECT_EQ(allocator->GetNextInChain()->GetStats().UsedBlockCount, 0u);
+    EXPECT_EQ(allocator->GetStats().UsedMemoryUsage, 0u);
+    EXPECT_EQ(allocator->GetStats().UsedMemoryCount, 0u);
+}
+
+// Verify magazines of an exited thread are returned to the depot and re-used by other threads.
+TEST_F(MagazineMemoryAllocatorTests, ThreadExit) {
+    constexpr uint64_t kBlockSize = 16;
+    constexpr uint64_t kMagazineSize = 4;
+    std::unique_ptr<MagazineMemoryAllocator> allocator = CreateAllocator(kMagazineSize);
+
+    std::thread thread([&]() {
+        std::unique_ptr<MemoryAllocation> allocation =
+            allocator->TryAllocateMemory(CreateBasicRequest(kBlockSize, 1));
+        ASSERT_NE(allocation, nullptr);
+        allocator->DeallocateMemory(std::move(allocation));
+    });
+    thread.join();
+
+    const uint64_t slabBlockCount = allocator->GetNextInChain()->GetStats().UsedBlockCount;
+    EXPECT_EQ(slabBlockCount, 1u + kMagazineSize);
+    EXPECT_EQ(allocator->GetStats().UsedBlockCount, 0u);
+
+    // Blocks cached by the exited thread are used before refilling from the slab allocator.
+    std::vector<std::unique_ptr<MemoryAllocation>> allocations;
+    for (uint64_t i = 0; i < slabBlockCount; i++) {
+        allocations.push_back(allocator->TryAllocateMemory(CreateBasicRequest(kBlockSize, 1)));
+        ASSERT_NE(allocations.back(), nullptr);
+        EXPECT_EQ(allocator->GetNextInChain()->GetStats().UsedBlockCount, slabBlockCount);
+    }
+
+    for (auto& allocation : allocations) {
+        allocator->DeallocateMemory(std::move(allocation));
+    }
+}
+
+// Verify blocks can be allocated and de-allocated from many threads.
+TEST_F(MagazineMemoryAllocatorTests, AllocateManyThreaded) {
+    constexpr uint64_t kThreadCount = 8;
+    constexpr uint64_t kAllocationsPerThread = 64;
+    std::unique_ptr<MagazineMemoryAllocator> allocator = CreateAllocator(/*magazineSize*/ 4);
+
+    auto allocateThenDeallocate = [&](uint64_t threadIndex) {
+        const uint64_t blockSize = 8u << (threadIndex % 3);
+        std::vector<std::unique_ptr<MemoryAllocation>> allocations;
+        for (uint64_t i = 0; i < kAllocationsPerThread; i++) {
+            allocations.push_back(allocator->TryAllocateMemory(CreateBasicRequest(blockSize, 1)));
+            ASSERT_NE(allocations.back(), nullptr);
+            EXPECT_EQ(allocations.back()->GetSize(), blockSize);
+        }
+        for (auto& allocation : allocations) {
+            allocator->DeallocateMemory(std::move(allocation));
+        }
+    };
+
+    std::vector<std::thread> threads(kThreadCount);
+    for (uint64_t i = 0; i < threads.size(); i++) {
+        threads[i] = std::thread([&, i]() { allocateThenDeallocate(i); });
+    }
+
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(allocator->GetStats().UsedBlockCount, 0u);
+
+    allocator->ReleaseMemory();
+
+    EXPECT_EQ(allocator->GetStats().UsedMemoryUsage, 0u);
+}
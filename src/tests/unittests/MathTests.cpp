@@ -36,6 +36,16 @@ TEST(MathTests, IsPowerOfTwo) {
     EXPECT_FALSE(IsPowerOfTwo(3u));
 }
 
+TEST(MathTests, ScanForward) {
+    EXPECT_EQ(ScanForward(1u), 0u);
+    EXPECT_EQ(ScanForward(6u), 1u);
+    EXPECT_EQ(ScanForward(0x80000000u), 31u);
+
+    EXPECT_EQ(ScanForward(uint64_t{1}), 0u);
+    EXPECT_EQ(ScanForward(uint64_t{1} << 32), 32u);
+    EXPECT_EQ(ScanForward((uint64_t{1} << 63) | (uint64_t{1} << 40)), 40u);
+}
+
 TEST(MathTests, PrevPowerOfTwo) {
     // Check number from POT.
     EXPECT_EQ(PrevPowerOfTwo(1u), 1u);
@@ -0,0 +1,248 @@
+// Copyright 2022 The GPGMM Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <gtest/gtest.h>
+
+#include "gpgmm/common/MemoryAllocationQueue.h"
+#include "tests/DummyMemoryAllocator.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <set>
+#include <thread>
+
+using namespace gpgmm;
+
+static constexpr uint64_t kDefaultMemorySize = 128u;
+static constexpr uint64_t kDefaultMemoryAlignment = 1u;
+
+// Blocks requests of the blocked size until unblocked.
+class BlockingMemoryAllocator : public DummyMemoryAllocator {
+  public:
+    explicit BlockingMemoryAllocator(uint64_t blockedSize) : mBlockedSize(blockedSize) {
+    }
+
+    std::unique_ptr<MemoryAllocation> TryAllocateMemory(
+        const MemoryAllocationRequest& request) override {
+        mNumOfRequests++;
+        if (request.SizeInBytes == mBlockedSize) {
+            std::unique_lock<std::mutex> lock(mBlockMutex);
+            mIsBlocking = true;
+            mBlockCondition.notify_all();
+            mBlockCondition.wait(lock, [this] { return !mIsBlocked; });
+        }
+        return DummyMemoryAllocator::TryAllocateMemory(request);
+    }
+
+    // Waits until a request of the blocked size is being served.
+    void WaitUntilBlocking() {
+        std::unique_lock<std::mutex> lock(mBlockMutex);
+        mBlockCondition.wait(lock, [this] { return mIsBlocking; });
+    }
+
+    void Unblock() {
+        {
+            std::lock_guard<std::mutex> lock(mBlockMutex);
+            mIsBlocked = false;
+        }
+        mBlockCondition.notify_all();
+    }
+
+    uint64_t GetRequestCount() const {
+        return mNumOfRequests;
+    }
+
+  private:
+    const uint64_t mBlockedSize;
+    std::atomic<uint64_t> mNumOfRequests = {0};
+
+    std::mutex mBlockMutex;
+    std::condition_variable mBlockCondition;
+    bool mIsBlocking = false;
+    bool mIsBlocked = true;
+};
+
+class MemoryAllocationQueueTests : public testing::Test {
+  public:
+    MemoryAllocationRequest CreateBasicRequest(uint64_t size, uint64_t alignment) {
+        MemoryAllocationRequest request = {};
+        request.SizeInBytes = size;
+        request.Alignment = alignment;
+        request.NeverAllocate = false;
+        request.AlwaysCacheSize = false;
+        request.AlwaysPrefetch = false;
+        request.AvailableForAllocation = kInvalidSize;
+        return request;
+    }
+};
+
+// Verify every submitted request completes once with its user data.
+TEST_F(MemoryAllocationQueueTests, SubmitAndWait) {
+    DummyMemoryAllocator allocator;
+    std::unique_ptr<MemoryAllocationQueue> queue =
+        allocator.CreateAllocationQueue(/*numOfWorkers*/ 2);
+    ASSERT_NE(queue, nullptr);
+
+    constexpr uint64_t kNumOfRequests = 64;
+    for (uint64_t i = 0; i < kNumOfRequests; i++) {
+        queue->Submit(CreateBasicRequest(kDefaultMemorySize, kDefaultMemoryAlignment),
+                      /*userData*/ i);
+    }
+
+    std::set<uint64_t> completedUserData;
+    MemoryAllocationCompletion completion = {};
+    while (queue->WaitForCompletion(&completion)) {
+        ASSERT_NE(completion.Allocation, nullptr);
+        EXPECT_FALSE(completion.IsCancelled);
+        EXPECT_TRUE(completedUserData.insert(completion.UserData).second);
+        allocator.DeallocateMemory(std::move(completion.Allocation));
+    }
+
+    EXPECT_EQ(completedUserData.size(), kNumOfRequests);
+    EXPECT_EQ(queue->GetOutstandingCount(), 0u);
+    EXPECT_FALSE(queue->TryGetCompletion(&completion));
+    EXPECT_EQ(allocator.GetStats().UsedMemoryCount, 0u);
+}
+
+// Verify a request completes before a previously submitted request still being served.
+TEST_F(MemoryAllocationQueueTests, OutOfOrder) {
+    BlockingMemoryAllocator allocator(/*blockedSize*/ kDefaultMemorySize * 2);
+    MemoryAllocationQueue queue(&allocator, /*numOfWorkers*/ 2);
+
+    queue.Submit(CreateBasicRequest(kDefaultMemorySize * 2, kDefaultMemoryAlignment),
+                 /*userData*/ 1);
+    allocator.WaitUntilBlocking();
+
+    queue.Submit(CreateBasicRequest(kDefaultMemorySize, kDefaultMemoryAlignment),
+                 /*userData*/ 2);
+
+    MemoryAllocationCompletion completion = {};
+    ASSERT_TRUE(queue.WaitForCompletion(&completion));
+    EXPECT_EQ(completion.UserData, 2u);
+    allocator.DeallocateMemory(std::move(completion.Allocation));
+
+    allocator.Unblock();
+
+    ASSERT_TRUE(queue.WaitForCompletion(&completion));
+    EXPECT_EQ(completion.UserData, 1u);
+    allocator.DeallocateMemory(std::move(completion.Allocation));
+}
+
+// Verify only requests not yet served can be cancelled.
+TEST_F(MemoryAllocationQueueTests, Cancel) {
+    BlockingMemoryAllocator allocator(/*blockedSize*/ kDefaultMemorySize * 2);
+    MemoryAllocationQueue queue(&allocator);
+
+    queue.Submit(CreateBasicRequest(kDefaultMemorySize * 2, kDefaultMemoryAlignment),
+                 /*userData*/ 1);
+    allocator.WaitUntilBlocking();
+
+    queue.Submit(CreateBasicRequest(kDefaultMemorySize, kDefaultMemoryAlignment),
+                 /*userData*/ 2);
+    queue.Submit(CreateBasicRequest(kDefaultMemorySize, kDefaultMemoryAlignment),
+                 /*userData*/ 2);
+    queue.Submit(CreateBasicRequest(kDefaultMemorySize, kDefaultMemoryAlignment),
+                 /*userData*/ 3);
+    EXPECT_EQ(queue.GetOutstandingCount(), 4u);
+
+    EXPECT_EQ(queue.Cancel(/*userData*/ 1), 0u);
+    EXPECT_EQ(queue.Cancel(/*userData*/ 2), 2u);
+
+    // Cancelled requests complete right away, even while the worker is busy.
+    MemoryAllocationCompletion completion = {};
+    for (uint32_t i = 0; i < 2; i++) {
+        ASSERT_TRUE(queue.TryGetCompletion(&completion));
+        EXPECT_EQ(completion.UserData, 2u);
+        EXPECT_TRUE(completion.IsCancelled);
+        EXPECT_EQ(completion.Allocation, nullptr);
+    }
+
+    allocator.Unblock();
+
+    std::set<uint64_t> completedUserData;
+    while (queue.WaitForCompletion(&completion)) {
+        ASSERT_NE(completion.Allocation, nullptr);
+        EXPECT_FALSE(completion.IsCancelled);
+        completedUserData.insert(completion.UserData);
+        allocator.DeallocateMemory(std::move(completion.Allocation));
+    }
+
+    EXPECT_EQ(completedUserData, std::set<uint64_t>({1, 3}));
+    EXPECT_EQ(allocator.GetStats().UsedMemoryCount, 0u);
+}
+
+// Verify a failed request completes without an allocation.
+TEST_F(MemoryAllocationQueueTests, Failed) {
+    DummyMemoryAllocator allocator;
+    MemoryAllocationQueue queue(&allocator);
+
+    MemoryAllocationRequest request =
+        CreateBasicRequest(kDefaultMemorySize, kDefaultMemoryAlignment);
+    request.NeverAllocate = true;
+    queue.Submit(request, /*userData*/ 1);
+
+    MemoryAllocationCompletion completion = {};
+    ASSERT_TRUE(queue.WaitForCompletion(&completion));
+    EXPECT_EQ(completion.UserData, 1u);
+    EXPECT_FALSE(completion.IsCancelled);
+    EXPECT_EQ(completion.Allocation, nullptr);
+}
+
+// Verify allocations never retrieved are deallocated once the queue is destroyed.
+TEST_F(MemoryAllocationQueueTests, Destroy) {
+    DummyMemoryAllocator allocator;
+    {
+        MemoryAllocationQueue queue(&allocator);
+        for (uint64_t i = 0; i < 8; i++) {
+            queue.Submit(CreateBasicRequest(kDefaultMemorySize, kDefaultMemoryAlignment),
+                         /*userData*/ i);
+        }
+
+        MemoryAllocationCompletion completion = {};
+        ASSERT_TRUE(queue.WaitForCompletion(&completion));
+        allocator.DeallocateMemory(std::move(completion.Allocation));
+    }
+
+    EXPECT_EQ(allocator.GetStats().UsedMemoryCount, 0u);
+}
+
+// Verify requests not yet served are cancelled, and the request being served is waited on, once
+// the queue is destroyed.
+TEST_F(MemoryAllocationQueueTests, DestroyWhileServing) {
+    BlockingMemoryAllocator allocator(/*blockedSize*/ kDefaultMemorySize * 2);
+    std::thread unblocker;
+    {
+        MemoryAllocationQueue queue(&allocator);
+        queue.Submit(CreateBasicRequest(kDefaultMemorySize * 2, kDefaultMemoryAlignment),
+                     /*userData*/ 1);
+        allocator.WaitUntilBlocking();
+
+        for (uint64_t i = 0; i < 4; i++) {
+            queue.Submit(CreateBasicRequest(kDefaultMemorySize, kDefaultMemoryAlignment),
+                         /*userData*/ 2);
+        }
+
+        unblocker = std::thread([&] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            allocator.Unblock();
+        });
+    }
+    unblocker.join();
+
+    EXPECT_EQ(allocator.GetRequestCount(), 1u);
+    EXPECT_EQ(allocator.GetStats().UsedMemoryCount, 0u);
+}
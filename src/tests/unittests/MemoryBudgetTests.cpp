@@ -0,0 +1,149 @@
+// Copyright 2022 The GPGMM Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include "gpgmm/common/MemoryBudget.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace gpgmm;
+
+TEST(MemoryBudgetTests, Unlimited) {
+    MemoryBudget budget;
+    EXPECT_EQ(budget.GetAvailableForAllocation(), kInvalidSize);
+
+    EXPECT_TRUE(budget.TryReserve(1024));
+    EXPECT_EQ(budget.GetUsage(), 1024u);
+    EXPECT_EQ(budget.GetAvailableForAllocation(), kInvalidSize);
+
+    budget.Release(1024);
+    EXPECT_EQ(budget.GetUsage(), 0u);
+}
+
+// Verify reservations never exceed the hard limit.
+TEST(MemoryBudgetTests, HardLimit) {
+    MemoryBudget budget(/*hardLimit*/ 256);
+
+    EXPECT_TRUE(budget.TryReserve(128));
+    EXPECT_TRUE(budget.TryReserve(128));
+    EXPECT_EQ(budget.GetAvailableForAllocation(), 0u);
+
+    EXPECT_FALSE(budget.TryReserve(1));
+    EXPECT_FALSE(budget.TryReserve(kInvalidSize));
+    EXPECT_EQ(budget.GetUsage(), 256u);
+
+    budget.Release(128);
+    EXPECT_EQ(budget.GetAvailableForAllocation(), 128u);
+    EXPECT_TRUE(budget.TryReserve(64));
+    EXPECT_EQ(budget.GetAvailableForAllocation(), 64u);
+
+    // Existing memory is always counted.
+    budget.Reserve(128);
+    EXPECT_EQ(budget.GetUsage(), 320u);
+    EXPECT_EQ(budget.GetAvailableForAllocation(), 0u);
+
+    budget.Release(320);
+}
+
+// Verify the soft limit can be exceeded but runs the over-budget callbacks.
+TEST(MemoryBudgetTests, SoftLimit) {
+    MemoryBudget budget(/*hardLimit*/ kInvalidSize, /*softLimit*/ 256);
+
+    std::atomic<uint64_t> bytesOverBudget = {0};
+    budget.AddOverBudgetCallback([&](uint64_t size) { bytesOverBudget = size; });
+
+    EXPECT_TRUE(budget.TryReserve(256));
+    budget.WaitForOverBudgetCallbacks();
+    EXPECT_EQ(bytesOverBudget, 0u);
+
+    EXPECT_TRUE(budget.TryReserve(64));
+    budget.WaitForOverBudgetCallbacks();
+    EXPECT_EQ(bytesOverBudget, 64u);
+
+    // Only the hard limit bounds allocations.
+    EXPECT_EQ(budget.GetAvailableForAllocation(), kInvalidSize);
+
+    budget.Release(320);
+}
+
+// Verify callbacks stop once enough memory was released.
+TEST(MemoryBudgetTests, SoftLimitReleased) {
+    MemoryBudget budget;
+    EXPECT_TRUE(budget.TryReserve(512));
+
+    uint64_t firstCallCount = 0;
+    uint64_t secondCallCount = 0;
+    budget.AddOverBudgetCallback([&](uint64_t size) {
+        firstCallCount++;
+        budget.Release(size);
+    });
+    budget.AddOverBudgetCallback([&](uint64_t) { secondCallCount++; });
+
+    budget.SetLimits(/*hardLimit*/ kInvalidSize, /*softLimit*/ 384);
+    budget.WaitForOverBudgetCallbacks();
+
+    EXPECT_EQ(firstCallCount, 1u);
+    EXPECT_EQ(secondCallCount, 0u);
+    EXPECT_EQ(budget.GetUsage(), 384u);
+
+    budget.Release(384);
+}
+
+// Verify lowering the hard limit keeps existing usage but fails new reservations.
+TEST(MemoryBudgetTests, SetLimits) {
+    MemoryBudget budget(/*hardLimit*/ 512);
+    EXPECT_TRUE(budget.TryReserve(256));
+
+    budget.SetLimits(/*hardLimit*/ 128, /*softLimit*/ kInvalidSize);
+    EXPECT_EQ(budget.GetHardLimit(), 128u);
+    EXPECT_EQ(budget.GetUsage(), 256u);
+    EXPECT_EQ(budget.GetAvailableForAllocation(), 0u);
+    EXPECT_FALSE(budget.TryReserve(1));
+
+    budget.Release(256);
+    EXPECT_TRUE(budget.TryReserve(128));
+    budget.Release(128);
+}
+
+// Verify concurrent reservations never exceed the hard limit.
+TEST(MemoryBudgetTests, ReserveMultiThreaded) {
+    constexpr uint64_t kThreadCount = 8;
+    constexpr uint64_t kReserveSize = 64;
+    constexpr uint64_t kHardLimit = kReserveSize * 100;
+    MemoryBudget budget(kHardLimit);
+
+    std::atomic<uint64_t> reservedCount = {0};
+    std::vector<std::thread> threads(kThreadCount);
+    for (size_t threadIdx = 0; threadIdx < threads.size(); threadIdx++) {
+        threads[threadIdx] = std::thread([&]() {
+            for (uint64_t i = 0; i < 100; i++) {
+                if (budget.TryReserve(kReserveSize)) {
+                    reservedCount++;
+                }
+            }
+        });
+    }
+
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(reservedCount, kHardLimit / kReserveSize);
+    EXPECT_EQ(budget.GetUsage(), kHardLimit);
+
+    budget.Release(kHardLimit);
+}
@@ -14,9 +14,13 @@
 
 #include <gtest/gtest.h>
 
+#include "gpgmm/common/IndexedMemoryPool.h"
 #include "gpgmm/common/LIFOMemoryPool.h"
 #include "tests/DummyMemoryAllocator.h"
 
+#include <chrono>
+#include <thread>
+
 using namespace gpgmm;
 
 static uint64_t kDefaultMemorySize = 128u;
@@ -82,3 +86,76 @@ TEST_F(LIFOMemoryPoolTests, MultipleAllocations) {
     EXPECT_EQ(pool.GetStats().SizeInBytes, 0u);
     EXPECT_EQ(pool.GetPoolSize(), 0u);
 }
+
+// Verify the least recently returned memory is released first.
+TEST_F(LIFOMemoryPoolTests, ReleaseLeastRecentlyUsed) {
+    DummyMemoryAllocator allocator;
+    LIFOMemoryPool pool(kDefaultMemorySize);
+    EXPECT_EQ(pool.GetLeastRecentlyUsedTime(), std::chrono::steady_clock::time_point::max());
+
+    MemoryAllocation firstAllocation =
+        *allocator.TryAllocateMemory(CreateBasicRequest(kDefaultMemorySize));
+    MemoryAllocation secondAllocation =
+        *allocator.TryAllocateMemory(CreateBasicRequest(kDefaultMemorySize));
+
+    pool.ReturnToPool(firstAllocation);
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    const std::chrono::steady_clock::time_point lastUsedTime = std::chrono::steady_clock::now();
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    pool.ReturnToPool(secondAllocation);
+
+    EXPECT_LT(pool.GetLeastRecentlyUsedTime(), lastUsedTime);
+
+    // Only the first allocation was returned before.
+    EXPECT_EQ(pool.ReleasePoolOlderThan(lastUsedTime), kDefaultMemorySize);
+    EXPECT_EQ(pool.GetPoolSize(), 1u);
+    EXPECT_GT(pool.GetLeastRecentlyUsedTime(), lastUsedTime);
+    EXPECT_EQ(pool.ReleasePoolOlderThan(lastUsedTime), 0u);
+
+    // The second allocation was kept.
+    EXPECT_EQ(pool.AcquireFromPool().GetMemory(), secondAllocation.GetMemory());
+
+    pool.ReturnToPool(secondAllocation);
+    pool.ReturnToPool(*allocator.TryAllocateMemory(CreateBasicRequest(kDefaultMemorySize)));
+
+    // Releasing one memory size releases the oldest.
+    EXPECT_EQ(pool.ReleasePool(kDefaultMemorySize), kDefaultMemorySize);
+    EXPECT_NE(pool.AcquireFromPool().GetMemory(), secondAllocation.GetMemory());
+    EXPECT_EQ(pool.GetPoolSize(), 0u);
+}
+
+class IndexedMemoryPoolTests : public MemoryPoolTests {};
+
+// Verify the least recently returned memory is released first without changing indexes.
+TEST_F(IndexedMemoryPoolTests, ReleaseLeastRecentlyUsed) {
+    DummyMemoryAllocator allocator;
+    IndexedMemoryPool pool(kDefaultMemorySize);
+
+    constexpr uint64_t kPoolSize = 4;
+    std::vector<MemoryAllocation> allocations;
+    for (uint64_t i = 0; i < kPoolSize; i++) {
+        EXPECT_EQ(pool.AcquireFromPool(i), GPGMM_ERROR_INVALID_ALLOCATION);
+        allocations.push_back(*allocator.TryAllocateMemory(CreateBasicRequest(kDefaultMemorySize)));
+    }
+
+    // Return in reverse order of the indexes.
+    for (uint64_t i = 0; i < kPoolSize; i++) {
+        pool.ReturnToPool(allocations[kPoolSize - i - 1], kPoolSize - i - 1);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    EXPECT_EQ(pool.GetPoolSize(), kPoolSize);
+
+    // Releases the last two indexes, which were returned first.
+    EXPECT_EQ(pool.ReleasePool(kDefaultMemorySize * 2), kDefaultMemorySize * 2);
+    EXPECT_EQ(pool.GetPoolSize(), 2u);
+    EXPECT_EQ(pool.AcquireFromPool(3), GPGMM_ERROR_INVALID_ALLOCATION);
+    EXPECT_EQ(pool.AcquireFromPool(2), GPGMM_ERROR_INVALID_ALLOCATION);
+
+    MemoryAllocation allocation = pool.AcquireFromPool(1);
+    EXPECT_EQ(allocation.GetMemory(), allocations[1].GetMemory());
+    pool.ReturnToPool(allocation, 1);
+
+    EXPECT_EQ(pool.ReleasePoolOlderThan(std::chrono::steady_clock::now()), kDefaultMemorySize * 2);
+    EXPECT_EQ(pool.GetPoolSize(), 0u);
+}
@@ -17,6 +17,10 @@
 #include "gpgmm/common/PooledMemoryAllocator.h"
 #include "tests/DummyMemoryAllocator.h"
 
+#include <chrono>
+#include <thread>
+#include <vector>
+
 using namespace gpgmm;
 
 static constexpr uint64_t kDefaultMemorySize = 128u;
@@ -133,3 +137,80 @@ TEST_F(PooledMemoryAllocatorTests, GetInfo) {
     EXPECT_EQ(allocator.GetStats().UsedMemoryUsage, 0u);
     EXPECT_EQ(allocator.GetStats().FreeMemoryUsage, kDefaultMemorySize);
 }
+
+// Verify only memory unused for long enough is released.
+TEST_F(PooledMemoryAllocatorTests, ReleaseMemoryOlderThan) {
+    PooledMemoryAllocator allocator(kDefaultMemorySize, kDefaultMemoryAlignment,
+                                    std::make_unique<DummyMemoryAllocator>());
+
+    std::unique_ptr<MemoryAllocation> idleAllocation = allocator.TryAllocateMemory(
+        CreateBasicRequest(kDefaultMemorySize, kDefaultMemoryAlignment));
+    ASSERT_NE(idleAllocation, nullptr);
+
+    std::unique_ptr<MemoryAllocation> hotAllocation = allocator.TryAllocateMemory(
+        CreateBasicRequest(kDefaultMemorySize, kDefaultMemoryAlignment));
+    ASSERT_NE(hotAllocation, nullptr);
+
+    allocator.DeallocateMemory(std::move(idleAllocation));
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    allocator.DeallocateMemory(std::move(hotAllocation));
+
+    EXPECT_EQ(allocator.ReleaseMemoryOlderThan(std::chrono::milliseconds(50)), kDefaultMemorySize);
+    EXPECT_EQ(allocator.GetStats().FreeMemoryUsage, kDefaultMemorySize);
+
+    EXPECT_EQ(allocator.ReleaseMemory(), kDefaultMemorySize);
+    EXPECT_EQ(allocator.GetStats().FreeMemoryUsage, 0u);
+}
+
+// Verify the pool is trimmed down to the low watermark once above the high watermark.
+TEST_F(PooledMemoryAllocatorTests, Watermarks) {
+    PoolWatermarkPolicy watermarkPolicy = {};
+    watermarkPolicy.HighWatermarkCount = 4;
+    watermarkPolicy.LowWatermarkUsage = kDefaultMemorySize * 2;
+
+    PooledMemoryAllocator allocator(kDefaultMemorySize, kDefaultMemoryAlignment,
+                                    std::make_unique<DummyMemoryAllocator>(), watermarkPolicy);
+
+    std::vector<std::unique_ptr<MemoryAllocation>> allocations;
+    for (uint64_t i = 0; i < 5; i++) {
+        allocations.push_back(allocator.TryAllocateMemory(
+            CreateBasicRequest(kDefaultMemorySize, kDefaultMemoryAlignment)));
+        ASSERT_NE(allocations.back(), nullptr);
+    }
+
+    // Up to the high watermark is kept.
+    for (uint64_t i = 0; i < 4; i++) {
+        allocator.DeallocateMemory(std::move(allocations[i]));
+    }
+    EXPECT_EQ(allocator.GetStats().FreeMemoryUsage, kDefaultMemorySize * 4);
+
+    // Exceeding the high watermark trims down to the low watermark.
+    allocator.DeallocateMemory(std::move(allocations[4]));
+    EXPECT_EQ(allocator.GetStats().FreeMemoryUsage, kDefaultMemorySize * 2);
+
+    EXPECT_EQ(allocator.ReleaseMemory(), kDefaultMemorySize * 2);
+}
+
+// Verify the low watermark defaults to the high watermark.
+TEST_F(PooledMemoryAllocatorTests, HighWatermarkOnly) {
+    PoolWatermarkPolicy watermarkPolicy = {};
+    watermarkPolicy.HighWatermarkUsage = kDefaultMemorySize * 2;
+
+    PooledMemoryAllocator allocator(kDefaultMemorySize, kDefaultMemoryAlignment,
+                                    std::make_unique<DummyMemoryAllocator>(), watermarkPolicy);
+
+    std::vector<std::unique_ptr<MemoryAllocation>> allocations;
+    for (uint64_t i = 0; i < 4; i++) {
+        allocations.push_back(allocator.TryAllocateMemory(
+            CreateBasicRequest(kDefaultMemorySize, kDefaultMemoryAlignment)));
+        ASSERT_NE(allocations.back(), nullptr);
+    }
+
+    for (auto& allocation : allocations) {
+        allocator.DeallocateMemory(std::move(allocation));
+        EXPECT_LE(allocator.GetStats().FreeMemoryUsage, kDefaultMemorySize * 2);
+    }
+
+    EXPECT_EQ(allocator.GetStats().FreeMemoryUsage, kDefaultMemorySize * 2);
+    EXPECT_EQ(allocator.ReleaseMemory(), kDefaultMemorySize * 2);
+}
@@ -0,0 +1,131 @@
+// Copyright 2022 The GPGMM Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include "gpgmm/common/MemoryAllocation.h"
+#include "gpgmm/utils/PooledObject.h"
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace gpgmm;
+
+class Object : public PooledObject<Object, /*MaxCachedObjectsPerThread*/ 4> {
+  public:
+    virtual ~Object() = default;
+
+    uint64_t mValue[2] = {};
+};
+
+class LargerObject final : public Object {
+  public:
+    uint64_t mOtherValue[8] = {};
+};
+
+// Verify storage of a deleted object is re-used by the next object.
+TEST(PooledObjectTests, Reuse) {
+    Object* object = new Object();
+    void* storage = object;
+    delete object;
+
+    std::unique_ptr<Object> reusedObject = std::make_unique<Object>();
+    EXPECT_EQ(reusedObject.get(), storage);
+}
+
+// Verify derived objects of a different size are never pooled.
+TEST(PooledObjectTests, DerivedObject) {
+    // Cache one object first so the next object never comes from the heap.
+    delete new Object();
+
+    std::unique_ptr<Object> object = std::make_unique<LargerObject>();
+    void* storage = object.get();
+    object.reset();
+
+    std::unique_ptr<Object> otherObject = std::make_unique<Object>();
+    EXPECT_NE(otherObject.get(), storage);
+}
+
+// Verify no more objects than the max are cached and the rest are freed.
+TEST(PooledObjectTests, MaxCachedObjects) {
+    std::vector<std::unique_ptr<Object>> objects;
+    for (uint64_t i = 0; i < 8; i++) {
+        objects.push_back(std::make_unique<Object>());
+    }
+    objects.clear();
+
+    for (uint64_t i = 0; i < 8; i++) {
+        objects.push_back(std::make_unique<Object>());
+    }
+}
+
+// Verify objects can be deleted by another thread than the one that created them.
+TEST(PooledObjectTests, DeleteOnOtherThread) {
+    std::vector<std::unique_ptr<Object>> objects;
+    for (uint64_t i = 0; i < 8; i++) {
+        objects.push_back(std::make_unique<Object>());
+    }
+
+    std::thread thread([&]() { objects.clear(); });
+    thread.join();
+
+    EXPECT_TRUE(objects.empty());
+}
+
+// Verify storage of objects deleted by another thread returns to the creating thread.
+TEST(PooledObjectTests, DeleteOnOtherThreadReuse) {
+    // Empty the free-list of this thread so the next object can only be re-used storage.
+    std::vector<std::unique_ptr<Object>> objects;
+    for (uint64_t i = 0; i < 8; i++) {
+        objects.push_back(std::make_unique<Object>());
+    }
+
+    std::unique_ptr<Object> object = std::make_unique<Object>();
+    void* storage = object.get();
+
+    std::thread thread([&]() { object.reset(); });
+    thread.join();
+
+    std::unique_ptr<Object> reusedObject = std::make_unique<Object>();
+    EXPECT_EQ(reusedObject.get(), storage);
+}
+
+// Verify objects can be deleted once the thread that created them has exited.
+TEST(PooledObjectTests, DeleteAfterThreadExit) {
+    std::vector<std::unique_ptr<Object>> objects;
+    std::thread thread([&]() {
+        for (uint64_t i = 0; i < 8; i++) {
+            objects.push_back(std::make_unique<Object>());
+        }
+        // Cache some storage in the free-list of the exiting thread.
+        objects.pop_back();
+    });
+    thread.join();
+
+    objects.clear();
+
+    std::unique_ptr<Object> object = std::make_unique<Object>();
+    EXPECT_NE(object, nullptr);
+}
+
+// Verify MemoryAllocation is pooled.
+TEST(PooledObjectTests, MemoryAllocation) {
+    std::unique_ptr<MemoryAllocation> allocation = std::make_unique<MemoryAllocation>();
+    void* storage = allocation.get();
+    allocation.reset();
+
+    allocation = std::make_unique<MemoryAllocation>();
+    EXPECT_EQ(allocation.get(), storage);
+}
@@ -17,6 +17,9 @@
 #include "gpgmm/common/SegmentedMemoryAllocator.h"
 #include "tests/DummyMemoryAllocator.h"
 
+#include <chrono>
+#include <thread>
+
 using namespace gpgmm;
 
 static constexpr uint64_t kDefaultMemorySize = 128u;
@@ -210,3 +213,95 @@ TEST(SegmentedMemoryAllocatorTests, GetInfo) {
     EXPECT_EQ(allocator.GetStats().UsedMemoryUsage, 0u);
     EXPECT_EQ(allocator.GetStats().FreeMemoryUsage, kDefaultMemorySize);
 }
+
+// Verify best-fit re-uses memory of a larger segment, within the limit, before creating memory.
+TEST(SegmentedMemoryAllocatorTests, BestFit) {
+    SegmentedMemoryAllocator allocator(std::make_unique<DummyMemoryAllocator>(),
+                                       kDefaultMemoryAlignment, /*segmentFitLimit*/ 0.25);
+
+    std::unique_ptr<MemoryAllocation> allocation = allocator.TryAllocateMemory(
+        CreateBasicRequest(kDefaultMemorySize, kDefaultMemoryAlignment));
+    ASSERT_NE(allocation, nullptr);
+    allocator.DeallocateMemory(std::move(allocation));
+
+    // Re-uses the larger memory since it is no more than 25% larger.
+    allocation = allocator.TryAllocateMemory(
+        CreateBasicRequest(kDefaultMemorySize - kDefaultMemorySize / 8, kDefaultMemoryAlignment));
+    ASSERT_NE(allocation, nullptr);
+    EXPECT_EQ(allocation->GetSize(), kDefaultMemorySize);
+    EXPECT_EQ(allocator.GetStats().FreeMemoryUsage, 0u);
+
+    // Creates new memory since the larger memory is in use.
+    std::unique_ptr<MemoryAllocation> otherAllocation = allocator.TryAllocateMemory(
+        CreateBasicRequest(kDefaultMemorySize - kDefaultMemorySize / 8, kDefaultMemoryAlignment));
+    ASSERT_NE(otherAllocation, nullptr);
+    EXPECT_EQ(otherAllocation->GetSize(), kDefaultMemorySize - kDefaultMemorySize / 8);
+
+    // Larger memory is returned to the segment it came from.
+    allocator.DeallocateMemory(std::move(allocation));
+    allocator.DeallocateMemory(std::move(otherAllocation));
+    EXPECT_EQ(allocator.GetStats().FreeMemoryUsage,
+              kDefaultMemorySize + kDefaultMemorySize - kDefaultMemorySize / 8);
+
+    // Creates new memory since both free memory are more than 25% larger.
+    allocation = allocator.TryAllocateMemory(
+        CreateBasicRequest(kDefaultMemorySize / 2, kDefaultMemoryAlignment));
+    ASSERT_NE(allocation, nullptr);
+    EXPECT_EQ(allocation->GetSize(), kDefaultMemorySize / 2);
+    allocator.DeallocateMemory(std::move(allocation));
+
+    EXPECT_EQ(allocator.GetSegmentSizeForTesting(), 3u);
+    const uint64_t totalFreeMemorySize =
+        kDefaultMemorySize * 2 - kDefaultMemorySize / 8 + kDefaultMemorySize / 2;
+    EXPECT_EQ(allocator.ReleaseMemory(), totalFreeMemorySize);
+}
+
+// Verify the least recently used memory is released first, across segments.
+TEST(SegmentedMemoryAllocatorTests, ReleaseLeastRecentlyUsed) {
+    SegmentedMemoryAllocator allocator(std::make_unique<DummyMemoryAllocator>(),
+                                       kDefaultMemoryAlignment);
+
+    std::unique_ptr<MemoryAllocation> largerAllocation = allocator.TryAllocateMemory(
+        CreateBasicRequest(kDefaultMemorySize, kDefaultMemoryAlignment));
+    ASSERT_NE(largerAllocation, nullptr);
+
+    std::unique_ptr<MemoryAllocation> smallerAllocation = allocator.TryAllocateMemory(
+        CreateBasicRequest(kDefaultMemorySize / 2, kDefaultMemoryAlignment));
+    ASSERT_NE(smallerAllocation, nullptr);
+
+    allocator.DeallocateMemory(std::move(largerAllocation));
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    allocator.DeallocateMemory(std::move(smallerAllocation));
+
+    // Larger memory was used less recently.
+    EXPECT_EQ(allocator.ReleaseMemory(1), kDefaultMemorySize);
+    EXPECT_EQ(allocator.GetStats().FreeMemoryUsage, kDefaultMemorySize / 2);
+
+    EXPECT_EQ(allocator.ReleaseMemory(1), kDefaultMemorySize / 2);
+    EXPECT_EQ(allocator.GetStats().FreeMemoryUsage, 0u);
+}
+
+// Verify only memory unused for long enough is released.
+TEST(SegmentedMemoryAllocatorTests, ReleaseMemoryOlderThan) {
+    SegmentedMemoryAllocator allocator(std::make_unique<DummyMemoryAllocator>(),
+                                       kDefaultMemoryAlignment);
+
+    std::unique_ptr<MemoryAllocation> idleAllocation = allocator.TryAllocateMemory(
+        CreateBasicRequest(kDefaultMemorySize, kDefaultMemoryAlignment));
+    ASSERT_NE(idleAllocation, nullptr);
+
+    std::unique_ptr<MemoryAllocation> hotAllocation = allocator.TryAllocateMemory(
+        CreateBasicRequest(kDefaultMemorySize / 2, kDefaultMemoryAlignment));
+    ASSERT_NE(hotAllocation, nullptr);
+
+    allocator.DeallocateMemory(std::move(idleAllocation));
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    allocator.DeallocateMemory(std::move(hotAllocation));
+
+    EXPECT_EQ(allocator.ReleaseMemoryOlderThan(std::chrono::milliseconds(50)), kDefaultMemorySize);
+    EXPECT_EQ(allocator.GetStats().FreeMemoryUsage, kDefaultMemorySize / 2);
+
+    EXPECT_EQ(allocator.ReleaseMemoryOlderThan(std::chrono::steady_clock::duration::zero()),
+              kDefaultMemorySize / 2);
+    EXPECT_EQ(allocator.GetStats().FreeMemoryUsage, 0u);
+}
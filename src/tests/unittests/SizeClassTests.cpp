@@ -0,0 +1,67 @@
+// Copyright 2022 The GPGMM Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include "gpgmm/common/SizeClass.h"
+
+using namespace gpgmm;
+
+// Verify every size maps to the size class containing it.
+TEST(SizeClassTests, GetSizeClassIndex) {
+    static constexpr auto kSizeClasses = GenerateSizeClasses<64>();
+    for (uint64_t size = 1; size < kSizeClasses.back().SizeInBytes; size++) {
+        const uint64_t index = GetSizeClassIndex(size);
+        ASSERT_LT(index + 1, kSizeClasses.size());
+        EXPECT_LE(kSizeClasses[index].SizeInBytes, size);
+        EXPECT_GT(kSizeClasses[index + 1].SizeInBytes, size);
+    }
+
+    EXPECT_EQ(GetSizeClassIndex(1), 1u);
+    EXPECT_EQ(GetSizeClassIndex(4), 4u);
+    EXPECT_EQ(GetSizeClassIndex(8), 8u);
+    EXPECT_EQ(GetSizeClassIndex(9), 8u);
+    EXPECT_EQ(GetSizeClassIndex(10), 9u);
+}
+
+// Verify the number of size classes grows with the log of the size.
+TEST(SizeClassTests, GetSizeClassIndexLargeSizes) {
+    EXPECT_EQ(GetSizeClassIndex(GPGMM_MB_TO_BYTES(4)), 84u);
+    EXPECT_EQ(GetSizeClassIndex(GPGMM_MB_TO_BYTES(4) + 1), 84u);
+    EXPECT_EQ(GetSizeClassIndex(GPGMM_GB_TO_BYTES(4)), 124u);
+    EXPECT_EQ(GetSizeClassIndex(std::numeric_limits<uint64_t>::max()), 251u);
+
+    EXPECT_EQ(GetSizeClassInfo(84).SizeInBytes, GPGMM_MB_TO_BYTES(4));
+    EXPECT_EQ(GetSizeClassInfo(124).SizeInBytes, GPGMM_GB_TO_BYTES(4));
+}
+
+// Verify sizes round up to the next of the equally spaced sizes in their power-of-two range.
+TEST(SizeClassTests, AlignToSizeClass) {
+    EXPECT_EQ(AlignToSizeClass(3, 4), 3u);
+    EXPECT_EQ(AlignToSizeClass(5, 4), 5u);
+    EXPECT_EQ(AlignToSizeClass(9, 4), 10u);
+    EXPECT_EQ(AlignToSizeClass(16, 4), 16u);
+    EXPECT_EQ(AlignToSizeClass(17, 4), 20u);
+    EXPECT_EQ(AlignToSizeClass(29, 4), 32u);
+
+    // One class per doubling rounds up to a power-of-two.
+    EXPECT_EQ(AlignToSizeClass(17, 1), 32u);
+
+    // Rounding never wastes more than 1 / (N + 1) of the rounded size.
+    for (uint64_t size = 1; size < 4096; size++) {
+        const uint64_t sizeClassSize = AlignToSizeClass(size, 8);
+        ASSERT_GE(sizeClassSize, size);
+        EXPECT_LT((sizeClassSize - size) * 9, sizeClassSize);
+    }
+}
@@ -18,6 +18,7 @@
 #include "gpgmm/utils/Math.h"
 
 #include <unordered_set>
+#include <vector>
 
 using namespace gpgmm;
 
@@ -140,3 +141,57 @@ TEST(SlabBlockAllocatorTests, MultipleBlocksVarious) {
     allocator.DeallocateBlock(blockC);
     allocator.DeallocateBlock(blockB);
 }
+
+// Verify blocks spanning many bitmap words are allocated lowest-first and re-used.
+TEST(SlabBlockAllocatorTests, ManyBlocks) {
+    constexpr uint64_t blockSize = 32;
+    constexpr uint64_t blockCount = 130;
+    SlabBlockAllocator allocator(blockCount, blockSize);
+
+    std::vector<MemoryBlock*> blocks;
+    for (uint64_t i = 0; i < blockCount; i++) {
+        blocks.push_back(allocator.TryAllocateBlock(blockSize));
+        ASSERT_NE(blocks.back(), nullptr);
+        EXPECT_EQ(blocks.back()->Offset, blockSize * i);
+    }
+
+    // Slab is full.
+    EXPECT_EQ(allocator.TryAllocateBlock(blockSize), nullptr);
+
+    // De-allocate a block from the last and first words.
+    allocator.DeallocateBlock(blocks[129]);
+    allocator.DeallocateBlock(blocks[64]);
+
+    // Lowest free block is always allocated first.
+    EXPECT_EQ(allocator.TryAllocateBlock(blockSize), blocks[64]);
+    EXPECT_EQ(allocator.TryAllocateBlock(blockSize), blocks[129]);
+    EXPECT_EQ(allocator.TryAllocateBlock(blockSize), nullptr);
+
+    for (MemoryBlock* block : blocks) {
+        allocator.DeallocateBlock(block);
+    }
+
+    allocator.ReleaseBlocks();
+}
+
+// Verify blocks allocated before a move remain owned by the moved-to allocator.
+TEST(SlabBlockAllocatorTests, Move) {
+    constexpr uint64_t blockSize = 32;
+    SlabBlockAllocator allocator(/*blockCount*/ 2, blockSize);
+
+    MemoryBlock* blockA = allocator.TryAllocateBlock(blockSize);
+    ASSERT_NE(blockA, nullptr);
+
+    SlabBlockAllocator movedAllocator = std::move(allocator);
+
+    MemoryBlock* blockB = movedAllocator.TryAllocateBlock(blockSize);
+    ASSERT_NE(blockB, nullptr);
+    EXPECT_EQ(blockB->Offset, blockSize);
+    EXPECT_EQ(movedAllocator.TryAllocateBlock(blockSize), nullptr);
+
+    movedAllocator.DeallocateBlock(blockA);
+    EXPECT_EQ(movedAllocator.TryAllocateBlock(blockSize), blockA);
+
+    movedAllocator.DeallocateBlock(blockA);
+    movedAllocator.DeallocateBlock(blockB);
+}
@@ -22,6 +22,7 @@
 #include "tests/DummyMemoryAllocator.h"
 
 #include <set>
+#include <thread>
 #include <vector>
 
 using namespace gpgmm;
@@ -682,6 +683,439 @@ TEST_F(SlabMemoryAllocatorTests, SlabGrowthLimit) {
     }
 }
 
+// Verify compaction empties the least-utilized slabs into the most-utilized ones.
+TEST_F(SlabMemoryAllocatorTests, Compaction) {
+    std::unique_ptr<DummyMemoryAllocator> dummyMemoryAllocator =
+        std::make_unique<DummyMemoryAllocator>();
+
+    constexpr uint64_t kBlockSize = 16;
+    constexpr uint64_t kBlocksPerSlab = kDefaultSlabSize / kBlockSize;
+    SlabMemoryAllocator allocator(kBlockSize, kDefaultSlabSize, kDefaultSlabSize,
+                                  kDefaultSlabAlignment, kDefaultSlabFragmentationLimit,
+                                  kNoSlabPrefetchAllowed, kDisableSlabGrowth,
+                                  dummyMemoryAllocator.get());
+
+    // Fill slabs A, B, C and D.
+    std::vector<std::unique_ptr<MemoryAllocation>> allocations;
+    for (uint64_t i = 0; i < kBlocksPerSlab * 4; i++) {
+        allocations.push_back(allocator.TryAllocateMemory(CreateBasicRequest(kBlockSize, 1)));
+        ASSERT_NE(allocations.back(), nullptr);
+    }
+
+    EXPECT_EQ(allocator.GetStats().UsedMemoryCount, 4u);
+
+    // Leave 7, 1, 1 and 6 blocks used in slabs A, B, C and D.
+    const uint64_t kUsedBlocksPerSlab[] = {7, 1, 1, 6};
+    std::vector<std::unique_ptr<MemoryAllocation>> liveAllocations;
+    for (uint64_t slabIndex = 0; slabIndex < 4; slabIndex++) {
+        for (uint64_t blockIndex = 0; blockIndex < kBlocksPerSlab; blockIndex++) {
+            std::unique_ptr<MemoryAllocation>& allocation =
+                allocations[slabIndex * kBlocksPerSlab + blockIndex];
+            if (blockIndex < kUsedBlocksPerSlab[slabIndex]) {
+                liveAllocations.push_back(std::move(allocation));
+            } else {
+                allocator.DeallocateMemory(std::move(allocation));
+            }
+        }
+    }
+
+    IMemoryObject* slabMemoryA = liveAllocations[0]->GetMemory();
+    IMemoryObject* slabMemoryD = liveAllocations.back()->GetMemory();
+
+    std::vector<MemoryAllocation*> allocationsToCompact;
+    for (auto& allocation : liveAllocations) {
+        allocationsToCompact.push_back(allocation.get());
+    }
+
+    // Slabs B and C fit into the three free blocks of A and D.
+    SlabCompactionPlan plan = allocator.PlanCompaction(allocationsToCompact);
+    ASSERT_EQ(plan.Moves.size(), 2u);
+    EXPECT_EQ(plan.BytesMoved, kBlockSize * 2);
+    EXPECT_EQ(plan.BytesReclaimed, kDefaultSlabSize * 2);
+    EXPECT_EQ(plan.GetBytesReclaimedPerByteMoved(), 8.0);
+
+    // The most-utilized slab is filled first.
+    EXPECT_EQ(plan.Moves[0].DstMemory, slabMemoryA);
+    EXPECT_EQ(plan.Moves[0].DstOffset, kBlockSize * 7);
+    EXPECT_EQ(plan.Moves[1].DstMemory, slabMemoryD);
+    EXPECT_EQ(plan.Moves[1].DstOffset, kBlockSize * 6);
+
+    EXPECT_TRUE(allocator.CommitCompaction(plan));
+
+    // Moved allocations are rebound to the destination.
+    for (const SlabAllocationMove& move : plan.Moves) {
+        EXPECT_EQ(move.Allocation->GetMemory(), move.DstMemory);
+        EXPECT_EQ(move.Allocation->GetOffset(), move.DstOffset);
+    }
+
+    EXPECT_EQ(allocator.GetStats().UsedMemoryCount, 2u);
+    EXPECT_EQ(allocator.GetStats().UsedMemoryUsage, kDefaultSlabSize * 2);
+    EXPECT_EQ(allocator.GetStats().UsedBlockCount, liveAllocations.size());
+
+    // Nothing left to compact.
+    EXPECT_TRUE(allocator.PlanCompaction(allocationsToCompact).Moves.empty());
+
+    for (auto& allocation : liveAllocations) {
+        allocator.DeallocateMemory(std::move(allocation));
+    }
+
+    EXPECT_EQ(allocator.GetStats().UsedMemoryCount, 0u);
+    EXPECT_EQ(allocator.GetStats().UsedBlockCount, 0u);
+}
+
+// Verify slabs with allocations unknown to the caller are never emptied.
+TEST_F(SlabMemoryAllocatorTests, CompactionPartial) {
+    std::unique_ptr<DummyMemoryAllocator> dummyMemoryAllocator =
+        std::make_unique<DummyMemoryAllocator>();
+
+    constexpr uint64_t kBlockSize = 16;
+    constexpr uint64_t kBlocksPerSlab = kDefaultSlabSize / kBlockSize;
+    SlabMemoryAllocator allocator(kBlockSize, kDefaultSlabSize, kDefaultSlabSize,
+                                  kDefaultSlabAlignment, kDefaultSlabFragmentationLimit,
+                                  kNoSlabPrefetchAllowed, kDisableSlabGrowth,
+                                  dummyMemoryAllocator.get());
+
+    std::vector<std::unique_ptr<MemoryAllocation>> allocations;
+    for (uint64_t i = 0; i < kBlocksPerSlab * 2; i++) {
+        allocations.push_back(allocator.TryAllocateMemory(CreateBasicRequest(kBlockSize, 1)));
+        ASSERT_NE(allocations.back(), nullptr);
+    }
+
+    // Leave 2 blocks used in each slab.
+    for (uint64_t i = 0; i < allocations.size(); i++) {
+        if (i % kBlocksPerSlab >= 2) {
+            allocator.DeallocateMemory(std::move(allocations[i]));
+        }
+    }
+
+    // Only one block of the first slab is known.
+    EXPECT_TRUE(allocator.PlanCompaction({allocations[0].get()}).Moves.empty());
+
+    // Both blocks of the first slab are known.
+    SlabCompactionPlan plan =
+        allocator.PlanCompaction({allocations[0].get(), allocations[1].get()});
+    EXPECT_EQ(plan.Moves.size(), 2u);
+    EXPECT_EQ(plan.BytesReclaimed, kDefaultSlabSize);
+
+    // Plan is stale once the allocator changes.
+    std::unique_ptr<MemoryAllocation> allocation =
+        allocator.TryAllocateMemory(CreateBasicRequest(kBlockSize, 1));
+    ASSERT_NE(allocation, nullptr);
+    EXPECT_FALSE(allocator.CommitCompaction(plan));
+    EXPECT_EQ(allocator.GetStats().UsedMemoryCount, 2u);
+
+    allocator.DeallocateMemory(std::move(allocation));
+    for (auto& liveAllocation : allocations) {
+        if (liveAllocation != nullptr) {
+            allocator.DeallocateMemory(std::move(liveAllocation));
+        }
+    }
+
+    EXPECT_EQ(allocator.GetStats().UsedMemoryCount, 0u);
+}
+
+// Verify fragmentation is tracked on every allocate and de-allocate.
+TEST_F(SlabMemoryAllocatorTests, FragmentationStats) {
+    std::unique_ptr<DummyMemoryAllocator> dummyMemoryAllocator =
+        std::make_unique<DummyMemoryAllocator>();
+
+    constexpr uint64_t kBlockSize = 16;
+    constexpr uint64_t kBlocksPerSlab = kDefaultSlabSize / kBlockSize;
+    SlabMemoryAllocator allocator(kBlockSize, kDefaultSlabSize, kDefaultSlabSize,
+                                  kDefaultSlabAlignment, kDefaultSlabFragmentationLimit,
+                                  kNoSlabPrefetchAllowed, kDisableSlabGrowth,
+                                  dummyMemoryAllocator.get());
+
+    // 10 bytes uses a whole 16 byte block.
+    std::vector<std::unique_ptr<MemoryAllocation>> allocations;
+    allocations.push_back(allocator.TryAllocateMemory(CreateBasicRequest(10, 1)));
+    ASSERT_NE(allocations.back(), nullptr);
+    EXPECT_EQ(allocator.GetStats().InternalFragmentationUsage, 6u);
+    EXPECT_EQ(allocator.GetStats().ExternalFragmentationUsage, kDefaultSlabSize - kBlockSize);
+    EXPECT_EQ(allocator.GetStats().LargestFreeBlockSize, kBlockSize);
+
+    // Full slabs are not fragmented.
+    for (uint64_t i = 1; i < kBlocksPerSlab; i++) {
+        allocations.push_back(allocator.TryAllocateMemory(CreateBasicRequest(kBlockSize, 1)));
+        ASSERT_NE(allocations.back(), nullptr);
+    }
+    EXPECT_EQ(allocator.GetStats().InternalFragmentationUsage, 6u);
+    EXPECT_EQ(allocator.GetStats().ExternalFragmentationUsage, 0u);
+    EXPECT_EQ(allocator.GetStats().LargestFreeBlockSize, 0u);
+
+    allocator.DeallocateMemory(std::move(allocations.back()));
+    allocations.pop_back();
+    EXPECT_EQ(allocator.GetStats().ExternalFragmentationUsage, kBlockSize);
+    EXPECT_EQ(allocator.GetStats().LargestFreeBlockSize, kBlockSize);
+
+    for (auto& allocation : allocations) {
+        allocator.DeallocateMemory(std::move(allocation));
+    }
+
+    EXPECT_EQ(allocator.GetStats().InternalFragmentationUsage, 0u);
+    EXPECT_EQ(allocator.GetStats().ExternalFragmentationUsage, 0u);
+    EXPECT_EQ(allocator.GetStats().LargestFreeBlockSize, 0u);
+}
+
+// Verify empty slabs are retained up to the count and byte limits.
+TEST_F(SlabMemoryAllocatorTests, RetainEmptySlabs) {
+    std::unique_ptr<DummyMemoryAllocator> dummyMemoryAllocator =
+        std::make_unique<DummyMemoryAllocator>();
+
+    constexpr uint64_t kBlockSize = 16;
+    constexpr uint64_t kBlocksPerSlab = kDefaultSlabSize / kBlockSize;
+
+    // Oscillating across a slab boundary re-uses the retained slab.
+    {
+        SlabRetentionPolicy retentionPolicy = {};
+        retentionPolicy.MaxEmptySlabCount = 1;
+
+        SlabMemoryAllocator allocator(kBlockSize, kDefaultSlabSize, kDefaultSlabSize,
+                                      kDefaultSlabAlignment, kDefaultSlabFragmentationLimit,
+                                      kNoSlabPrefetchAllowed, kDisableSlabGrowth,
+                                      dummyMemoryAllocator.get(), retentionPolicy);
+
+        std::vector<std::unique_ptr<MemoryAllocation>> allocations;
+        for (uint64_t i = 0; i < kBlocksPerSlab; i++) {
+            allocations.push_back(allocator.TryAllocateMemory(CreateBasicRequest(kBlockSize, 1)));
+            ASSERT_NE(allocations.back(), nullptr);
+        }
+
+        for (uint64_t i = 0; i < 4; i++) {
+            std::unique_ptr<MemoryAllocation> allocation =
+                allocator.TryAllocateMemory(CreateBasicRequest(kBlockSize, 1));
+            ASSERT_NE(allocation, nullptr);
+            allocator.DeallocateMemory(std::move(allocation));
+
+            EXPECT_EQ(allocator.GetRetainedSlabUsage(), kDefaultSlabSize);
+            EXPECT_EQ(allocator.GetStats().UsedMemoryCount, 2u);
+        }
+
+        EXPECT_EQ(dummyMemoryAllocator->GetStats().UsedMemoryCount, 2u);
+
+        // Only one of the two empty slabs is retained.
+        for (auto& allocation : allocations) {
+            allocator.DeallocateMemory(std::move(allocation));
+        }
+
+        EXPECT_EQ(allocator.GetRetainedSlabUsage(), kDefaultSlabSize);
+        EXPECT_EQ(allocator.GetStats().UsedMemoryCount, 1u);
+    }
+
+    EXPECT_EQ(dummyMemoryAllocator->GetStats().UsedMemoryCount, 0u);
+
+    // Slabs exceeding the byte limit are never retained.
+    {
+        SlabRetentionPolicy retentionPolicy = {};
+        retentionPolicy.MaxEmptySlabCount = 2;
+        retentionPolicy.MaxEmptySlabUsage = kDefaultSlabSize - 1;
+
+        SlabMemoryAllocator allocator(kBlockSize, kDefaultSlabSize, kDefaultSlabSize,
+                                      kDefaultSlabAlignment, kDefaultSlabFragmentationLimit,
+                                      kNoSlabPrefetchAllowed, kDisableSlabGrowth,
+                                      dummyMemoryAllocator.get(), retentionPolicy);
+
+        std::unique_ptr<MemoryAllocation> allocation =
+            allocator.TryAllocateMemory(CreateBasicRequest(kBlockSize, 1));
+        ASSERT_NE(allocation, nullptr);
+        allocator.DeallocateMemory(std::move(allocation));
+
+        EXPECT_EQ(allocator.GetRetainedSlabUsage(), 0u);
+        EXPECT_EQ(allocator.GetStats().UsedMemoryCount, 0u);
+    }
+}
+
+// Verify retained slabs are released once unused for too long.
+TEST_F(SlabMemoryAllocatorTests, RetainEmptySlabsAge) {
+    std::unique_ptr<DummyMemoryAllocator> dummyMemoryAllocator =
+        std::make_unique<DummyMemoryAllocator>();
+
+    constexpr uint64_t kBlockSize = 16;
+    constexpr uint64_t kBlocksPerSlab = kDefaultSlabSize / kBlockSize;
+
+    SlabRetentionPolicy retentionPolicy = {};
+    retentionPolicy.MaxEmptySlabCount = 1;
+    retentionPolicy.MaxEmptySlabAge = 2;
+
+    SlabMemoryAllocator allocator(kBlockSize, kDefaultSlabSize, kDefaultSlabSize,
+                                  kDefaultSlabAlignment, kDefaultSlabFragmentationLimit,
+                                  kNoSlabPrefetchAllowed, kDisableSlabGrowth,
+                                  dummyMemoryAllocator.get(), retentionPolicy);
+
+    std::vector<std::unique_ptr<MemoryAllocation>> allocations;
+    for (uint64_t i = 0; i < kBlocksPerSlab + 1; i++) {
+        allocations.push_back(allocator.TryAllocateMemory(CreateBasicRequest(kBlockSize, 1)));
+        ASSERT_NE(allocations.back(), nullptr);
+    }
+
+    // Empty the second slab.
+    allocator.DeallocateMemory(std::move(allocations.back()));
+    allocations.pop_back();
+    EXPECT_EQ(allocator.GetRetainedSlabUsage(), kDefaultSlabSize);
+
+    // Age the retained slab using the first slab.
+    allocator.DeallocateMemory(std::move(allocations[0]));
+    allocator.DeallocateMemory(std::move(allocations[1]));
+    EXPECT_EQ(allocator.GetRetainedSlabUsage(), kDefaultSlabSize);
+    EXPECT_EQ(allocator.GetStats().UsedMemoryCount, 2u);
+
+    allocator.DeallocateMemory(std::move(allocations[2]));
+    EXPECT_EQ(allocator.GetRetainedSlabUsage(), 0u);
+    EXPECT_EQ(allocator.GetStats().UsedMemoryCount, 1u);
+
+    for (auto& allocation : allocations) {
+        if (allocation != nullptr) {
+            allocator.DeallocateMemory(std::move(allocation));
+        }
+    }
+
+    // The first slab is now retained.
+    EXPECT_EQ(allocator.GetRetainedSlabUsage(), kDefaultSlabSize);
+}
+
+// Verify a retained slab is re-used, even of a smaller slab size, before creating a new slab.
+TEST_F(SlabMemoryAllocatorTests, ReuseRetainedSlab) {
+    std::unique_ptr<DummyMemoryAllocator> dummyMemoryAllocator =
+        std::make_unique<DummyMemoryAllocator>();
+
+    constexpr uint64_t kBlockSize = 16;
+    constexpr uint64_t kMinSlabSize = 64;
+    constexpr uint64_t kMaxSlabSize = 256;
+    constexpr uint64_t kBlocksPerMinSlab = kMinSlabSize / kBlockSize;
+
+    SlabRetentionPolicy retentionPolicy = {};
+    retentionPolicy.MaxEmptySlabCount = 1;
+
+    SlabMemoryAllocator allocator(kBlockSize, kMaxSlabSize, kMinSlabSize, kDefaultSlabAlignment,
+                                  kDefaultSlabFragmentationLimit, kNoSlabPrefetchAllowed,
+                                  /*slabGrowthFactor*/ 2, dummyMemoryAllocator.get(),
+                                  retentionPolicy);
+
+    // Fill two 64 byte slabs, then a 128 byte one.
+    std::vector<std::unique_ptr<MemoryAllocation>> allocations;
+    for (uint64_t i = 0; i < kBlocksPerMinSlab * 4; i++) {
+        allocations.push_back(allocator.TryAllocateMemory(CreateBasicRequest(kBlockSize, 1)));
+        ASSERT_NE(allocations.back(), nullptr);
+    }
+
+    EXPECT_EQ(allocator.GetStats().UsedMemoryCount, 3u);
+
+    // Empty the first 64 byte slab so it gets retained.
+    const IMemoryObject* retainedMemory = allocations[0]->GetMemory();
+    for (uint64_t i = 0; i < kBlocksPerMinSlab; i++) {
+        allocator.DeallocateMemory(std::move(allocations[i]));
+    }
+
+    EXPECT_EQ(allocator.GetRetainedSlabUsage(), kMinSlabSize);
+
+    // The next slab would be 128 bytes, but the retained slab is used instead.
+    std::unique_ptr<MemoryAllocation> allocation =
+        allocator.TryAllocateMemory(CreateBasicRequest(kBlockSize, 1));
+    ASSERT_NE(allocation, nullptr);
+    EXPECT_EQ(allocation->GetMemory(), retainedMemory);
+    EXPECT_EQ(allocator.GetRetainedSlabUsage(), 0u);
+    EXPECT_EQ(allocator.GetStats().UsedMemoryCount, 3u);
+
+    allocator.DeallocateMemory(std::move(allocation));
+    for (auto& remaining : allocations) {
+        if (remaining != nullptr) {
+            allocator.DeallocateMemory(std::move(remaining));
+        }
+    }
+}
+
+// Verify ReleaseMemory releases the largest retained slabs first.
+TEST_F(SlabMemoryAllocatorTests, ReleaseRetainedSlabs) {
+    std::unique_ptr<DummyMemoryAllocator> dummyMemoryAllocator =
+        std::make_unique<DummyMemoryAllocator>();
+
+    constexpr uint64_t kBlockSize = 16;
+    constexpr uint64_t kMinSlabSize = 64;
+    constexpr uint64_t kMaxSlabSize = 256;
+
+    SlabRetentionPolicy retentionPolicy = {};
+    retentionPolicy.MaxEmptySlabCount = 3;
+
+    SlabMemoryAllocator allocator(kBlockSize, kMaxSlabSize, kMinSlabSize, kDefaultSlabAlignment,
+                                  kDefaultSlabFragmentationLimit, kNoSlabPrefetchAllowed,
+                                  /*slabGrowthFactor*/ 2, dummyMemoryAllocator.get(),
+                                  retentionPolicy);
+
+    // Fill two 64 byte slabs, then use a 128 byte one.
+    std::vector<std::unique_ptr<MemoryAllocation>> allocations;
+    for (uint64_t i = 0; i < (kMinSlabSize / kBlockSize) * 2 + 1; i++) {
+        allocations.push_back(allocator.TryAllocateMemory(CreateBasicRequest(kBlockSize, 1)));
+        ASSERT_NE(allocations.back(), nullptr);
+    }
+
+    EXPECT_EQ(allocator.GetStats().UsedMemoryUsage, kMinSlabSize * 4);
+
+    for (auto& allocation : allocations) {
+        allocator.DeallocateMemory(std::move(allocation));
+    }
+
+    EXPECT_EQ(allocator.GetRetainedSlabUsage(), kMinSlabSize * 4);
+
+    EXPECT_EQ(allocator.ReleaseMemory(1), kMinSlabSize * 2);
+    EXPECT_EQ(allocator.GetRetainedSlabUsage(), kMinSlabSize * 2);
+    EXPECT_EQ(allocator.GetStats().UsedMemoryCount, 2u);
+
+    EXPECT_EQ(allocator.ReleaseMemory(kMinSlabSize + 1), kMinSlabSize * 2);
+    EXPECT_EQ(allocator.GetRetainedSlabUsage(), 0u);
+    EXPECT_EQ(allocator.GetStats().UsedMemoryCount, 0u);
+
+    EXPECT_EQ(allocator.ReleaseMemory(), 0u);
+}
+
+// Verify slab sizes follow the observed demand.
+TEST_F(SlabMemoryAllocatorTests, AdaptiveSlabSize) {
+    std::unique_ptr<DummyMemoryAllocator> dummyMemoryAllocator =
+        std::make_unique<DummyMemoryAllocator>();
+
+    constexpr uint64_t kBlockSize = 16;
+    constexpr uint64_t kMinSlabSize = 64;
+    constexpr uint64_t kMaxSlabSize = 1024;
+    constexpr uint64_t kMaxBlockCount = kMaxSlabSize / kBlockSize;
+
+    SlabMemoryAllocator allocator(kBlockSize, kMaxSlabSize, kMinSlabSize, kDefaultSlabAlignment,
+                                  kDefaultSlabFragmentationLimit, kNoSlabPrefetchAllowed,
+                                  kDisableSlabGrowth, dummyMemoryAllocator.get(),
+                                  /*retentionPolicy*/ {}, /*allowAdaptiveSlabSize*/ true);
+
+    // While growing, each slab is as large as the slabs before it.
+    std::vector<std::unique_ptr<MemoryAllocation>> allocations;
+    for (uint64_t i = 0; i < kMaxBlockCount; i++) {
+        allocations.push_back(allocator.TryAllocateMemory(CreateBasicRequest(kBlockSize, 1)));
+        ASSERT_NE(allocations.back(), nullptr);
+    }
+
+    // 64 + 64 + 128 + 256 + 512 bytes.
+    EXPECT_EQ(allocator.GetStats().UsedMemoryCount, 5u);
+    EXPECT_EQ(allocator.GetStats().UsedMemoryUsage, kMaxSlabSize);
+
+    for (auto& allocation : allocations) {
+        allocator.DeallocateMemory(std::move(allocation));
+    }
+    allocations.clear();
+
+    EXPECT_EQ(allocator.GetStats().UsedMemoryCount, 0u);
+
+    // Once demand returns, one slab covers the previous peak.
+    for (uint64_t i = 0; i < kMaxBlockCount; i++) {
+        allocations.push_back(allocator.TryAllocateMemory(CreateBasicRequest(kBlockSize, 1)));
+        ASSERT_NE(allocations.back(), nullptr);
+    }
+
+    EXPECT_EQ(allocator.GetStats().UsedMemoryCount, 1u);
+    EXPECT_EQ(allocator.GetStats().UsedMemoryUsage, kMaxSlabSize);
+
+    for (auto& allocation : allocations) {
+        allocator.DeallocateMemory(std::move(allocation));
+    }
+
+    EXPECT_EQ(allocator.GetStats().UsedMemoryCount, 0u);
+}
+
 class SlabCacheAllocatorTests : public SlabMemoryAllocatorTests {};
 
 // Attempting to allocate a block greater then the slab should always fail.
@@ -1099,3 +1533,496 @@ TEST_F(SlabCacheAllocatorTests, OutOfMemory) {
         allocator.DeallocateMemory(std::move(allocation));
     }
 }
+
+// Verify a batch of mixed sizes is allocated in request order and failures do not fail the batch.
+TEST_F(SlabCacheAllocatorTests, AllocateBatch) {
+    SlabCacheAllocator allocator(kDefaultSlabSize, kDefaultSlabSize, kDefaultSlabAlignment,
+                                 kDefaultSlabFragmentationLimit, kNoSlabPrefetchAllowed,
+                                 kDisableSlabGrowth, std::make_unique<DummyMemoryAllocator>());
+
+    std::vector<MemoryAllocationRequest> requests;
+    requests.push_back(CreateBasicRequest(16, 1));
+    requests.push_back(CreateBasicRequest(32, 1));
+    requests.push_back(CreateBasicRequest(kDefaultSlabSize * 2, 1));  // Too large, fails.
+    requests.push_back(CreateBasicRequest(16, 1));
+    requests.push_back(CreateBasicRequest(24, 32));  // Same block size as 32.
+
+    std::vector<std::unique_ptr<MemoryAllocation>> allocations =
+        allocator.TryAllocateMemoryBatch(requests.data(), requests.size());
+    ASSERT_EQ(allocations.size(), requests.size());
+
+    EXPECT_EQ(allocations[2], nullptr);
+    for (uint64_t i = 0; i < allocations.size(); i++) {
+        if (i == 2) {
+            continue;
+        }
+        ASSERT_NE(allocations[i], nullptr);
+        EXPECT_EQ(allocations[i]->GetAllocator(), &allocator);
+        EXPECT_EQ(allocations[i]->GetRequestSize(), requests[i].SizeInBytes);
+        EXPECT_EQ(allocations[i]->GetSize(),
+                  AlignTo(requests[i].SizeInBytes, requests[i].Alignment));
+    }
+
+    // Requests of the same block size are allocated in order from the same slab.
+    EXPECT_EQ(allocations[0]->GetMemory(), allocations[3]->GetMemory());
+    EXPECT_LT(allocations[0]->GetOffset(), allocations[3]->GetOffset());
+    EXPECT_EQ(allocations[1]->GetMemory(), allocations[4]->GetMemory());
+    EXPECT_LT(allocations[1]->GetOffset(), allocations[4]->GetOffset());
+
+    EXPECT_EQ(allocator.GetStats().UsedBlockCount, 4u);
+    EXPECT_EQ(allocator.GetStats().UsedMemoryCount, 2u);
+
+    allocator.DeallocateMemoryBatch(std::move(allocations));
+
+    EXPECT_EQ(allocator.GetStats().UsedBlockCount, 0u);
+    EXPECT_EQ(allocator.GetStats().UsedMemoryUsage, 0u);
+}
+
+// Verify allocations of different sizes can be made from many threads.
+TEST_F(SlabCacheAllocatorTests, AllocateManyThreadedMultipleSizes) {
+    constexpr uint64_t kMaxSlabSize = 4096;
+    SlabCacheAllocator allocator(kMaxSlabSize, kDefaultSlabSize, kDefaultSlabAlignment,
+                                 kDefaultSlabFragmentationLimit, kNoSlabPrefetchAllowed,
+                                 kDisableSlabGrowth, std::make_unique<DummyMemoryAllocator>());
+
+    constexpr uint64_t kThreadCount = 8;
+    constexpr uint64_t kAllocationsPerThread = 64;
+
+    auto allocateThenDeallocate = [&](uint64_t threadIndex) {
+        const uint64_t blockSize = 8u << (threadIndex % 4);
+        std::vector<std::unique_ptr<MemoryAllocation>> allocations;
+        for (uint64_t i = 0; i < kAllocationsPerThread; i++) {
+            allocations.push_back(allocator.TryAllocateMemory(CreateBasicRequest(blockSize, 1)));
+            ASSERT_NE(allocations.back(), nullptr);
+            EXPECT_EQ(allocations.back()->GetSize(), blockSize);
+        }
+        for (auto& allocation : allocations) {
+            allocator.DeallocateMemory(std::move(allocation));
+        }
+    };
+
+    std::vector<std::thread> threads(kThreadCount);
+    for (uint64_t i = 0; i < threads.size(); i++) {
+        threads[i] = std::thread([&, i]() { allocateThenDeallocate(i); });
+    }
+
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(allocator.GetStats().UsedBlockCount, 0u);
+    EXPECT_EQ(allocator.GetStats().UsedMemoryUsage, 0u);
+}
+
+// Verify slab allocators keep their retained slabs until released.
+TEST_F(SlabCacheAllocatorTests, ReleaseRetainedSlabs) {
+    constexpr uint64_t kMaxSlabSize = 256;
+    constexpr uint64_t kBlockSize = 16;
+
+    SlabRetentionPolicy retentionPolicy = {};
+    retentionPolicy.MaxEmptySlabCount = 1;
+
+    SlabCacheAllocator allocator(kMaxSlabSize, kDefaultSlabSize, kDefaultSlabAlignment,
+                                 kDefaultSlabFragmentationLimit, kNoSlabPrefetchAllowed,
+                                 kDisableSlabGrowth, std::make_unique<DummyMemoryAllocator>(),
+                                 retentionPolicy);
+
+    std::unique_ptr<MemoryAllocation> allocation =
+        allocator.TryAllocateMemory(CreateBasicRequest(kBlockSize, 1));
+    ASSERT_NE(allocation, nullptr);
+    allocator.DeallocateMemory(std::move(allocation));
+
+    EXPECT_EQ(allocator.GetStats().UsedMemoryUsage, kDefaultSlabSize);
+
+    // Re-uses the retained slab.
+    allocation = allocator.TryAllocateMemory(CreateBasicRequest(kBlockSize, 1));
+    ASSERT_NE(allocation, nullptr);
+    EXPECT_EQ(allocator.GetStats().UsedMemoryCount, 1u);
+    allocator.DeallocateMemory(std::move(allocation));
+
+    EXPECT_EQ(allocator.ReleaseMemory(), kDefaultSlabSize);
+    EXPECT_EQ(allocator.GetStats().UsedMemoryUsage, 0u);
+}
+
+// Verify sizes of the same size class share a slab allocator unless rounding wastes too much.
+TEST_F(SlabCacheAllocatorTests, SizeClassPolicy) {
+    constexpr uint64_t kMaxSlabSize = 256;
+
+    SlabSizeClassPolicy sizeClassPolicy = {};
+    sizeClassPolicy.SizeClassesPerDoubling = 4;
+
+    {
+        SlabCacheAllocator allocator(kMaxSlabSize, kDefaultSlabSize, kDefaultSlabAlignment,
+                                     kDefaultSlabFragmentationLimit, kNoSlabPrefetchAllowed,
+                                     kDisableSlabGrowth, std::make_unique<DummyMemoryAllocator>(),
+                                     /*retentionPolicy*/ {}, /*allowAdaptiveSlabSize*/ false,
+                                     sizeClassPolicy);
+
+        // 17 through 20 bytes all round up to 20 bytes and share the same slab.
+        std::vector<std::unique_ptr<MemoryAllocation>> allocations;
+        for (uint64_t size = 17; size <= 20; size++) {
+            allocations.push_back(allocator.TryAllocateMemory(CreateBasicRequest(size, 1)));
+            ASSERT_NE(allocations.back(), nullptr);
+            EXPECT_EQ(allocations.back()->GetSize(), 20u);
+        }
+
+        // 21 bytes rounds up to the next size class.
+        allocations.push_back(allocator.TryAllocateMemory(CreateBasicRequest(21, 1)));
+        ASSERT_NE(allocations.back(), nullptr);
+        EXPECT_EQ(allocations.back()->GetSize(), 24u);
+
+        const MemoryAllocatorStats stats = allocator.GetStats();
+        EXPECT_EQ(stats.UsedMemoryCount, 2u);
+        EXPECT_EQ(stats.InternalFragmentationUsage, 3u + 2u + 1u + 3u);
+
+        MemorySizeClassStats sizeClassStats[2] = {};
+        ASSERT_EQ(allocator.GetSizeClassStats(sizeClassStats, 2), 2u);
+        EXPECT_EQ(sizeClassStats[0].BlockSize, 20u);
+        EXPECT_EQ(sizeClassStats[0].UsedBlockCount, 4u);
+        EXPECT_EQ(sizeClassStats[0].InternalFragmentationUsage, 3u + 2u + 1u);
+        EXPECT_EQ(sizeClassStats[1].BlockSize, 24u);
+        EXPECT_EQ(sizeClassStats[1].UsedBlockCount, 1u);
+        EXPECT_EQ(sizeClassStats[1].InternalFragmentationUsage, 3u);
+
+        // Only the first size classes are returned if the array is too small.
+        sizeClassStats[1] = {};
+        EXPECT_EQ(allocator.GetSizeClassStats(sizeClassStats, 1), 2u);
+        EXPECT_EQ(sizeClassStats[0].BlockSize, 20u);
+        EXPECT_EQ(sizeClassStats[1].BlockSize, 0u);
+        EXPECT_EQ(allocator.GetSizeClassStats(nullptr, 0), 2u);
+
+        for (auto& allocation : allocations) {
+            allocator.DeallocateMemory(std::move(allocation));
+        }
+
+        EXPECT_EQ(allocator.GetStats().UsedBlockCount, 0u);
+        EXPECT_EQ(allocator.GetStats().InternalFragmentationUsage, 0u);
+    }
+
+    // Sizes that would waste more than the max are not rounded.
+    sizeClassPolicy.MaxWasteRatio = 0.1;
+    {
+        SlabCacheAllocator allocator(kMaxSlabSize, kDefaultSlabSize, kDefaultSlabAlignment,
+                                     kDefaultSlabFragmentationLimit, kNoSlabPrefetchAllowed,
+                                     kDisableSlabGrowth, std::make_unique<DummyMemoryAllocator>(),
+                                     /*retentionPolicy*/ {}, /*allowAdaptiveSlabSize*/ false,
+                                     sizeClassPolicy);
+
+        std::unique_ptr<MemoryAllocation> allocation =
+            allocator.TryAllocateMemory(CreateBasicRequest(17, 1));
+        ASSERT_NE(allocation, nullptr);
+        EXPECT_EQ(allocation->GetSize(), 17u);
+        allocator.DeallocateMemory(std::move(allocation));
+
+        allocation = allocator.TryAllocateMemory(CreateBasicRequest(19, 1));
+        ASSERT_NE(allocation, nullptr);
+        EXPECT_EQ(allocation->GetSize(), 20u);
+        allocator.DeallocateMemory(std::move(allocation));
+    }
+}
+
+// Verify unrounded block sizes of the same size class are cached by separate slab allocators.
+TEST_F(SlabCacheAllocatorTests, SameSizeClassBlockSizes) {
+    constexpr uint64_t kMaxSlabSize = 256;
+    SlabCacheAllocator allocator(kMaxSlabSize, kDefaultSlabSize, kDefaultSlabAlignment,
+                                 kDefaultSlabFragmentationLimit, kNoSlabPrefetchAllowed,
+                                 kDisableSlabGrowth, std::make_unique<DummyMemoryAllocator>());
+
+    // 17 through 20 bytes belong to the same size class but are not rounded.
+    std::vector<std::unique_ptr<MemoryAllocation>> allocations;
+    for (uint64_t size = 20; size >= 17; size--) {
+        allocations.push_back(allocator.TryAllocateMemory(CreateBasicRequest(size, 1)));
+        ASSERT_NE(allocations.back(), nullptr);
+        EXPECT_EQ(allocations.back()->GetSize(), size);
+    }
+
+    EXPECT_EQ(allocator.GetStats().UsedMemoryCount, 4u);
+    EXPECT_EQ(allocator.GetStats().SizeCacheMisses, 4u);
+
+    // Same sizes are found again, whichever entry caches them.
+    for (uint64_t size = 17; size <= 20; size++) {
+        allocations.push_back(allocator.TryAllocateMemory(CreateBasicRequest(size, 1)));
+        ASSERT_NE(allocations.back(), nullptr);
+    }
+
+    EXPECT_EQ(allocator.GetStats().UsedMemoryCount, 4u);
+    EXPECT_EQ(allocator.GetStats().SizeCacheHits, 4u);
+
+    MemorySizeClassStats sizeClassStats[4] = {};
+    ASSERT_EQ(allocator.GetSizeClassStats(sizeClassStats, 4), 4u);
+    for (uint64_t i = 0; i < 4; i++) {
+        EXPECT_EQ(sizeClassStats[i].BlockSize, 17u + i);
+        EXPECT_EQ(sizeClassStats[i].UsedBlockCount, 2u);
+    }
+
+    // Free the size class entry first so the others outlive it.
+    allocator.DeallocateMemory(std::move(allocations[0]));
+    allocator.DeallocateMemory(std::move(allocations[7]));
+    EXPECT_EQ(allocator.GetSizeClassStats(nullptr, 0), 3u);
+
+    // The freed size class entry gets re-used while the others remain cached.
+    std::unique_ptr<MemoryAllocation> allocation =
+        allocator.TryAllocateMemory(CreateBasicRequest(20, 1));
+    ASSERT_NE(allocation, nullptr);
+    EXPECT_EQ(allocator.GetSizeClassStats(nullptr, 0), 4u);
+    allocator.DeallocateMemory(std::move(allocation));
+
+    allocator.DeallocateMemoryBatch(std::move(allocations));
+
+    EXPECT_EQ(allocator.GetStats().UsedBlockCount, 0u);
+    EXPECT_EQ(allocator.GetSizeClassStats(nullptr, 0), 0u);
+}
+
+// Verify allocations of a group are packed into the slab of the group before any other.
+TEST_F(SlabMemoryAllocatorTests, GroupKey) {
+    constexpr uint64_t kBlockSize = 32;
+    constexpr uint64_t kMaxSlabSize = kDefaultSlabSize;
+    constexpr uint64_t kBlocksPerSlab = kDefaultSlabSize / kBlockSize;
+
+    SlabCacheAllocator allocator(kMaxSlabSize, kDefaultSlabSize, kDefaultSlabAlignment,
+                                 kDefaultSlabFragmentationLimit, kNoSlabPrefetchAllowed,
+                                 kDisableSlabGrowth, std::make_unique<DummyMemoryAllocator>());
+
+    // Fill the first slab so the group starts in the second.
+    std::vector<std::unique_ptr<MemoryAllocation>> allocations;
+    for (uint64_t i = 0; i < kBlocksPerSlab; i++) {
+        allocations.push_back(allocator.TryAllocateMemory(CreateBasicRequest(kBlockSize, 1)));
+        ASSERT_NE(allocations.back(), nullptr);
+    }
+
+    MemoryAllocationRequest request = CreateBasicRequest(kBlockSize, 1);
+    request.GroupKey = 1;
+
+    std::unique_ptr<MemoryAllocation> allocationA = allocator.TryAllocateMemory(request);
+    ASSERT_NE(allocationA, nullptr);
+    EXPECT_NE(allocationA->GetMemory(), allocations[0]->GetMemory());
+    EXPECT_EQ(allocator.GetStats().UsedMemoryCount, 2u);
+
+    // Free a block of the first slab so it would be the next free slab.
+    allocator.DeallocateMemory(std::move(allocations.back()));
+    allocations.pop_back();
+
+    // The group re-uses its slab instead of the next free slab.
+    std::unique_ptr<MemoryAllocation> allocationB = allocator.TryAllocateMemory(request);
+    ASSERT_NE(allocationB, nullptr);
+    EXPECT_EQ(allocationB->GetMemory(), allocationA->GetMemory());
+    EXPECT_EQ(allocator.GetStats().GroupCount, 1u);
+    EXPECT_EQ(allocator.GetStats().GroupMemoryCount, 1u);
+
+    // Another group uses the next free slab, then the slab of the first group, instead of
+    // creating a slab of its own.
+    MemoryAllocationRequest otherRequest = request;
+    otherRequest.GroupKey = 2;
+
+    std::unique_ptr<MemoryAllocation> allocationC = allocator.TryAllocateMemory(otherRequest);
+    ASSERT_NE(allocationC, nullptr);
+    EXPECT_EQ(allocationC->GetMemory(), allocations[0]->GetMemory());
+
+    std::unique_ptr<MemoryAllocation> allocationD = allocator.TryAllocateMemory(otherRequest);
+    ASSERT_NE(allocationD, nullptr);
+    EXPECT_EQ(allocationD->GetMemory(), allocationA->GetMemory());
+
+    EXPECT_EQ(allocator.GetStats().UsedMemoryCount, 2u);
+    EXPECT_EQ(allocator.GetStats().GroupCount, 2u);
+    EXPECT_EQ(allocator.GetStats().GroupMemoryCount, 3u);
+
+    for (auto& allocation : allocations) {
+        allocator.DeallocateMemory(std::move(allocation));
+    }
+    allocator.DeallocateMemory(std::move(allocationA));
+    allocator.DeallocateMemory(std::move(allocationB));
+    allocator.DeallocateMemory(std::move(allocationC));
+    allocator.DeallocateMemory(std::move(allocationD));
+
+    EXPECT_EQ(allocator.GetStats().GroupCount, 0u);
+    EXPECT_EQ(allocator.GetStats().GroupMemoryCount, 0u);
+    EXPECT_EQ(allocator.GetStats().UsedMemoryCount, 0u);
+}
+
+// Verify many groups of a single small allocation share slabs instead of creating one each.
+TEST_F(SlabMemoryAllocatorTests, GroupKeyManyGroups) {
+    constexpr uint64_t kBlockSize = 32;
+    constexpr uint64_t kMaxSlabSize = kDefaultSlabSize;
+    constexpr uint64_t kGroupCount = kDefaultSlabSize / kBlockSize;
+
+    SlabCacheAllocator allocator(kMaxSlabSize, kDefaultSlabSize, kDefaultSlabAlignment,
+                                 kDefaultSlabFragmentationLimit, kNoSlabPrefetchAllowed,
+                                 kDisableSlabGrowth, std::make_unique<DummyMemoryAllocator>());
+
+    std::vector<std::unique_ptr<MemoryAllocation>> allocations;
+    for (uint64_t groupKey = 1; groupKey <= kGroupCount; groupKey++) {
+        MemoryAllocationRequest request = CreateBasicRequest(kBlockSize, 1);
+        request.GroupKey = groupKey;
+        allocations.push_back(allocator.TryAllocateMemory(request));
+        ASSERT_NE(allocations.back(), nullptr);
+    }
+
+    EXPECT_EQ(allocator.GetStats().UsedMemoryCount, 1u);
+    EXPECT_EQ(allocator.GetStats().GroupCount, kGroupCount);
+    EXPECT_EQ(allocator.GetStats().GroupMemoryCount, kGroupCount);
+
+    for (auto& allocation : allocations) {
+        allocator.DeallocateMemory(std::move(allocation));
+    }
+
+    EXPECT_EQ(allocator.GetStats().UsedMemoryCount, 0u);
+}
+
+// Verify prefetched memory of the wrong size is parked instead of released.
+TEST_F(SlabMemoryAllocatorTests, ParkPrefetchedSlabs) {
+    constexpr uint64_t kBlockSize = 32;
+    constexpr uint64_t kMaxSlabSize = 512;
+
+    std::unique_ptr<DummyMemoryAllocator> dummyMemoryAllocator =
+        std::make_unique<DummyMemoryAllocator>();
+
+    SlabMemoryAllocator allocator(kBlockSize, kMaxSlabSize, kDefaultSlabSize,
+                                  kDefaultSlabAlignment, kDefaultSlabFragmentationLimit,
+                                  kAllowSlabPrefetching, kDisableSlabGrowth,
+                                  dummyMemoryAllocator.get());
+
+    // Fill the first slab, which prefetches memory for the next slab of the same size.
+    MemoryAllocationRequest request = CreateBasicRequest(kBlockSize, 1);
+    request.AlwaysPrefetch = true;
+
+    std::vector<std::unique_ptr<MemoryAllocation>> allocations = {};
+    for (uint64_t i = 0; i < kDefaultSlabSize / kBlockSize; i++) {
+        allocations.push_back(allocator.TryAllocateMemory(request));
+        ASSERT_NE(allocations.back(), nullptr);
+    }
+
+    // A smaller request needs a larger slab to stay under the fragmentation limit.
+    allocations.push_back(allocator.TryAllocateMemory(CreateBasicRequest(kBlockSize / 4, 1)));
+    ASSERT_NE(allocations.back(), nullptr);
+    EXPECT_EQ(allocations.back()->GetMemory()->GetSize(), kDefaultSlabSize * 2);
+
+    EXPECT_EQ(allocator.GetStats().PrefetchedMemoryMisses, 1u);
+    EXPECT_EQ(allocator.GetStats().PrefetchedMemoryParkedUsage, kDefaultSlabSize);
+    EXPECT_EQ(dummyMemoryAllocator->GetStats().UsedMemoryCount, 3u);
+
+    // Parked memory is released first.
+    EXPECT_EQ(allocator.ReleaseMemory(kDefaultSlabSize), kDefaultSlabSize);
+    EXPECT_EQ(allocator.GetStats().PrefetchedMemoryParkedUsage, 0u);
+    EXPECT_EQ(allocator.GetStats().PrefetchedMemoryWasted, 1u);
+    EXPECT_EQ(dummyMemoryAllocator->GetStats().UsedMemoryCount, 2u);
+
+    for (auto& allocation : allocations) {
+        allocator.DeallocateMemory(std::move(allocation));
+    }
+}
+
+// Verify prefetched memory of the wrong size is re-homed to another slab allocator needing it.
+TEST_F(SlabMemoryAllocatorTests, RehomePrefetchedSlabs) {
+    constexpr uint64_t kBlockSize = 32;
+    constexpr uint64_t kMaxSlabSize = 512;
+
+    std::unique_ptr<DummyMemoryAllocator> dummyMemoryAllocator =
+        std::make_unique<DummyMemoryAllocator>();
+
+    SlabMemoryExchange slabMemoryExchange(dummyMemoryAllocator.get());
+
+    SlabMemoryAllocator allocator(kBlockSize, kMaxSlabSize, kDefaultSlabSize,
+                                  kDefaultSlabAlignment, kDefaultSlabFragmentationLimit,
+                                  kAllowSlabPrefetching, kDisableSlabGrowth,
+                                  dummyMemoryAllocator.get(), /*retentionPolicy*/ {},
+                                  /*allowAdaptiveSlabSize*/ false, &slabMemoryExchange);
+
+    SlabMemoryAllocator otherAllocator(kBlockSize, kMaxSlabSize, kDefaultSlabSize,
+                                       kDefaultSlabAlignment, kDefaultSlabFragmentationLimit,
+                                       kNoSlabPrefetchAllowed, kDisableSlabGrowth,
+                                       dummyMemoryAllocator.get(), /*retentionPolicy*/ {},
+                                       /*allowAdaptiveSlabSize*/ false, &slabMemoryExchange);
+
+    // The other allocator needs a slab of the default size next.
+    std::vector<std::unique_ptr<MemoryAllocation>> otherAllocations = {};
+    otherAllocations.push_back(otherAllocator.TryAllocateMemory(CreateBasicRequest(kBlockSize, 1)));
+    ASSERT_NE(otherAllocations.back(), nullptr);
+
+    // Fill the first slab, which prefetches memory for the next slab of the same size.
+    MemoryAllocationRequest request = CreateBasicRequest(kBlockSize, 1);
+    request.AlwaysPrefetch = true;
+
+    std::vector<std::unique_ptr<MemoryAllocation>> allocations = {};
+    for (uint64_t i = 0; i < kDefaultSlabSize / kBlockSize; i++) {
+        allocations.push_back(allocator.TryAllocateMemory(request));
+        ASSERT_NE(allocations.back(), nullptr);
+    }
+
+    // A smaller request needs a larger slab, so the prefetched memory is re-homed instead.
+    allocations.push_back(allocator.TryAllocateMemory(CreateBasicRequest(kBlockSize / 4, 1)));
+    ASSERT_NE(allocations.back(), nullptr);
+
+    EXPECT_EQ(allocator.GetStats().PrefetchedMemoryMisses, 1u);
+    EXPECT_EQ(allocator.GetStats().PrefetchedMemoryParkedUsage, 0u);
+    EXPECT_EQ(slabMemoryExchange.GetStats().PrefetchedMemoryParkedUsage, kDefaultSlabSize);
+    EXPECT_EQ(dummyMemoryAllocator->GetStats().UsedMemoryCount, 4u);
+
+    // The next slab of the other allocator uses it instead of creating memory.
+    for (uint64_t i = 0; i < kDefaultSlabSize / kBlockSize; i++) {
+        otherAllocations.push_back(
+            otherAllocator.TryAllocateMemory(CreateBasicRequest(kBlockSize, 1)));
+        ASSERT_NE(otherAllocations.back(), nullptr);
+    }
+
+    EXPECT_EQ(otherAllocator.GetStats().PrefetchedMemorySalvagedUsage, kDefaultSlabSize);
+    EXPECT_EQ(slabMemoryExchange.GetStats().PrefetchedMemoryParkedUsage, 0u);
+    EXPECT_EQ(dummyMemoryAllocator->GetStats().UsedMemoryCount, 4u);
+
+    for (auto& allocation : allocations) {
+        allocator.DeallocateMemory(std::move(allocation));
+    }
+
+    for (auto& allocation : otherAllocations) {
+        otherAllocator.DeallocateMemory(std::move(allocation));
+    }
+}
+
+// Verify the exchange keeps no more memory of a size than other slab allocators need.
+TEST_F(SlabMemoryAllocatorTests, SlabMemoryExchange) {
+    std::unique_ptr<DummyMemoryAllocator> dummyMemoryAllocator =
+        std::make_unique<DummyMemoryAllocator>();
+
+    SlabMemoryExchange slabMemoryExchange(dummyMemoryAllocator.get());
+
+    SlabMemoryAllocator allocator(kDefaultSlabSize, kDefaultSlabSize, kDefaultSlabSize,
+                                  kDefaultSlabAlignment, kDefaultSlabFragmentationLimit,
+                                  kNoSlabPrefetchAllowed, kDisableSlabGrowth,
+                                  dummyMemoryAllocator.get());
+
+    SlabMemoryAllocator otherAllocator(kDefaultSlabSize, kDefaultSlabSize, kDefaultSlabSize,
+                                       kDefaultSlabAlignment, kDefaultSlabFragmentationLimit,
+                                       kNoSlabPrefetchAllowed, kDisableSlabGrowth,
+                                       dummyMemoryAllocator.get());
+
+    std::unique_ptr<MemoryAllocation> slabMemory =
+        dummyMemoryAllocator->TryAllocateMemory(CreateBasicRequest(kDefaultSlabSize, 1));
+    ASSERT_NE(slabMemory, nullptr);
+
+    // No other slab allocator needs the size.
+    EXPECT_FALSE(slabMemoryExchange.TryOffer(&allocator, *slabMemory));
+
+    slabMemoryExchange.SetNextSlabSize(&allocator, kDefaultSlabSize);
+    EXPECT_FALSE(slabMemoryExchange.TryOffer(&allocator, *slabMemory));
+
+    slabMemoryExchange.SetNextSlabSize(&otherAllocator, kDefaultSlabSize * 2);
+    EXPECT_FALSE(slabMemoryExchange.TryOffer(&allocator, *slabMemory));
+
+    // Only one slab is kept for the other slab allocator.
+    slabMemoryExchange.SetNextSlabSize(&otherAllocator, kDefaultSlabSize);
+    EXPECT_TRUE(slabMemoryExchange.TryOffer(&allocator, *slabMemory));
+    EXPECT_FALSE(slabMemoryExchange.TryOffer(&allocator, *slabMemory));
+
+    EXPECT_EQ(slabMemoryExchange.TryTake(kDefaultSlabSize * 2), nullptr);
+    slabMemory = slabMemoryExchange.TryTake(kDefaultSlabSize);
+    ASSERT_NE(slabMemory, nullptr);
+    EXPECT_EQ(slabMemoryExchange.GetStats().PrefetchedMemoryParkedUsage, 0u);
+
+    // Memory never taken is released.
+    EXPECT_TRUE(slabMemoryExchange.TryOffer(&allocator, *slabMemory));
+    EXPECT_EQ(slabMemoryExchange.ReleaseMemory(kInvalidSize), kDefaultSlabSize);
+    EXPECT_EQ(slabMemoryExchange.GetStats().PrefetchedMemoryWasted, 1u);
+    EXPECT_EQ(dummyMemoryAllocator->GetStats().UsedMemoryCount, 0u);
+
+    slabMemoryExchange.SetNextSlabSize(&allocator, 0);
+    slabMemoryExchange.SetNextSlabSize(&otherAllocator, 0);
+}
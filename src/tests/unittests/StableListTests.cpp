@@ -246,6 +246,25 @@ TEST(StableListTests, Enumerate) {
         EXPECT_EQ(n, 6);
     }
 
+    // Over holes at the front.
+    {
+        StableList<int, 2> list;
+        list.push_back(0xdeadbeef);
+        list.push_back(0xdeadbeef);
+        list.push_back(2);
+        list.push_back(3);
+
+        list.erase(0);
+        list.erase(1);
+
+        int i = 2;
+        for (auto& it : list) {
+            EXPECT_EQ(it, i++);
+        }
+
+        EXPECT_EQ(i, 4);
+    }
+
     // Over empty list.
     {
         StableList<int, 4> list;
@@ -0,0 +1,178 @@
+// Copyright 2022 The GPGMM Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include "gpgmm/common/TLSFBlockAllocator.h"
+#include "gpgmm/utils/Math.h"
+
+#include <vector>
+
+using namespace gpgmm;
+
+// Verify a single block that spans the entire range.
+TEST(TLSFBlockAllocatorTests, SingleBlock) {
+    constexpr uint64_t maxBlockSize = 5 * 1024;
+    TLSFBlockAllocator allocator(maxBlockSize);
+
+    // Cannot allocate an empty or oversized block.
+    EXPECT_EQ(allocator.TryAllocateBlock(0), nullptr);
+    EXPECT_EQ(allocator.TryAllocateBlock(maxBlockSize + 1), nullptr);
+
+    MemoryBlock* block = allocator.TryAllocateBlock(maxBlockSize);
+    ASSERT_NE(block, nullptr);
+    EXPECT_EQ(block->Offset, 0u);
+    EXPECT_EQ(block->Size, maxBlockSize);
+    EXPECT_EQ(allocator.ComputeTotalNumOfFreeBlocksForTesting(), 0u);
+
+    // Check that we are full.
+    EXPECT_EQ(allocator.TryAllocateBlock(1), nullptr);
+
+    allocator.DeallocateBlock(block);
+    EXPECT_TRUE(allocator.IsEmpty());
+    EXPECT_EQ(allocator.ComputeTotalNumOfFreeBlocksForTesting(), 1u);
+}
+
+// Verify blocks are exactly the requested size and are not rounded-up.
+TEST(TLSFBlockAllocatorTests, MultipleBlocks) {
+    constexpr uint64_t maxBlockSize = 1024;
+    TLSFBlockAllocator allocator(maxBlockSize);
+
+    MemoryBlock* blockA = allocator.TryAllocateBlock(100);
+    ASSERT_NE(blockA, nullptr);
+    EXPECT_EQ(blockA->Offset, 0u);
+    EXPECT_EQ(blockA->Size, 100u);
+
+    MemoryBlock* blockB = allocator.TryAllocateBlock(300);
+    ASSERT_NE(blockB, nullptr);
+    EXPECT_EQ(blockB->Offset, 100u);
+    EXPECT_EQ(blockB->Size, 300u);
+
+    MemoryBlock* blockC = allocator.TryAllocateBlock(624);
+    ASSERT_NE(blockC, nullptr);
+    EXPECT_EQ(blockC->Offset, 400u);
+    EXPECT_EQ(blockC->Size, 624u);
+
+    EXPECT_EQ(allocator.TryAllocateBlock(1), nullptr);
+
+    // De-allocate the middle block then re-use it.
+    allocator.DeallocateBlock(blockB);
+    EXPECT_EQ(allocator.ComputeTotalNumOfFreeBlocksForTesting(), 1u);
+
+    blockB = allocator.TryAllocateBlock(200);
+    ASSERT_NE(blockB, nullptr);
+    EXPECT_EQ(blockB->Offset, 100u);
+    EXPECT_EQ(allocator.ComputeTotalNumOfFreeBlocksForTesting(), 1u);
+
+    allocator.DeallocateBlock(blockA);
+    allocator.DeallocateBlock(blockC);
+    allocator.DeallocateBlock(blockB);
+
+    EXPECT_TRUE(allocator.IsEmpty());
+}
+
+// Verify free blocks are merged with both neighbors upon de-allocation.
+TEST(TLSFBlockAllocatorTests, MergeFreeBlocks) {
+    constexpr uint64_t blockSize = 64;
+    constexpr uint64_t blockCount = 8;
+    TLSFBlockAllocator allocator(blockSize * blockCount);
+
+    std::vector<MemoryBlock*> blocks;
+    for (uint64_t i = 0; i < blockCount; i++) {
+        blocks.push_back(allocator.TryAllocateBlock(blockSize));
+        ASSERT_NE(blocks.back(), nullptr);
+    }
+
+    // Every other block is free and cannot be merged.
+    for (uint64_t i = 0; i < blockCount; i += 2) {
+        allocator.DeallocateBlock(blocks[i]);
+    }
+    EXPECT_EQ(allocator.ComputeTotalNumOfFreeBlocksForTesting(), blockCount / 2);
+
+    // A larger block cannot fit until merged.
+    EXPECT_EQ(allocator.TryAllocateBlock(blockSize * 3), nullptr);
+
+    // Merges with the previous and next free blocks.
+    allocator.DeallocateBlock(blocks[1]);
+    EXPECT_EQ(allocator.ComputeTotalNumOfFreeBlocksForTesting(), blockCount / 2 - 1);
+
+    MemoryBlock* block = allocator.TryAllocateBlock(blockSize * 3);
+    ASSERT_NE(block, nullptr);
+    EXPECT_EQ(block->Offset, 0u);
+
+    allocator.DeallocateBlock(block);
+    for (uint64_t i = 3; i < blockCount; i += 2) {
+        allocator.DeallocateBlock(blocks[i]);
+    }
+
+    EXPECT_TRUE(allocator.IsEmpty());
+    EXPECT_EQ(allocator.ComputeTotalNumOfFreeBlocksForTesting(), 1u);
+}
+
+// Verify aligned blocks return the unaligned padding as a free block.
+TEST(TLSFBlockAllocatorTests, AlignedBlocks) {
+    constexpr uint64_t maxBlockSize = 1024;
+    TLSFBlockAllocator allocator(maxBlockSize);
+
+    MemoryBlock* blockA = allocator.TryAllocateBlock(10);
+    ASSERT_NE(blockA, nullptr);
+    EXPECT_EQ(blockA->Offset, 0u);
+
+    MemoryBlock* blockB = allocator.TryAllocateBlock(64, 256);
+    ASSERT_NE(blockB, nullptr);
+    EXPECT_EQ(blockB->Offset, 256u);
+    EXPECT_EQ(blockB->Size, 64u);
+
+    // Padding is re-used by the next fitting request.
+    MemoryBlock* blockC = allocator.TryAllocateBlock(128, 16);
+    ASSERT_NE(blockC, nullptr);
+    EXPECT_EQ(blockC->Offset, 16u);
+
+    // Alignment must be a power-of-two.
+    EXPECT_EQ(allocator.TryAllocateBlock(64, 3), nullptr);
+
+    allocator.DeallocateBlock(blockB);
+    allocator.DeallocateBlock(blockA);
+    allocator.DeallocateBlock(blockC);
+
+    EXPECT_TRUE(allocator.IsEmpty());
+}
+
+// Verify many blocks of various sizes can be allocated then de-allocated.
+TEST(TLSFBlockAllocatorTests, MultipleBlocksVarious) {
+    constexpr uint64_t maxBlockSize = 1 << 20;
+    TLSFBlockAllocator allocator(maxBlockSize);
+
+    std::vector<MemoryBlock*> blocks;
+    uint64_t usedSize = 0;
+    for (uint64_t i = 1; usedSize + i * 37 <= maxBlockSize / 2; i++) {
+        const uint64_t requestSize = i * 37;
+        MemoryBlock* block = allocator.TryAllocateBlock(requestSize);
+        ASSERT_NE(block, nullptr);
+        EXPECT_EQ(block->Size, requestSize);
+        blocks.push_back(block);
+        usedSize += requestSize;
+    }
+
+    // De-allocate every other block first so both merges are exercised.
+    for (uint64_t i = 0; i < blocks.size(); i += 2) {
+        allocator.DeallocateBlock(blocks[i]);
+    }
+    for (uint64_t i = 1; i < blocks.size(); i += 2) {
+        allocator.DeallocateBlock(blocks[i]);
+    }
+
+    EXPECT_TRUE(allocator.IsEmpty());
+    EXPECT_EQ(allocator.ComputeTotalNumOfFreeBlocksForTesting(), 1u);
+}
@@ -0,0 +1,197 @@
+// Copyright 2022 The GPGMM Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include "gpgmm/common/TLSFMemoryAllocator.h"
+#include "tests/DummyMemoryAllocator.h"
+
+#include <vector>
+
+using namespace gpgmm;
+
+static constexpr uint64_t kDefaultMemorySize = 1024u;
+static constexpr uint64_t kDefaultMemoryAlignment = 1u;
+
+class TLSFMemoryAllocatorTests : public testing::Test {
+  public:
+    MemoryAllocationRequest CreateBasicRequest(uint64_t size,
+                                               uint64_t alignment,
+                                               bool neverAllocate = false) {
+        MemoryAllocationRequest request = {};
+        request.SizeInBytes = size;
+        request.Alignment = alignment;
+        request.NeverAllocate = neverAllocate;
+        request.AlwaysCacheSize = false;
+        request.AlwaysPrefetch = false;
+        request.AvailableForAllocation = kInvalidSize;
+        return request;
+    }
+};
+
+// Verify variable-sized allocations share the same memory.
+TEST_F(TLSFMemoryAllocatorTests, SingleHeap) {
+    TLSFMemoryAllocator allocator(kDefaultMemorySize, kDefaultMemoryAlignment,
+                                  std::make_unique<DummyMemoryAllocator>());
+
+    // Cannot allocate greater than memory size.
+    EXPECT_EQ(allocator.TryAllocateMemory(CreateBasicRequest(kDefaultMemorySize + 1, 1)),
+              nullptr);
+
+    std::unique_ptr<MemoryAllocation> allocationA =
+        allocator.TryAllocateMemory(CreateBasicRequest(300, 1));
+    ASSERT_NE(allocationA, nullptr);
+    EXPECT_EQ(allocationA->GetOffset(), 0u);
+    EXPECT_EQ(allocationA->GetSize(), 300u);
+    EXPECT_EQ(allocationA->GetMethod(), AllocationMethod::kSubAllocated);
+
+    std::unique_ptr<MemoryAllocation> allocationB =
+        allocator.TryAllocateMemory(CreateBasicRequest(500, 1));
+    ASSERT_NE(allocationB, nullptr);
+    EXPECT_EQ(allocationB->GetOffset(), 300u);
+    EXPECT_EQ(allocationB->GetMemory(), allocationA->GetMemory());
+
+    EXPECT_EQ(allocator.GetStats().UsedMemoryCount, 1u);
+    EXPECT_EQ(allocator.GetStats().UsedBlockCount, 2u);
+    EXPECT_EQ(allocator.GetStats().UsedBlockUsage, 800u);
+
+    allocator.DeallocateMemory(std::move(allocationA));
+    EXPECT_EQ(allocator.GetStats().UsedMemoryCount, 1u);
+
+    allocator.DeallocateMemory(std::move(allocationB));
+    EXPECT_EQ(allocator.GetStats().UsedMemoryCount, 0u);
+    EXPECT_EQ(allocator.GetStats().UsedBlockCount, 0u);
+    EXPECT_EQ(allocator.GetStats().UsedBlockUsage, 0u);
+}
+
+// Verify new memory is only created once existing memory cannot fit the request.
+TEST_F(TLSFMemoryAllocatorTests, MultipleHeaps) {
+    TLSFMemoryAllocator allocator(kDefaultMemorySize, kDefaultMemoryAlignment,
+                                  std::make_unique<DummyMemoryAllocator>());
+
+    std::unique_ptr<MemoryAllocation> allocationA =
+        allocator.TryAllocateMemory(CreateBasicRequest(800, 1));
+    ASSERT_NE(allocationA, nullptr);
+
+    // Does not fit in the first memory.
+    std::unique_ptr<MemoryAllocation> allocationB =
+        allocator.TryAllocateMemory(CreateBasicRequest(800, 1));
+    ASSERT_NE(allocationB, nullptr);
+    EXPECT_NE(allocationB->GetMemory(), allocationA->GetMemory());
+    EXPECT_EQ(allocator.GetStats().UsedMemoryCount, 2u);
+
+    // Fits in the first memory.
+    std::unique_ptr<MemoryAllocation> allocationC =
+        allocator.TryAllocateMemory(CreateBasicRequest(200, 1));
+    ASSERT_NE(allocationC, nullptr);
+    EXPECT_EQ(allocationC->GetMemory(), allocationA->GetMemory());
+    EXPECT_EQ(allocator.GetStats().UsedMemoryCount, 2u);
+
+    // NeverAllocate cannot create memory.
+    EXPECT_EQ(allocator.TryAllocateMemory(CreateBasicRequest(800, 1, /*neverAllocate*/ true)),
+              nullptr);
+
+    allocator.DeallocateMemory(std::move(allocationA));
+    allocator.DeallocateMemory(std::move(allocationB));
+    EXPECT_EQ(allocator.GetStats().UsedMemoryCount, 1u);
+
+    allocator.DeallocateMemory(std::move(allocationC));
+    EXPECT_EQ(allocator.GetStats().UsedMemoryCount, 0u);
+}
+
+// Verify requests use the memory whose largest free block best fits, without creating memory.
+TEST_F(TLSFMemoryAllocatorTests, GoodFitHeap) {
+    TLSFMemoryAllocator allocator(kDefaultMemorySize, kDefaultMemoryAlignment,
+                                  std::make_unique<DummyMemoryAllocator>());
+
+    // Leaves 24 bytes free in each memory.
+    constexpr uint64_t kNumOfHeaps = 4;
+    std::vector<std::unique_ptr<MemoryAllocation>> allocations;
+    for (uint64_t i = 0; i < kNumOfHeaps * 2; i++) {
+        allocations.push_back(allocator.TryAllocateMemory(CreateBasicRequest(500, 1)));
+        ASSERT_NE(allocations.back(), nullptr);
+    }
+    EXPECT_EQ(allocator.GetStats().UsedMemoryCount, kNumOfHeaps);
+
+    // Only the third memory fits the request.
+    IMemoryObject* thirdMemory = allocations[5]->GetMemory();
+    allocator.DeallocateMemory(std::move(allocations[5]));
+
+    allocations[5] = allocator.TryAllocateMemory(CreateBasicRequest(400, 1));
+    ASSERT_NE(allocations[5], nullptr);
+    EXPECT_EQ(allocations[5]->GetMemory(), thirdMemory);
+
+    // Small requests use the oldest memory with the smallest free block.
+    allocations.push_back(allocator.TryAllocateMemory(CreateBasicRequest(20, 1)));
+    ASSERT_NE(allocations.back(), nullptr);
+    EXPECT_EQ(allocations.back()->GetMemory(), allocations[0]->GetMemory());
+    EXPECT_EQ(allocator.GetStats().UsedMemoryCount, kNumOfHeaps);
+
+    for (auto& allocation : allocations) {
+        allocator.DeallocateMemory(std::move(allocation));
+    }
+
+    EXPECT_EQ(allocator.GetStats().UsedMemoryCount, 0u);
+}
+
+// Verify aligned allocations are aligned within the memory.
+TEST_F(TLSFMemoryAllocatorTests, AlignedAllocations) {
+    TLSFMemoryAllocator allocator(kDefaultMemorySize, kDefaultMemoryAlignment,
+                                  std::make_unique<DummyMemoryAllocator>());
+
+    std::vector<std::unique_ptr<MemoryAllocation>> allocations;
+    for (uint64_t alignment : {1u, 64u, 16u, 256u}) {
+        allocations.push_back(allocator.TryAllocateMemory(CreateBasicRequest(30, alignment)));
+        ASSERT_NE(allocations.back(), nullptr);
+        EXPECT_EQ(allocations.back()->GetOffset() % alignment, 0u);
+    }
+
+    EXPECT_EQ(allocator.GetStats().UsedMemoryCount, 1u);
+
+    for (auto& allocation : allocations) {
+        allocator.DeallocateMemory(std::move(allocation));
+    }
+
+    EXPECT_EQ(allocator.GetStats().UsedMemoryCount, 0u);
+}
+
+// Verify fragmentation is tracked on every allocate and de-allocate.
+TEST_F(TLSFMemoryAllocatorTests, FragmentationStats) {
+    TLSFMemoryAllocator allocator(kDefaultMemorySize, kDefaultMemoryAlignment,
+                                  std::make_unique<DummyMemoryAllocator>());
+
+    std::unique_ptr<MemoryAllocation> allocationA =
+        allocator.TryAllocateMemory(CreateBasicRequest(100, 1));
+    ASSERT_NE(allocationA, nullptr);
+    EXPECT_EQ(allocator.GetStats().InternalFragmentationUsage, 0u);
+    EXPECT_EQ(allocator.GetStats().ExternalFragmentationUsage, kDefaultMemorySize - 100);
+    EXPECT_EQ(allocator.GetStats().LargestFreeBlockSize, kDefaultMemorySize - 100);
+
+    // Does not fit in the first memory.
+    std::unique_ptr<MemoryAllocation> allocationB =
+        allocator.TryAllocateMemory(CreateBasicRequest(1000, 1));
+    ASSERT_NE(allocationB, nullptr);
+    EXPECT_NE(allocationA->GetMemory(), allocationB->GetMemory());
+    EXPECT_EQ(allocator.GetStats().ExternalFragmentationUsage,
+              kDefaultMemorySize * 2 - 100 - 1000);
+    EXPECT_EQ(allocator.GetStats().LargestFreeBlockSize, kDefaultMemorySize - 100);
+
+    allocator.DeallocateMemory(std::move(allocationA));
+    EXPECT_EQ(allocator.GetStats().ExternalFragmentationUsage, kDefaultMemorySize - 1000);
+    EXPECT_EQ(allocator.GetStats().LargestFreeBlockSize, kDefaultMemorySize - 1000);
+
+    allocator.DeallocateMemory(std::move(allocationB));
+    EXPECT_EQ(allocator.GetStats().ExternalFragmentationUsage, 0u);
+    EXPECT_EQ(allocator.GetStats().LargestFreeBlockSize, 0u);
+}
@@ -0,0 +1,312 @@
+// Copyright 2022 The GPGMM Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include "gpgmm/common/WorkerThread.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace gpgmm;
+
+class CountingTask : public VoidCallback {
+  public:
+    explicit CountingTask(std::atomic<uint64_t>* count) : mCount(count) {
+    }
+
+    void operator()() override {
+        (*mCount)++;
+    }
+
+  private:
+    std::atomic<uint64_t>* const mCount;
+};
+
+// Records the order tasks were run in.
+class OrderedTask : public VoidCallback {
+  public:
+    OrderedTask(uint64_t id, std::mutex* mutex, std::vector<uint64_t>* order)
+        : mID(id), mMutex(mutex), mOrder(order) {
+    }
+
+    void operator()() override {
+        std::lock_guard<std::mutex> lock(*mMutex);
+        mOrder->push_back(mID);
+    }
+
+  private:
+    const uint64_t mID;
+    std::mutex* const mMutex;
+    std::vector<uint64_t>* const mOrder;
+};
+
+// Blocks the worker until the event is signaled.
+class BlockingTask : public VoidCallback {
+  public:
+    explicit BlockingTask(std::shared_ptr<Event> event,
+                          std::shared_ptr<Event> startedEvent = nullptr)
+        : mEvent(event), mStartedEvent(startedEvent) {
+    }
+
+    void operator()() override {
+        if (mStartedEvent != nullptr) {
+            mStartedEvent->Signal();
+        }
+        mEvent->Wait();
+    }
+
+  private:
+    std::shared_ptr<Event> mEvent;
+    std::shared_ptr<Event> mStartedEvent;
+};
+
+// Event signaled by the test itself.
+class ManualEvent : public Event {
+  public:
+    void Wait() override {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mCondition.wait(lock, [this] { return mIsSignaled; });
+    }
+
+    bool IsSignaled() override {
+        std::unique_lock<std::mutex> lock(mMutex);
+        return mIsSignaled;
+    }
+
+    void Signal() override {
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mIsSignaled = true;
+        }
+        mCondition.notify_all();
+    }
+
+  private:
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    bool mIsSignaled = false;
+};
+
+TEST(WorkerThreadTests, PostTask) {
+    std::shared_ptr<ThreadPool> pool = ThreadPool::Create(/*numOfWorkers*/ 4);
+
+    constexpr uint64_t kNumOfTasks = 100;
+    std::atomic<uint64_t> count{0};
+    std::shared_ptr<CountingTask> task = std::make_shared<CountingTask>(&count);
+
+    std::vector<std::shared_ptr<Event>> events;
+    for (uint64_t i = 0; i < kNumOfTasks; i++) {
+        events.push_back(ThreadPool::PostTask(pool, task, "PostTask"));
+        ASSERT_NE(events.back(), nullptr);
+    }
+
+    for (auto& event : events) {
+        event->Wait();
+        EXPECT_TRUE(event->IsSignaled());
+    }
+
+    EXPECT_EQ(count, kNumOfTasks);
+}
+
+// Verify higher priority tasks run before lower priority ones.
+TEST(WorkerThreadTests, PostTaskWithPriority) {
+    std::shared_ptr<ThreadPool> pool = ThreadPool::Create(/*numOfWorkers*/ 1);
+
+    // Keep the only worker busy until every task below was queued.
+    std::shared_ptr<Event> unblockEvent = std::make_shared<ManualEvent>();
+    std::shared_ptr<Event> busyEvent =
+        ThreadPool::PostTask(pool, std::make_shared<BlockingTask>(unblockEvent), "Busy");
+
+    std::mutex mutex;
+    std::vector<uint64_t> order;
+
+    std::vector<std::shared_ptr<Event>> events;
+    events.push_back(ThreadPool::PostTask(pool, std::make_shared<OrderedTask>(2, &mutex, &order),
+                                          "Low", TaskPriority::kLow));
+    events.push_back(ThreadPool::PostTask(pool, std::make_shared<OrderedTask>(1, &mutex, &order),
+                                          "Normal", TaskPriority::kNormal));
+    events.push_back(ThreadPool::PostTask(pool, std::make_shared<OrderedTask>(0, &mutex, &order),
+                                          "High", TaskPriority::kHigh));
+
+    unblockEvent->Signal();
+    busyEvent->Wait();
+
+    for (auto& event : events) {
+        event->Wait();
+    }
+
+    EXPECT_EQ(order, std::vector<uint64_t>({0, 1, 2}));
+}
+
+// Records the thread the task was run on.
+class ThreadTask : public VoidCallback {
+  public:
+    void operator()() override {
+        mThreadId = std::this_thread::get_id();
+    }
+
+    std::thread::id GetThreadId() const {
+        return mThreadId;
+    }
+
+  private:
+    std::thread::id mThreadId;
+};
+
+// Verify posting to a full pool drops low priority tasks and blocks the poster of any other
+// task until a worker makes room, which then runs it on a worker, never the caller.
+TEST(WorkerThreadTests, PostTaskWhenFull) {
+    std::shared_ptr<ThreadPool> pool = ThreadPool::Create(/*numOfWorkers*/ 1);
+
+    std::shared_ptr<Event> unblockEvent = std::make_shared<ManualEvent>();
+    std::shared_ptr<Event> startedEvent = std::make_shared<ManualEvent>();
+    std::shared_ptr<Event> busyEvent = ThreadPool::PostTask(
+        pool, std::make_shared<BlockingTask>(unblockEvent, startedEvent), "Busy");
+    startedEvent->Wait();
+
+    std::atomic<uint64_t> count{0};
+    std::shared_ptr<CountingTask> countingTask = std::make_shared<CountingTask>(&count);
+    std::vector<std::shared_ptr<Event>> events;
+    for (uint64_t i = 0; i < ThreadPool::kMaxTasksPerWorker; i++) {
+        events.push_back(ThreadPool::PostTask(pool, countingTask, "Full"));
+        EXPECT_FALSE(events.back()->IsSignaled());
+    }
+
+    std::shared_ptr<Event> droppedEvent =
+        ThreadPool::PostTask(pool, countingTask, "Dropped", TaskPriority::kLow);
+    EXPECT_TRUE(droppedEvent->IsSignaled());
+
+    std::shared_ptr<ThreadTask> blockedTask = std::make_shared<ThreadTask>();
+    std::shared_ptr<Event> blockedEvent;
+    std::atomic<bool> isPosted{false};
+    std::thread poster([&]() {
+        blockedEvent = ThreadPool::PostTask(pool, blockedTask, "Blocked");
+        isPosted = true;
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    EXPECT_FALSE(isPosted);
+
+    unblockEvent->Signal();
+    busyEvent->Wait();
+    poster.join();
+
+    blockedEvent->Wait();
+    EXPECT_NE(blockedTask->GetThreadId(), std::this_thread::get_id());
+
+    for (std::shared_ptr<Event>& event : events) {
+        event->Wait();
+    }
+    EXPECT_EQ(count, ThreadPool::kMaxTasksPerWorker);
+}
+
+// Posts twice as many tasks as a worker can queue.
+class PostingTask : public VoidCallback {
+  public:
+    PostingTask(std::shared_ptr<ThreadPool> pool, std::shared_ptr<VoidCallback> task)
+        : mPool(pool), mTask(task) {
+    }
+
+    void operator()() override {
+        for (uint64_t i = 0; i < ThreadPool::kMaxTasksPerWorker * 2; i++) {
+            ThreadPool::PostTask(mPool, mTask, "FromWorker");
+        }
+    }
+
+  private:
+    std::shared_ptr<ThreadPool> mPool;
+    std::shared_ptr<VoidCallback> mTask;
+};
+
+// Verify a worker posting to its own full pool is never blocked.
+TEST(WorkerThreadTests, PostTaskWhenFullFromWorker) {
+    std::shared_ptr<ThreadPool> pool = ThreadPool::Create(/*numOfWorkers*/ 1);
+
+    std::atomic<uint64_t> count{0};
+    std::shared_ptr<CountingTask> countingTask = std::make_shared<CountingTask>(&count);
+
+    ThreadPool::PostTask(pool, std::make_shared<PostingTask>(pool, countingTask), "Posting")
+        ->Wait();
+
+    while (count < ThreadPool::kMaxTasksPerWorker * 2) {
+        std::this_thread::yield();
+    }
+}
+
+// Verify every queued task still runs once the pool is only referenced by its tasks.
+TEST(WorkerThreadTests, ReleasePoolWithQueuedTasks) {
+    constexpr uint64_t kNumOfTasks = 100;
+    std::atomic<uint64_t> count{0};
+    {
+        std::shared_ptr<ThreadPool> pool = ThreadPool::Create(/*numOfWorkers*/ 2);
+        std::shared_ptr<CountingTask> task = std::make_shared<CountingTask>(&count);
+        for (uint64_t i = 0; i < kNumOfTasks; i++) {
+            ThreadPool::PostTask(pool, task, "Release");
+        }
+    }
+
+    while (count < kNumOfTasks) {
+        std::this_thread::yield();
+    }
+
+    EXPECT_EQ(count, kNumOfTasks);
+}
+
+// Verify delayed tasks run once due, earliest first.
+TEST(WorkerThreadTests, PostDelayedTask) {
+    std::shared_ptr<ThreadPool> pool = ThreadPool::Create(/*numOfWorkers*/ 1);
+
+    std::mutex mutex;
+    std::vector<uint64_t> order;
+
+    const auto start = std::chrono::steady_clock::now();
+    std::shared_ptr<Event> lateEvent = ThreadPool::PostDelayedTask(
+        pool, std::make_shared<OrderedTask>(1, &mutex, &order), "Late",
+        std::chrono::milliseconds(20));
+    std::shared_ptr<Event> earlyEvent = ThreadPool::PostDelayedTask(
+        pool, std::make_shared<OrderedTask>(0, &mutex, &order), "Early",
+        std::chrono::milliseconds(10));
+
+    earlyEvent->Wait();
+    lateEvent->Wait();
+
+    EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(20));
+    EXPECT_EQ(order, std::vector<uint64_t>({0, 1}));
+}
+
+// Verify delayed tasks not yet due are dropped, but signaled, once the pool is destroyed.
+TEST(WorkerThreadTests, ReleasePoolWithDelayedTasks) {
+    std::atomic<uint64_t> count{0};
+    std::shared_ptr<Event> event;
+    {
+        std::shared_ptr<ThreadPool> pool = ThreadPool::Create(/*numOfWorkers*/ 1);
+        event = ThreadPool::PostDelayedTask(pool, std::make_shared<CountingTask>(&count),
+                                            "Dropped", std::chrono::hours(1));
+    }
+
+    event->Wait();
+    EXPECT_EQ(count, 0u);
+}
+
+// Verify the shared pool is re-used while referenced.
+TEST(WorkerThreadTests, GetOrCreateShared) {
+    std::shared_ptr<ThreadPool> pool = ThreadPool::GetOrCreateShared();
+    ASSERT_NE(pool, nullptr);
+    EXPECT_EQ(pool, ThreadPool::GetOrCreateShared());
+}